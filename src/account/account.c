@@ -1,6 +1,9 @@
 #include "account.h"
 
+#include <string.h>
+
 #include "defines/agent_values.h"
+#include "defines/ipc_values.h"
 #include "defines/oidc_values.h"
 #include "defines/settings.h"
 #include "issuer_helper.h"
@@ -12,6 +15,7 @@
 #include "utils/listUtils.h"
 #include "utils/logger.h"
 #include "utils/matcher.h"
+#include "utils/string/intern.h"
 #include "utils/string/stringUtils.h"
 #include "utils/uriUtils.h"
 
@@ -262,6 +266,135 @@ cJSON* accountToJSONWithoutCredentials(const struct oidc_account* a) {
   return _accountToJSON(a, 0);
 }
 
+static void _addStringIfValid(cJSON* json, const char* key,
+                              const char* value) {
+  if (strValid(value)) {
+    jsonAddStringValue(json, key, value);
+  }
+}
+
+/**
+ * @brief converts a loaded account into json for the state snapshot of the
+ * agent. Additionally to the account config it contains the issuer metadata,
+ * the access token and how the account was loaded, so that it can be restored
+ * without contacting the issuer.
+ * @note the credentials are taken as they are, i.e. they have to be decrypted
+ * by the caller
+ * @return a json object; has to be freed after usage
+ */
+cJSON* accountToSnapshotJSON(const struct oidc_account* p) {
+  cJSON*              json     = accountToJSON(p);
+  cJSON*              metadata = cJSON_CreateObject();
+  struct oidc_issuer* iss      = account_getIssuer(p);
+  _addStringIfValid(metadata, OIDC_KEY_TOKEN_ENDPOINT,
+                    issuer_getTokenEndpoint(iss));
+  _addStringIfValid(metadata, MYTOKEN_KEY_MYTOKEN_ENDPOINT,
+                    issuer_getMytokenEndpoint(iss));
+  _addStringIfValid(metadata, OIDC_KEY_AUTHORIZATION_ENDPOINT,
+                    issuer_getAuthorizationEndpoint(iss));
+  _addStringIfValid(metadata, OIDC_KEY_REVOCATION_ENDPOINT,
+                    issuer_getRevocationEndpoint(iss));
+  _addStringIfValid(metadata, OIDC_KEY_REGISTRATION_ENDPOINT,
+                    issuer_getRegistrationEndpoint(iss));
+  _addStringIfValid(metadata, OIDC_KEY_SCOPES_SUPPORTED,
+                    issuer_getScopesSupported(iss));
+  _addStringIfValid(metadata, OIDC_KEY_GRANT_TYPES_SUPPORTED,
+                    issuer_getGrantTypesSupported(iss));
+  _addStringIfValid(metadata, OIDC_KEY_RESPONSE_TYPES_SUPPORTED,
+                    issuer_getResponseTypesSupported(iss));
+  _addStringIfValid(metadata, SNAPSHOT_KEY_CODECHALLENGEMETHOD,
+                    account_getCodeChallengeMethod(p));
+  jsonAddJSON(json, SNAPSHOT_KEY_METADATA, metadata);
+  _addStringIfValid(json, OIDC_KEY_ACCESSTOKEN, account_getAccessToken(p));
+  jsonAddNumberValue(json, AGENT_KEY_EXPIRESAT, account_getTokenExpiresAt(p));
+  jsonAddNumberValue(json, SNAPSHOT_KEY_DEATH, account_getDeath(p));
+  jsonAddNumberValue(json, SNAPSHOT_KEY_LASTUSED, account_getLastUsed(p));
+  jsonAddNumberValue(json, IPC_KEY_CONFIRM,
+                     account_getConfirmationRequired(p) ? 1 : 0);
+  jsonAddNumberValue(json, IPC_KEY_ALWAYSALLOWID,
+                     account_getAlwaysAllowId(p) ? 1 : 0);
+  jsonAddNumberValue(json, IPC_KEY_RELOADABLE,
+                     account_getReloadable(p) ? 1 : 0);
+  return json;
+}
+
+static oidc_error_t _setMetadataFromJSON(struct oidc_account* p,
+                                         const char*          json) {
+  INIT_KEY_VALUE(OIDC_KEY_TOKEN_ENDPOINT, MYTOKEN_KEY_MYTOKEN_ENDPOINT,
+                 OIDC_KEY_AUTHORIZATION_ENDPOINT, OIDC_KEY_REVOCATION_ENDPOINT,
+                 OIDC_KEY_REGISTRATION_ENDPOINT, OIDC_KEY_SCOPES_SUPPORTED,
+                 OIDC_KEY_GRANT_TYPES_SUPPORTED,
+                 OIDC_KEY_RESPONSE_TYPES_SUPPORTED,
+                 SNAPSHOT_KEY_CODECHALLENGEMETHOD);
+  GET_JSON_VALUES_RETURN_OIDCERRNO_ONERROR(json);
+  KEY_VALUE_VARS(token_endpoint, mytoken_endpoint, authorization_endpoint,
+                 revocation_endpoint, registration_endpoint, scopes_supported,
+                 grant_types_supported, response_types_supported,
+                 code_challenge_method);
+  struct oidc_issuer* iss = account_getIssuer(p);
+  issuer_setTokenEndpoint(iss, _token_endpoint);
+  issuer_setMytokenEndpoint(iss, _mytoken_endpoint);
+  issuer_setAuthorizationEndpoint(iss, _authorization_endpoint);
+  issuer_setRevocationEndpoint(iss, _revocation_endpoint);
+  issuer_setRegistrationEndpoint(iss, _registration_endpoint);
+  // not account_setScopesSupported, that would change the scope of the account
+  issuer_setScopesSupported(iss, _scopes_supported);
+  issuer_setGrantTypesSupported(iss, _grant_types_supported);
+  issuer_setResponseTypesSupported(iss, _response_types_supported);
+  account_setCodeChallengeMethod(p, _code_challenge_method);
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief restores an account from the json created by
+ * @c accountToSnapshotJSON
+ * @return a pointer to the account or @c NULL on failure; has to be freed
+ * after usage
+ */
+struct oidc_account* getAccountFromSnapshotJSON(const char* json) {
+  struct oidc_account* p = getAccountFromJSON(json);
+  if (p == NULL) {
+    return NULL;
+  }
+  INIT_KEY_VALUE(SNAPSHOT_KEY_METADATA, OIDC_KEY_ACCESSTOKEN,
+                 AGENT_KEY_EXPIRESAT, SNAPSHOT_KEY_DEATH, SNAPSHOT_KEY_LASTUSED,
+                 IPC_KEY_CONFIRM, IPC_KEY_ALWAYSALLOWID, IPC_KEY_RELOADABLE);
+  if (CALL_GETJSONVALUES(json) < 0) {
+    SEC_FREE_KEY_VALUES();
+    secFreeAccount(p);
+    return NULL;
+  }
+  KEY_VALUE_VARS(metadata, access_token, expires_at, death, last_used, confirm,
+                 alwaysallowid, reloadable);
+  if (_metadata == NULL || _setMetadataFromJSON(p, _metadata) != OIDC_SUCCESS) {
+    if (_metadata == NULL) {
+      oidc_setArgNullFuncError(__func__);
+    }
+    SEC_FREE_KEY_VALUES();
+    secFreeAccount(p);
+    return NULL;
+  }
+  account_setAccessToken(p, _access_token);
+  account_setTokenExpiresAt(p, strToULong(_expires_at));
+  account_setDeath(p, strToLong(_death));
+  account_setLastUsed(p, strToLong(_last_used));
+  if (strToInt(_confirm)) {
+    account_setConfirmationRequired(p);
+  }
+  if (strToInt(_alwaysallowid)) {
+    account_setAlwaysAllowId(p);
+  }
+  account_setReloadable(p, strToInt(_reloadable));
+  secFree(_metadata);
+  secFree(_expires_at);
+  secFree(_death);
+  secFree(_last_used);
+  secFree(_confirm);
+  secFree(_alwaysallowid);
+  secFree(_reloadable);
+  return p;
+}
+
 /** void freeAccount(struct oidc_account* p)
  * @brief frees an account completly including all fields.
  * @param p a pointer to the account to be freed
@@ -336,6 +469,67 @@ int hasRedirectUris(const struct oidc_account* account) {
   return ret;
 }
 
+static size_t _strFootprint(const char* str) {
+  return str ? strlen(str) + 1 : 0;
+}
+
+/**
+ * @brief estimates the memory an account uses
+ * @return the size of the account, its issuer and the strings they hold, in
+ * bytes; interned strings are only counted with the account's share
+ */
+size_t account_getMemoryFootprint(const struct oidc_account* p) {
+  if (p == NULL) {
+    return 0;
+  }
+  size_t      size   = sizeof(struct oidc_account);
+  const char* strs[] = {p->shortname,
+                        p->clientname,
+                        p->client_id,
+                        p->client_secret,
+                        p->scope,
+                        p->audience,
+                        p->used_mytoken_profile,
+                        p->username,
+                        p->password,
+                        p->refresh_token,
+                        p->token.access_token,
+                        p->usedState,
+                        p->code_challenge_method};
+  for (size_t i = 0; i < sizeof(strs) / sizeof(*strs); i++) {
+    size += _strFootprint(strs[i]);
+  }
+  size += intern_footprint(p->cert_path);
+  const struct oidc_issuer* iss = p->issuer;
+  if (iss != NULL) {
+    size += sizeof(struct oidc_issuer);
+    const char* iss_strs[] = {iss->issuer_url,
+                              iss->mytoken_url,
+                              iss->configuration_endpoint,
+                              iss->token_endpoint,
+                              iss->mytoken_endpoint,
+                              iss->authorization_endpoint,
+                              iss->revocation_endpoint,
+                              iss->registration_endpoint,
+                              iss->device_authorization_endpoint.url,
+                              iss->scopes_supported,
+                              iss->grant_types_supported,
+                              iss->response_types_supported};
+    for (size_t i = 0; i < sizeof(iss_strs) / sizeof(*iss_strs); i++) {
+      size += intern_footprint(iss_strs[i]);
+    }
+  }
+  if (p->redirect_uris != NULL) {
+    list_node_t*     node;
+    list_iterator_t* it = list_iterator_new(p->redirect_uris, LIST_HEAD);
+    while ((node = list_iterator_next(it))) {
+      size += sizeof(list_node_t) + _strFootprint(node->val);
+    }
+    list_iterator_destroy(it);
+  }
+  return size;
+}
+
 list_t* defineUsableScopeList(const struct oidc_account* account) {
   char*   wanted_str = account_getScope(account);
   list_t* wanted     = delimitedStringToList(wanted_str, ' ');
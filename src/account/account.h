@@ -32,6 +32,7 @@ struct oidc_account {
   char*               usedState;
   unsigned char       usedStateChecked;
   time_t              death;
+  time_t              last_used;
   char*               code_challenge_method;
   unsigned char       mode;
 };
@@ -42,7 +43,7 @@ struct oidc_account {
 #define ACCOUNT_MODE_ALWAYSALLOWID 0x08
 #define ACCOUNT_MODE_OAUTH2 0x10
 #define ACCOUNT_MODE_PUBCLIENT 0x20
-#define ACCOUNT_MODE_UNUSED 0x40
+#define ACCOUNT_MODE_RELOADABLE 0x40
 #define ACCOUNT_MODE_UNUSED_ 0x80
 
 char*                defineUsableScopes(const struct oidc_account* account);
@@ -51,6 +52,8 @@ cJSON*               accountToJSON(const struct oidc_account* p);
 char*                accountToJSONString(const struct oidc_account* p);
 cJSON* accountToJSONWithoutCredentials(const struct oidc_account* p);
 char*  accountToJSONStringWithoutCredentials(const struct oidc_account* p);
+cJSON* accountToSnapshotJSON(const struct oidc_account* p);
+struct oidc_account* getAccountFromSnapshotJSON(const char* json);
 void   _secFreeAccount(struct oidc_account* p);
 void   secFreeAccountContent(struct oidc_account* p);
 
@@ -61,6 +64,7 @@ char*                getScopesForUserClient(const struct oidc_account*);
 int                  accountConfigExists(const char* accountname);
 char*                getAccountNameList(list_t* accounts);
 int                  hasRedirectUris(const struct oidc_account* account);
+size_t               account_getMemoryFootprint(const struct oidc_account* p);
 
 int   account_matchByState(const struct oidc_account* p1,
                            const struct oidc_account* p2);
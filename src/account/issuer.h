@@ -2,12 +2,18 @@
 #define ISSUER_H
 
 #include "utils/memory.h"
+#include "utils/string/intern.h"
 
 struct device_authorization_endpoint {
   char* url;
   int   setByUser;
 };
 
+/**
+ * The strings of an issuer are interned (see utils/string/intern.h), so the
+ * accounts of an issuer share a single copy of its metadata. They are set
+ * through the setters below and must not be modified in place.
+ */
 struct oidc_issuer {
   char* issuer_url;
   char* mytoken_url;
@@ -73,64 +79,64 @@ inline static void issuer_setIssuerUrl(struct oidc_issuer* iss,
   if (iss->issuer_url == issuer_url) {
     return;
   }
-  secFree(iss->issuer_url);
-  iss->issuer_url = issuer_url;
+  intern_release(iss->issuer_url);
+  iss->issuer_url = intern_take(issuer_url);
 }
 inline static void issuer_setMytokenUrl(struct oidc_issuer* iss,
                                         char*               mytoken_url) {
   if (iss->mytoken_url == mytoken_url) {
     return;
   }
-  secFree(iss->mytoken_url);
-  iss->mytoken_url = mytoken_url;
+  intern_release(iss->mytoken_url);
+  iss->mytoken_url = intern_take(mytoken_url);
 }
 inline static void issuer_setConfigurationEndpoint(
     struct oidc_issuer* iss, char* configuration_endpoint) {
   if (iss->configuration_endpoint == configuration_endpoint) {
     return;
   }
-  secFree(iss->configuration_endpoint);
-  iss->configuration_endpoint = configuration_endpoint;
+  intern_release(iss->configuration_endpoint);
+  iss->configuration_endpoint = intern_take(configuration_endpoint);
 }
 inline static void issuer_setTokenEndpoint(struct oidc_issuer* iss,
                                            char*               token_endpoint) {
   if (iss->token_endpoint == token_endpoint) {
     return;
   }
-  secFree(iss->token_endpoint);
-  iss->token_endpoint = token_endpoint;
+  intern_release(iss->token_endpoint);
+  iss->token_endpoint = intern_take(token_endpoint);
 }
 inline static void issuer_setMytokenEndpoint(struct oidc_issuer* iss,
                                              char* mytoken_endpoint) {
   if (iss->mytoken_endpoint == mytoken_endpoint) {
     return;
   }
-  secFree(iss->mytoken_endpoint);
-  iss->mytoken_endpoint = mytoken_endpoint;
+  intern_release(iss->mytoken_endpoint);
+  iss->mytoken_endpoint = intern_take(mytoken_endpoint);
 }
 inline static void issuer_setAuthorizationEndpoint(
     struct oidc_issuer* iss, char* authorization_endpoint) {
   if (iss->authorization_endpoint == authorization_endpoint) {
     return;
   }
-  secFree(iss->authorization_endpoint);
-  iss->authorization_endpoint = authorization_endpoint;
+  intern_release(iss->authorization_endpoint);
+  iss->authorization_endpoint = intern_take(authorization_endpoint);
 }
 inline static void issuer_setRevocationEndpoint(struct oidc_issuer* iss,
                                                 char* revocation_endpoint) {
   if (iss->revocation_endpoint == revocation_endpoint) {
     return;
   }
-  secFree(iss->revocation_endpoint);
-  iss->revocation_endpoint = revocation_endpoint;
+  intern_release(iss->revocation_endpoint);
+  iss->revocation_endpoint = intern_take(revocation_endpoint);
 }
 inline static void issuer_setRegistrationEndpoint(struct oidc_issuer* iss,
                                                   char* registration_endpoint) {
   if (iss->registration_endpoint == registration_endpoint) {
     return;
   }
-  secFree(iss->registration_endpoint);
-  iss->registration_endpoint = registration_endpoint;
+  intern_release(iss->registration_endpoint);
+  iss->registration_endpoint = intern_take(registration_endpoint);
 }
 inline static void issuer_setDeviceAuthorizationEndpoint(
     struct oidc_issuer* iss, char* device_authorization_endpoint,
@@ -138,8 +144,9 @@ inline static void issuer_setDeviceAuthorizationEndpoint(
   if (iss->device_authorization_endpoint.url == device_authorization_endpoint) {
     return;
   }
-  secFree(iss->device_authorization_endpoint.url);
-  iss->device_authorization_endpoint.url       = device_authorization_endpoint;
+  intern_release(iss->device_authorization_endpoint.url);
+  iss->device_authorization_endpoint.url =
+      intern_take(device_authorization_endpoint);
   iss->device_authorization_endpoint.setByUser = setByUser;
 }
 inline static void issuer_setScopesSupported(struct oidc_issuer* iss,
@@ -147,24 +154,24 @@ inline static void issuer_setScopesSupported(struct oidc_issuer* iss,
   if (iss->scopes_supported == scopes_supported) {
     return;
   }
-  secFree(iss->scopes_supported);
-  iss->scopes_supported = scopes_supported;
+  intern_release(iss->scopes_supported);
+  iss->scopes_supported = intern_take(scopes_supported);
 }
 inline static void issuer_setGrantTypesSupported(struct oidc_issuer* iss,
                                                  char* grant_types_supported) {
   if (iss->grant_types_supported == grant_types_supported) {
     return;
   }
-  secFree(iss->grant_types_supported);
-  iss->grant_types_supported = grant_types_supported;
+  intern_release(iss->grant_types_supported);
+  iss->grant_types_supported = intern_take(grant_types_supported);
 }
 inline static void issuer_setResponseTypesSupported(
     struct oidc_issuer* iss, char* response_types_supported) {
   if (iss->response_types_supported == response_types_supported) {
     return;
   }
-  secFree(iss->response_types_supported);
-  iss->response_types_supported = response_types_supported;
+  intern_release(iss->response_types_supported);
+  iss->response_types_supported = intern_take(response_types_supported);
 }
 
 #ifndef secFreeIssuer
@@ -2,6 +2,7 @@
 
 #include "utils/config/agent_config.h"
 #include "utils/hostname.h"
+#include "utils/string/intern.h"
 #include "utils/string/stringUtils.h"
 
 struct oidc_issuer* account_getIssuer(const struct oidc_account* p) {
@@ -134,6 +135,10 @@ time_t account_getDeath(const struct oidc_account* p) {
   return p ? p->death : 0;
 }
 
+time_t account_getLastUsed(const struct oidc_account* p) {
+  return p ? p->last_used : 0;
+}
+
 char* account_getCodeChallengeMethod(const struct oidc_account* p) {
   return p ? p->code_challenge_method : NULL;
 }
@@ -162,6 +167,14 @@ unsigned char account_getUsesPubClient(const struct oidc_account* p) {
   return p ? p->mode & ACCOUNT_MODE_PUBCLIENT : 0;
 }
 
+/**
+ * @brief returns if the account can be loaded again without asking the user,
+ * i.e. if it might be evicted
+ */
+unsigned char account_getReloadable(const struct oidc_account* p) {
+  return p ? p->mode & ACCOUNT_MODE_RELOADABLE : 0;
+}
+
 void account_setIssuerUrl(struct oidc_account* p, char* issuer_url) {
   if (!p->issuer) {
     p->issuer = secAlloc(sizeof(struct oidc_issuer));
@@ -325,8 +338,8 @@ void account_setCertPath(struct oidc_account* p, char* cert_path) {
   if (p->cert_path == cert_path) {
     return;
   }
-  secFree(p->cert_path);
-  p->cert_path = cert_path;
+  intern_release(p->cert_path);
+  p->cert_path = intern_take(cert_path);
 }
 
 void account_setRedirectUris(struct oidc_account* p, list_t* redirect_uris) {
@@ -356,6 +369,10 @@ void account_setDeath(struct oidc_account* p, time_t death) {
   p->death = death;
 }
 
+void account_setLastUsed(struct oidc_account* p, time_t last_used) {
+  p->last_used = last_used;
+}
+
 void account_setCodeChallengeMethod(struct oidc_account* p,
                                     char* code_challenge_method) {
   if (p->code_challenge_method == code_challenge_method) {
@@ -389,6 +406,14 @@ void account_setUsesPubClient(struct oidc_account* p) {
   p->mode |= ACCOUNT_MODE_PUBCLIENT;
 }
 
+void account_setReloadable(struct oidc_account* p, unsigned char reloadable) {
+  if (reloadable) {
+    p->mode |= ACCOUNT_MODE_RELOADABLE;
+  } else {
+    p->mode &= ~ACCOUNT_MODE_RELOADABLE;
+  }
+}
+
 int account_refreshTokenIsValid(const struct oidc_account* p) {
   char* refresh_token = account_getRefreshToken(p);
   int   ret           = strValid(refresh_token);
@@ -34,6 +34,7 @@ list_t*       account_getRedirectUris(const struct oidc_account* p);
 size_t        account_getRedirectUrisCount(const struct oidc_account* p);
 char*         account_getUsedState(const struct oidc_account* p);
 time_t        account_getDeath(const struct oidc_account* p);
+time_t        account_getLastUsed(const struct oidc_account* p);
 char*         account_getCodeChallengeMethod(const struct oidc_account* p);
 unsigned char account_getConfirmationRequired(const struct oidc_account* p);
 unsigned char account_getNoWebServer(const struct oidc_account* p);
@@ -41,6 +42,7 @@ unsigned char account_getNoScheme(const struct oidc_account* p);
 unsigned char account_getAlwaysAllowId(const struct oidc_account* p);
 unsigned char account_getIsOAuth2(const struct oidc_account* p);
 unsigned char account_getUsesPubClient(const struct oidc_account* p);
+unsigned char account_getReloadable(const struct oidc_account* p);
 
 void account_setIssuerUrl(struct oidc_account* p, char* issuer_url);
 void account_setMytokenUrl(struct oidc_account* p, char* issuer_url);
@@ -67,6 +69,7 @@ void account_setRedirectUris(struct oidc_account* p, list_t* redirect_uris);
 void account_setUsedState(struct oidc_account* p, char* used_state);
 void account_clearCredentials(struct oidc_account* a);
 void account_setDeath(struct oidc_account* p, time_t death);
+void account_setLastUsed(struct oidc_account* p, time_t last_used);
 void account_setCodeChallengeMethod(struct oidc_account* p,
                                     char*                code_challenge_method);
 void account_setConfirmationRequired(struct oidc_account* p);
@@ -75,6 +78,7 @@ void account_setNoScheme(struct oidc_account* p);
 void account_setAlwaysAllowId(struct oidc_account* p);
 void account_setOAuth2(struct oidc_account* p);
 void account_setUsesPubClient(struct oidc_account* p);
+void account_setReloadable(struct oidc_account* p, unsigned char reloadable);
 
 int account_refreshTokenIsValid(const struct oidc_account* p);
 
@@ -88,7 +88,8 @@ static struct agent_response _getAgentAccountInfosResponse(int type) {
     case AGENT_RESPONSE_TYPE_ACCOUNTINFO:
       request = getAccountInfoRequest();
       break;
-    default: return (struct agent_response){};
+    default: END_APILOGLEVEL
+      return (struct agent_response){};
   }
   char*                 response = communicate(LOCAL_COMM, request);
   struct agent_response ret = parseForAgentAccountInfosResponse(response, type);
@@ -2,10 +2,13 @@
 #define OIDC_AGENT_API_H
 
 #include "accounts.h"
+#include "async.h"
+#include "context.h"
 #include "error.h"
 #include "memory.h"
 #include "mytokens.h"
 #include "response.h"
 #include "tokens.h"
+#include "watch.h"
 
 #endif  // OIDC_AGENT_API_H
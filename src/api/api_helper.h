@@ -2,16 +2,24 @@
 #define OIDC_AGENT_API_HELPER_H
 
 #include "utils/logger.h"
+#include "utils/oidc_error.h"
 
 #ifndef API_LOGLEVEL
 #define API_LOGLEVEL NOTICE
 #endif  // API_LOGLEVEL
 
+// The api log level only applies to the calling thread, so that library calls
+// from several threads do not interfere with each other or the application's
+// own log mask. On return the error state is published for applications that
+// still read the process-wide oidc_errno.
 #ifndef START_APILOGLEVEL
-#define START_APILOGLEVEL int oldLogMask = logger_setloglevel(API_LOGLEVEL);
+#define START_APILOGLEVEL \
+  int oldLogLevel = logger_setThreadLoglevel(API_LOGLEVEL);
 #endif
 #ifndef END_APILOGLEVEL
-#define END_APILOGLEVEL logger_setlogmask(oldLogMask);
+#define END_APILOGLEVEL                \
+  logger_setThreadLoglevel(oldLogLevel); \
+  oidc_publishErrorState();
 #endif  // END_APILOGLEVEL
 
 #define LOCAL_COMM 0
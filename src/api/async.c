@@ -0,0 +1,471 @@
+#define _POSIX_C_SOURCE 200809L
+#include "async.h"
+
+#include "defines/msys.h"
+
+#ifndef MINGW
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "api_helper.h"
+#include "defines/settings.h"
+#include "ipc/cryptIpc.h"
+#include "token_cache.h"
+#include "tokens.h"
+#include "tokens_internal.h"
+#include "utils/crypt/crypt.h"
+#include "utils/crypt/ipcCryptUtils.h"
+#include "utils/json.h"
+#include "utils/memory.h"
+#include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
+
+/**
+ * The steps of a request; each one is done as far as the socket allows and
+ * continued in the next call of @c oidcagent_requestStep. The messages are
+ * the same as for the blocking @c ipc_cryptCommunicate: the client sends its
+ * public key, the agent answers with its public key, the client sends the
+ * encrypted request and the agent answers with the encrypted response and
+ * closes the connection.
+ * A token from the in-process token cache is delivered through a pipe that is
+ * readable right away, so that it reaches the callback in the next step just
+ * like a response of the agent.
+ */
+enum request_state {
+  REQUEST_CACHED,
+  REQUEST_CONNECTING,
+  REQUEST_SEND_KEY,
+  REQUEST_RECV_KEY,
+  REQUEST_SEND_REQUEST,
+  REQUEST_RECV_RESPONSE,
+};
+
+struct oidcagent_request {
+  int                        sock;
+  enum request_state         state;
+  char*                      request;
+  unsigned char*             ipc_key;
+  struct pubsec_keySet*      keys;
+  char*                      out;
+  size_t                     out_len;
+  size_t                     out_done;
+  char*                      in;
+  size_t                     in_len;
+  size_t                     in_size;
+  char*                      cache_account;
+  char*                      cache_issuer;
+  char*                      cache_scope;
+  char*                      cache_audience;
+  unsigned char              use_cache;
+  struct agent_response      cached;
+  oidcagent_request_callback callback;
+  void*                      arg;
+};
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// length of the base64 encoded public key sent by the agent
+#define SERVER_KEY_LEN \
+  (sodium_base64_ENCODED_LEN(crypto_kx_PUBLICKEYBYTES, \
+                             sodium_base64_VARIANT_ORIGINAL) - 1)
+
+static void _secFreeRequest(oidcagent_request_t* req) {
+  if (req->sock >= 0) {
+    close(req->sock);
+  }
+  secFree(req->request);
+  secFree(req->ipc_key);
+  secFreePubSecKeySet(req->keys);
+  secFree(req->out);
+  secFree(req->in);
+  secFree(req->cache_account);
+  secFree(req->cache_issuer);
+  secFree(req->cache_scope);
+  secFree(req->cache_audience);
+  if (req->state == REQUEST_CACHED) {
+    secFreeAgentResponse(req->cached);
+  }
+  secFree(req);
+}
+
+static void _setOutput(oidcagent_request_t* req, char* msg) {
+  secFree(req->out);
+  req->out      = msg;
+  req->out_len  = strlen(msg);
+  req->out_done = 0;
+}
+
+/**
+ * @brief creates a request that delivers a token from the token cache
+ * @param res the cached response; it is owned by the request
+ */
+static oidcagent_request_t* _cachedRequest(struct agent_response      res,
+                                           oidcagent_request_callback callback,
+                                           void*                      arg) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    oidc_setErrnoError();
+    secFreeAgentResponse(res);
+    return NULL;
+  }
+  close(fds[1]);  // the read end reports end of file right away
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  oidcagent_request_t* req = secAlloc(sizeof(oidcagent_request_t));
+  req->sock                = fds[0];
+  req->state               = REQUEST_CACHED;
+  req->cached              = res;
+  req->callback            = callback;
+  req->arg                 = arg;
+  return req;
+}
+
+static oidcagent_request_t* _startRequest(
+    const char* socket_path, const char* accountname, const char* issuer,
+    time_t min_valid_period, const char* scope, const char* application_hint,
+    const char* audience, oidcagent_request_callback callback, void* arg) {
+  if (callback == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return NULL;
+  }
+  const char* path = socket_path ?: getenv(OIDC_SOCK_ENV_NAME);
+  if (path == NULL) {
+    oidc_errno = OIDC_EENVVAR;
+    oidc_seterror("Could not get the socket path from env var "
+                  "'" OIDC_SOCK_ENV_NAME "'. Have you set the env var?");
+    return NULL;
+  }
+  struct sockaddr_un addr = {.sun_family = AF_UNIX};
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    oidc_errno = OIDC_ESOCKINV;
+    return NULL;
+  }
+  strcpy(addr.sun_path, path);
+  if (socket_path == NULL) {
+    struct agent_response res;
+    if (tokenCache_get(accountname, issuer, min_valid_period, scope, audience,
+                       &res)) {
+      return _cachedRequest(res, callback, arg);
+    }
+  }
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0) {
+    oidc_errno = OIDC_ECRSOCK;
+    return NULL;
+  }
+  if (fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK) != 0 ||
+      fcntl(sock, F_SETFD, FD_CLOEXEC) != 0) {
+    oidc_setErrnoError();
+    close(sock);
+    return NULL;
+  }
+  int connected = connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+  // EAGAIN means that the backlog of the agent socket is full; unlike
+  // EINPROGRESS the connection is not established later on
+  if (!connected && errno != EINPROGRESS) {
+    oidc_errno = OIDC_ECONSOCK;
+    close(sock);
+    return NULL;
+  }
+  START_APILOGLEVEL
+  oidcagent_request_t* req = secAlloc(sizeof(oidcagent_request_t));
+  req->sock                = sock;
+  req->state               = connected ? REQUEST_SEND_KEY : REQUEST_CONNECTING;
+  req->keys                = generatePubSecKeys();
+  req->callback            = callback;
+  req->arg                 = arg;
+  req->use_cache           = socket_path == NULL;
+
+  req->request = _getAccessTokenRequest(accountname, issuer, min_valid_period,
+                                        0, scope, application_hint, audience);
+  if (req->use_cache) {
+    req->cache_account  = oidc_strcopy(accountname);
+    req->cache_issuer   = oidc_strcopy(issuer);
+    req->cache_scope    = oidc_strcopy(scope);
+    req->cache_audience = oidc_strcopy(audience);
+  }
+  _setOutput(req, toBase64((char*)req->keys->pk, crypto_kx_PUBLICKEYBYTES));
+  END_APILOGLEVEL
+  return req;
+}
+
+oidcagent_request_t* oidcagent_startTokenRequest(
+    const char* socket_path, const char* accountname, time_t min_valid_period,
+    const char* scope, const char* application_hint, const char* audience,
+    oidcagent_request_callback callback, void* arg) {
+  return _startRequest(socket_path, accountname, NULL, min_valid_period, scope,
+                       application_hint, audience, callback, arg);
+}
+
+oidcagent_request_t* oidcagent_startTokenRequestForIssuer(
+    const char* socket_path, const char* issuer_url, time_t min_valid_period,
+    const char* scope, const char* application_hint, const char* audience,
+    oidcagent_request_callback callback, void* arg) {
+  return _startRequest(socket_path, NULL, issuer_url, min_valid_period, scope,
+                       application_hint, audience, callback, arg);
+}
+
+int oidcagent_requestFd(const oidcagent_request_t* req) {
+  return req == NULL ? -1 : req->sock;
+}
+
+short oidcagent_requestEvents(const oidcagent_request_t* req) {
+  if (req == NULL) {
+    return 0;
+  }
+  switch (req->state) {
+    case REQUEST_CONNECTING:
+    case REQUEST_SEND_KEY:
+    case REQUEST_SEND_REQUEST: return POLLOUT;
+    default: return POLLIN;
+  }
+}
+
+void oidcagent_cancelRequest(oidcagent_request_t* req) {
+  if (req != NULL) {
+    _secFreeRequest(req);
+  }
+}
+
+/**
+ * @brief writes as much of the pending output as possible
+ * @return @c 1 if all output was written, @c 0 if the socket is full, @c -1
+ * on error
+ */
+static int _writeOutput(oidcagent_request_t* req) {
+  while (req->out_done < req->out_len) {
+    ssize_t n = send(req->sock, req->out + req->out_done,
+                     req->out_len - req->out_done, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return 0;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      oidc_errno = OIDC_EWRITE;
+      return -1;
+    }
+    req->out_done += n;
+  }
+  secFree(req->out);
+  return 1;
+}
+
+/**
+ * @brief reads everything that is available without blocking
+ * @return @c 1 if the agent closed the connection, @c 0 if no more data is
+ * available at the moment, @c -1 on error
+ */
+static int _readInput(oidcagent_request_t* req) {
+  while (1) {
+    if (req->in_size - req->in_len < 2) {
+      req->in_size = req->in_size ? 2 * req->in_size : 256;
+      req->in      = secRealloc(req->in, req->in_size);
+      if (req->in == NULL) {
+        oidc_errno = OIDC_EALLOC;
+        return -1;
+      }
+    }
+    ssize_t n = recv(req->sock, req->in + req->in_len,
+                     req->in_size - req->in_len - 1, 0);
+    if (n == 0) {
+      return 1;
+    }
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return 0;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      oidc_setErrnoError();
+      return -1;
+    }
+    req->in_len += n;
+    req->in[req->in_len] = '\0';
+  }
+}
+
+static int _finish(oidcagent_request_t* req, struct agent_response res) {
+  if (req->use_cache) {
+    tokenCache_update(req->cache_account, req->cache_issuer, req->cache_scope,
+                      req->cache_audience, &res);
+  }
+  oidcagent_request_callback callback = req->callback;
+  void*                      arg      = req->arg;
+  _secFreeRequest(req);
+  callback(res, arg);
+  return OIDCAGENT_REQUEST_DONE;
+}
+
+static int _fail(oidcagent_request_t* req) {
+  return _finish(req, _errorResponse());
+}
+
+static int _finishWithInput(oidcagent_request_t* req) {
+  char* response = req->in;
+  req->in        = NULL;
+  if (response != NULL && req->ipc_key != NULL && !isJSONObject(response)) {
+    char* decrypted = decryptForIpc(response, req->ipc_key);
+    secFree(response);
+    response = decrypted;
+  }
+  return _finish(req, parseForAgentResponse(response));
+}
+
+/**
+ * @brief handles the public key of the agent
+ * @return @c 1 if the key was complete and the request can be sent; @c 0 if
+ * more input is needed; @c -1 on error
+ */
+static int _useServerKey(oidcagent_request_t* req) {
+  if (req->in_len < SERVER_KEY_LEN) {
+    return 0;
+  }
+  unsigned char server_pk[crypto_kx_PUBLICKEYBYTES];
+  if (fromBase64(req->in, crypto_kx_PUBLICKEYBYTES, server_pk) != 0) {
+    oidc_errno = OIDC_ECRYPPUB;
+    return -1;
+  }
+  secFree(req->in);
+  req->in_len = req->in_size = 0;
+  req->ipc_key = generateIpcKey(server_pk, req->keys->sk);
+  secFreePubSecKeySet(req->keys);
+  req->keys = NULL;
+  if (req->ipc_key == NULL) {
+    return -1;
+  }
+  char* encrypted = encryptForIpc(req->request, req->ipc_key);
+  if (encrypted == NULL) {
+    return -1;
+  }
+  _setOutput(req, encrypted);
+  return 1;
+}
+
+int oidcagent_requestStep(oidcagent_request_t* req) {
+  if (req == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return OIDCAGENT_REQUEST_DONE;
+  }
+  START_APILOGLEVEL
+  int ret = OIDCAGENT_REQUEST_PENDING;
+  int done;
+  switch (req->state) {
+    case REQUEST_CACHED: {
+      struct agent_response res = req->cached;
+      req->state                = REQUEST_RECV_RESPONSE;
+      ret                       = _finish(req, res);
+      break;
+    }
+    case REQUEST_CONNECTING: {
+      int       err = 0;
+      socklen_t len = sizeof(err);
+      if (getsockopt(req->sock, SOL_SOCKET, SO_ERROR, &err, &len) != 0 ||
+          err != 0) {
+        oidc_errno = OIDC_ECONSOCK;
+        ret        = _fail(req);
+        break;
+      }
+      req->state = REQUEST_SEND_KEY;
+    }
+      // fall through
+    case REQUEST_SEND_KEY:
+      if ((done = _writeOutput(req)) < 0) {
+        ret = _fail(req);
+        break;
+      }
+      if (done == 0) {
+        break;
+      }
+      req->state = REQUEST_RECV_KEY;
+      // The key of the agent is not there yet, wait for the next step
+      break;
+    case REQUEST_RECV_KEY:
+      if ((done = _readInput(req)) < 0) {
+        ret = _fail(req);
+        break;
+      }
+      if (req->in_len > 0 && req->in[0] == '{') {
+        // The agent answered in plain text, e.g. with an error; it closes the
+        // connection after that
+        req->state = REQUEST_RECV_RESPONSE;
+        if (done) {
+          ret = _finishWithInput(req);
+        }
+        break;
+      }
+      int closed = done;
+      if ((done = _useServerKey(req)) < 0) {
+        ret = _fail(req);
+        break;
+      }
+      if (done == 0) {
+        if (closed) {
+          oidc_errno = OIDC_EIPCDIS;
+          ret        = _fail(req);
+        }
+        break;
+      }
+      req->state = REQUEST_SEND_REQUEST;
+      // fall through
+    case REQUEST_SEND_REQUEST:
+      if ((done = _writeOutput(req)) < 0) {
+        ret = _fail(req);
+        break;
+      }
+      if (done) {
+        req->state = REQUEST_RECV_RESPONSE;
+      }
+      break;
+    case REQUEST_RECV_RESPONSE:
+      if ((done = _readInput(req)) < 0) {
+        ret = _fail(req);
+      } else if (done) {
+        ret = _finishWithInput(req);
+      }
+      break;
+  }
+  END_APILOGLEVEL
+  return ret;
+}
+
+#else
+
+#include "utils/oidc_error.h"
+
+static oidcagent_request_t* _notSupported() {
+  oidc_errno = OIDC_NOTIMPL;
+  return NULL;
+}
+
+oidcagent_request_t* oidcagent_startTokenRequest(
+    const char* socket_path, const char* accountname, time_t min_valid_period,
+    const char* scope, const char* application_hint, const char* audience,
+    oidcagent_request_callback callback, void* arg) {
+  return _notSupported();
+}
+
+oidcagent_request_t* oidcagent_startTokenRequestForIssuer(
+    const char* socket_path, const char* issuer_url, time_t min_valid_period,
+    const char* scope, const char* application_hint, const char* audience,
+    oidcagent_request_callback callback, void* arg) {
+  return _notSupported();
+}
+
+int   oidcagent_requestFd(const oidcagent_request_t* req) { return -1; }
+short oidcagent_requestEvents(const oidcagent_request_t* req) { return 0; }
+int   oidcagent_requestStep(oidcagent_request_t* req) {
+  return OIDCAGENT_REQUEST_DONE;
+}
+void oidcagent_cancelRequest(oidcagent_request_t* req) {}
+
+#endif
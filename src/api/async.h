@@ -0,0 +1,89 @@
+#ifndef OIDC_AGENT_API_ASYNC_H
+#define OIDC_AGENT_API_ASYNC_H
+
+#include <time.h>
+
+#include "export_symbols.h"
+#include "response.h"
+
+/**
+ * An asynchronous request to the agent. It does not block the calling thread
+ * and can be integrated into any event loop: wait until the file descriptor
+ * returned by @c oidcagent_requestFd is ready for the events returned by
+ * @c oidcagent_requestEvents and then call @c oidcagent_requestStep. When the
+ * request is finished the callback is called with the response. A token from
+ * the in-process token cache (see @c oidcagent_enableTokenCache) is delivered
+ * the same way, without connecting to the agent.
+ */
+typedef struct oidcagent_request oidcagent_request_t;
+
+/**
+ * @brief is called once an asynchronous request is finished
+ * @param response the response of the agent or an @c agent_error_response.
+ * Has to be freed after usage using the @c secFreeAgentResponse function.
+ * @param arg the argument passed when the request was started
+ */
+typedef void (*oidcagent_request_callback)(struct agent_response response,
+                                           void*                 arg);
+
+#define OIDCAGENT_REQUEST_DONE 0
+#define OIDCAGENT_REQUEST_PENDING 1
+
+/**
+ * @brief starts an asynchronous request for an access token for an account
+ * config; the parameters are the same as for @c getAgentTokenResponse
+ * @param socket_path the path of the agent socket; if @c NULL the value of the
+ * @c OIDC_SOCK environment variable is used
+ * @param callback the function that is called with the response
+ * @param arg passed to @p callback
+ * @return the request or @c NULL if it could not be started; in that case the
+ * callback is not called and @c oidcagent_serror describes the error
+ */
+LIB_PUBLIC oidcagent_request_t* oidcagent_startTokenRequest(
+    const char* socket_path, const char* accountname, time_t min_valid_period,
+    const char* scope, const char* application_hint, const char* audience,
+    oidcagent_request_callback callback, void* arg);
+
+/**
+ * @brief starts an asynchronous request for an access token for a specific
+ * provider; the parameters are the same as for
+ * @c getAgentTokenResponseForIssuer
+ * @param socket_path the path of the agent socket; if @c NULL the value of the
+ * @c OIDC_SOCK environment variable is used
+ * @param callback the function that is called with the response
+ * @param arg passed to @p callback
+ * @return the request or @c NULL if it could not be started; in that case the
+ * callback is not called and @c oidcagent_serror describes the error
+ */
+LIB_PUBLIC oidcagent_request_t* oidcagent_startTokenRequestForIssuer(
+    const char* socket_path, const char* issuer_url, time_t min_valid_period,
+    const char* scope, const char* application_hint, const char* audience,
+    oidcagent_request_callback callback, void* arg);
+
+/**
+ * @brief returns the file descriptor a request waits on
+ * @note the file descriptor stays the same for the whole request
+ */
+LIB_PUBLIC int oidcagent_requestFd(const oidcagent_request_t* req);
+
+/**
+ * @brief returns the events a request waits for
+ * @return @c POLLIN or @c POLLOUT
+ */
+LIB_PUBLIC short oidcagent_requestEvents(const oidcagent_request_t* req);
+
+/**
+ * @brief advances a request as far as possible without blocking
+ * @return @c OIDCAGENT_REQUEST_PENDING if the request waits for its file
+ * descriptor again; @c OIDCAGENT_REQUEST_DONE if the request is finished. In
+ * that case the callback was called, the file descriptor is closed and @p req
+ * is freed and must not be used anymore.
+ */
+LIB_PUBLIC int oidcagent_requestStep(oidcagent_request_t* req);
+
+/**
+ * @brief aborts a request without calling its callback and frees it
+ */
+LIB_PUBLIC void oidcagent_cancelRequest(oidcagent_request_t* req);
+
+#endif  // OIDC_AGENT_API_ASYNC_H
@@ -11,6 +11,7 @@ char* communicate(unsigned char remote, const char* fmt, ...) {
   START_APILOGLEVEL
   if (fmt == NULL) {
     oidc_setArgNullFuncError(__func__);
+    END_APILOGLEVEL
     return NULL;
   }
   va_list args;
@@ -0,0 +1,109 @@
+#include "context.h"
+
+#include <stdlib.h>
+
+#include "api_helper.h"
+#include "comm.h"
+#include "defines/msys.h"
+#include "defines/settings.h"
+#include "ipc/cryptCommunicator.h"
+#include "token_cache.h"
+#include "tokens.h"
+#include "tokens_internal.h"
+#include "utils/memory.h"
+#include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
+
+struct oidcagent_context {
+  char*         socket_path;
+  unsigned char use_cache;
+  char*         error;
+};
+
+oidcagent_context_t* oidcagent_newContext(const char* socket_path) {
+  char* path = oidc_strcopy(socket_path ?: getenv(OIDC_SOCK_ENV_NAME));
+#ifndef MINGW
+  if (path == NULL) {
+    oidc_errno = OIDC_EENVVAR;
+    oidc_seterror("Could not get the socket path from env var "
+                  "'" OIDC_SOCK_ENV_NAME "'. Have you set the env var?");
+    return NULL;
+  }
+#endif
+  oidcagent_context_t* ctx = secAlloc(sizeof(oidcagent_context_t));
+  ctx->socket_path         = path;
+  // The process wide token cache does not know about other agents
+  ctx->use_cache = socket_path == NULL;
+  return ctx;
+}
+
+void oidcagent_freeContext(oidcagent_context_t* ctx) {
+  if (ctx == NULL) {
+    return;
+  }
+  secFree(ctx->socket_path);
+  secFree(ctx->error);
+  secFree(ctx);
+}
+
+const char* oidcagent_ctx_serror(const oidcagent_context_t* ctx) {
+  return ctx == NULL ? NULL : ctx->error;
+}
+
+static void _ctxSaveError(oidcagent_context_t* ctx) {
+  secFree(ctx->error);
+  if (oidc_errno != OIDC_SUCCESS) {
+    ctx->error = oidc_strcopy(oidc_serror());
+  }
+}
+
+static char* _ctxCommunicate(const oidcagent_context_t* ctx,
+                             const char*                request) {
+#ifdef MINGW
+  return communicate(LOCAL_COMM, "%s", request);
+#else
+  return ipc_cryptCommunicateWithPath(ctx->socket_path, "%s", request);
+#endif
+}
+
+static struct agent_response _ctxGetAgentTokenResponse(
+    oidcagent_context_t* ctx, const char* accountname, const char* issuer,
+    time_t min_valid_period, const char* scope, const char* application_hint,
+    const char* audience) {
+  struct agent_response res;
+  if (ctx == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return _errorResponse();
+  }
+  if (ctx->use_cache && tokenCache_get(accountname, issuer, min_valid_period,
+                                       scope, audience, &res)) {
+    _ctxSaveError(ctx);
+    return res;
+  }
+  START_APILOGLEVEL
+  char* request =
+      _getAccessTokenRequest(accountname, issuer, min_valid_period, 0, scope,
+                             application_hint, audience);
+  res = parseForAgentResponse(_ctxCommunicate(ctx, request));
+  secFree(request);
+  if (ctx->use_cache) {
+    tokenCache_update(accountname, issuer, scope, audience, &res);
+  }
+  _ctxSaveError(ctx);
+  END_APILOGLEVEL
+  return res;
+}
+
+struct agent_response oidcagent_ctx_getAgentTokenResponse(
+    oidcagent_context_t* ctx, const char* accountname, time_t min_valid_period,
+    const char* scope, const char* application_hint, const char* audience) {
+  return _ctxGetAgentTokenResponse(ctx, accountname, NULL, min_valid_period,
+                                   scope, application_hint, audience);
+}
+
+struct agent_response oidcagent_ctx_getAgentTokenResponseForIssuer(
+    oidcagent_context_t* ctx, const char* issuer_url, time_t min_valid_period,
+    const char* scope, const char* application_hint, const char* audience) {
+  return _ctxGetAgentTokenResponse(ctx, NULL, issuer_url, min_valid_period,
+                                   scope, application_hint, audience);
+}
@@ -0,0 +1,67 @@
+#ifndef OIDC_AGENT_API_CONTEXT_H
+#define OIDC_AGENT_API_CONTEXT_H
+
+#include <time.h>
+
+#include "export_symbols.h"
+#include "response.h"
+
+/**
+ * A context bundles the connection settings and the error state of a sequence
+ * of library calls. Threads that use their own context can request tokens in
+ * parallel without any locking. A single context must not be used by several
+ * threads at the same time.
+ */
+typedef struct oidcagent_context oidcagent_context_t;
+
+/**
+ * @brief creates a new context
+ * @param socket_path the path of the agent socket; if @c NULL the value of the
+ * @c OIDC_SOCK environment variable at the time of this call is used
+ * @return a pointer to the new context or @c NULL on failure. Has to be freed
+ * after usage using the @c oidcagent_freeContext function.
+ */
+LIB_PUBLIC oidcagent_context_t* oidcagent_newContext(const char* socket_path);
+
+/**
+ * @brief frees a context
+ * @param ctx the context to be freed
+ */
+LIB_PUBLIC void oidcagent_freeContext(oidcagent_context_t* ctx);
+
+/**
+ * @brief gets a valid access token for an account config as well as related
+ * information; like @c getAgentTokenResponse but uses the agent of @p ctx
+ * @param ctx the context to be used
+ * @return an agent_response struct containing the access token, issuer_url, and
+ * expiration time in the @c token_response or an @c agent_error_response.
+ * Has to be freed after usage using the @c secFreeAgentResponse function.
+ * @note remote agents are not contacted
+ */
+LIB_PUBLIC struct agent_response oidcagent_ctx_getAgentTokenResponse(
+    oidcagent_context_t* ctx, const char* accountname, time_t min_valid_period,
+    const char* scope, const char* application_hint, const char* audience);
+
+/**
+ * @brief gets a valid access token for a specific provider as well as related
+ * information; like @c getAgentTokenResponseForIssuer but uses the agent of
+ * @p ctx
+ * @param ctx the context to be used
+ * @return an agent_response struct containing the access token, issuer_url, and
+ * expiration time in the @c token_response or an @c agent_error_response.
+ * Has to be freed after usage using the @c secFreeAgentResponse function.
+ * @note remote agents are not contacted
+ */
+LIB_PUBLIC struct agent_response oidcagent_ctx_getAgentTokenResponseForIssuer(
+    oidcagent_context_t* ctx, const char* issuer_url, time_t min_valid_period,
+    const char* scope, const char* application_hint, const char* audience);
+
+/**
+ * @brief gets an error string detailing the last error that occurred in a call
+ * using @p ctx
+ * @return the error string or @c NULL if the last call succeeded. MUST NOT be
+ * freed; it is valid until the next call using @p ctx.
+ */
+LIB_PUBLIC const char* oidcagent_ctx_serror(const oidcagent_context_t* ctx);
+
+#endif  // OIDC_AGENT_API_CONTEXT_H
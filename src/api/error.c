@@ -2,6 +2,8 @@
 
 #include "utils/oidc_error.h"
 
+int oidcagent_errno() { return oidc_errno; }
+
 char* oidcagent_serror() { return oidc_serror(); }
 
 void oidcagent_perror() { oidc_perror(); }
@@ -3,6 +3,13 @@
 
 #include "export_symbols.h"
 
+/**
+ * @brief gets the error code of the last error that occurred in the calling
+ * thread
+ * @return the error code, @c OIDC_SUCCESS if there was no error
+ */
+LIB_PUBLIC int oidcagent_errno();
+
 /**
  * @brief gets an error string detailing the last occurred error
  * @return the error string. MUST NOT be freed.
@@ -134,6 +134,7 @@ char* getMytoken(const char* accountname, const char* mytoken_profile,
       oidc_seterror(response.error_response.error);
     }
     secFreeAgentResponse(response);
+    END_APILOGLEVEL
     return NULL;
   }
   char* mytoken = oidc_strcopy(response.mytoken_response.token);
@@ -0,0 +1,172 @@
+#include "token_cache.h"
+
+#include <pthread.h>
+
+#include "tokens.h"
+#include "utils/hashmap.h"
+#include "utils/listUtils.h"
+#include "utils/memory.h"
+#include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
+
+/**
+ * In-process cache for access tokens obtained from the agent. It is disabled
+ * by default and enabled with @c oidcagent_enableTokenCache. Entries are keyed
+ * by account (or issuer), scope and audience and store the expiration time, so
+ * one entry serves requests with any @c min_valid_period it still satisfies.
+ * When the cache is full, expired entries and then the least recently used
+ * entry are evicted. All access is serialized through @c cache_lock.
+ */
+struct cached_token {
+  char*         token;
+  char*         issuer;
+  time_t        expires_at;
+  unsigned long last_used;  // value of use_clock at the last hit or update
+};
+
+static pthread_mutex_t cache_lock    = PTHREAD_MUTEX_INITIALIZER;
+static hashmap_t*      cache         = NULL;
+static unsigned char   cache_enabled = 0;
+static unsigned long   use_clock     = 0;
+
+static void _secFreeCachedToken(void* p) {
+  struct cached_token* t = p;
+  secFree(t->token);
+  secFree(t->issuer);
+  secFree(t);
+}
+
+static char* _cacheKey(const char* accountname, const char* issuer,
+                       const char* scope, const char* audience) {
+  return oidc_sprintf("%c\n%s\n%s\n%s", accountname ? 'a' : 'i',
+                      accountname ?: issuer ?: "", scope ?: "",
+                      audience ?: "");
+}
+
+struct prune_state {
+  list_t*       expired;
+  time_t        now;
+  const char*   lru_key;
+  unsigned long lru_used;
+};
+
+static void _collectExpired(const char* key, void* value, void* arg) {
+  const struct cached_token* t     = value;
+  struct prune_state*        state = arg;
+  if (t->expires_at <= state->now) {
+    list_rpush(state->expired, list_node_new(oidc_strcopy(key)));
+  } else if (state->lru_key == NULL || t->last_used < state->lru_used) {
+    state->lru_key  = key;
+    state->lru_used = t->last_used;
+  }
+}
+
+/**
+ * @brief makes room for one entry: removes all expired entries or, if there
+ * are none, the least recently used one
+ */
+static void _pruneCache() {
+  struct prune_state state = {.expired = list_new(), .now = time(NULL)};
+  state.expired->free      = _secFree;
+  hashmap_foreach(cache, _collectExpired, &state);
+  if (state.expired->len == 0 && state.lru_key != NULL) {
+    _secFreeCachedToken(hashmap_remove(cache, state.lru_key));
+  }
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(state.expired, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    _secFreeCachedToken(hashmap_remove(cache, node->val));
+  }
+  list_iterator_destroy(it);
+  secFreeList(state.expired);
+}
+
+/**
+ * @brief looks up a cached access token
+ * @param res is filled with a copy of the cached token on a hit
+ * @return @c 1 if a token was found that is valid for more than
+ * @p min_valid_period seconds; @c 0 otherwise
+ */
+int tokenCache_get(const char* accountname, const char* issuer,
+                   time_t min_valid_period, const char* scope,
+                   const char* audience, struct agent_response* res) {
+  if (min_valid_period < 0) {  // FORCE_NEW_TOKEN
+    return 0;
+  }
+  int hit = 0;
+  pthread_mutex_lock(&cache_lock);
+  if (cache_enabled && cache != NULL) {
+    char*                key = _cacheKey(accountname, issuer, scope, audience);
+    struct cached_token* t   = hashmap_get(cache, key);
+    time_t               now = time(NULL);
+    if (t != NULL && t->expires_at - now > min_valid_period) {
+      res->type           = AGENT_RESPONSE_TYPE_TOKEN;
+      res->token_response = (struct token_response){
+          oidc_strcopy(t->token), oidc_strcopy(t->issuer), t->expires_at};
+      t->last_used = ++use_clock;
+      hit          = 1;
+    } else if (t != NULL && t->expires_at <= now) {
+      _secFreeCachedToken(hashmap_remove(cache, key));
+    }
+    secFree(key);
+  }
+  pthread_mutex_unlock(&cache_lock);
+  if (hit) {
+    oidc_errno = OIDC_SUCCESS;
+  }
+  return hit;
+}
+
+/**
+ * @brief stores a token response from the agent; an error response drops the
+ * cached token for the same request
+ */
+void tokenCache_update(const char* accountname, const char* issuer,
+                       const char* scope, const char* audience,
+                       const struct agent_response* res) {
+  pthread_mutex_lock(&cache_lock);
+  if (!cache_enabled) {
+    pthread_mutex_unlock(&cache_lock);
+    return;
+  }
+  char* key = _cacheKey(accountname, issuer, scope, audience);
+  if (res->type != AGENT_RESPONSE_TYPE_TOKEN ||
+      res->token_response.expires_at <= time(NULL)) {
+    if (cache != NULL) {
+      _secFreeCachedToken(hashmap_remove(cache, key));
+    }
+  } else {
+    if (cache != NULL && hashmap_size(cache) >= TOKEN_CACHE_MAX_ENTRIES &&
+        !hashmap_contains(cache, key)) {
+      _pruneCache();
+    }
+    if (cache == NULL) {
+      cache = hashmap_new(16, _secFreeCachedToken);
+    }
+    struct cached_token* t = secAlloc(sizeof(struct cached_token));
+    t->token               = oidc_strcopy(res->token_response.token);
+    t->issuer              = oidc_strcopy(res->token_response.issuer);
+    t->expires_at          = res->token_response.expires_at;
+    t->last_used           = ++use_clock;
+    hashmap_put(cache, key, t);
+  }
+  secFree(key);
+  pthread_mutex_unlock(&cache_lock);
+}
+
+void oidcagent_enableTokenCache(unsigned char enable) {
+  pthread_mutex_lock(&cache_lock);
+  cache_enabled = enable ? 1 : 0;
+  if (!cache_enabled && cache != NULL) {
+    secFreeHashmap(cache);
+  }
+  pthread_mutex_unlock(&cache_lock);
+}
+
+void oidcagent_clearTokenCache() {
+  pthread_mutex_lock(&cache_lock);
+  if (cache != NULL) {
+    secFreeHashmap(cache);
+  }
+  pthread_mutex_unlock(&cache_lock);
+}
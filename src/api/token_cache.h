@@ -0,0 +1,19 @@
+#ifndef OIDC_AGENT_API_TOKEN_CACHE_H
+#define OIDC_AGENT_API_TOKEN_CACHE_H
+
+#include <time.h>
+
+#include "response.h"
+
+#ifndef TOKEN_CACHE_MAX_ENTRIES
+#define TOKEN_CACHE_MAX_ENTRIES 128
+#endif
+
+int  tokenCache_get(const char* accountname, const char* issuer,
+                    time_t min_valid_period, const char* scope,
+                    const char* audience, struct agent_response* res);
+void tokenCache_update(const char* accountname, const char* issuer,
+                       const char* scope, const char* audience,
+                       const struct agent_response* res);
+
+#endif  // OIDC_AGENT_API_TOKEN_CACHE_H
@@ -1,12 +1,23 @@
 #include "tokens.h"
 
 #include "api_helper.h"
+#include "tokens_internal.h"
 #include "comm.h"
 #include "defines/ipc_values.h"
+#include "token_cache.h"
 #include "utils/errorUtils.h"
 #include "utils/json.h"
+#include "utils/kernelKeyring.h"
 #include "utils/oidc_error.h"
 #include "utils/string/stringUtils.h"
+struct agent_response _errorResponse() {
+  struct agent_response res;
+  res.type           = AGENT_RESPONSE_TYPE_ERROR;
+  res.error_response = (struct agent_error_response){
+      oidc_strcopy(oidc_serror()), NULL};
+  return res;
+}
+
 struct agent_response parseForAgentResponse(char* response) {
   struct agent_response res;
   if (response == NULL) {
@@ -65,12 +76,17 @@ struct token_response parseForTokenResponse(char* response) {
 }
 
 char* _getAccessTokenRequest(const char* accountname, const char* issuer,
-                             time_t min_valid_period, const char* scope,
+                             time_t min_valid_period,
+                             time_t stale_min_valid_period, const char* scope,
                              const char* hint, const char* audience) {
   START_APILOGLEVEL
   cJSON* json = generateJSONObject(IPC_KEY_REQUEST, cJSON_String,
                                    REQUEST_VALUE_ACCESSTOKEN, IPC_KEY_MINVALID,
                                    cJSON_Number, min_valid_period, NULL);
+  if (stale_min_valid_period > 0) {
+    cJSON_AddNumberToObject(json, IPC_KEY_STALEMINVALID,
+                            stale_min_valid_period);
+  }
   if (strValid(accountname)) {
     jsonAddStringValue(json, IPC_KEY_SHORTNAME, accountname);
   } else if (strValid(issuer)) {
@@ -95,14 +111,14 @@ char* _getAccessTokenRequest(const char* accountname, const char* issuer,
 char* getAccessTokenRequest(const char* accountname, time_t min_valid_period,
                             const char* scope, const char* hint,
                             const char* audience) {
-  return _getAccessTokenRequest(accountname, NULL, min_valid_period, scope,
+  return _getAccessTokenRequest(accountname, NULL, min_valid_period, 0, scope,
                                 hint, audience);
 }
 
 char* getAccessTokenRequestIssuer(const char* issuer, time_t min_valid_period,
                                   const char* scope, const char* hint,
                                   const char* audience) {
-  return _getAccessTokenRequest(NULL, issuer, min_valid_period, scope, hint,
+  return _getAccessTokenRequest(NULL, issuer, min_valid_period, 0, scope, hint,
                                 audience);
 }
 
@@ -112,6 +128,37 @@ struct agent_response _getAgentResponseFromRequest(unsigned char remote,
   return parseForAgentResponse(response);
 }
 
+/**
+ * @brief looks up a token that the agent published in the kernel keyring
+ * @return @c 1 if a token was found that is valid for more than
+ * @p min_valid_period seconds; @c 0 otherwise
+ */
+static int _getKernelKeyringToken(const char*            accountname,
+                                  time_t                 min_valid_period,
+                                  const char*            scope,
+                                  const char*            audience,
+                                  struct agent_response* res) {
+  if (min_valid_period < 0 || strValid(audience)) {
+    return 0;
+  }
+  char*  issuer     = NULL;
+  time_t expires_at = 0;
+  char*  token =
+      kernelKeyring_getToken(accountname, scope, &issuer, &expires_at);
+  if (token == NULL) {
+    return 0;
+  }
+  if (expires_at - time(NULL) <= min_valid_period) {
+    secFree(token);
+    secFree(issuer);
+    return 0;
+  }
+  res->type           = AGENT_RESPONSE_TYPE_TOKEN;
+  res->token_response = (struct token_response){token, issuer, expires_at};
+  oidc_errno          = OIDC_SUCCESS;
+  return 1;
+}
+
 struct token_response _agentResponseToTokenResponse(
     struct agent_response agentResponse) {  // lgtm [cpp/large-parameter]
   if (agentResponse.type == AGENT_RESPONSE_TYPE_TOKEN) {
@@ -121,15 +168,23 @@ struct token_response _agentResponseToTokenResponse(
   return (struct token_response){NULL, NULL, 0};
 }
 
-struct agent_response getAgentTokenResponse(const char* accountname,
-                                            time_t      min_valid_period,
-                                            const char* scope,
-                                            const char* application_hint,
-                                            const char* audience) {
+struct agent_response getAgentTokenResponseAllowStale(
+    const char* accountname, time_t min_valid_period,
+    time_t stale_min_valid_period, const char* scope,
+    const char* application_hint, const char* audience) {
+  struct agent_response res;
+  if (tokenCache_get(accountname, NULL, min_valid_period, scope, audience,
+                     &res) ||
+      _getKernelKeyringToken(accountname, min_valid_period, scope, audience,
+                             &res)) {
+    return res;
+  }
   START_APILOGLEVEL
-  char* request = getAccessTokenRequest(accountname, min_valid_period, scope,
-                                        application_hint, audience);
-  struct agent_response res = _getAgentResponseFromRequest(LOCAL_COMM, request);
+  char* request =
+      _getAccessTokenRequest(accountname, NULL, min_valid_period,
+                             stale_min_valid_period, scope, application_hint,
+                             audience);
+  res = _getAgentResponseFromRequest(LOCAL_COMM, request);
   struct oidc_error_state* localError = saveErrorState();
   const unsigned char      remote     = _checkLocalResponseForRemote(res);
   if (remote) {
@@ -145,22 +200,48 @@ struct agent_response getAgentTokenResponse(const char* accountname,
   }
   secFreeErrorState(localError);
   secFree(request);
+  tokenCache_update(accountname, NULL, scope, audience, &res);
   END_APILOGLEVEL
   return res;
 }
 
-struct agent_response getAgentTokenResponseForIssuer(
-    const char* issuer_url, time_t min_valid_period, const char* scope,
+struct agent_response getAgentTokenResponse(const char* accountname,
+                                            time_t      min_valid_period,
+                                            const char* scope,
+                                            const char* application_hint,
+                                            const char* audience) {
+  return getAgentTokenResponseAllowStale(accountname, min_valid_period, 0,
+                                         scope, application_hint, audience);
+}
+
+struct agent_response getAgentTokenResponseForIssuerAllowStale(
+    const char* issuer_url, time_t min_valid_period,
+    time_t stale_min_valid_period, const char* scope,
     const char* application_hint, const char* audience) {
+  struct agent_response res;
+  if (tokenCache_get(NULL, issuer_url, min_valid_period, scope, audience,
+                     &res)) {
+    return res;
+  }
   START_APILOGLEVEL
-  char* request = getAccessTokenRequestIssuer(
-      issuer_url, min_valid_period, scope, application_hint, audience);
-  struct agent_response res = _getAgentResponseFromRequest(LOCAL_COMM, request);
+  char* request =
+      _getAccessTokenRequest(NULL, issuer_url, min_valid_period,
+                             stale_min_valid_period, scope, application_hint,
+                             audience);
+  res = _getAgentResponseFromRequest(LOCAL_COMM, request);
   secFree(request);
+  tokenCache_update(NULL, issuer_url, scope, audience, &res);
   END_APILOGLEVEL
   return res;
 }
 
+struct agent_response getAgentTokenResponseForIssuer(
+    const char* issuer_url, time_t min_valid_period, const char* scope,
+    const char* application_hint, const char* audience) {
+  return getAgentTokenResponseForIssuerAllowStale(
+      issuer_url, min_valid_period, 0, scope, application_hint, audience);
+}
+
 char* getAccessToken(const char* accountname, time_t min_valid_period,
                      const char* scope, const char* application_hint,
                      const char* audience) {
@@ -171,6 +252,7 @@ char* getAccessToken(const char* accountname, time_t min_valid_period,
     oidc_seterror(response.error_response.error);
     oidc_errno = OIDC_EERROR;
     secFreeAgentResponse(response);
+    END_APILOGLEVEL
     return NULL;
   }
   char* at = oidc_strcopy(response.token_response.token);
@@ -189,6 +271,7 @@ char* getAccessTokenForIssuer(const char* issuer_url, time_t min_valid_period,
     oidc_seterror(response.error_response.error);
     oidc_errno = OIDC_EERROR;
     secFreeAgentResponse(response);
+    END_APILOGLEVEL
     return NULL;
   }
   char* at = oidc_strcopy(response.token_response.token);
@@ -52,6 +52,64 @@ LIB_PUBLIC struct agent_response getAgentTokenResponseForIssuer(
     const char* issuer_url, time_t min_valid_period, const char* scope,
     const char* application_hint, const char* audience);
 
+/**
+ * @brief gets a valid access token for an account config as well as related
+ * information; allows the agent to return a token that is valid for less than
+ * @p min_valid_period while it obtains a new one in the background
+ * @param accountname the short name of the account config for which an access
+ * token should be returned
+ * @param min_valid_period the minium period of time the access token should be
+ * valid in seconds
+ * @param stale_min_valid_period the minimum period of time in seconds a token
+ * must be valid, if it is returned while a new one is obtained in the
+ * background. The agent enforces its own lower bound. @c 0 disables this.
+ * @param scope a space delimited list of scope values for the to be issued
+ * access token. @c NULL if default value for that account configuration should
+ * be used.
+ * @param application_hint a hint indicating what application requests the
+ * access token. This string might be displayed to the user.
+ * @param audience Use this parameter to request an access token with this
+ * specific audience. Can be a space separated list. @c NULL if no special
+ * audience should be requested.
+ * @return an agent_response struct containing the access token, issuer_url, and
+ * expiration time in the @c token_response or an @c agent_error_response.
+ * Has to be freed after usage using the @c secFreeAgentResponse function.
+ * @note a token is only returned early if no @p scope and @p audience are
+ * requested
+ */
+LIB_PUBLIC struct agent_response getAgentTokenResponseAllowStale(
+    const char* accountname, time_t min_valid_period,
+    time_t stale_min_valid_period, const char* scope,
+    const char* application_hint, const char* audience);
+
+/**
+ * @brief gets a valid access token for a specific provider as well as related
+ * information; allows the agent to return a token that is valid for less than
+ * @p min_valid_period while it obtains a new one in the background
+ * @param issuer_url the issuer url of the provider for which an access token
+ * should be returned
+ * @param min_valid_period the minium period of time the access token should be
+ * valid in seconds
+ * @param stale_min_valid_period the minimum period of time in seconds a token
+ * must be valid, if it is returned while a new one is obtained in the
+ * background. The agent enforces its own lower bound. @c 0 disables this.
+ * @param scope a space delimited list of scope values for the to be issued
+ * access token. @c NULL if default value for the used account configuration
+ * should be used.
+ * @param application_hint a hint indicating what application requests the
+ * access token. This string might be displayed to the user.
+ * @param audience Use this parameter to request an access token with this
+ * specific audience. Can be a space separated list. @c NULL if no special
+ * audience should be requested.
+ * @return an agent_response struct containing the access token, issuer_url, and
+ * expiration time in the @c token_response or an @c agent_error_response.
+ * Has to be freed after usage using the @c secFreeAgentResponse function.
+ */
+LIB_PUBLIC struct agent_response getAgentTokenResponseForIssuerAllowStale(
+    const char* issuer_url, time_t min_valid_period,
+    time_t stale_min_valid_period, const char* scope,
+    const char* application_hint, const char* audience);
+
 /**
  * @brief gets a valid access token for an account config
  * @param accountname the short name of the account config for which an access
@@ -97,4 +155,21 @@ LIB_PUBLIC char* getAccessTokenForIssuer(const char* issuer_url,
                                          const char* application_hint,
                                          const char* audience);
 
+/**
+ * @brief enables or disables the in-process token cache
+ * When enabled, access tokens obtained through the functions of this header
+ * are kept in the process and returned without contacting the agent as long
+ * as they are valid for the requested @c min_valid_period. The cache is
+ * disabled by default; disabling it drops all cached tokens.
+ * @param enable @c 1 to enable the cache, @c 0 to disable it
+ * @note the cache is shared by all threads of the process
+ */
+LIB_PUBLIC void oidcagent_enableTokenCache(unsigned char enable);
+
+/**
+ * @brief drops all tokens from the in-process token cache, e.g. after the
+ * application found that a token was revoked
+ */
+LIB_PUBLIC void oidcagent_clearTokenCache();
+
 #endif  // OIDC_TOKEN_API_TOKENS_H
@@ -0,0 +1,23 @@
+#ifndef OIDC_TOKEN_API_TOKENS_INTERNAL_H
+#define OIDC_TOKEN_API_TOKENS_INTERNAL_H
+
+#include <time.h>
+
+#include "response.h"
+
+// Not part of the public api; shared by the token functions, the contexts,
+// async requests and token watches.
+
+char* _getAccessTokenRequest(const char* accountname, const char* issuer,
+                             time_t min_valid_period,
+                             time_t stale_min_valid_period, const char* scope,
+                             const char* hint, const char* audience);
+struct agent_response parseForAgentResponse(char* response);
+
+/**
+ * @brief creates an error response from the current oidc error
+ * @return the error response; has to be freed after usage
+ */
+struct agent_response _errorResponse();
+
+#endif  // OIDC_TOKEN_API_TOKENS_INTERNAL_H
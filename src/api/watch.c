@@ -0,0 +1,216 @@
+#include "watch.h"
+
+#include "defines/msys.h"
+
+#ifndef MINGW
+#include "api_helper.h"
+#include "defines/ipc_values.h"
+#include "ipc/cryptIpc.h"
+#include "ipc/ipc.h"
+#include "tokens.h"
+#include "tokens_internal.h"
+#include "utils/crypt/ipcCryptUtils.h"
+#include "utils/json.h"
+#include "utils/memory.h"
+#include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
+
+/**
+ * The agent answers the watch request and sends every new token as a single
+ * newline terminated message, encrypted with the key negotiated for the
+ * request.
+ */
+struct oidcagent_watch {
+  struct connection     con;
+  unsigned char*        ipc_key;
+  struct agent_response first;
+  unsigned char         first_pending;
+  unsigned char         closed;
+};
+
+static char* _readMessage(oidcagent_watch_t* watch) {
+  char* line = ipc_readLine(*(watch->con.sock));
+  if (line == NULL || isJSONObject(line)) {
+    return line;
+  }
+  char* decrypted = decryptForIpc(line, watch->ipc_key);
+  secFree(line);
+  return decrypted;
+}
+
+static void _secFreeWatch(oidcagent_watch_t* watch) {
+  ipc_closeConnection(&watch->con);
+  secFree(watch->ipc_key);
+  if (watch->first_pending) {
+    secFreeAgentResponse(watch->first);
+  }
+  secFree(watch);
+}
+
+static oidcagent_watch_t* _startWatch(const char* accountname,
+                                      const char* issuer,
+                                      time_t      min_valid_period,
+                                      const char* scope, const char* hint,
+                                      const char* audience) {
+  struct agent_response first =
+      strValid(accountname)
+          ? getAgentTokenResponse(accountname, min_valid_period, scope, hint,
+                                  audience)
+          : getAgentTokenResponseForIssuer(issuer, min_valid_period, scope,
+                                           hint, audience);
+  if (first.type != AGENT_RESPONSE_TYPE_TOKEN) {
+    secFreeAgentResponse(first);
+    return NULL;
+  }
+  START_APILOGLEVEL
+  oidcagent_watch_t* watch = secAlloc(sizeof(oidcagent_watch_t));
+  watch->first             = first;
+  watch->first_pending     = 1;
+  if (ipc_client_init(&watch->con, 0) != OIDC_SUCCESS ||
+      ipc_connect(watch->con) != OIDC_SUCCESS) {
+    _secFreeWatch(watch);
+    END_APILOGLEVEL
+    return NULL;
+  }
+  watch->ipc_key = client_keyExchange(*(watch->con.sock));
+  if (watch->ipc_key == NULL) {
+    _secFreeWatch(watch);
+    END_APILOGLEVEL
+    return NULL;
+  }
+  char* request = _getAccessTokenRequest(accountname, issuer, min_valid_period,
+                                         0, scope, hint, audience);
+  // Same parameters as an access token request and the expiration of the
+  // token we already have
+  cJSON* json = stringToJson(request);
+  secFree(request);
+  setJSONValue(json, IPC_KEY_REQUEST, REQUEST_VALUE_WATCH);
+  jsonAddNumberValue(json, AGENT_KEY_EXPIRESAT,
+                     first.token_response.expires_at);
+  request = jsonToStringUnformatted(json);
+  secFreeJson(json);
+  oidc_error_t e =
+      ipc_cryptWrite(*(watch->con.sock), watch->ipc_key, "%s", request);
+  secFree(request);
+  if (e != OIDC_SUCCESS) {
+    _secFreeWatch(watch);
+    END_APILOGLEVEL
+    return NULL;
+  }
+  char* res    = _readMessage(watch);
+  char* status = res ? getJSONValueFromString(res, IPC_KEY_STATUS) : NULL;
+  if (!strequal(status, STATUS_SUCCESS)) {
+    if (res != NULL) {  // sets the error of the agent
+      secFreeAgentResponse(parseForAgentResponse(res));
+    }
+    secFree(status);
+    _secFreeWatch(watch);
+    END_APILOGLEVEL
+    return NULL;
+  }
+  secFree(status);
+  secFree(res);
+  END_APILOGLEVEL
+  return watch;
+}
+
+oidcagent_watch_t* oidcagent_startWatch(const char* accountname,
+                                        time_t      min_valid_period,
+                                        const char* scope,
+                                        const char* application_hint,
+                                        const char* audience) {
+  if (accountname == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return NULL;
+  }
+  return _startWatch(accountname, NULL, min_valid_period, scope,
+                     application_hint, audience);
+}
+
+oidcagent_watch_t* oidcagent_startWatchForIssuer(const char* issuer_url,
+                                                 time_t      min_valid_period,
+                                                 const char* scope,
+                                                 const char* application_hint,
+                                                 const char* audience) {
+  if (issuer_url == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return NULL;
+  }
+  return _startWatch(NULL, issuer_url, min_valid_period, scope,
+                     application_hint, audience);
+}
+
+int oidcagent_watchFd(const oidcagent_watch_t* watch) {
+  return watch == NULL ? -1 : *(watch->con.sock);
+}
+
+struct agent_response oidcagent_watchNext(oidcagent_watch_t* watch) {
+  if (watch == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return _errorResponse();
+  }
+  if (watch->first_pending) {
+    watch->first_pending = 0;
+    return watch->first;
+  }
+  if (watch->closed) {
+    oidc_errno = OIDC_EIPCDIS;
+    return _errorResponse();
+  }
+  START_APILOGLEVEL
+  char* res = _readMessage(watch);
+  END_APILOGLEVEL
+  if (res == NULL) {
+    watch->closed = 1;
+    return _errorResponse();
+  }
+  return parseForAgentResponse(res);
+}
+
+int oidcagent_watchClosed(const oidcagent_watch_t* watch) {
+  return watch == NULL || watch->closed;
+}
+
+void oidcagent_stopWatch(oidcagent_watch_t* watch) {
+  if (watch != NULL) {
+    _secFreeWatch(watch);
+  }
+}
+
+#else
+
+#include "utils/oidc_error.h"
+
+oidcagent_watch_t* oidcagent_startWatch(const char* accountname,
+                                        time_t      min_valid_period,
+                                        const char* scope,
+                                        const char* application_hint,
+                                        const char* audience) {
+  oidc_errno = OIDC_NOTIMPL;
+  return NULL;
+}
+
+oidcagent_watch_t* oidcagent_startWatchForIssuer(const char* issuer_url,
+                                                 time_t      min_valid_period,
+                                                 const char* scope,
+                                                 const char* application_hint,
+                                                 const char* audience) {
+  oidc_errno = OIDC_NOTIMPL;
+  return NULL;
+}
+
+int oidcagent_watchFd(const oidcagent_watch_t* watch) { return -1; }
+int oidcagent_watchClosed(const oidcagent_watch_t* watch) { return 1; }
+
+struct agent_response oidcagent_watchNext(oidcagent_watch_t* watch) {
+  oidc_errno = OIDC_NOTIMPL;
+  struct agent_response res;
+  res.type           = AGENT_RESPONSE_TYPE_ERROR;
+  res.error_response = (struct agent_error_response){
+      oidc_strcopy(oidc_serror()), NULL};
+  return res;
+}
+
+void oidcagent_stopWatch(oidcagent_watch_t* watch) {}
+
+#endif
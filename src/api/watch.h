@@ -0,0 +1,69 @@
+#ifndef OIDC_AGENT_API_WATCH_H
+#define OIDC_AGENT_API_WATCH_H
+
+#include <time.h>
+
+#include "export_symbols.h"
+#include "response.h"
+
+/**
+ * A subscription to the access tokens of an account. The agent keeps the
+ * connection open and sends a new access token shortly before the previous
+ * one is valid for less than the requested minimum period, so a long-running
+ * service always has a valid token without polling the agent.
+ */
+typedef struct oidcagent_watch oidcagent_watch_t;
+
+/**
+ * @brief subscribes to the access tokens of an account config; the
+ * parameters are the same as for @c getAgentTokenResponse
+ * @note the first token is requested like with @c getAgentTokenResponse, so
+ * the user might be prompted, e.g. to load the account. Later tokens are
+ * obtained by the agent without any user interaction; if that is not possible
+ * an error is delivered instead and the agent tries again later.
+ * @return the subscription or @c NULL on failure; in that case
+ * @c oidcagent_serror describes the error
+ */
+LIB_PUBLIC oidcagent_watch_t* oidcagent_startWatch(
+    const char* accountname, time_t min_valid_period, const char* scope,
+    const char* application_hint, const char* audience);
+
+/**
+ * @brief subscribes to the access tokens of a specific provider; the
+ * parameters are the same as for @c getAgentTokenResponseForIssuer
+ * @return the subscription or @c NULL on failure; in that case
+ * @c oidcagent_serror describes the error
+ */
+LIB_PUBLIC oidcagent_watch_t* oidcagent_startWatchForIssuer(
+    const char* issuer_url, time_t min_valid_period, const char* scope,
+    const char* application_hint, const char* audience);
+
+/**
+ * @brief returns the file descriptor of a subscription; it becomes readable
+ * when the agent sent a new token, so it can be added to an event loop
+ */
+LIB_PUBLIC int oidcagent_watchFd(const oidcagent_watch_t* watch);
+
+/**
+ * @brief waits for the next token of a subscription
+ * @note the first call returns the token that was obtained when the
+ * subscription was started
+ * @return an agent_response struct containing the new access token or an
+ * @c agent_error_response. Has to be freed after usage using the
+ * @c secFreeAgentResponse function.
+ */
+LIB_PUBLIC struct agent_response oidcagent_watchNext(oidcagent_watch_t* watch);
+
+/**
+ * @brief tells if the connection to the agent was lost; in that case
+ * @c oidcagent_watchNext only returns errors and the subscription should be
+ * stopped
+ */
+LIB_PUBLIC int oidcagent_watchClosed(const oidcagent_watch_t* watch);
+
+/**
+ * @brief ends a subscription and frees it
+ */
+LIB_PUBLIC void oidcagent_stopWatch(oidcagent_watch_t* watch);
+
+#endif  // OIDC_AGENT_API_WATCH_H
@@ -50,8 +50,25 @@
 #define CONFIG_KEY_STATSCOLLECTSHARE "stats_collect_share"
 #define CONFIG_KEY_STATSCOLLECTLOCATION "stats_collect_location"
 #define CONFIG_KEY_LEGACYAUDMODE "legacy_aud_mode"
+#define CONFIG_KEY_HTTPDNSCACHETTL "http_dns_cache_ttl"
+#define CONFIG_KEY_HTTPCONNMAXIDLE "http_connection_max_idle"
+#define CONFIG_KEY_STALETOKENMINVALID "stale_token_min_valid_period"
+#define CONFIG_KEY_KERNELKEYRING "kernel_keyring"
+#define CONFIG_KEY_MAXLOADEDACCOUNTS "max_loaded_accounts"
+#define CONFIG_KEY_MAXLOADEDACCOUNTSBYTES "max_loaded_accounts_bytes"
+#define CONFIG_KEY_STATESNAPSHOT "state_snapshot"
+#define CONFIG_KEY_STATESNAPSHOTINTERVAL "state_snapshot_interval"
+#define CONFIG_KEY_STATESNAPSHOTKEYCMD "state_snapshot_key_cmd"
 
 #define ACCOUNTINFO_KEY_HASPUBCLIENT "pubclient"
+#define ACCOUNTINDEX_KEY_MTIME "mtime"
+
+#define SNAPSHOT_KEY_METADATA "metadata"
+#define SNAPSHOT_KEY_CODECHALLENGEMETHOD "code_challenge_method"
+#define SNAPSHOT_KEY_DEATH "death"
+#define SNAPSHOT_KEY_LASTUSED "last_used"
+#define SNAPSHOT_KEY_CREATED "created"
+#define SNAPSHOT_KEY_PASSWORDS "passwords"
 
 // INTERNAL / CLI FLOW VALUES
 #define FLOW_VALUE_CODE "code"
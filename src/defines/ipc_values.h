@@ -20,9 +20,11 @@
 #define IPC_KEY_FLOW "flow"
 #define IPC_KEY_APPLICATIONHINT "application_hint"
 #define IPC_KEY_MINVALID "min_valid_period"
+#define IPC_KEY_STALEMINVALID "stale_min_valid_period"
 #define IPC_KEY_PASSWORDENTRY "pw_entry"
 #define IPC_KEY_CONFIRM "confirm"
 #define IPC_KEY_ALWAYSALLOWID "always_allow_id_token"
+#define IPC_KEY_RELOADABLE "reloadable"
 #define IPC_KEY_REDIRECTEDURI "redirect_uri"
 #define IPC_KEY_FROMGEN "from_gen"
 #define IPC_KEY_USECUSTOMSCHEMEURL "no_webserver"
@@ -34,6 +36,7 @@
 #define IPC_KEY_FILENAME "filename"
 #define IPC_KEY_DATA "data"
 #define IPC_KEY_ONLYAT "only_at"
+#define IPC_KEY_REQUESTS "requests"
 #define IPC_KEY_MYTOKEN_OIDC_ISS "oidc_issuer"
 #define IPC_KEY_MYTOKEN_MY_ISS "mytoken_issuer"
 
@@ -72,6 +75,8 @@
 #define REQUEST_VALUE_DELETECLIENT "delete_client"
 #define REQUEST_VALUE_REAUTHENTICATE "reauthenticate"
 #define REQUEST_VALUE_ACCOUNTINFO "account_info"
+#define REQUEST_VALUE_WATCH "watch"
+#define REQUEST_VALUE_BATCH "batch"
 
 // RESPONSE TEMPLATES
 #define RESPONSE_SUCCESS "{\"" IPC_KEY_STATUS "\":\"" STATUS_SUCCESS "\"}"
@@ -221,11 +226,14 @@
 #define INT_REQUEST_VALUE_UPD_REFRESH "update_refresh"
 #define INT_REQUEST_VALUE_UPD_ISSUER "update_issuer"
 #define INT_REQUEST_VALUE_AUTOLOAD "autoload"
+#define INT_REQUEST_VALUE_RELOAD "reload"
 #define INT_REQUEST_VALUE_AUTOGEN "autogen"
 #define INT_REQUEST_VALUE_CONFIRM "confirm"
 #define INT_REQUEST_VALUE_CONFIRMIDTOKEN "confirm_id"
 #define INT_REQUEST_VALUE_CONFIRMMYTOKEN "confirm_mytoken"
 #define INT_REQUEST_VALUE_QUERY_ACCDEFAULT "query_account_default"
+#define INT_REQUEST_VALUE_STATEEXPORT "state_export"
+#define INT_REQUEST_VALUE_STATEIMPORT "state_import"
 
 #define INT_IPC_KEY_OIDCERRNO "oidc_errno"
 #define INT_IPC_KEY_ACTION "action"
@@ -248,6 +256,9 @@
   "{\"" IPC_KEY_REQUEST "\":\"" INT_REQUEST_VALUE_AUTOLOAD   \
   "\",\"" IPC_KEY_SHORTNAME "\":\"%s\",\"" IPC_KEY_ISSUERURL \
   "\":\"%s\",\"" IPC_KEY_APPLICATIONHINT "\":\"%s\"}"
+#define INT_REQUEST_RELOAD                               \
+  "{\"" IPC_KEY_REQUEST "\":\"" INT_REQUEST_VALUE_RELOAD \
+  "\",\"" IPC_KEY_SHORTNAME "\":\"%s\"}"
 #define INT_REQUEST_AUTOGEN                               \
   "{\"" IPC_KEY_REQUEST "\":\"" INT_REQUEST_VALUE_AUTOGEN \
   "\",\"" IPC_KEY_ISSUERURL "\":\"%s\",\"" OIDC_KEY_SCOPE \
@@ -265,6 +276,11 @@
 #define INT_REQUEST_QUERY_ACCDEFAULT_ISSUER                        \
   "{\"" IPC_KEY_REQUEST "\":\"" INT_REQUEST_VALUE_QUERY_ACCDEFAULT \
   "\",\"" IPC_KEY_ISSUERURL "\":\"%s\"}"
+#define INT_REQUEST_STATEEXPORT \
+  "{\"" IPC_KEY_REQUEST "\":\"" INT_REQUEST_VALUE_STATEEXPORT "\"}"
+#define INT_REQUEST_STATEIMPORT                               \
+  "{\"" IPC_KEY_REQUEST "\":\"" INT_REQUEST_VALUE_STATEIMPORT \
+  "\",\"" IPC_KEY_DATA "\":%s}"
 #define INT_RESPONSE_ACCDEFAULT                                         \
   "{\"" IPC_KEY_STATUS "\":\"" STATUS_SUCCESS "\",\"" IPC_KEY_SHORTNAME \
   "\":\"%s\"}"
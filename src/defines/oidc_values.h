@@ -63,7 +63,9 @@
 #define GOOGLE_KEY_VERIFICATIONURI_COMPLETE "verification_url_complete"
 #define OIDC_KEY_INTERVAL "interval"
 #define OIDC_SLOW_DOWN "slow_down"
+#define OIDC_EXPIRED_TOKEN "expired_token"
 #define OIDC_AUTHORIZATION_PENDING "authorization_pending"
+#define OIDC_INVALID_GRANT "invalid_grant"
 
 // OIDC ERROR
 #define OIDC_KEY_ERROR "error"
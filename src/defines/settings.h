@@ -39,6 +39,10 @@
 // file names
 #define ISSUER_CONFIG_FILENAME "issuer.config"
 #define ISSUER_CONFIG_DIRNAME ISSUER_CONFIG_FILENAME ".d"
+// the .config suffix keeps the index out of the account config listing
+#define ACCOUNT_INDEX_FILENAME "account_index.config"
+#define ACCOUNT_INDEX_LOCK_FILENAME "account_index.lock.config"
+#define STATE_SNAPSHOT_FILENAME "agent_state.config"
 
 #ifdef ANY_MSYS
 const char* CERT_FILE();
@@ -69,6 +73,21 @@ const char* ETC_CONFIG_FILE();
  */
 #define DELTA_POLL 2  // seconds
 
+/**
+ * limits of the stores oidcd keeps for account generation; entries are
+ * removed after their time to live, and the least recently used entries are
+ * evicted if a store is full
+ */
+#define AGENT_CODEVERIFIER_TTL 3600  // seconds
+#define AGENT_CODEVERIFIER_MAX 64
+#define AGENT_DEVICECODE_TTL 3600  // seconds, if the provider does not say
+#define AGENT_DEVICECODE_MAX 64
+#define AGENT_FILE_TTL 86400  // seconds
+#define AGENT_FILE_MAX 128
+#define AGENT_FILE_MAX_BYTES (1024 * 1024)
+
+#define AGENT_STATE_SNAPSHOT_INTERVAL 300  // seconds, if not configured
+
 #define HTTP_DEFAULT_PORT 4242
 #define HTTP_FALLBACK_PORT 8080
 
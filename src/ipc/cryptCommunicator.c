@@ -58,7 +58,7 @@ char* ipc_cryptCommunicate(unsigned char remote, const char* fmt, ...) {
 
 char* ipc_vcryptCommunicate(unsigned char remote, const char* fmt,
                             va_list args) {
-  static struct connection con;
+  struct connection con = {0};
   if (ipc_client_init(&con, remote) != OIDC_SUCCESS) {
     return NULL;
   }
@@ -68,7 +68,7 @@ char* ipc_vcryptCommunicate(unsigned char remote, const char* fmt,
 #ifndef MINGW
 char* ipc_vcryptCommunicateWithPath(const char* socket_path, const char* fmt,
                                     va_list args) {
-  static struct connection con;
+  struct connection con = {0};
   if (initConnectionWithPath(&con, socket_path) != OIDC_SUCCESS) {
     return NULL;
   }
@@ -79,6 +79,8 @@ char* ipc_cryptCommunicateWithPath(const char* socket_path, const char* fmt,
                                    ...) {
   va_list args;
   va_start(args, fmt);
-  return ipc_vcryptCommunicateWithPath(socket_path, fmt, args);
+  char* ret = ipc_vcryptCommunicateWithPath(socket_path, fmt, args);
+  va_end(args);
+  return ret;
 }
 #endif
\ No newline at end of file
@@ -79,9 +79,16 @@ unsigned char* generateIpcKey(const unsigned char* publicKey,
   return sharedKey;
 }
 
-list_t* encryptionKeys = NULL;
-
-char* server_ipc_cryptRead(const SOCKET sock, const char* client_pk_base64) {
+/**
+ * @brief reads an encrypted request from a client
+ * @param sock the socket to read from
+ * @param client_pk_base64 the base64 encoded public key of the client
+ * @param ipc_key_out is set to the negotiated key on success; it is needed to
+ * encrypt the response and has to be freed after usage
+ * @return the decrypted request or @c NULL on failure
+ */
+char* server_ipc_cryptRead(const SOCKET sock, const char* client_pk_base64,
+                           unsigned char** ipc_key_out) {
   logger(DEBUG, "Doing encrypted ipc read");
   unsigned char client_pk[crypto_kx_PUBLICKEYBYTES];
   fromBase64(client_pk_base64, crypto_kx_PUBLICKEYBYTES, client_pk);
@@ -102,10 +109,7 @@ char* server_ipc_cryptRead(const SOCKET sock, const char* client_pk_base64) {
   secFree(encrypted_request);
   logger(DEBUG, "Decrypted request is '%s'", decryptedRequest);
   if (decryptedRequest != NULL) {
-    if (encryptionKeys == NULL) {
-      encryptionKeys = list_new();
-    }
-    list_rpush(encryptionKeys, list_node_new(ipc_key));
+    *ipc_key_out = ipc_key;
   } else {
     secFree(ipc_key);
   }
@@ -27,7 +27,8 @@ oidc_error_t   ipc_cryptWrite(const SOCKET, const unsigned char*, const char*,
 oidc_error_t   ipc_vcryptWrite(const SOCKET, const unsigned char*, const char*,
                                va_list);
 void           secFreePubSecKeySet(struct pubsec_keySet*);
-char*          server_ipc_cryptRead(const SOCKET, const char*);
+char*          server_ipc_cryptRead(const SOCKET, const char*,
+                                    unsigned char** ipc_key_out);
 unsigned char* client_keyExchange(const SOCKET sock);
 
 #endif  // IPC_CRYPT_H
@@ -7,6 +7,7 @@
 #include <winsock2.h>
 #else
 #include <arpa/inet.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/select.h>
@@ -138,8 +139,9 @@ oidc_error_t ipc_client_init(struct connection* con, unsigned char remote) {
 
   if (remote) {
     logger(DEBUG, "Using TCP socket");
-    char*          ip         = strtok(path, ":");
-    char*          port_str   = strtok(NULL, ":");
+    char*          saveptr    = NULL;
+    char*          ip         = strtok_r(path, ":", &saveptr);
+    char*          port_str   = strtok_r(NULL, ":", &saveptr);
     unsigned short port       = port_str == NULL ? 0 : strToUShort(port_str);
     con->tcp_server->sin_port = htons(port ?: 42424);
     con->tcp_server->sin_addr.s_addr =
@@ -316,6 +318,55 @@ struct timeval* initTimeout(time_t death) {
  * is set.
  */
 char* ipc_readWithTimeout(const int _sock, time_t death) {
+  return ipc_readWithTimeoutAndWatch(_sock, death, NULL);
+}
+
+/**
+ * @brief adds the file descriptors of a chain of watches to a fd set
+ * @param watch the first watch of the chain; might be @c NULL
+ * @param set the set the file descriptors are added to
+ * @param maxfd the highest file descriptor already in @p set
+ * @return the highest file descriptor in @p set
+ */
+int ipc_watchFdset(const struct ipc_watch* watch, fd_set* set, int maxfd) {
+  for (; watch; watch = watch->next) {
+    if (watch->fd >= 0) {
+      FD_SET(watch->fd, set);
+      if (watch->fd > maxfd) {
+        maxfd = watch->fd;
+      }
+    }
+  }
+  return maxfd;
+}
+
+/**
+ * @brief calls the handlers of all watches whose file descriptor is readable
+ * @param watch the first watch of the chain; might be @c NULL
+ * @param set the fd set returned by select
+ */
+void ipc_watchHandle(const struct ipc_watch* watch, const fd_set* set) {
+  for (; watch; watch = watch->next) {
+    if (watch->fd >= 0 && FD_ISSET(watch->fd, set)) {
+      watch->handle();
+    }
+  }
+}
+
+/**
+ * @brief reads from a socket until a timeout is reached; while waiting
+ * additional file descriptors are watched
+ * @param _sock the socket to read from
+ * @param timeout the time when the request times out, if @c 0 no timeout is
+ * used.
+ * @param watch the additional file descriptors and their handlers; a handler
+ * is called whenever its file descriptor becomes readable. Might be @c NULL.
+ * @return a pointer to the readed content. Has to be freed after usage. If an
+ * error occurs or the timeout is reached @c NULL is returned and @c oidc_errno
+ * is set.
+ */
+char* ipc_readWithTimeoutAndWatch(const int _sock, time_t death,
+                                  const struct ipc_watch* watch) {
   logger(DEBUG, "ipc reading from socket %d\n", _sock);
   if (_sock < 0) {
     logger(ERROR, "invalid socket in ipc_read");
@@ -325,22 +376,30 @@ char* ipc_readWithTimeout(const int _sock, time_t death) {
   int    len = 0;
   int    rv;
   fd_set set;
-  FD_ZERO(&set);
-  FD_SET(_sock, &set);
-  struct timeval* timeout = initTimeout(death);
-  if (oidc_errno != OIDC_SUCCESS) {  // death before now
-    return NULL;
-  }
-  rv = select(_sock + 1, &set, NULL, NULL, timeout);
-  secFree(timeout);
-  if (rv == -1) {
-    logger(ALERT, "error select in %s: %m", __func__);
-    oidc_errno = OIDC_ESELECT;
-    return NULL;
-  }
-  if (rv == 0) {
-    oidc_errno = OIDC_ETIMEOUT;
-    return NULL;
+  while (1) {
+    FD_ZERO(&set);
+    FD_SET(_sock, &set);
+    int maxfd = ipc_watchFdset(watch, &set, _sock);
+    struct timeval* timeout = initTimeout(death);
+    if (oidc_errno != OIDC_SUCCESS) {  // death before now
+      return NULL;
+    }
+    rv = select(maxfd + 1, &set, NULL, NULL, timeout);
+    secFree(timeout);
+    if (rv == -1) {
+      logger(ALERT, "error select in %s: %m", __func__);
+      oidc_errno = OIDC_ESELECT;
+      return NULL;
+    }
+    if (rv == 0) {
+      oidc_errno = OIDC_ETIMEOUT;
+      return NULL;
+    }
+    ipc_watchHandle(watch, &set);
+    if (!FD_ISSET(_sock, &set)) {
+      continue;
+    }
+    break;
   }
   if (ioctl(_sock, FIONREAD, &len) != 0) {
     logger(ERROR, "ioctl: %m");
@@ -385,6 +444,52 @@ char* ipc_readWithTimeout(const int _sock, time_t death) {
   logger(DEBUG, "ipc read '%s'", buf);
   return buf;
 }
+
+/**
+ * @brief reads a single newline terminated message from a socket that is used
+ * for several messages
+ * @note reads byte by byte, so that a following message stays in the socket
+ * and the socket is still reported as readable
+ * @return the message without the newline or @c NULL on failure; if the other
+ * party closed the connection @c oidc_errno is set to @c OIDC_EIPCDIS
+ */
+char* ipc_readLine(const int _sock) {
+  size_t len  = 0;
+  size_t size = 256;
+  char*  line = secAlloc(size);
+  while (1) {
+    char    c;
+    ssize_t n = read(_sock, &c, 1);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      oidc_setErrnoError();
+      secFree(line);
+      return NULL;
+    }
+    if (n == 0) {
+      if (len > 0) {  // e.g. a plain text error before the other party closed
+        return line;
+      }
+      oidc_errno = OIDC_EIPCDIS;
+      secFree(line);
+      return NULL;
+    }
+    if (c == '\n') {
+      return line;
+    }
+    if (len + 2 > size) {
+      size *= 2;
+      line = secRealloc(line, size);
+      if (line == NULL) {
+        oidc_errno = OIDC_EALLOC;
+        return NULL;
+      }
+    }
+    line[len++] = c;
+  }
+}
 #endif
 
 /**
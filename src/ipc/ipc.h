@@ -6,6 +6,8 @@
 #ifdef MINGW
 #include <winsock2.h>
 #else
+#include <sys/select.h>
+
 #include "socket.h"
 #endif
 #include <stdarg.h>
@@ -23,7 +25,24 @@ int ipc_connect(struct connection con);
 
 char* ipc_read(const SOCKET _sock);
 #ifndef MINGW
+/**
+ * @brief an additional file descriptor that is watched while waiting for ipc
+ * messages; @c handle is called when @c fd becomes readable. Multiple watches
+ * can be chained through @c next.
+ */
+struct ipc_watch {
+  int fd;
+  void (*handle)(void);
+  const struct ipc_watch* next;
+};
+
+int  ipc_watchFdset(const struct ipc_watch* watch, fd_set* set, int maxfd);
+void ipc_watchHandle(const struct ipc_watch* watch, const fd_set* set);
+
 char* ipc_readWithTimeout(const SOCKET _sock, time_t timeout);
+char* ipc_readWithTimeoutAndWatch(const SOCKET _sock, time_t timeout,
+                                  const struct ipc_watch* watch);
+char* ipc_readLine(const SOCKET _sock);
 #endif
 
 oidc_error_t ipc_write(SOCKET _sock, const char* msg, ...);
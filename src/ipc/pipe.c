@@ -79,6 +79,11 @@ char* ipc_readFromPipeWithTimeout(struct ipcPipe pipes, time_t timeout) {
   return ipc_readWithTimeout(pipes.rx, timeout);
 }
 
+char* ipc_readFromPipeWithTimeoutAndWatch(struct ipcPipe pipes, time_t timeout,
+                                          const struct ipc_watch* watch) {
+  return ipc_readWithTimeoutAndWatch(pipes.rx, timeout, watch);
+}
+
 char* ipc_vcommunicateThroughPipe(struct ipcPipe pipes, const char* fmt,
                                   va_list args) {
   if (ipc_vwriteToPipe(pipes, fmt, args) != OIDC_SUCCESS) {
@@ -11,6 +11,8 @@ struct ipcPipe {
   int tx;
 };
 
+struct ipc_watch;
+
 struct pipeSet {
   struct ipcPipe pipe1;
   struct ipcPipe pipe2;
@@ -26,6 +28,8 @@ oidc_error_t ipc_vwriteToPipe(struct ipcPipe, const char*, va_list);
 oidc_error_t ipc_writeOidcErrnoToPipe(struct ipcPipe);
 char*        ipc_readFromPipe(struct ipcPipe);
 char*        ipc_readFromPipeWithTimeout(struct ipcPipe, time_t);
+char*        ipc_readFromPipeWithTimeoutAndWatch(struct ipcPipe, time_t,
+                                                 const struct ipc_watch*);
 char*        ipc_communicateThroughPipe(struct ipcPipe, const char*, ...);
 char*        ipc_vcommunicateThroughPipe(struct ipcPipe, const char*, va_list);
 
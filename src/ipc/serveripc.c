@@ -17,6 +17,7 @@
 #include "ipc.h"
 #include "ipc/cryptCommunicator.h"
 #include "utils/agentLogger.h"
+#include "utils/crypt/ipcCryptUtils.h"
 #include "utils/db/connection_db.h"
 #include "utils/file_io/fileUtils.h"
 #include "utils/file_io/file_io.h"
@@ -315,12 +316,25 @@ struct connection* _checkClientSocksForMsg(fd_set* readSet) {
  */
 struct connection* ipc_readAsyncFromMultipleConnectionsWithTimeout(
     struct connection listencon, time_t death) {
+  return ipc_readAsyncFromMultipleConnectionsWithTimeoutAndWatch(listencon,
+                                                                 death, NULL);
+}
+
+/**
+ * @brief handles asynchronous server read for multiple sockets like
+ * @c ipc_readAsyncFromMultipleConnectionsWithTimeout; additionally the
+ * handlers of the chained watches are called whenever their file descriptor
+ * becomes readable
+ */
+struct connection* ipc_readAsyncFromMultipleConnectionsWithTimeoutAndWatch(
+    struct connection listencon, time_t death, const struct ipc_watch* watch) {
   while (1) {
     fd_set readSockSet;
     FD_ZERO(&readSockSet);
     FD_SET(*(listencon.sock), &readSockSet);
     int maxSock =
         _determineMaxSockAndAddToReadSet(*(listencon.sock), &readSockSet);
+    maxSock = ipc_watchFdset(watch, &readSockSet, maxSock);
 
     struct timeval* timeout = initTimeout(death);
     if (oidc_errno != OIDC_SUCCESS) {  // death before now
@@ -332,6 +346,7 @@ struct connection* ipc_readAsyncFromMultipleConnectionsWithTimeout(
     int ret = select(maxSock + 1, &readSockSet, NULL, NULL, timeout);
     secFree(timeout);
     if (ret > 0) {
+      ipc_watchHandle(watch, &readSockSet);
       if (FD_ISSET(*(listencon.sock),
                    &readSockSet)) {  // if listensock read something it means a
                                      // new client connected
@@ -374,11 +389,52 @@ char* ipc_vcryptCommunicateWithServerPath(const char* fmt, va_list args) {
   return ipc_vcryptCommunicateWithPath(server_socket_path, fmt, args);
 }
 
-extern list_t* encryptionKeys;
+// keys of the requests that still have to be answered; only used by the
+// thread that serves the socket
+static list_t* encryptionKeys = NULL;
+
+// while the requests of a batch are handled, the responses for the socket of
+// the batch are collected here instead of being written
+static int   captureSock      = -1;
+static char* capturedResponse = NULL;
+
+/**
+ * @brief collects the responses written to a socket instead of writing them,
+ * until @c server_ipc_stopCapture is called
+ * @note only the last response is kept; it can be obtained with
+ * @c server_ipc_takeCapturedResponse
+ */
+void server_ipc_startCapture(const int sock) {
+  captureSock = sock;
+  secFree(capturedResponse);
+}
+
+void server_ipc_stopCapture() {
+  captureSock = -1;
+  secFree(capturedResponse);
+}
+
+/**
+ * @brief returns the response collected since the capture was started or this
+ * function was called the last time
+ * @return the response or @c NULL if none was written; has to be freed after
+ * usage
+ */
+char* server_ipc_takeCapturedResponse() {
+  char* res        = capturedResponse;
+  capturedResponse = NULL;
+  return res;
+}
 
 oidc_error_t server_ipc_write(const int sock, const char* fmt, ...) {
   va_list args;
   va_start(args, fmt);
+  if (sock == captureSock) {
+    secFree(capturedResponse);
+    capturedResponse = oidc_vsprintf(fmt, args);
+    va_end(args);
+    return OIDC_SUCCESS;
+  }
   if (encryptionKeys == NULL || encryptionKeys->len <= 0) {
     oidc_error_t ret = ipc_vwrite(sock, fmt, args);
     va_end(args);
@@ -402,8 +458,15 @@ char* server_ipc_read(const int sock) {
   if (msg == NULL || isJSONObject(msg)) {
     return msg;
   }
-  char* res = server_ipc_cryptRead(sock, msg);
+  unsigned char* ipc_key = NULL;
+  char*          res     = server_ipc_cryptRead(sock, msg, &ipc_key);
   secFree(msg);
+  if (ipc_key != NULL) {
+    if (encryptionKeys == NULL) {
+      encryptionKeys = list_new();
+    }
+    list_rpush(encryptionKeys, list_node_new(ipc_key));
+  }
   return res;
 }
 
@@ -417,6 +480,94 @@ void server_ipc_freeLastKey() {
   secFree(key);
 }
 
+/**
+ * @brief takes the key of the last request out of the key stack, so that the
+ * connection can be used for further messages
+ * @return the key or @c NULL if the last request was not encrypted; has to be
+ * freed after usage
+ */
+unsigned char* server_ipc_takeLastKey() {
+  if (encryptionKeys == NULL || encryptionKeys->len <= 0) {
+    return NULL;
+  }
+  list_node_t*   node = list_rpop(encryptionKeys);
+  unsigned char* key  = node->val;
+  LIST_FREE(node);
+  return key;
+}
+
+/**
+ * @brief gives a key that was taken with @c server_ipc_takeLastKey back to the
+ * key stack, so that the next @c server_ipc_write on the connection uses it
+ * @param ipc_key the key; ownership is taken. If @c NULL the next response is
+ * written unencrypted.
+ */
+void server_ipc_restoreKey(unsigned char* ipc_key) {
+  if (ipc_key == NULL) {
+    return;
+  }
+  if (encryptionKeys == NULL) {
+    encryptionKeys = list_new();
+  }
+  list_rpush(encryptionKeys, list_node_new(ipc_key));
+}
+
+/**
+ * @brief writes a newline terminated message to a connection that is kept
+ * open for several messages
+ * @param sock the socket to write to
+ * @param key the key obtained by @c server_ipc_takeLastKey; if @c NULL the
+ * message is written unencrypted
+ * @param msg the message; must not contain a newline
+ */
+oidc_error_t server_ipc_writeLine(const int sock, const unsigned char* key,
+                                  const char* msg) {
+  if (key == NULL) {
+    return ipc_write(sock, "%s\n", msg);
+  }
+  char* encrypted = encryptForIpc(msg, key);
+  if (encrypted == NULL) {
+    return oidc_errno;
+  }
+  oidc_error_t e = ipc_write(sock, "%s\n", encrypted);
+  secFree(encrypted);
+  return e;
+}
+
+/**
+ * @brief like @c server_ipc_writeLine, but does not block if the client does
+ * not read its messages
+ * @return @c OIDC_EWRITE if the message could not be written completely, e.g.
+ * because the socket buffer is full; the connection should be closed then
+ */
+oidc_error_t server_ipc_pushLine(const int sock, const unsigned char* key,
+                                 const char* msg) {
+#ifdef ANY_MSYS
+  return server_ipc_writeLine(sock, key, msg);
+#else
+  char* encrypted = NULL;
+  if (key != NULL) {
+    encrypted = encryptForIpc(msg, key);
+    if (encrypted == NULL) {
+      return oidc_errno;
+    }
+  }
+  char* line = oidc_sprintf("%s\n", encrypted ?: msg);
+  secFree(encrypted);
+  size_t  len     = strlen(line);
+  ssize_t written = send(sock, line, len, MSG_DONTWAIT);
+  secFree(line);
+  if (written < 0) {
+    logger(DEBUG, "pushing on stream socket: %m");
+  }
+  if (written < 0 || (size_t)written < len) {
+    oidc_errno = OIDC_EWRITE;
+    return oidc_errno;
+  }
+  return OIDC_SUCCESS;
+#endif
+}
+
 oidc_error_t server_ipc_writeOidcErrno(const int sock) {
   return server_ipc_write(sock, RESPONSE_ERROR, oidc_serror());
 }
@@ -5,11 +5,14 @@
 #include <time.h>
 
 #include "connection.h"
+#include "ipc.h"
 #include "utils/oidc_error.h"
 
 oidc_error_t       initServerConnection(struct connection* con);
 struct connection* ipc_readAsyncFromMultipleConnectionsWithTimeout(
     struct connection, time_t);
+struct connection* ipc_readAsyncFromMultipleConnectionsWithTimeoutAndWatch(
+    struct connection, time_t, const struct ipc_watch*);
 char* ipc_vcryptCommunicateWithServerPath(const char* fmt, va_list args);
 char* ipc_cryptCommunicateWithServerPath(const char* fmt, ...);
 char* getServerSocketPath();
@@ -19,10 +22,19 @@ oidc_error_t ipc_server_init(struct connection* con, const char* group_name,
 oidc_error_t ipc_initWithPath(struct connection* con);
 int          ipc_bindAndListen(struct connection* con, const char* group);
 
-void         server_ipc_freeLastKey();
-char*        server_ipc_read(const int);
-oidc_error_t server_ipc_write(const int, const char*, ...);
-oidc_error_t server_ipc_writeOidcErrno(const int);
-oidc_error_t server_ipc_writeOidcErrnoPlain(const int sock);
+void           server_ipc_freeLastKey();
+unsigned char* server_ipc_takeLastKey();
+void           server_ipc_restoreKey(unsigned char* ipc_key);
+void           server_ipc_startCapture(const int sock);
+void           server_ipc_stopCapture();
+char*          server_ipc_takeCapturedResponse();
+char*          server_ipc_read(const int);
+oidc_error_t   server_ipc_write(const int, const char*, ...);
+oidc_error_t   server_ipc_writeLine(const int sock, const unsigned char* key,
+                                    const char* msg);
+oidc_error_t   server_ipc_pushLine(const int sock, const unsigned char* key,
+                                   const char* msg);
+oidc_error_t   server_ipc_writeOidcErrno(const int);
+oidc_error_t   server_ipc_writeOidcErrnoPlain(const int sock);
 
 #endif  // IPC_SERVER_H
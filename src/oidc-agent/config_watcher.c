@@ -0,0 +1,194 @@
+#include "config_watcher.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <libgen.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "defines/settings.h"
+#include "utils/agentLogger.h"
+#include "utils/config/agent_config.h"
+#include "utils/config/gen_config.h"
+#include "utils/config/issuerConfig.h"
+#include "utils/file_io/oidc_file_io.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+#define CONFIG_CHANGED_ISSUER 0x1
+#define CONFIG_CHANGED_AGENT 0x2
+
+#ifdef __linux__
+
+#define CONFIG_WATCH_MAX 8
+#define CONFIG_WATCH_MASK                                                 \
+  (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | \
+   IN_ONLYDIR)
+// events on files that indicate that their content changed; IN_CREATE is
+// ignored for files since it is followed by IN_CLOSE_WRITE
+#define CONFIG_FILE_CHANGED_MASK \
+  (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE)
+
+struct config_watch {
+  int           wd;
+  char*         dir;
+  char*         file;  // the watched file in dir; NULL for all files
+  unsigned char what;  // which config is affected; CONFIG_CHANGED_*
+  unsigned char watch_issuer_dir : 1;  // add a watch if issuer.config.d is
+                                       // created in dir
+};
+
+static int                 inotify_fd = -1;
+static struct config_watch watches[CONFIG_WATCH_MAX];
+
+/**
+ * @brief adds a watch for @p dir; takes ownership of @p dir and @p file
+ */
+static void addWatch(char* dir, char* file, unsigned char what,
+                     unsigned char watch_issuer_dir) {
+  struct config_watch* w = NULL;
+  for (size_t i = 0; i < CONFIG_WATCH_MAX && w == NULL; i++) {
+    if (watches[i].wd < 0) {
+      w = &watches[i];
+    }
+  }
+  if (dir == NULL || w == NULL) {
+    secFree(dir);
+    secFree(file);
+    return;
+  }
+  int wd = inotify_add_watch(inotify_fd, dir, CONFIG_WATCH_MASK);
+  if (wd < 0) {
+    agent_log(DEBUG, "Not watching '%s': %m", dir);
+    secFree(dir);
+    secFree(file);
+    return;
+  }
+  agent_log(DEBUG, "Watching '%s' for config changes", dir);
+  w->wd               = wd;
+  w->dir              = dir;
+  w->file             = file;
+  w->what             = what;
+  w->watch_issuer_dir = watch_issuer_dir;
+}
+
+static void removeWatch(struct config_watch* w) {
+  secFree(w->dir);
+  secFree(w->file);
+  w->wd = -1;
+}
+
+static void addConfigDirWatches(const char*   dir,
+                                unsigned char watchAgentConfig) {
+  if (dir == NULL) {
+    return;
+  }
+  addWatch(oidc_strcopy(dir), oidc_strcopy(ISSUER_CONFIG_FILENAME),
+           CONFIG_CHANGED_ISSUER, 1);
+  addWatch(oidc_pathcat(dir, ISSUER_CONFIG_DIRNAME), NULL,
+           CONFIG_CHANGED_ISSUER, 0);
+  if (watchAgentConfig) {
+    addWatch(oidc_strcopy(dir), oidc_strcopy("config"), CONFIG_CHANGED_AGENT,
+             0);
+  }
+}
+
+static unsigned char handleEvent(const struct inotify_event* event) {
+  unsigned char changed = 0;
+  for (size_t i = 0; i < CONFIG_WATCH_MAX; i++) {
+    struct config_watch* w = &watches[i];
+    if (w->wd < 0 || w->wd != event->wd) {
+      continue;
+    }
+    if (event->mask & IN_IGNORED) {  // watched dir was removed
+      changed |= w->what;
+      removeWatch(w);
+      continue;
+    }
+    if (event->len == 0 || strstarts(event->name, ".")) {
+      continue;
+    }
+    if (event->mask & IN_ISDIR) {
+      if (w->watch_issuer_dir && event->mask & (IN_CREATE | IN_MOVED_TO) &&
+          strequal(event->name, ISSUER_CONFIG_DIRNAME)) {
+        addWatch(oidc_pathcat(w->dir, event->name), NULL,
+                 CONFIG_CHANGED_ISSUER, 0);
+        changed |= CONFIG_CHANGED_ISSUER;
+      }
+      continue;
+    }
+    if (!(event->mask & CONFIG_FILE_CHANGED_MASK)) {
+      continue;
+    }
+    if (w->file == NULL || strequal(w->file, event->name)) {
+      changed |= w->what;
+    }
+  }
+  return changed;
+}
+
+static void handleConfigChanges(void) {
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  unsigned char changed = 0;
+  ssize_t       len;
+  while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+    const struct inotify_event* event;
+    for (char* ptr = buf; ptr < buf + len;
+         ptr += sizeof(struct inotify_event) + event->len) {
+      event = (const struct inotify_event*)ptr;
+      changed |= handleEvent(event);
+    }
+  }
+  if (changed & CONFIG_CHANGED_ISSUER) {
+    agent_log(NOTICE, "Issuer configuration changed; reloading");
+    reloadIssuerConfigs();
+  }
+  if (changed & CONFIG_CHANGED_AGENT) {
+    agent_log(NOTICE, "Configuration changed; reloading");
+    if (reloadAgentConfig() != OIDC_SUCCESS ||
+        reloadGenConfig() != OIDC_SUCCESS) {
+      agent_log(ERROR, "Could not reload configuration: %s", oidc_serror());
+    }
+  }
+}
+
+static struct ipc_watch config_ipc_watch = {.fd     = -1,
+                                            .handle = handleConfigChanges};
+
+const struct ipc_watch* configWatcher_init() {
+  if (inotify_fd >= 0) {
+    return &config_ipc_watch;
+  }
+  inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd < 0) {
+    agent_log(ERROR, "Cannot watch config files: %m");
+    return NULL;
+  }
+  for (size_t i = 0; i < CONFIG_WATCH_MAX; i++) {
+    watches[i].wd = -1;
+  }
+  const char* user_config = getenv(OIDC_USER_CONFIG_PATH_ENV_NAME);
+  char*       oidc_dir    = getOidcDir();
+  addConfigDirWatches(oidc_dir, user_config == NULL);
+  secFree(oidc_dir);
+  addConfigDirWatches(CONFIG_PATH "/oidc-agent", 1);
+  if (user_config && !strcaseequal(user_config, "/dev/null")) {
+    char* tmp_dir  = oidc_strcopy(user_config);
+    char* tmp_file = oidc_strcopy(user_config);
+    addWatch(oidc_strcopy(dirname(tmp_dir)),
+             oidc_strcopy(basename(tmp_file)), CONFIG_CHANGED_AGENT, 0);
+    secFree(tmp_dir);
+    secFree(tmp_file);
+  }
+  config_ipc_watch.fd = inotify_fd;
+  return &config_ipc_watch;
+}
+
+#else
+
+const struct ipc_watch* configWatcher_init() { return NULL; }
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef OIDC_AGENT_CONFIG_WATCHER_H
+#define OIDC_AGENT_CONFIG_WATCHER_H
+
+#include "ipc/ipc.h"
+
+/**
+ * @brief starts watching the issuer and agent config files of the user and in
+ * the global config dir for changes
+ * @note must be called in each process that wants to be notified, i.e. after
+ * forking
+ * @return a watch that has to be passed to the ipc read functions of the main
+ * loop; when config files change the affected configs are reloaded by its
+ * handler. @c NULL if config files cannot be watched on this system.
+ */
+const struct ipc_watch* configWatcher_init();
+
+#endif  // OIDC_AGENT_CONFIG_WATCHER_H
@@ -0,0 +1,193 @@
+#include "circuit_breaker.h"
+
+#include <sodium.h>
+#include <time.h>
+
+#include "utils/agentLogger.h"
+#include "utils/hashmap.h"
+#include "utils/json.h"
+#include "utils/memory.h"
+#include "utils/uriUtils.h"
+
+/**
+ * Health of a single provider endpoint, identified by its url without query
+ * string. Endpoints are tracked separately, so that issuers sharing a host
+ * (e.g. multiple realms of one server) do not affect each other.
+ *
+ * A provider starts closed, i.e. all requests are sent. After
+ * @c AGENT_CB_FAILURE_THRESHOLD consecutive failures it is opened and requests
+ * fail immediately until the backoff has passed. Then a single probe request
+ * is let through (half open); if it succeeds the provider is closed again,
+ * otherwise it is opened with a doubled backoff.
+ */
+enum provider_state {
+  PROVIDER_CLOSED,
+  PROVIDER_OPEN,
+  PROVIDER_HALF_OPEN,
+};
+
+struct provider_health {
+  enum provider_state state;
+  unsigned int        failures;
+  time_t              backoff;
+  time_t              open_until;
+  unsigned char       probing;
+};
+
+static hashmap_t* providers = NULL;
+
+static hashmap_t* getProviders() {
+  if (providers == NULL) {
+    providers = hashmap_new(8, _secFree);
+  }
+  return providers;
+}
+
+static void openCircuit(const char* endpoint, struct provider_health* h) {
+  // +-20% jitter, so clients of many agents do not probe in lockstep
+  time_t jitter = h->backoff / 5;
+  time_t delay =
+      h->backoff - jitter + (time_t)randombytes_uniform(2 * jitter + 1);
+  h->state      = PROVIDER_OPEN;
+  h->open_until = time(NULL) + delay;
+  agent_log(WARNING, "%s failed %u times; not contacting it for %lu seconds",
+            endpoint, h->failures, (unsigned long)delay);
+}
+
+static int isProviderFailure(oidc_error_t result) {
+  switch ((int)result) {
+    case OIDC_EURL:
+    case OIDC_ESSL:
+    case OIDC_EERROR:
+    case 408:
+    case 429: return 1;
+    default: return result >= 500 && result < 600;
+  }
+}
+
+static int isProviderSuccess(oidc_error_t result) {
+  // Any answer of the provider shows that it is reachable, even an error
+  return result == OIDC_SUCCESS || result == OIDC_EHTTP0 ||
+         (result >= 200 && result < 500);
+}
+
+/**
+ * @brief checks if a request to @p url may be sent
+ * @param url the url of the request
+ * @return @c OIDC_SUCCESS if the request may be sent; @c OIDC_EPROVDOWN if the
+ * provider is considered unavailable
+ * @note if the request is allowed, its result has to be passed to
+ * @c circuitBreaker_record
+ */
+oidc_error_t circuitBreaker_allow(const char* url) {
+  char* endpoint = getUriEndpoint(url);
+  if (endpoint == NULL) {
+    return OIDC_SUCCESS;
+  }
+  struct provider_health* h = hashmap_get(getProviders(), endpoint);
+  oidc_error_t            e = OIDC_SUCCESS;
+  if (h != NULL) {
+    switch (h->state) {
+      case PROVIDER_CLOSED: break;
+      case PROVIDER_OPEN:
+        if (time(NULL) < h->open_until) {
+          e = OIDC_EPROVDOWN;
+          break;
+        }
+        agent_log(NOTICE, "Probing if %s is available again", endpoint);
+        h->state = PROVIDER_HALF_OPEN;
+        // fall through
+      case PROVIDER_HALF_OPEN:
+        if (h->probing) {
+          e = OIDC_EPROVDOWN;
+        } else {
+          h->probing = 1;
+        }
+        break;
+    }
+  }
+  if (e != OIDC_SUCCESS) {
+    agent_log(DEBUG, "Not sending request to unavailable endpoint %s",
+              endpoint);
+    oidc_errno = e;
+  }
+  secFree(endpoint);
+  return e;
+}
+
+/**
+ * @brief records the result of a request that was allowed by
+ * @c circuitBreaker_allow
+ * @param url the url of the request
+ * @param result @c OIDC_SUCCESS or the error of the request; errors that are
+ * not caused by the provider do not change its health
+ * @note @c oidc_errno is not changed
+ */
+void circuitBreaker_record(const char* url, oidc_error_t result) {
+  int   saved_errno = oidc_errno;
+  char* endpoint    = getUriEndpoint(url);
+  oidc_errno        = saved_errno;
+  if (endpoint == NULL) {
+    return;
+  }
+  struct provider_health* h = hashmap_get(getProviders(), endpoint);
+  if (isProviderSuccess(result)) {
+    if (h != NULL) {
+      if (h->state != PROVIDER_CLOSED) {
+        agent_log(NOTICE, "%s is available again", endpoint);
+      }
+      _secFree(hashmap_remove(providers, endpoint));
+    }
+  } else if (isProviderFailure(result)) {
+    if (h == NULL) {
+      h = secAlloc(sizeof(struct provider_health));
+      hashmap_put(providers, endpoint, h);
+    }
+    h->probing = 0;
+    h->failures++;
+    if (h->state == PROVIDER_HALF_OPEN) {
+      h->backoff *= 2;
+      if (h->backoff > AGENT_CB_MAX_BACKOFF) {
+        h->backoff = AGENT_CB_MAX_BACKOFF;
+      }
+      openCircuit(endpoint, h);
+    } else if (h->state == PROVIDER_CLOSED &&
+               h->failures >= AGENT_CB_FAILURE_THRESHOLD) {
+      h->backoff = AGENT_CB_MIN_BACKOFF;
+      openCircuit(endpoint, h);
+    }
+  } else if (h != NULL) {
+    h->probing = 0;
+  }
+  secFree(endpoint);
+}
+
+static void addProviderStatus(const char* endpoint, void* value, void* arg) {
+  const struct provider_health* h    = value;
+  cJSON*                        json = arg;
+  if (h->state == PROVIDER_CLOSED) {
+    return;
+  }
+  time_t now      = time(NULL);
+  time_t retry_in = h->open_until > now ? h->open_until - now : 0;
+  cJSON* item     = cJSON_AddObjectToObject(json, endpoint);
+  cJSON_AddNumberToObject(item, "failures", h->failures);
+  cJSON_AddNumberToObject(item, "retry_in", retry_in);
+}
+
+/**
+ * @brief returns the providers that are currently considered unavailable
+ * @return a json object string mapping the provider endpoints to their state
+ * or @c NULL if all providers are available; has to be freed after usage
+ */
+char* circuitBreaker_status() {
+  if (providers == NULL || hashmap_size(providers) == 0) {
+    return NULL;
+  }
+  cJSON* json = cJSON_CreateObject();
+  hashmap_foreach(providers, addProviderStatus, json);
+  char* status = cJSON_GetArraySize(json) > 0 ? jsonToStringUnformatted(json)
+                                              : NULL;
+  secFreeJson(json);
+  return status;
+}
@@ -0,0 +1,20 @@
+#ifndef HTTP_CIRCUIT_BREAKER_H
+#define HTTP_CIRCUIT_BREAKER_H
+
+#include "utils/oidc_error.h"
+
+#ifndef AGENT_CB_FAILURE_THRESHOLD
+#define AGENT_CB_FAILURE_THRESHOLD 3
+#endif
+#ifndef AGENT_CB_MIN_BACKOFF
+#define AGENT_CB_MIN_BACKOFF 5
+#endif
+#ifndef AGENT_CB_MAX_BACKOFF
+#define AGENT_CB_MAX_BACKOFF 300
+#endif
+
+oidc_error_t circuitBreaker_allow(const char* url);
+void         circuitBreaker_record(const char* url, oidc_error_t result);
+char*        circuitBreaker_status();
+
+#endif  // HTTP_CIRCUIT_BREAKER_H
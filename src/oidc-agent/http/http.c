@@ -5,40 +5,168 @@
 #include "http_handler.h"
 #include "utils/agentLogger.h"
 #include "utils/memory.h"
+#include "utils/memzero.h"
 #include "utils/oidc_error.h"
 #include "utils/pass.h"
 #include "utils/string/stringUtils.h"
 
-/** @fn char* httpsGET(const char* url, const char* cert_path)
- * @brief does a https GET request
+static struct http_request* _prepareRequest(const char* url,
+                                            const char* cert_path) {
+  CURL* curl = init();
+  if (curl == NULL) {
+    return NULL;
+  }
+  struct http_request* req = secAlloc(sizeof(struct http_request));
+  req->curl                = curl;
+  setUrl(curl, url);
+  if (setWriteFunction(curl, &req->response) != OIDC_SUCCESS) {
+    cleanup(curl);
+    secFree(req);
+    return NULL;
+  }
+  setSSLOpts(curl, cert_path);
+  return req;
+}
+
+/**
+ * @brief prepares a https GET request without performing it
  * @param url the request url
+ * @param headers additional headers; must stay valid until the request is
+ * finished
  * @param cert_path the path to the SSL certs
- * @return a pointer to the response. Has to be freed after usage. If the Https
- * call failed, NULL is returned.
+ * @return the prepared request or @c NULL on error; has to be passed to
+ * @c http_finishRequest
  */
-char* _httpsGET(const char* url, struct curl_slist* headers,
-                const char* cert_path) {
+struct http_request* _httpsPrepareGET(const char* url,
+                                      struct curl_slist* headers,
+                                      const char*        cert_path) {
   agent_log(DEBUG, "Https GET to: %s", url);
-  CURL* curl = init();
-  setUrl(curl, url);
-  struct string s;
-  if (setWriteFunction(curl, &s) != OIDC_SUCCESS) {
+  struct http_request* req = _prepareRequest(url, cert_path);
+  if (req == NULL) {
     return NULL;
   }
-  setSSLOpts(curl, cert_path);
-  setHeaders(curl, headers);
-  oidc_error_t err = perform(curl);
+  // GET is only used for public documents (discovery, etc.), so the response
+  // does not need to be zeroed
+  markPublicMem(req->response.ptr);
+  setHeaders(req->curl, headers);
+  return req;
+}
+
+/**
+ * @brief prepares a https DELETE request without performing it
+ * @param url the request url
+ * @param headers additional headers; must stay valid until the request is
+ * finished
+ * @param cert_path the path to the SSL certs
+ * @param bearer_token the token used for authorization
+ * @return the prepared request or @c NULL on error; has to be passed to
+ * @c http_finishRequest
+ */
+struct http_request* _httpsPrepareDELETE(const char*        url,
+                                         struct curl_slist* headers,
+                                         const char*        cert_path,
+                                         const char*        bearer_token) {
+  agent_log(DEBUG, "Https DELETE to: %s", url);
+  struct http_request* req = _prepareRequest(url, cert_path);
+  if (req == NULL) {
+    return NULL;
+  }
+  curl_easy_setopt(req->curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+  req->bearer_header = oidc_sprintf("Authorization: Bearer %s", bearer_token);
+  struct curl_slist* all_headers =
+      curl_slist_append(headers, req->bearer_header);
+  if (headers == NULL) {
+    req->owned_headers = all_headers;
+  }
+  setHeaders(req->curl, all_headers);
+  return req;
+}
+
+/**
+ * @brief prepares a https POST request without performing it
+ * @param url the request url
+ * @param data the data to be posted
+ * @param headers additional headers; must stay valid until the request is
+ * finished
+ * @param cert_path the path to the SSL certs
+ * @return the prepared request or @c NULL on error; has to be passed to
+ * @c http_finishRequest
+ */
+struct http_request* _httpsPreparePOST(const char* url, const char* data,
+                                       struct curl_slist* headers,
+                                       const char*        cert_path,
+                                       const char*        username,
+                                       const char*        password) {
+  agent_log(DEBUG, "Https POST to: %s", url);
+  struct http_request* req = _prepareRequest(url, cert_path);
+  if (req == NULL) {
+    return NULL;
+  }
+  curl_easy_setopt(req->curl, CURLOPT_POST, 1L);
+  setPostData(req->curl, data);
+  setHeaders(req->curl, headers);
+  if (username) {
+    setBasicAuth(req->curl, username, password ?: "");
+  }
+  return req;
+}
+
+/**
+ * @brief discards a partially received response, so the request can be
+ * performed again
+ * @param req the request
+ */
+void http_resetResponse(struct http_request* req) {
+  if (req->response.ptr) {
+    moresecure_memzero(req->response.ptr, req->response.len);
+  }
+  req->response.len = 0;
+}
+
+/**
+ * @brief frees a request and returns its response
+ * @param req the request
+ * @param err the result of performing the request
+ * @return a pointer to the response. Has to be freed after usage. If the Https
+ * call failed, NULL is returned.
+ */
+char* http_finishRequest(struct http_request* req, oidc_error_t err) {
+  char* res = req->response.ptr;
   if (err != OIDC_SUCCESS) {
-    if (err >= 200 && err < 600 && strValid(s.ptr)) {
+    if (err >= 200 && err < 600 && strValid(res)) {
       pass;
     } else {
-      secFree(s.ptr);
-      return NULL;
+      secFree(res);
+      res = NULL;
     }
   }
-  cleanup(curl);
-  agent_log(DEBUG, "Response: %s\n", s.ptr);
-  return s.ptr;
+  cleanup(req->curl);
+  curl_slist_free_all(req->owned_headers);
+  secFree(req->bearer_header);
+  secFree(req);
+  if (res) {
+    agent_log(DEBUG, "Response: %s\n", res);
+  }
+  return res;
+}
+
+static char* _performRequest(struct http_request* req) {
+  if (req == NULL) {
+    return NULL;
+  }
+  return http_finishRequest(req, perform(req->curl));
+}
+
+/** @fn char* httpsGET(const char* url, const char* cert_path)
+ * @brief does a https GET request
+ * @param url the request url
+ * @param cert_path the path to the SSL certs
+ * @return a pointer to the response. Has to be freed after usage. If the Https
+ * call failed, NULL is returned.
+ */
+char* _httpsGET(const char* url, struct curl_slist* headers,
+                const char* cert_path) {
+  return _performRequest(_httpsPrepareGET(url, headers, cert_path));
 }
 
 /** @fn char* httpsDELETE(const char* url, const char* cert_path)
@@ -50,34 +178,8 @@ char* _httpsGET(const char* url, struct curl_slist* headers,
  */
 char* _httpsDELETE(const char* url, struct curl_slist* headers,
                    const char* cert_path, const char* bearer_token) {
-  agent_log(DEBUG, "Https GET to: %s", url);
-  CURL* curl = init();
-  setUrl(curl, url);
-  curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-  struct string s;
-  if (setWriteFunction(curl, &s) != OIDC_SUCCESS) {
-    return NULL;
-  }
-  setSSLOpts(curl, cert_path);
-  char* bearer_header = oidc_sprintf("Authorization: Bearer %s", bearer_token);
-  headers             = curl_slist_append(headers, bearer_header);
-  setHeaders(curl, headers);
-  // if (bearer_token) {
-  //   setTokenAuth(curl, bearer_token);
-  // }
-  oidc_error_t err = perform(curl);
-  secFree(bearer_header);
-  if (err != OIDC_SUCCESS) {
-    if (err >= 200 && err < 600 && strValid(s.ptr)) {
-      pass;
-    } else {
-      secFree(s.ptr);
-      return NULL;
-    }
-  }
-  cleanup(curl);
-  agent_log(DEBUG, "Response: %s\n", s.ptr);
-  return s.ptr;
+  return _performRequest(
+      _httpsPrepareDELETE(url, headers, cert_path, bearer_token));
 }
 
 /** @fn char* httpsPOST(const char* url, const char* data, const char*
@@ -92,30 +194,6 @@ char* _httpsDELETE(const char* url, struct curl_slist* headers,
 char* _httpsPOST(const char* url, const char* data, struct curl_slist* headers,
                  const char* cert_path, const char* username,
                  const char* password) {
-  agent_log(DEBUG, "Https POST to: %s", url);
-  CURL* curl = init();
-  setUrl(curl, url);
-  curl_easy_setopt(curl, CURLOPT_POST, 1L);
-  struct string s;
-  if (setWriteFunction(curl, &s) != OIDC_SUCCESS) {
-    return NULL;
-  }
-  setPostData(curl, data);
-  setSSLOpts(curl, cert_path);
-  setHeaders(curl, headers);
-  if (username) {
-    setBasicAuth(curl, username, password ?: "");
-  }
-  oidc_error_t err = perform(curl);
-  if (err != OIDC_SUCCESS) {
-    if (err >= 200 && err < 600 && strValid(s.ptr)) {
-      pass;
-    } else {
-      secFree(s.ptr);
-      return NULL;
-    }
-  }
-  cleanup(curl);
-  agent_log(DEBUG, "Response: %s\n", s.ptr ? s.ptr : "(null)");
-  return s.ptr;
+  return _performRequest(
+      _httpsPreparePOST(url, data, headers, cert_path, username, password));
 }
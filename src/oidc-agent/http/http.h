@@ -3,6 +3,20 @@
 
 #include <curl/curl.h>
 
+#include "utils/oidc_error.h"
+#include "utils/string/oidc_string.h"
+
+/**
+ * @brief a prepared https request; created by one of the @c _httpsPrepare*
+ * functions and freed by @c http_finishRequest
+ */
+struct http_request {
+  CURL*              curl;
+  struct string      response;
+  struct curl_slist* owned_headers;
+  char*              bearer_header;
+};
+
 char* _httpsGET(const char* url, struct curl_slist* list,
                 const char* cert_path);
 char* _httpsPOST(const char* url, const char* data, struct curl_slist* headers,
@@ -10,4 +24,19 @@ char* _httpsPOST(const char* url, const char* data, struct curl_slist* headers,
                  const char* password);
 char* _httpsDELETE(const char* url, struct curl_slist* headers,
                    const char* cert_path, const char* bearer_token);
+
+struct http_request* _httpsPrepareGET(const char* url, struct curl_slist* list,
+                                      const char* cert_path);
+struct http_request* _httpsPreparePOST(const char* url, const char* data,
+                                       struct curl_slist* headers,
+                                       const char*        cert_path,
+                                       const char*        username,
+                                       const char*        password);
+struct http_request* _httpsPrepareDELETE(const char*        url,
+                                         struct curl_slist* headers,
+                                         const char*        cert_path,
+                                         const char*        bearer_token);
+void                 http_resetResponse(struct http_request* req);
+char* http_finishRequest(struct http_request* req, oidc_error_t err);
+
 #endif
@@ -2,6 +2,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 #include "account/account.h"
 #include "defines/version.h"
@@ -14,19 +15,40 @@
 
 static size_t write_callback(void* ptr, size_t size, size_t nmemb,
                              struct string* s) {
-  size_t new_len = s->len + size * nmemb;
-  void*  tmp     = secRealloc(s->ptr, new_len + 1);
-  if (tmp == NULL) {
+  if (string_append(s, ptr, size * nmemb) != OIDC_SUCCESS) {
     exit(EXIT_FAILURE);
   }
-  s->ptr = tmp;
-  memcpy(s->ptr + s->len, ptr, size * nmemb);
-  // s->ptr[new_len] = '\0';
-  s->len = new_len;
-
   return size * nmemb;
 }
 
+#ifndef AGENT_CURL_MAX_PREALLOC
+#define AGENT_CURL_MAX_PREALLOC (1024 * 1024)
+#endif
+
+/**
+ * @brief uses the Content-Length header as a size hint for the response
+ * buffer, so the body can be received without reallocations
+ * @note the hint is capped at @c AGENT_CURL_MAX_PREALLOC, larger bodies still
+ * grow the buffer as needed
+ */
+static size_t header_callback(char* buffer, size_t size, size_t nitems,
+                              struct string* s) {
+  size_t      len  = size * nitems;
+  const char* name = "content-length:";
+  size_t      nlen = strlen(name);
+  if (len > nlen && strncasecmp(buffer, name, nlen) == 0) {
+    char*         end  = NULL;
+    unsigned long hint = strtoul(buffer + nlen, &end, 10);
+    if (end != buffer + nlen && hint > 0) {
+      if (hint > AGENT_CURL_MAX_PREALLOC) {
+        hint = AGENT_CURL_MAX_PREALLOC;
+      }
+      string_reserve(s, s->len + hint);
+    }
+  }
+  return len;
+}
+
 #ifndef AGENT_CURL_CONNECT_TIMEOUT
 #define AGENT_CURL_CONNECT_TIMEOUT 5
 #endif
@@ -36,6 +58,18 @@ static size_t write_callback(void* ptr, size_t size, size_t nmemb,
 
 static unsigned char mem_init = 0;
 
+static long curl_dns_cache_ttl = AGENT_CURL_DNS_CACHE_TTL;
+static long curl_conn_max_idle = AGENT_CURL_CONN_MAX_IDLE;
+
+static struct {
+  unsigned long requests;
+  unsigned long new_connections;
+  unsigned long reused_connections;
+  curl_off_t    dns_time_us;
+  curl_off_t    connect_time_us;
+  curl_off_t    tls_time_us;
+} cache_stats;
+
 oidc_error_t curlMemInit() {
   if (!mem_init) {
     CURLcode res = curl_global_init_mem(CURL_GLOBAL_ALL, secAlloc, _secFree,
@@ -48,6 +82,72 @@ oidc_error_t curlMemInit() {
   return OIDC_SUCCESS;
 }
 
+/**
+ * @brief returns the share handle that is used by all curl handles of this
+ * process, so DNS lookups, TLS sessions and connections are reused between
+ * requests
+ * @return the share handle or @c NULL if it could not be created
+ */
+static CURLSH* getShare() {
+  static CURLSH* share = NULL;
+  if (share == NULL) {
+    share = curl_share_init();
+    if (share == NULL) {
+      agent_log(ERROR, "Could not init curl share handle");
+      return NULL;
+    }
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+  }
+  return share;
+}
+
+void curlSetCacheLimits(long dns_cache_ttl, long conn_max_idle) {
+  curl_dns_cache_ttl = dns_cache_ttl;
+  curl_conn_max_idle = conn_max_idle;
+}
+
+/**
+ * @brief returns statistics about the reuse of cached connections
+ * @return a json object string; has to be freed after usage
+ */
+char* curlCacheStats() {
+  return oidc_sprintf(
+      "{\"requests\":%lu,\"new_connections\":%lu,\"reused_connections\":%lu,"
+      "\"dns_time_us\":%lld,\"connect_time_us\":%lld,\"tls_time_us\":%lld}",
+      cache_stats.requests, cache_stats.new_connections,
+      cache_stats.reused_connections, (long long)cache_stats.dns_time_us,
+      (long long)cache_stats.connect_time_us,
+      (long long)cache_stats.tls_time_us);
+}
+
+static void updateCacheStats(CURL* curl) {
+  cache_stats.requests++;
+  long connects = 0;
+  curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+  if (connects > 0) {
+    cache_stats.new_connections += connects;
+  } else {
+    cache_stats.reused_connections++;
+  }
+#if LIBCURL_VERSION_NUM >= 0x073d00
+  curl_off_t dns = 0, connect = 0, appconnect = 0;
+  curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+  curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+  curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+  cache_stats.dns_time_us += dns;
+  if (connects > 0) {
+    cache_stats.connect_time_us += connect - dns;
+    if (appconnect > connect) {
+      cache_stats.tls_time_us += appconnect - connect;
+    }
+  }
+#endif
+}
+
 /** @fn CURL* init()
  * @brief initializes curl
  * @return a CURL pointer
@@ -68,6 +168,12 @@ CURL* init() {
   curl_easy_setopt(curl, CURLOPT_USERAGENT, AGENT_VERSION);
   curl_easy_setopt(curl, CURLOPT_TIMEOUT, AGENT_CURL_TIMEOUT);
   curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, AGENT_CURL_CONNECT_TIMEOUT);
+  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(curl, CURLOPT_SHARE, getShare());
+  curl_easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, curl_dns_cache_ttl);
+#if LIBCURL_VERSION_NUM >= 0x074100
+  curl_easy_setopt(curl, CURLOPT_MAXAGE_CONN, curl_conn_max_idle);
+#endif
   return curl;
 }
 
@@ -102,6 +208,8 @@ oidc_error_t setWriteFunction(CURL* curl, struct string* s) {
   }
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
   curl_easy_setopt(curl, CURLOPT_WRITEDATA, s);
+  curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+  curl_easy_setopt(curl, CURLOPT_HEADERDATA, s);
   return OIDC_SUCCESS;
 }
 
@@ -121,8 +229,10 @@ void setUrl(CURL* curl, const char* url) {
  */
 void setPostData(CURL* curl, const char* data) {
   long data_len = (long)strlen(data);
-  curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data);
   curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, data_len);
+  // the data is copied, so the caller does not have to keep it until an
+  // asynchronous request is done
+  curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, data);
 }
 
 void setHeaders(CURL* curl, struct curl_slist* headers) {
@@ -145,9 +255,36 @@ void setBasicAuth(CURL* curl, const char* username, const char* password) {
 //   token);
 // }
 
-#ifndef AGENT_CURL_MAX_TRIES
-#define AGENT_CURL_MAX_TRIES 3
-#endif
+/**
+ * @brief checks if a finished transfer failed in a way that is worth retrying,
+ * e.g. a timeout or a temporarily unavailable server
+ * @param curl the curl instance of the finished transfer
+ * @param res the result of the transfer
+ * @return @c 1 if the transfer should be retried, @c 0 otherwise
+ */
+unsigned char transferNeedsRetry(CURL* curl, CURLcode res) {
+  updateCacheStats(curl);
+  switch (res) {
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_RESOLVE_PROXY: return 1;
+    case CURLE_OK: {
+      long status;
+      curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+      switch (status) {
+        case 408:  // Request Timeout
+        case 429:  // Too Many Requests
+        case 502:  // Bad Gateway
+        case 503:  // Service Unavailable
+        case 504:  // Gateway Timeout
+          return 1;
+        default: return 0;
+      }
+    }
+    default: return 0;
+  }
+}
 
 /** @fn int perform(CURL* curl)
  * @brief performs the https request and checks for errors
@@ -155,11 +292,9 @@ void setBasicAuth(CURL* curl, const char* username, const char* password) {
  * @return 0 on success, for error values see \f CURLErrorHandling
  */
 oidc_error_t perform(CURL* curl) {
-  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-  // curl_easy_setopt(curl, CURLOPT_POSTREDIR, CURL_REDIR_POST_ALL);
   CURLcode     res;
   unsigned int tries   = 0;
-  unsigned int sleep_t = 1;
+  unsigned int sleep_t = AGENT_CURL_RETRY_DELAY;
   do {
     if (tries != 0) {
       msleep(sleep_t * 1000);
@@ -167,26 +302,8 @@ oidc_error_t perform(CURL* curl) {
     }
     tries++;
     res = curl_easy_perform(curl);
-    switch (res) {
-      case CURLE_OPERATION_TIMEDOUT:
-      case CURLE_COULDNT_CONNECT:
-      case CURLE_COULDNT_RESOLVE_HOST:
-      case CURLE_COULDNT_RESOLVE_PROXY: break;
-      case CURLE_OK: {
-        long status;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
-        switch (status) {
-          case 408:  // Request Timeout
-          case 429:  // Too Many Requests
-          case 502:  // Bad Gateway
-          case 503:  // Service Unavailable
-          case 504:  // Gateway Timeout
-            break;
-          default: return CURLErrorHandling(res, curl);
-        }
-        break;
-      }
-      default: return CURLErrorHandling(res, curl);
+    if (!transferNeedsRetry(curl, res)) {
+      break;
     }
   } while (tries < AGENT_CURL_MAX_TRIES);
 
@@ -194,10 +311,9 @@ oidc_error_t perform(CURL* curl) {
 }
 
 /** @fn void cleanup(CURL* curl)
- * @brief does a easy and global cleanup
+ * @brief cleans up a curl handle
+ * @note the global state and the share handle are kept, so later requests can
+ * reuse cached connections
  * @param curl the curl instance
  */
-void cleanup(CURL* curl) {
-  curl_easy_cleanup(curl);
-  curl_global_cleanup();
-}
+void cleanup(CURL* curl) { curl_easy_cleanup(curl); }
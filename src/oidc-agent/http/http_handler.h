@@ -6,6 +6,19 @@
 #include "utils/oidc_error.h"
 #include "utils/string/oidc_string.h"
 
+#ifndef AGENT_CURL_DNS_CACHE_TTL
+#define AGENT_CURL_DNS_CACHE_TTL 60
+#endif
+#ifndef AGENT_CURL_CONN_MAX_IDLE
+#define AGENT_CURL_CONN_MAX_IDLE 118
+#endif
+#ifndef AGENT_CURL_MAX_TRIES
+#define AGENT_CURL_MAX_TRIES 3
+#endif
+#ifndef AGENT_CURL_RETRY_DELAY
+#define AGENT_CURL_RETRY_DELAY 1
+#endif
+
 CURL*        init();
 oidc_error_t curlMemInit();
 void         setSSLOpts(CURL* curl, const char* cert_file);
@@ -14,7 +27,10 @@ void         setUrl(CURL* curl, const char* url);
 void         setHeaders(CURL* curl, struct curl_slist* headers);
 void         setPostData(CURL* curl, const char* data);
 void setBasicAuth(CURL* curl, const char* username, const char* password);
-oidc_error_t perform(CURL* curl);
+oidc_error_t  perform(CURL* curl);
+unsigned char transferNeedsRetry(CURL* curl, CURLcode res);
 void         cleanup(CURL* curl);
+void         curlSetCacheLimits(long dns_cache_ttl, long conn_max_idle);
+char*        curlCacheStats();
 
 #endif  // HTTP_HANDLER_H
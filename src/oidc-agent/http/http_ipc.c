@@ -1,84 +1,631 @@
+#define _GNU_SOURCE
 #include "http_ipc.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include "circuit_breaker.h"
 #include "http_handler.h"
+#include "http_multi.h"
 #include "ipc/pipe.h"
 #include "utils/agentLogger.h"
+#include "utils/config/agent_config.h"
+#include "utils/json.h"
+#include "utils/listUtils.h"
 #include "utils/memory.h"
+#include "utils/memzero.h"
 #include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
 
-char* _handleParent(struct ipcPipe pipes) {
-  char* e = ipc_readFromPipe(pipes);
-  ipc_closePipes(pipes);
+#define HTTP_WORKER_KEY_METHOD "method"
+#define HTTP_WORKER_KEY_URL "url"
+#define HTTP_WORKER_KEY_DATA "data"
+#define HTTP_WORKER_KEY_HEADERS "headers"
+#define HTTP_WORKER_KEY_CERTPATH "cert_path"
+#define HTTP_WORKER_KEY_USERNAME "username"
+#define HTTP_WORKER_KEY_PASSWORD "password"
+#define HTTP_WORKER_KEY_BEARER "bearer"
+#define HTTP_WORKER_KEY_DNSCACHETTL "dns_cache_ttl"
+#define HTTP_WORKER_KEY_CONNMAXIDLE "conn_max_idle"
+
+#define HTTP_WORKER_METHOD_GET "GET"
+#define HTTP_WORKER_METHOD_POST "POST"
+#define HTTP_WORKER_METHOD_DELETE "DELETE"
+#define HTTP_WORKER_METHOD_STATS "STATS"
+
+#ifndef HTTP_WORKER_MAX_FD
+#define HTTP_WORKER_MAX_FD 65536
+#endif
+#ifndef HTTP_WORKER_READ_CHUNK
+#define HTTP_WORKER_READ_CHUNK 16384
+#endif
+
+/**
+ * @brief splits a response of the http worker, "<status> <body>"
+ * @param e the response; is freed
+ * @param status is set to the result of the request: @c OIDC_SUCCESS, the
+ * http status of an error response or an error code
+ * @return the body or @c NULL if there is none; has to be freed after usage
+ */
+static char* _parseWorkerResponse(char* e, oidc_error_t* status) {
+  *status = OIDC_EHTTP0;
   if (e == NULL) {
     return NULL;
   }
   char* end   = NULL;
   int   error = (int)strtol(e, &end, 10);
+  char* body  = *end == ' ' && end[1] != '\0' ? oidc_strcopy(end + 1) : NULL;
+  secFree(e);
+  *status = error;
+  if (body != NULL) {
+    agent_log(DEBUG, "Received response: %s", body);
+    return body;
+  }
   if (error) {
-    secFree(e);
     oidc_errno = error;
     agent_log(ERROR, "Error from http request: %s", oidc_serror());
     return NULL;
   }
-  if (*end != '\0') {
-    char* res = e;
-    agent_log(DEBUG, "Received response: %s", res);
-    return res;
-  }
-  secFree(e);
   agent_log(ERROR, "Internal error: Http sent 0");
+  *status    = OIDC_EHTTP0;
   oidc_errno = OIDC_EHTTP0;
   return NULL;
 }
 
-void handleChild(char* res, struct ipcPipe pipes) {
-  if (res == NULL) {
-    ipc_writeToPipe(pipes, "%d", oidc_errno);
-    exit(EXIT_FAILURE);
+static struct curl_slist* _jsonArrayToCurlSlist(const char* json) {
+  list_t* list = JSONArrayStringToList(json);
+  if (list == NULL) {
+    return NULL;
+  }
+  struct curl_slist* headers = NULL;
+  list_node_t*       node;
+  list_iterator_t*   it = list_iterator_new(list, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    headers = curl_slist_append(headers, node->val);
+  }
+  list_iterator_destroy(it);
+  secFreeList(list);
+  return headers;
+}
+
+/**
+ * Requests and responses between an agent process and its http worker are
+ * framed as "<id>:<length>:<payload>", so multiple requests can be in flight
+ * and responses can arrive in any order.
+ */
+static oidc_error_t _writeFrame(int fd, unsigned long id, const char* payload) {
+  char* msg =
+      oidc_sprintf("%lu:%lu:%s", id, (unsigned long)strlen(payload), payload);
+  if (msg == NULL) {
+    return oidc_errno;
+  }
+  size_t len = strlen(msg);
+#ifdef __linux__
+  if (fcntl(fd, F_GETPIPE_SZ) < (int)len) {
+    fcntl(fd, F_SETPIPE_SZ, len);
+  }
+#endif
+  size_t written = 0;
+  while (written < len) {
+    ssize_t w = write(fd, msg + written, len - written);
+    if (w < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      agent_log(ERROR, "Could not write to http worker pipe: %m");
+      secFree(msg);
+      oidc_errno = OIDC_EWRITE;
+      return oidc_errno;
+    }
+    written += w;
+  }
+  secFree(msg);
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief reads the currently available data from @p fd into @p buf
+ * @return the number of bytes read; @c 0 if the other end closed the pipe and
+ * a negative value on error
+ */
+static ssize_t _readFrames(int fd, struct string* buf) {
+  char    chunk[HTTP_WORKER_READ_CHUNK];
+  ssize_t r;
+  do {
+    r = read(fd, chunk, sizeof(chunk));
+  } while (r < 0 && errno == EINTR);
+  if (r > 0 && string_append(buf, chunk, r) != OIDC_SUCCESS) {
+    r = -1;
   }
-  ipc_writeToPipe(pipes, res);
+  moresecure_memzero(chunk, sizeof(chunk));
+  return r;
+}
+
+/**
+ * @brief removes the next complete frame from @p buf
+ * @param buf the buffer filled by @c _readFrames
+ * @param id is set to the id of the frame
+ * @return the payload of the frame or @c NULL if @p buf does not contain a
+ * complete frame; has to be freed after usage
+ */
+static char* _nextFrame(struct string* buf, unsigned long* id) {
+  if (buf->len == 0) {
+    return NULL;
+  }
+  char*         end = NULL;
+  unsigned long i   = strtoul(buf->ptr, &end, 10);
+  if (end >= buf->ptr + buf->len || *end != ':') {
+    return NULL;
+  }
+  char*         payload = NULL;
+  unsigned long len     = strtoul(end + 1, &payload, 10);
+  if (payload >= buf->ptr + buf->len || *payload != ':') {
+    return NULL;
+  }
+  payload++;
+  size_t header = payload - buf->ptr;
+  if (buf->len - header < len) {
+    return NULL;
+  }
+  char* ret = oidc_strncopy(payload, len);
+  *id       = i;
+  size_t frame = header + len;
+  memmove(buf->ptr, buf->ptr + frame, buf->len - frame);
+  moresecure_memzero(buf->ptr + buf->len - frame, frame);
+  buf->len -= frame;
+  return ret;
+}
+
+static int worker_tx = -1;
+
+/**
+ * @brief writes a response to the parent as "<status> <body>", so that the
+ * parent learns the http status of an error response that has a body
+ * @param status @c OIDC_SUCCESS or the error of the request; if @p res is
+ * @c NULL and @p status is @c OIDC_SUCCESS, @c oidc_errno is used
+ * @param res the body or @c NULL; is freed
+ */
+static void _writeWorkerResponse(unsigned long id, oidc_error_t status,
+                                 char* res) {
+  if (res == NULL && status == OIDC_SUCCESS) {
+    status = oidc_errno;
+  }
+  char* payload = oidc_sprintf("%d %s", status, res ?: "");
   secFree(res);
-  exit(EXIT_SUCCESS);
+  if (_writeFrame(worker_tx, id, payload) != OIDC_SUCCESS) {
+    exit(EXIT_FAILURE);
+  }
+  secFree(payload);
 }
 
-/** @fn char* httpsGET(const char* url, const char* cert_path)
- * @brief forks and does a https GET request
- * @param url the request url
- * @param cert_path the path to the SSL certs
- * @return a pointer to the response. Has to be freed after usage. If the Https
- * call failed, NULL is returned.
+static void _workerTransferDone(struct http_request* req, oidc_error_t err,
+                                void* arg) {
+  char* res = http_finishRequest(req, err);
+  _writeWorkerResponse((unsigned long)(uintptr_t)arg, err, res);
+}
+
+/**
+ * @brief starts a single request in the http worker; the response is written
+ * back when the request is done
+ * @param id the id of the request
+ * @param request the json encoded request
  */
-char* httpsGET(const char* url, struct curl_slist* headers,
-               const char* cert_path) {
+static void _startWorkerRequest(unsigned long id, const char* request) {
+  INIT_KEY_VALUE(HTTP_WORKER_KEY_METHOD, HTTP_WORKER_KEY_URL,
+                 HTTP_WORKER_KEY_DATA, HTTP_WORKER_KEY_HEADERS,
+                 HTTP_WORKER_KEY_CERTPATH, HTTP_WORKER_KEY_USERNAME,
+                 HTTP_WORKER_KEY_PASSWORD, HTTP_WORKER_KEY_BEARER,
+                 HTTP_WORKER_KEY_DNSCACHETTL, HTTP_WORKER_KEY_CONNMAXIDLE);
+  if (CALL_GETJSONVALUES(request) < 0) {
+    SEC_FREE_KEY_VALUES();
+    _writeWorkerResponse(id, OIDC_SUCCESS, NULL);
+    return;
+  }
+  KEY_VALUE_VARS(method, url, data, headers, cert_path, username, password,
+                 bearer, dns_cache_ttl, conn_max_idle);
+  if (strequal(_method, HTTP_WORKER_METHOD_STATS)) {
+    _writeWorkerResponse(id, OIDC_SUCCESS, curlCacheStats());
+    SEC_FREE_KEY_VALUES();
+    return;
+  }
+  if (_dns_cache_ttl && _conn_max_idle) {
+    curlSetCacheLimits(strToLong(_dns_cache_ttl), strToLong(_conn_max_idle));
+  }
+  struct curl_slist*   headers = _jsonArrayToCurlSlist(_headers);
+  struct http_request* req     = NULL;
+  if (strequal(_method, HTTP_WORKER_METHOD_GET)) {
+    req = _httpsPrepareGET(_url, headers, _cert_path);
+  } else if (strequal(_method, HTTP_WORKER_METHOD_POST)) {
+    headers = curl_slist_append(headers, HTTP_HEADER_ACCEPT_JSON);
+    req     = _httpsPreparePOST(_url, _data, headers, _cert_path, _username,
+                                _password);
+  } else if (strequal(_method, HTTP_WORKER_METHOD_DELETE)) {
+    req = _httpsPrepareDELETE(_url, headers, _cert_path, _bearer);
+  } else {
+    oidc_errno = OIDC_EERROR;
+  }
+  SEC_FREE_KEY_VALUES();
+  if (req == NULL) {
+    curl_slist_free_all(headers);
+    _writeWorkerResponse(id, OIDC_SUCCESS, NULL);
+    return;
+  }
+  if (headers) {
+    req->owned_headers = headers;
+  }
+  if (httpMulti_add(req, _workerTransferDone, (void*)(uintptr_t)id) !=
+      OIDC_SUCCESS) {
+    oidc_error_t e = oidc_errno;
+    http_finishRequest(req, e);
+    oidc_errno = e;
+    _writeWorkerResponse(id, OIDC_SUCCESS, NULL);
+  }
+}
+
+/**
+ * @brief main loop of the http worker; performs requests until the parent
+ * closes the pipe
+ * @note the worker lives as long as its parent, so the curl share handle (DNS
+ * cache, TLS sessions and connections) is reused for all requests. All
+ * requests are driven by a single curl multi handle, so slow providers do not
+ * delay other requests.
+ */
+_Noreturn static void _httpWorker(struct ipcPipe pipes) {
+  worker_tx         = pipes.tx;
+  struct string buf = {0};
+  if (init_string(&buf) != OIDC_SUCCESS) {
+    exit(EXIT_FAILURE);
+  }
+  while (1) {
+    fd_set read_fds, write_fds;
+    FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    FD_SET(pipes.rx, &read_fds);
+    int maxfd = httpMulti_fdset(&read_fds, &write_fds, pipes.rx);
+    struct timeval  tv;
+    struct timeval* timeout = httpMulti_timeout(&tv);
+    int rv = select(maxfd + 1, &read_fds, &write_fds, NULL, timeout);
+    if (rv < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      agent_log(ALERT, "error select in %s: %m", __func__);
+      exit(EXIT_FAILURE);
+    }
+    if (rv > 0 && FD_ISSET(pipes.rx, &read_fds)) {
+      if (_readFrames(pipes.rx, &buf) <= 0) {  // parent closed the pipe or died
+        exit(EXIT_SUCCESS);
+      }
+      unsigned long id;
+      char*         request;
+      while ((request = _nextFrame(&buf, &id)) != NULL) {
+        _startWorkerRequest(id, request);
+        secFree(request);
+      }
+    }
+    httpMulti_perform(&read_fds, &write_fds);
+  }
+}
+
+/**
+ * @brief a request that was sent to the worker and whose response was not yet
+ * received
+ */
+struct http_pending {
+  unsigned long        id;
+  char*                url;
+  http_callback        callback;
+  void*                arg;
+  struct http_pending* next;
+};
+
+static void _secFreePending(struct http_pending* p) {
+  secFree(p->url);
+  secFree(p);
+}
+
+static pid_t                worker_pid = -1;
+static struct ipcPipe       worker_pipes;
+static struct string        worker_buf;
+static struct http_pending* pending = NULL;
+static unsigned long        next_id = 1;
+static struct ipc_watch     worker_watch;
+
+static void _stopWorker() {
+  if (worker_pid == -1) {
+    return;
+  }
+  ipc_closePipes(worker_pipes);
+  waitpid(worker_pid, NULL, WNOHANG);
+  worker_pid      = -1;
+  worker_watch.fd = -1;
+  secFree(worker_buf.ptr);
+  // requests that were in flight cannot be answered anymore
+  struct http_pending* lost = pending;
+  pending                   = NULL;
+  while (lost) {
+    struct http_pending* p = lost;
+    lost                   = p->next;
+    circuitBreaker_record(p->url, OIDC_EIPCDIS);
+    oidc_errno = OIDC_EIPCDIS;
+    p->callback(NULL, p->arg);
+    _secFreePending(p);
+  }
+}
+
+static oidc_error_t _startWorker() {
+  if (init_string(&worker_buf) != OIDC_SUCCESS) {
+    return oidc_errno;
+  }
   struct pipeSet pipes = ipc_pipe_init();
   if (pipes.pipe1.rx == -1) {
-    return NULL;
+    secFree(worker_buf.ptr);
+    return oidc_errno;
   }
-  pid_t pid = fork();
+  pid_t ppid_before_fork = getpid();
+  pid_t pid              = fork();
   if (pid == -1) {
     agent_log(ALERT, "fork %m");
     oidc_setErrnoError();
-    return NULL;
+    ipc_closePipes(pipes.pipe1);
+    ipc_closePipes(pipes.pipe2);
+    secFree(worker_buf.ptr);
+    return oidc_errno;
   }
   if (pid == 0) {  // child
+#ifdef __linux__
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+    if (getppid() != ppid_before_fork) {
+      exit(EXIT_FAILURE);
+    }
     struct ipcPipe childPipes = toClientPipes(pipes);
+    // the worker outlives the current request, so it must not keep sockets
+    // or pipes of its parent open
+    long max_fd = sysconf(_SC_OPEN_MAX);
+    if (max_fd < 0 || max_fd > HTTP_WORKER_MAX_FD) {
+      max_fd = HTTP_WORKER_MAX_FD;
+    }
+    for (int fd = STDERR_FILENO + 1; fd < max_fd; fd++) {
+      if (fd != childPipes.rx && fd != childPipes.tx) {
+        close(fd);
+      }
+    }
     logger_open("oidc-agent.http");
-    char* res = _httpsGET(url, headers, cert_path);
-    handleChild(res, childPipes);
+    _httpWorker(childPipes);
+  }
+  signal(SIGCHLD, SIG_IGN);
+  worker_pipes    = toServerPipes(pipes);
+  worker_pid      = pid;
+  worker_watch.fd = worker_pipes.rx;
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief reads the available responses from the worker and passes them to the
+ * callbacks of the matching requests
+ */
+static void _dispatchWorkerResponses() {
+  if (worker_pid == -1) {
+    return;
+  }
+  if (_readFrames(worker_pipes.rx, &worker_buf) <= 0) {
+    agent_log(ERROR, "http worker died");
+    _stopWorker();
+    return;
+  }
+  unsigned long id;
+  char*         res;
+  while (worker_pid != -1 && (res = _nextFrame(&worker_buf, &id)) != NULL) {
+    struct http_pending** prev = &pending;
+    while (*prev && (*prev)->id != id) { prev = &(*prev)->next; }
+    struct http_pending* p = *prev;
+    if (p == NULL) {
+      agent_log(ERROR, "Received http response for unknown request %lu", id);
+      secFree(res);
+      continue;
+    }
+    *prev       = p->next;
+    oidc_error_t status;
+    char*        reply = _parseWorkerResponse(res, &status);
+    // An error page of a load balancer has a body, but the provider is down
+    circuitBreaker_record(p->url, status);
+    p->callback(reply, p->arg);
+    _secFreePending(p);
+  }
+}
+
+/**
+ * @brief sends a request to the http worker; the worker is (re)started if
+ * needed
+ * @param url the url of the request; used to track the health of the provider
+ * @param request the json encoded request
+ * @param callback called with the response once it arrives
+ * @param arg passed to @p callback
+ * @return @c OIDC_SUCCESS if the request was sent; an error code otherwise
+ */
+static oidc_error_t _workerSubmit(const char* url, const char* request,
+                                  http_callback callback, void* arg) {
+  // A request is only sent again if it could not be delivered, i.e. if the
+  // worker died in between two requests
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (worker_pid == -1 && _startWorker() != OIDC_SUCCESS) {
+      return oidc_errno;
+    }
+    unsigned long id = next_id++;
+    if (_writeFrame(worker_pipes.tx, id, request) != OIDC_SUCCESS) {
+      _stopWorker();
+      continue;
+    }
+    struct http_pending* p = secAlloc(sizeof(struct http_pending));
+    p->id                  = id;
+    p->url                 = oidc_strcopy(url);
+    p->callback            = callback;
+    p->arg                 = arg;
+    p->next                = pending;
+    pending                = p;
+    return OIDC_SUCCESS;
+  }
+  return oidc_errno;
+}
+
+struct http_sync_result {
+  unsigned char done;
+  char*         res;
+  oidc_error_t  err;
+};
+
+static void _syncCallback(char* res, void* arg) {
+  struct http_sync_result* result = arg;
+  result->res                     = res;
+  result->err                     = res ? OIDC_SUCCESS : oidc_errno;
+  result->done                    = 1;
+}
+
+/**
+ * @brief sends a request to the http worker and waits for its response;
+ * responses to asynchronous requests that arrive in the meantime are passed
+ * to their callbacks
+ * @param request the json encoded request
+ * @return a pointer to the response or @c NULL on error
+ */
+static char* _workerRequest(const char* url, const char* request) {
+  struct http_sync_result result = {0};
+  if (_workerSubmit(url, request, _syncCallback, &result) != OIDC_SUCCESS) {
+    return NULL;
+  }
+  while (!result.done) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(worker_pipes.rx, &set);
+    if (select(worker_pipes.rx + 1, &set, NULL, NULL, NULL) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      agent_log(ALERT, "error select in %s: %m", __func__);
+      _stopWorker();
+      continue;
+    }
+    _dispatchWorkerResponses();
+  }
+  if (result.res == NULL) {
+    oidc_errno = result.err;
+  }
+  return result.res;
+}
+
+static char* _buildRequest(const char* method, const char* url,
+                           const char* data, struct curl_slist* headers,
+                           const char* cert_path, const char* username,
+                           const char* password, const char* bearer_token) {
+  // values are added with cJSON directly, so they are not logged
+  cJSON* json = generateJSONObject(HTTP_WORKER_KEY_METHOD, cJSON_String,
+                                   method, NULL);
+  if (url) {
+    cJSON_AddStringToObject(json, HTTP_WORKER_KEY_URL, url);
+  }
+  if (data) {
+    cJSON_AddStringToObject(json, HTTP_WORKER_KEY_DATA, data);
+  }
+  if (headers) {
+    cJSON* headers_json = cJSON_AddArrayToObject(json, HTTP_WORKER_KEY_HEADERS);
+    for (struct curl_slist* h = headers; h; h = h->next) {
+      cJSON_AddItemToArray(headers_json, cJSON_CreateString(h->data));
+    }
+  }
+  if (cert_path) {
+    cJSON_AddStringToObject(json, HTTP_WORKER_KEY_CERTPATH, cert_path);
+  }
+  if (username) {
+    cJSON_AddStringToObject(json, HTTP_WORKER_KEY_USERNAME, username);
+    cJSON_AddStringToObject(json, HTTP_WORKER_KEY_PASSWORD, password ?: "");
+  }
+  if (bearer_token) {
+    cJSON_AddStringToObject(json, HTTP_WORKER_KEY_BEARER, bearer_token);
+  }
+  const agent_config_t* config = getAgentConfig();
+  cJSON_AddNumberToObject(json, HTTP_WORKER_KEY_DNSCACHETTL,
+                          config->http_dns_cache_ttl_set
+                              ? config->http_dns_cache_ttl
+                              : AGENT_CURL_DNS_CACHE_TTL);
+  cJSON_AddNumberToObject(json, HTTP_WORKER_KEY_CONNMAXIDLE,
+                          config->http_conn_max_idle_set
+                              ? config->http_conn_max_idle
+                              : AGENT_CURL_CONN_MAX_IDLE);
+  char* request = jsonToStringUnformatted(json);
+  secFreeJson(json);
+  return request;
+}
+
+static char* _doRequest(const char* method, const char* url, const char* data,
+                        struct curl_slist* headers, const char* cert_path,
+                        const char* username, const char* password,
+                        const char* bearer_token) {
+  if (url && circuitBreaker_allow(url) != OIDC_SUCCESS) {
+    return NULL;
+  }
+  char* request = _buildRequest(method, url, data, headers, cert_path,
+                                username, password, bearer_token);
+  if (request == NULL) {
+    circuitBreaker_record(url, oidc_errno);
     return NULL;
-  } else {  // parent
-    signal(SIGCHLD, SIG_IGN);
-    struct ipcPipe parentPipes = toServerPipes(pipes);
-    return _handleParent(parentPipes);
   }
+  char* res = _workerRequest(url, request);
+  secFree(request);
+  return res;
+}
+
+static oidc_error_t _doAsyncRequest(const char* method, const char* url,
+                                    const char* data,
+                                    struct curl_slist* headers,
+                                    const char*        cert_path,
+                                    const char*        username,
+                                    const char*        password,
+                                    const char*        bearer_token,
+                                    http_callback callback, void* arg) {
+  if (url && circuitBreaker_allow(url) != OIDC_SUCCESS) {
+    return oidc_errno;
+  }
+  char* request = _buildRequest(method, url, data, headers, cert_path,
+                                username, password, bearer_token);
+  if (request == NULL) {
+    circuitBreaker_record(url, oidc_errno);
+    return oidc_errno;
+  }
+  oidc_error_t e = _workerSubmit(url, request, callback, arg);
+  if (e != OIDC_SUCCESS) {
+    circuitBreaker_record(url, e);
+  }
+  secFree(request);
+  return e;
+}
+
+/** @fn char* httpsGET(const char* url, const char* cert_path)
+ * @brief does a https GET request through the http worker
+ * @param url the request url
+ * @param cert_path the path to the SSL certs
+ * @return a pointer to the response. Has to be freed after usage. If the Https
+ * call failed, NULL is returned.
+ */
+char* httpsGET(const char* url, struct curl_slist* headers,
+               const char* cert_path) {
+  char* res = _doRequest(HTTP_WORKER_METHOD_GET, url, NULL, headers, cert_path,
+                         NULL, NULL, NULL);
+  markPublicMem(res);
+  return res;
 }
 
 /** @fn char* httpsDELETE(const char* url, const char* cert_path)
- * @brief forks and does a https DELETE request
+ * @brief does a https DELETE request through the http worker
  * @param url the request url
  * @param cert_path the path to the SSL certs
  * @return a pointer to the response. Has to be freed after usage. If the Https
@@ -86,32 +633,13 @@ char* httpsGET(const char* url, struct curl_slist* headers,
  */
 char* httpsDELETE(const char* url, struct curl_slist* headers,
                   const char* cert_path, const char* bearer_token) {
-  struct pipeSet pipes = ipc_pipe_init();
-  if (pipes.pipe1.rx == -1) {
-    return NULL;
-  }
-  pid_t pid = fork();
-  if (pid == -1) {
-    agent_log(ALERT, "fork %m");
-    oidc_setErrnoError();
-    return NULL;
-  }
-  if (pid == 0) {  // child
-    struct ipcPipe childPipes = toClientPipes(pipes);
-    logger_open("oidc-agent.http");
-    char* res = _httpsDELETE(url, headers, cert_path, bearer_token);
-    handleChild(res, childPipes);
-    return NULL;
-  } else {  // parent
-    signal(SIGCHLD, SIG_IGN);
-    struct ipcPipe parentPipes = toServerPipes(pipes);
-    return _handleParent(parentPipes);
-  }
+  return _doRequest(HTTP_WORKER_METHOD_DELETE, url, NULL, headers, cert_path,
+                    NULL, NULL, bearer_token);
 }
 
 /** @fn char* httpsPOST(const char* url, const char* data, const char*
  * cert_path)
- * @brief forks and does a https POST request
+ * @brief does a https POST request through the http worker
  * @param url the request url
  * @param cert_path the path to the SSL certs
  * @param data the data to be posted
@@ -121,27 +649,79 @@ char* httpsDELETE(const char* url, struct curl_slist* headers,
 char* httpsPOST(const char* url, const char* data, struct curl_slist* headers,
                 const char* cert_path, const char* username,
                 const char* password) {
-  struct pipeSet pipes = ipc_pipe_init();
-  if (pipes.pipe1.rx == -1) {
-    return NULL;
-  }
-  pid_t pid = fork();
-  if (pid == -1) {
-    agent_log(ALERT, "fork %m");
-    oidc_setErrnoError();
-    return NULL;
-  }
-  if (pid == 0) {  // child
-    struct ipcPipe childPipes = toClientPipes(pipes);
-    logger_open("oidc-agent.http");
-    headers   = curl_slist_append(headers, HTTP_HEADER_ACCEPT_JSON);
-    char* res = _httpsPOST(url, data, headers, cert_path, username, password);
-    handleChild(res, childPipes);
+  return _doRequest(HTTP_WORKER_METHOD_POST, url, data, headers, cert_path,
+                    username, password, NULL);
+}
+
+/**
+ * @brief starts a https GET request without waiting for the response
+ * @param url the request url
+ * @param headers additional headers; can be freed directly after the call
+ * @param cert_path the path to the SSL certs
+ * @param callback called with the response once it arrived; the response has
+ * to be freed by the callback. If the request failed, the response is @c NULL
+ * and @c oidc_errno is set.
+ * @param arg passed to @p callback
+ * @return @c OIDC_SUCCESS if the request was started; @p callback is only
+ * called in that case
+ * @note the callback is called from the event loop, so the watch returned by
+ * @c httpAsyncWatch must be part of it
+ */
+oidc_error_t httpsGETAsync(const char* url, struct curl_slist* headers,
+                           const char* cert_path, http_callback callback,
+                           void* arg) {
+  return _doAsyncRequest(HTTP_WORKER_METHOD_GET, url, NULL, headers, cert_path,
+                         NULL, NULL, NULL, callback, arg);
+}
+
+/**
+ * @brief starts a https POST request without waiting for the response
+ * @see httpsGETAsync
+ */
+oidc_error_t httpsPOSTAsync(const char* url, const char* data,
+                            struct curl_slist* headers, const char* cert_path,
+                            const char* username, const char* password,
+                            http_callback callback, void* arg) {
+  return _doAsyncRequest(HTTP_WORKER_METHOD_POST, url, data, headers,
+                         cert_path, username, password, NULL, callback, arg);
+}
+
+/**
+ * @brief starts a https DELETE request without waiting for the response
+ * @see httpsGETAsync
+ */
+oidc_error_t httpsDELETEAsync(const char* url, struct curl_slist* headers,
+                              const char* cert_path, const char* bearer_token,
+                              http_callback callback, void* arg) {
+  return _doAsyncRequest(HTTP_WORKER_METHOD_DELETE, url, NULL, headers,
+                         cert_path, NULL, NULL, bearer_token, callback, arg);
+}
+
+/**
+ * @brief returns the watch that delivers responses of asynchronous requests;
+ * it has to be added to the event loop of the calling process
+ * @param next the watch that is chained after the http watch; might be
+ * @c NULL
+ * @return the http watch
+ */
+const struct ipc_watch* httpAsyncWatch(const struct ipc_watch* next) {
+  worker_watch.fd     = worker_pid == -1 ? -1 : worker_pipes.rx;
+  worker_watch.handle = _dispatchWorkerResponses;
+  worker_watch.next   = next;
+  return &worker_watch;
+}
+
+/**
+ * @brief returns statistics about the connection caches of the http worker
+ * @return a json object string or @c NULL if no http request was done yet;
+ * has to be freed after usage
+ */
+char* httpCacheStats() {
+  if (worker_pid == -1) {
     return NULL;
-  } else {  // parent
-    struct ipcPipe parentPipes = toServerPipes(pipes);
-    return _handleParent(parentPipes);
   }
+  return _doRequest(HTTP_WORKER_METHOD_STATS, NULL, NULL, NULL, NULL, NULL,
+                    NULL, NULL);
 }
 
 char* sendPostDataWithBasicAuth(const char* endpoint, const char* data,
@@ -2,11 +2,19 @@
 #define HTTP_IPC_H
 
 #include "http.h"
+#include "ipc/ipc.h"
 
 #define HTTP_HEADER_ACCEPT_JSON "Accept: application/json"
 #define HTTP_HEADER_CONTENTTYPE_JSON "Content-Type: application/json"
 #define HTTP_HEADER_AUTHORIZATION_BEARER_FMT "Authorization: Bearer %s"
 
+/*
+ * The blocking calls wait for their own response and meanwhile dispatch the
+ * callbacks of any other response that arrives. oidcd serves one request at a
+ * time with sequential flows, so refresh (except the background refresh),
+ * revocation and discovery still block its main loop until the provider
+ * answers.
+ */
 char* httpsGET(const char* url, struct curl_slist* list, const char* cert_path);
 char* httpsPOST(const char* url, const char* data, struct curl_slist* headers,
                 const char* cert_path, const char* username,
@@ -28,6 +36,27 @@ char* sendJSONPostWithoutBasicAuth(const char* endpoint, const char* data,
                                    const char*        cert_path,
                                    struct curl_slist* headers);
 
+/**
+ * @brief called with the response of an asynchronous request
+ * @param res the response or @c NULL on error (@c oidc_errno is set); has to
+ * be freed by the callback
+ * @param arg the argument passed when starting the request
+ */
+typedef void (*http_callback)(char* res, void* arg);
+
+oidc_error_t httpsGETAsync(const char* url, struct curl_slist* headers,
+                           const char* cert_path, http_callback callback,
+                           void* arg);
+oidc_error_t httpsPOSTAsync(const char* url, const char* data,
+                            struct curl_slist* headers, const char* cert_path,
+                            const char* username, const char* password,
+                            http_callback callback, void* arg);
+oidc_error_t httpsDELETEAsync(const char* url, struct curl_slist* headers,
+                              const char* cert_path, const char* bearer_token,
+                              http_callback callback, void* arg);
+const struct ipc_watch* httpAsyncWatch(const struct ipc_watch* next);
+
 char* urlescape(const char* str);
+char* httpCacheStats();
 
 #endif  // HTTP_IPC_H
@@ -0,0 +1,292 @@
+#define _POSIX_C_SOURCE 200809L
+#include "http_multi.h"
+
+#include <time.h>
+
+#include "http_errorHandler.h"
+#include "http_handler.h"
+#include "utils/agentLogger.h"
+#include "utils/memory.h"
+
+/**
+ * A single request that is driven by the curl multi handle. Transfers that
+ * failed temporarily are not retried by sleeping, but are parked in the
+ * @c waiting list until their retry time is reached.
+ */
+struct http_transfer {
+  struct http_request*  req;
+  http_multi_callback   callback;
+  void*                 arg;
+  unsigned int          tries;
+  unsigned int          sleep_t;
+  long long             retry_at;
+  struct http_transfer* next;
+};
+
+struct http_socket {
+  curl_socket_t fd;
+  int           what;
+};
+
+static CURLM*                multi    = NULL;
+static long long             timer_at = -1;
+static struct http_transfer* waiting  = NULL;
+static size_t                pending  = 0;
+
+static struct http_socket* sockets     = NULL;
+static size_t              sockets_len = 0;
+static size_t              sockets_cap = 0;
+
+static long long now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int socketCallback(CURL* easy, curl_socket_t fd, int what, void* userp,
+                          void* socketp) {
+  (void)easy;
+  (void)userp;
+  (void)socketp;
+  for (size_t i = 0; i < sockets_len; i++) {
+    if (sockets[i].fd != fd) {
+      continue;
+    }
+    if (what == CURL_POLL_REMOVE) {
+      sockets[i] = sockets[--sockets_len];
+    } else {
+      sockets[i].what = what;
+    }
+    return 0;
+  }
+  if (what == CURL_POLL_REMOVE) {
+    return 0;
+  }
+  if (sockets_len == sockets_cap) {
+    size_t              cap = sockets_cap ? sockets_cap * 2 : 8;
+    struct http_socket* tmp =
+        sockets ? secRealloc(sockets, cap * sizeof(struct http_socket))
+                : pubAlloc(cap * sizeof(struct http_socket));
+    if (tmp == NULL) {
+      return -1;
+    }
+    sockets     = tmp;
+    sockets_cap = cap;
+  }
+  sockets[sockets_len].fd   = fd;
+  sockets[sockets_len].what = what;
+  sockets_len++;
+  return 0;
+}
+
+static int timerCallback(CURLM* m, long timeout_ms, void* userp) {
+  (void)m;
+  (void)userp;
+  timer_at = timeout_ms < 0 ? -1 : now_ms() + timeout_ms;
+  return 0;
+}
+
+static CURLM* getMulti() {
+  if (multi == NULL) {
+    if (curlMemInit() != OIDC_SUCCESS) {
+      return NULL;
+    }
+    multi = curl_multi_init();
+    if (multi == NULL) {
+      agent_log(ERROR, "Could not init curl multi handle");
+      oidc_errno = OIDC_ECURLI;
+      return NULL;
+    }
+    curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, socketCallback);
+    curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, timerCallback);
+  }
+  return multi;
+}
+
+static oidc_error_t startTransfer(struct http_transfer* t) {
+  t->tries++;
+  CURLMcode res = curl_multi_add_handle(multi, t->req->curl);
+  if (res != CURLM_OK) {
+    agent_log(ERROR, "Could not start http request: %s",
+              curl_multi_strerror(res));
+    oidc_errno = OIDC_ECURLI;
+    return oidc_errno;
+  }
+  return OIDC_SUCCESS;
+}
+
+static void finishTransfer(struct http_transfer* t, oidc_error_t err) {
+  pending--;
+  http_multi_callback callback = t->callback;
+  struct http_request* req     = t->req;
+  void*                arg     = t->arg;
+  secFree(t);
+  callback(req, err, arg);
+}
+
+/**
+ * @brief adds a request to the multi handle; the request is performed while
+ * the caller drives the multi handle through @c httpMulti_perform
+ * @param req the request; ownership is passed to the multi handle until the
+ * callback is called
+ * @param callback the function called when the request is done
+ * @param arg passed to @p callback
+ * @return @c OIDC_SUCCESS or an error code; on error @p req is still owned by
+ * the caller
+ */
+oidc_error_t httpMulti_add(struct http_request* req,
+                           http_multi_callback callback, void* arg) {
+  if (req == NULL || callback == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return oidc_errno;
+  }
+  if (getMulti() == NULL) {
+    return oidc_errno;
+  }
+  struct http_transfer* t = secAlloc(sizeof(struct http_transfer));
+  t->req                  = req;
+  t->callback             = callback;
+  t->arg                  = arg;
+  t->sleep_t              = AGENT_CURL_RETRY_DELAY;
+  curl_easy_setopt(req->curl, CURLOPT_PRIVATE, t);
+  if (startTransfer(t) != OIDC_SUCCESS) {
+    secFree(t);
+    return oidc_errno;
+  }
+  pending++;
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief adds the sockets curl is waiting on to the passed fd sets
+ * @return the highest file descriptor in the sets
+ */
+int httpMulti_fdset(fd_set* read_fds, fd_set* write_fds, int maxfd) {
+  for (size_t i = 0; i < sockets_len; i++) {
+    if (sockets[i].what & CURL_POLL_IN) {
+      FD_SET(sockets[i].fd, read_fds);
+    }
+    if (sockets[i].what & CURL_POLL_OUT) {
+      FD_SET(sockets[i].fd, write_fds);
+    }
+    if (sockets[i].fd > maxfd) {
+      maxfd = sockets[i].fd;
+    }
+  }
+  return maxfd;
+}
+
+/**
+ * @brief computes how long the caller may wait for socket activity before
+ * @c httpMulti_perform has to be called
+ * @param tv is filled with the timeout
+ * @return @p tv or @c NULL if there is nothing to wait for
+ */
+struct timeval* httpMulti_timeout(struct timeval* tv) {
+  long long due = timer_at;
+  for (struct http_transfer* t = waiting; t; t = t->next) {
+    if (due < 0 || t->retry_at < due) {
+      due = t->retry_at;
+    }
+  }
+  if (due < 0) {
+    return NULL;
+  }
+  long long wait = due - now_ms();
+  if (wait < 0) {
+    wait = 0;
+  }
+  tv->tv_sec  = wait / 1000;
+  tv->tv_usec = (wait % 1000) * 1000;
+  return tv;
+}
+
+static void startDueRetries() {
+  long long              now  = now_ms();
+  struct http_transfer** prev = &waiting;
+  while (*prev) {
+    struct http_transfer* t = *prev;
+    if (t->retry_at > now) {
+      prev = &t->next;
+      continue;
+    }
+    *prev   = t->next;
+    t->next = NULL;
+    if (startTransfer(t) != OIDC_SUCCESS) {
+      finishTransfer(t, oidc_errno);
+    }
+  }
+}
+
+static void handleDoneTransfers() {
+  CURLMsg* msg;
+  int      left;
+  while ((msg = curl_multi_info_read(multi, &left))) {
+    if (msg->msg != CURLMSG_DONE) {
+      continue;
+    }
+    CURL*                 easy = msg->easy_handle;
+    CURLcode              res  = msg->data.result;
+    struct http_transfer* t    = NULL;
+    curl_easy_getinfo(easy, CURLINFO_PRIVATE, (char**)&t);
+    curl_multi_remove_handle(multi, easy);
+    if (transferNeedsRetry(easy, res) && t->tries < AGENT_CURL_MAX_TRIES) {
+      agent_log(DEBUG, "Retrying http request in %u seconds", t->sleep_t);
+      http_resetResponse(t->req);
+      t->retry_at = now_ms() + (long long)t->sleep_t * 1000;
+      t->sleep_t *= 2;
+      t->next = waiting;
+      waiting = t;
+      continue;
+    }
+    finishTransfer(t, CURLErrorHandling(res, easy));
+  }
+}
+
+/**
+ * @brief drives all running requests; has to be called after waiting on the
+ * fd sets filled by @c httpMulti_fdset, at the latest when the timeout given by
+ * @c httpMulti_timeout is reached
+ * @param read_fds the readable file descriptors
+ * @param write_fds the writable file descriptors
+ */
+void httpMulti_perform(const fd_set* read_fds, const fd_set* write_fds) {
+  if (multi == NULL) {
+    return;
+  }
+  int running = 0;
+  // socket_action might change the socket list, so the ready sockets are
+  // collected first
+  size_t              ready_len = 0;
+  struct http_socket* ready =
+      sockets_len ? pubAlloc(sockets_len * sizeof(struct http_socket)) : NULL;
+  for (size_t i = 0; i < sockets_len; i++) {
+    int flags = 0;
+    if (read_fds && FD_ISSET(sockets[i].fd, read_fds)) {
+      flags |= CURL_CSELECT_IN;
+    }
+    if (write_fds && FD_ISSET(sockets[i].fd, write_fds)) {
+      flags |= CURL_CSELECT_OUT;
+    }
+    if (flags) {
+      ready[ready_len].fd   = sockets[i].fd;
+      ready[ready_len].what = flags;
+      ready_len++;
+    }
+  }
+  for (size_t i = 0; i < ready_len; i++) {
+    curl_multi_socket_action(multi, ready[i].fd, ready[i].what, &running);
+  }
+  secFree(ready);
+  if (timer_at >= 0 && timer_at <= now_ms()) {
+    timer_at = -1;
+    curl_multi_socket_action(multi, CURL_SOCKET_TIMEOUT, 0, &running);
+  }
+  startDueRetries();
+  handleDoneTransfers();
+}
+
+/**
+ * @brief returns the number of requests that are not yet done
+ */
+size_t httpMulti_pending() { return pending; }
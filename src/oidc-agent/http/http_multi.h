@@ -0,0 +1,28 @@
+#ifndef HTTP_MULTI_H
+#define HTTP_MULTI_H
+
+#include <stddef.h>
+#include <sys/select.h>
+#include <sys/time.h>
+
+#include "http.h"
+#include "utils/oidc_error.h"
+
+/**
+ * @brief called when a request added with @c httpMulti_add is done
+ * @param req the finished request; ownership is passed to the callback, which
+ * usually passes it to @c http_finishRequest
+ * @param err the result of the request
+ * @param arg the argument passed to @c httpMulti_add
+ */
+typedef void (*http_multi_callback)(struct http_request* req, oidc_error_t err,
+                                    void* arg);
+
+oidc_error_t    httpMulti_add(struct http_request* req,
+                              http_multi_callback callback, void* arg);
+int             httpMulti_fdset(fd_set* read_fds, fd_set* write_fds, int maxfd);
+struct timeval* httpMulti_timeout(struct timeval* tv);
+void   httpMulti_perform(const fd_set* read_fds, const fd_set* write_fds);
+size_t httpMulti_pending();
+
+#endif  // HTTP_MULTI_H
@@ -1,17 +1,53 @@
 #define _XOPEN_SOURCE
 #include "requestHandler.h"
 
-#include <signal.h>
+#include <pthread.h>
 #include <string.h>
 
 #include "defines/ipc_values.h"
 #include "ipc/serveripc.h"
 #include "utils/agentLogger.h"
 #include "utils/errorUtils.h"
+#include "utils/hashmap.h"
 #include "utils/memory.h"
 #include "utils/parseJson.h"
 #include "utils/string/stringUtils.h"
 
+/**
+ * The states of the flows that wait for a redirect to this server, mapped to
+ * the redirect uri they use. The map is updated by the control loop of the
+ * server and read by the request threads.
+ */
+static pthread_mutex_t states_lock = PTHREAD_MUTEX_INITIALIZER;
+static hashmap_t*      states      = NULL;
+
+void requestHandler_addState(const char* state, const char* redirect_uri) {
+  pthread_mutex_lock(&states_lock);
+  if (states == NULL) {
+    states = hashmap_new(8, _secFree);
+  }
+  hashmap_put(states, state, oidc_strcopy(redirect_uri));
+  pthread_mutex_unlock(&states_lock);
+}
+
+void requestHandler_removeState(const char* state) {
+  pthread_mutex_lock(&states_lock);
+  if (states != NULL) {
+    _secFree(hashmap_remove(states, state));
+  }
+  pthread_mutex_unlock(&states_lock);
+}
+
+static char* _getRedirectUri(const char* state) {
+  if (state == NULL) {
+    return NULL;
+  }
+  pthread_mutex_lock(&states_lock);
+  char* uri = states ? oidc_strcopy(hashmap_get(states, state)) : NULL;
+  pthread_mutex_unlock(&states_lock);
+  return uri;
+}
+
 const char* const HTML_SUCCESS =
 #include "static/success.html"
     ;
@@ -83,7 +119,6 @@ static int makeResponseError(struct MHD_Connection* connection) {
     response = MHD_create_response_from_buffer(strlen(res), (void*)res,
                                                MHD_RESPMEM_MUST_COPY);
     secFree(res);
-    kill(getpid(), SIGTERM);
   } else {
     response = MHD_create_response_from_buffer(
         strlen(HTML_NO_CODE), (void*)HTML_NO_CODE, MHD_RESPMEM_PERSISTENT);
@@ -93,7 +128,7 @@ static int makeResponseError(struct MHD_Connection* connection) {
   return ret;
 }
 
-static int handleRequest(void* cls, struct MHD_Connection* connection) {
+static int handleRequest(struct MHD_Connection* connection) {
   const char* code =
       MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "code");
   const char* state =
@@ -103,11 +138,12 @@ static int handleRequest(void* cls, struct MHD_Connection* connection) {
     return makeResponseError(connection);
   }
   agent_log(DEBUG, "HttpServer: Code is %s", code);
-  char** cr = (char**)cls;
-  if (!strequal(cr[1], state)) {
+  char* redirect_uri = _getRedirectUri(state);
+  if (redirect_uri == NULL) {
     return makeResponseWrongState(connection);
   }
-  char* url = oidc_sprintf("%s?code=%s&state=%s", cr[0], code, state);
+  char* url = oidc_sprintf("%s?code=%s&state=%s", redirect_uri, code, state);
+  secFree(redirect_uri);
   char* res = ipc_cryptCommunicateWithServerPath(REQUEST_CODEEXCHANGE, url);
   int   ret;
   if (res == NULL) {
@@ -117,14 +153,13 @@ static int handleRequest(void* cls, struct MHD_Connection* connection) {
     ret = makeResponseFromIPCResponse(connection, res, url, state);
   }
   secFree(url);
-  secFreeArray(cr, 2);
   return ret;
 }
 
 #ifdef MHD_YES
-int request_echo(void* cls, struct MHD_Connection* connection, const char* url,
+int request_echo(void* cls __attribute__((unused)), struct MHD_Connection* connection, const char* url,
 #else
-enum MHD_Result request_echo(void* cls, struct MHD_Connection* connection, const char* url,
+enum MHD_Result request_echo(void* cls __attribute__((unused)), struct MHD_Connection* connection, const char* url,
 #endif
                  const char* method, const char* version,
                  const char* upload_data __attribute__((unused)),
@@ -148,5 +183,5 @@ enum MHD_Result request_echo(void* cls, struct MHD_Connection* connection, const
   }
   *ptr = NULL; /* clear context pointer */
 
-  return handleRequest(cls, connection);
+  return handleRequest(connection);
 }
@@ -11,4 +11,7 @@ enum MHD_Result request_echo(void* cls, struct MHD_Connection* connection, const
                  const char* method, const char* version,
                  const char* upload_data, size_t* upload_data_size, void** ptr);
 
+void requestHandler_addState(const char* state, const char* redirect_uri);
+void requestHandler_removeState(const char* state);
+
 #endif  // HTTP_REQUEST_HANDLER_H
@@ -1,43 +1,151 @@
 #include "running_server.h"
 
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
 #include "utils/agentLogger.h"
+#include "utils/hashmap.h"
 #include "utils/listUtils.h"
 #include "utils/memory.h"
 #include "utils/string/stringUtils.h"
 
-static list_t* servers = NULL;
+static list_t*    servers = NULL;
+static hashmap_t* states  = NULL;  // state -> server, values are not owned
 
 void _secFreeRunningServer(struct running_server* s) {
-  secFree(s->state);
+  if (s->ctrl >= 0) {
+    close(s->ctrl);
+  }
   secFree(s);
 }
 
-int matchRunningServer(char* state, struct running_server* s) {
-  return strequal(s->state, state);
-}
-
 void addServer(struct running_server* running_server) {
   if (servers == NULL) {
-    servers        = list_new();
-    servers->free  = (void(*)(void*)) & _secFreeRunningServer;
-    servers->match = (matchFunction)matchRunningServer;
+    servers       = list_new();
+    servers->free = (void (*)(void*)) & _secFreeRunningServer;
   }
   list_rpush(servers, list_node_new(running_server));
-  agent_log(DEBUG, "Added Server. Now %d server run", servers->len);
+  agent_log(DEBUG, "Added Server for port %hu. Now %d server run",
+            running_server->port, servers->len);
+}
+
+struct running_server* getServerForPort(unsigned short port) {
+  if (servers == NULL) {
+    return NULL;
+  }
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(servers, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    if (((struct running_server*)node->val)->port == port) {
+      break;
+    }
+  }
+  list_iterator_destroy(it);
+  return node ? node->val : NULL;
+}
+
+static void _collectStates(const char* state, void* server, void* arg) {
+  void** args = arg;
+  if (server == args[0]) {
+    list_rpush(args[1], list_node_new(oidc_strcopy(state)));
+  }
+}
+
+/**
+ * @brief forgets a server that cannot be used anymore, together with the
+ * states registered with it
+ */
+void removeServer(struct running_server* running_server) {
+  if (states != NULL) {
+    list_t* gone = list_new();
+    gone->free   = _secFree;
+    void* args[] = {running_server, gone};
+    hashmap_foreach(states, _collectStates, args);
+    list_node_t*     node;
+    list_iterator_t* it = list_iterator_new(gone, LIST_HEAD);
+    while ((node = list_iterator_next(it))) {
+      hashmap_remove(states, node->val);
+    }
+    list_iterator_destroy(it);
+    secFreeList(gone);
+  }
+  list_node_t* node = servers ? list_find(servers, running_server) : NULL;
+  if (node != NULL) {
+    list_remove(servers, node);
+    agent_log(DEBUG, "Removed Server. Now %d server run", servers->len);
+  }
 }
 
-pid_t removeServer(const char* state) {
+/**
+ * @brief closes the control pipes of all servers; used in a newly forked
+ * server, so that the other servers notice when oidcd is gone
+ */
+void closeServerControls() {
   if (servers == NULL) {
-    agent_log(DEBUG, "No servers running");
-    return -1;
+    return;
+  }
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(servers, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    close(((struct running_server*)node->val)->ctrl);
+  }
+  list_iterator_destroy(it);
+}
+
+static oidc_error_t _writeControl(int fd, const char* msg) {
+  size_t len = strlen(msg);
+  while (len > 0) {
+    ssize_t written = write(fd, msg, len);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      oidc_setErrnoError();
+      return oidc_errno;
+    }
+    msg += written;
+    len -= written;
   }
-  list_node_t* n = findInList(servers, (char*)state);
-  if (n == NULL) {
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief registers the state of a flow with a server, so that the server
+ * accepts the redirect for it
+ * @param redirect_uri the redirect uri the flow uses; it is needed for the
+ * code exchange
+ */
+oidc_error_t serverAddState(struct running_server* running_server,
+                            const char* state, const char* redirect_uri) {
+  char*        msg = oidc_sprintf("+%s %s\n", state, redirect_uri);
+  oidc_error_t e   = _writeControl(running_server->ctrl, msg);
+  secFree(msg);
+  if (e != OIDC_SUCCESS) {
+    agent_log(ERROR, "Could not register state with HttpServer: %s",
+              oidc_serror());
+    return e;
+  }
+  if (states == NULL) {
+    states = hashmap_new(8, NULL);
+  }
+  hashmap_put(states, state, running_server);
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief unregisters the state of a flow from its server
+ * @return @c 1 if the state was registered, @c 0 otherwise
+ */
+int serverRemoveState(const char* state) {
+  struct running_server* running_server =
+      states ? hashmap_remove(states, state) : NULL;
+  if (running_server == NULL) {
     agent_log(DEBUG, "No server found for state %s", state);
-    return -1;
+    return 0;
   }
-  pid_t pid = ((struct running_server*)n->val)->pid;
-  list_remove(servers, n);
-  agent_log(DEBUG, "Removed Server. Now %d server run", servers->len);
-  return pid;
+  char* msg = oidc_sprintf("-%s\n", state);
+  _writeControl(running_server->ctrl, msg);
+  secFree(msg);
+  return 1;
 }
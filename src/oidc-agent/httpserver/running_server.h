@@ -3,16 +3,29 @@
 
 #include <sys/types.h>
 
+#include "utils/oidc_error.h"
+
+/**
+ * A redirect listener of oidcd. It serves all auth code flows whose redirect
+ * uri uses its port; the flows are registered with their state through the
+ * control pipe.
+ */
 struct running_server {
-  pid_t pid;
-  char* state;
+  pid_t          pid;
+  int            ctrl;  // write end of the control pipe
+  unsigned short port;
 };
 
 void _secFreeRunningServer(struct running_server* s);
-int  matchRunningServer(char* state, struct running_server* s);
 
-void  addServer(struct running_server* running_server);
-pid_t removeServer(const char* state);
+void                   addServer(struct running_server* running_server);
+struct running_server* getServerForPort(unsigned short port);
+void                   removeServer(struct running_server* running_server);
+void                   closeServerControls();
+oidc_error_t           serverAddState(struct running_server* running_server,
+                                      const char*            state,
+                                      const char*            redirect_uri);
+int                    serverRemoveState(const char* state);
 
 #ifndef secFreeRunningServer
 #define secFreeRunningServer(ptr) \
@@ -3,7 +3,9 @@
 
 #include <fcntl.h>
 #include <signal.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #ifdef __APPLE__
 #include <sys/event.h>
 #include <sys/time.h>
@@ -23,30 +25,32 @@
 #include "utils/string/stringUtils.h"
 #include "wrapper/list.h"
 
+#if MHD_VERSION >= 0x00095300
+#define HTTPSERVER_FLAGS MHD_USE_INTERNAL_POLLING_THREAD
+#else
+#define HTTPSERVER_FLAGS MHD_USE_SELECT_INTERNALLY
+#endif
+
 /**
- * @param config a pointer to a json account config.
- * */
-struct MHD_Daemon** startHttpServer(const char* redirect_uri,
-                                    const char* state) {
+ * @brief starts a redirect listener on the port of a redirect uri; requests
+ * are served by a fixed pool of threads
+ */
+struct MHD_Daemon** startHttpServer(const char* redirect_uri) {
   logger_open("oidc-agent.httpserver");
   unsigned short port = getPortFromUri(redirect_uri);
   if (port == 0) {
     agent_log(NOTICE, "Could not get port from uri");
     return NULL;
   }
-  size_t              cls_size = 2;
-  struct MHD_Daemon** d_ptr    = secAlloc(sizeof(struct MHD_Daemon*));
-  char**              cls      = secAlloc(sizeof(char*) * cls_size);
-  cls[0]                       = oidc_strcopy(redirect_uri);
-  cls[1] = oidc_sprintf("%hhu:%s", strEnds(redirect_uri, "/"), state);
-  *d_ptr = MHD_start_daemon(MHD_USE_THREAD_PER_CONNECTION, port, NULL, NULL,
-                            &request_echo, cls, MHD_OPTION_END);
+  struct MHD_Daemon** d_ptr = secAlloc(sizeof(struct MHD_Daemon*));
+  *d_ptr = MHD_start_daemon(HTTPSERVER_FLAGS, port, NULL, NULL, &request_echo,
+                            NULL, MHD_OPTION_THREAD_POOL_SIZE,
+                            (unsigned int)HTTPSERVER_THREADS, MHD_OPTION_END);
 
   if (*d_ptr == NULL) {
     agent_log(ERROR, "Error starting the HttpServer on port %d", port);
     oidc_errno = OIDC_EHTTPD;
     secFree(d_ptr);
-    secFreeArray(cls, cls_size);
     return NULL;
   }
   agent_log(DEBUG, "HttpServer: Started HttpServer on port %d", port);
@@ -99,22 +103,63 @@ void http_sig_handler(int signo) {
   exit(signo);
 }
 
-oidc_error_t fireHttpServer(list_t* redirect_uris, size_t size,
-                            char** state_ptr) {
+/**
+ * @brief registers and unregisters the states of flows as told by oidcd
+ * through the control pipe; returns when oidcd closed the pipe
+ */
+static void serveControl(int ctrl) {
+  FILE* in = fdopen(ctrl, "r");
+  if (in == NULL) {
+    return;
+  }
+  char*  line = NULL;
+  size_t size = 0;
+  while (getline(&line, &size, in) > 0) {
+    line[strcspn(line, "\n")] = '\0';
+    char* uri                  = strchr(line, ' ');
+    if (line[0] == '+' && uri != NULL) {
+      *uri++ = '\0';
+      requestHandler_addState(line + 1, uri);
+    } else if (line[0] == '-') {
+      requestHandler_removeState(line + 1);
+    }
+  }
+  free(line);
+  fclose(in);
+}
+
+/**
+ * @brief forks a redirect listener on the first port of @p redirect_uris
+ * that can be used
+ * @return the server or @c NULL on failure
+ */
+static struct running_server* forkHttpServer(list_t* redirect_uris,
+                                             size_t  size) {
   int fd[2];
+  int ctrl[2];
 #ifdef __APPLE__
   if (pipe(fd) != 0) {
 #else
   if (pipe2(fd, O_DIRECT) != 0) {
 #endif
     oidc_setErrnoError();
-    return oidc_errno;
+    return NULL;
+  }
+  if (pipe(ctrl) != 0) {
+    oidc_setErrnoError();
+    close(fd[0]);
+    close(fd[1]);
+    return NULL;
   }
   pid_t pid = fork();
   if (pid == -1) {
     agent_log(ALERT, "fork %m");
     oidc_setErrnoError();
-    return oidc_errno;
+    close(fd[0]);
+    close(fd[1]);
+    close(ctrl[0]);
+    close(ctrl[1]);
+    return NULL;
   }
   if (pid == 0) {  // child
 #ifdef __APPLE__
@@ -123,10 +168,11 @@ oidc_error_t fireHttpServer(list_t* redirect_uris, size_t size,
     prctl(PR_SET_PDEATHSIG, SIGTERM);
 #endif
     close(fd[0]);
+    close(ctrl[1]);
+    closeServerControls();
     size_t i;
     for (i = 0; i < size && oidc_mhd_daemon_ptr == NULL; i++) {
-      oidc_mhd_daemon_ptr =
-          startHttpServer(list_at(redirect_uris, i)->val, *state_ptr);
+      oidc_mhd_daemon_ptr = startHttpServer(list_at(redirect_uris, i)->val);
     }
     if (oidc_mhd_daemon_ptr == NULL) {
       ipc_write(fd[1], "%d", OIDC_EHTTPPORTS);
@@ -137,49 +183,87 @@ oidc_error_t fireHttpServer(list_t* redirect_uris, size_t size,
     ipc_write(fd[1], "%hu", getPortFromUri(used_uri));
     close(fd[1]);
     signal(SIGTERM, http_sig_handler);
-    sigset_t sigset;
-    sigemptyset(&sigset);
-    sigaddset(&sigset, SIGTERM);
-    sigsuspend(&sigset);
-    return OIDC_ENOPE;
-  } else {  // parent
-    close(fd[1]);
-    char* e = ipc_read(fd[0]);
-    close(fd[0]);
-    if (e == NULL) {
-      return oidc_errno;
-    }
-    char**   endptr = secAlloc(sizeof(char*));
-    long int port   = strtol(e, endptr, 10);
-    if (**endptr != '\0') {
-      secFree(endptr);
-      secFree(e);
-      oidc_errno = OIDC_EERROR;
-      oidc_seterror("Internal error. Could not convert pipe communication.");
-      return oidc_errno;
-    }
+    serveControl(ctrl[0]);
+    agent_log(DEBUG, "HttpServer: oidcd closed the control pipe");
+    stopHttpServer(oidc_mhd_daemon_ptr);
+    exit(EXIT_SUCCESS);
+  }
+  // parent
+  close(fd[1]);
+  close(ctrl[0]);
+  char* e = ipc_read(fd[0]);
+  close(fd[0]);
+  if (e == NULL) {
+    close(ctrl[1]);
+    return NULL;
+  }
+  char**   endptr = secAlloc(sizeof(char*));
+  long int port   = strtol(e, endptr, 10);
+  if (**endptr != '\0') {
     secFree(endptr);
     secFree(e);
-    if (port < 0) {
-      oidc_errno = port;
-      agent_log(ERROR, "HttpServer Start Error: %s", oidc_serror());
-      return oidc_errno;
+    close(ctrl[1]);
+    oidc_errno = OIDC_EERROR;
+    oidc_seterror("Internal error. Could not convert pipe communication.");
+    return NULL;
+  }
+  secFree(endptr);
+  secFree(e);
+  if (port < 0) {
+    close(ctrl[1]);
+    oidc_errno = port;
+    agent_log(ERROR, "HttpServer Start Error: %s", oidc_serror());
+    return NULL;
+  }
+  struct running_server* running_server =
+      secAlloc(sizeof(struct running_server));
+  running_server->pid  = pid;
+  running_server->ctrl = ctrl[1];
+  running_server->port = port;
+  addServer(running_server);
+  return running_server;
+}
+
+/**
+ * @brief makes a redirect listener accept the redirect of an auth code flow
+ *
+ * oidcd keeps one listener per port that serves all flows; a listener is only
+ * started if no running listener uses the port of one of the redirect uris.
+ * @param state_ptr a pointer to the state of the flow; it is prefixed with
+ * information about the used redirect uri
+ * @return the port of the listener or an error code
+ */
+oidc_error_t fireHttpServer(list_t* redirect_uris, size_t size,
+                            char** state_ptr) {
+  // A listener might have died; then it is replaced once
+  for (int attempt = 0; attempt < 2; attempt++) {
+    struct running_server* running_server = NULL;
+    for (size_t i = 0; i < size && running_server == NULL; i++) {
+      running_server =
+          getServerForPort(getPortFromUri(list_at(redirect_uris, i)->val));
+    }
+    if (running_server == NULL) {
+      running_server = forkHttpServer(redirect_uris, size);
+      if (running_server == NULL) {
+        return oidc_errno;
+      }
     }
     char* used_uri = NULL;
-    for (size_t i = 0; i < size; i++) {
-      unsigned short p = getPortFromUri(list_at(redirect_uris, i)->val);
-      if (p == port) {
+    for (size_t i = 0; i < size && used_uri == NULL; i++) {
+      if (getPortFromUri(list_at(redirect_uris, i)->val) ==
+          running_server->port) {
         used_uri = list_at(redirect_uris, i)->val;
       }
     }
     char* tmp = oidc_sprintf("%hhu:%s", strEnds(used_uri, "/"), *state_ptr);
+    if (serverAddState(running_server, tmp, used_uri) != OIDC_SUCCESS) {
+      secFree(tmp);
+      removeServer(running_server);
+      continue;
+    }
     secFree(*state_ptr);
     *state_ptr = tmp;
-    struct running_server* running_server =
-        secAlloc(sizeof(struct running_server));
-    running_server->pid   = pid;
-    running_server->state = oidc_strcopy(*state_ptr);
-    addServer(running_server);
-    return port;
+    return running_server->port;
   }
+  return oidc_errno;
 }
@@ -5,6 +5,10 @@
 #include "utils/oidc_error.h"
 #include "wrapper/list.h"
 
+#ifndef HTTPSERVER_THREADS
+#define HTTPSERVER_THREADS 4
+#endif
+
 oidc_error_t fireHttpServer(list_t* redirect_uris, size_t size,
                             char** state_ptr);
 
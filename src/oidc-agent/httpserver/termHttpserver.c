@@ -2,7 +2,6 @@
 #include "termHttpserver.h"
 
 #include <microhttpd.h>
-#include <signal.h>
 #include <sys/types.h>
 #ifdef __MSYS__
 #include <sys/select.h>
@@ -18,13 +17,15 @@ void stopHttpServer(struct MHD_Daemon** d_ptr) {
   secFree(d_ptr);
 }
 
+/**
+ * @brief stops accepting the redirect for a flow; the server itself keeps
+ * running for other flows
+ */
 void termHttpServer(const char* state) {
   if (state == NULL) {
     return;
   }
-  pid_t pid = removeServer(state);
-  if (pid > 0) {
-    kill(pid, SIGTERM);
-    agent_log(DEBUG, "killed webserver for state %s with pid %d", state, pid);
+  if (serverRemoveState(state)) {
+    agent_log(DEBUG, "unregistered state %s from webserver", state);
   }
 }
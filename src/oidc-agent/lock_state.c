@@ -7,11 +7,13 @@
 #include "utils/crypt/dbCryptUtils.h"
 #include "utils/memory.h"
 #include "utils/oidc_error.h"
-#include "utils/sleeper.h"
 #include "utils/string/stringUtils.h"
 
+/**
+ * @note a wrong password is answered right away; the brute-force delay is
+ * added by oidcp, so that only the client that tried the password waits
+ */
 oidc_error_t unlock(const char* password) {
-  static unsigned char fail_count = 0;
   agent_log(DEBUG, "Unlocking agent");
   if (agent_state.lock_state.locked == 0) {
     agent_log(DEBUG, "Agent not locked");
@@ -22,20 +24,13 @@ oidc_error_t unlock(const char* password) {
   if (!strequal(agent_state.lock_state.hash, hash)) {
     secFree(hash);
     oidc_errno = OIDC_EPASS;
-    if (fail_count < 25) {
-      fail_count++;
-    }
-    unsigned int delay = 100 * fail_count * fail_count;
-    agent_log(DEBUG, "unlock failed, delaying %0.1lf seconds",
-              (double)delay / 1000);
-    msleep(delay);
+    agent_log(DEBUG, "unlock failed");
     return oidc_errno;
   }
   secFree(hash);
 
   if (lockDecrypt(password) == OIDC_SUCCESS) {
     agent_state.lock_state.locked = 0;
-    fail_count                    = 0;
     secFree(agent_state.lock_state.hash);
     agent_log(DEBUG, "Agent unlocked");
     return OIDC_SUCCESS;
@@ -15,6 +15,7 @@
 #define OPT_JSON 10
 #define OPT_QUIET 11
 #define OPT_NO_AUTOREAUTHENTICATE 12
+#define OPT_KERNEL_KEYRING 13
 
 void initArguments(struct arguments* arguments) {
   arguments->kill_flag             = 0;
@@ -33,6 +34,7 @@ void initArguments(struct arguments* arguments) {
   arguments->json                  = 0;
   arguments->quiet                 = 0;
   arguments->no_autoreauthenticate = !getAgentConfig()->autoreauth;
+  arguments->kernel_keyring        = getAgentConfig()->kernel_keyring;
   arguments->command               = NULL;
   arguments->args_list             = NULL;
 }
@@ -86,6 +88,12 @@ static struct argp_option options[] = {
      "substitute them with random characters.",
      1},
     {"bind_address", 'a', "PATH", OPTION_ALIAS, NULL, 1},
+    {"kernel-keyring", OPT_KERNEL_KEYRING, 0, 0,
+     "Publishes access tokens in the session keyring of the kernel, so that "
+     "applications in the same session can read them without contacting the "
+     "agent. Only applies to Linux and not to accounts that require "
+     "confirmation.",
+     1},
     {"always-allow-idtoken", OPT_ALWAYS_ALLOW_IDTOKEN, 0, 0,
      "Always allow id-token requests without manual approval by the user.", 1},
     {"json", OPT_JSON, 0, 0,
@@ -136,6 +144,7 @@ static error_t parse_opt(int key, char* arg __attribute__((unused)),
     case OPT_JSON: arguments->json = 1; break;
     case OPT_QUIET: arguments->quiet = 1; break;
     case OPT_NO_AUTOREAUTHENTICATE: arguments->no_autoreauthenticate = 1; break;
+    case OPT_KERNEL_KEYRING: arguments->kernel_keyring = 1; break;
     case 'h':
       argp_state_help(state, state->out_stream, ARGP_HELP_STD_HELP);
       break;
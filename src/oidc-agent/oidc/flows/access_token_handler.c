@@ -7,6 +7,7 @@
 #include "password.h"
 #include "refresh.h"
 #include "utils/agentLogger.h"
+#include "utils/config/agent_config.h"
 #include "utils/json.h"
 #include "utils/listUtils.h"
 #include "utils/string/stringUtils.h"
@@ -65,15 +66,41 @@ int tokenIsValidForSeconds(const struct oidc_account* p,
   return expires_at - now > 0 && expires_at - now > min_valid_period;
 }
 
+static time_t staleTokenFloor(time_t stale_min_valid_period) {
+  const agent_config_t* config = getAgentConfig();
+  time_t                floor  = config->stale_token_min_valid_set
+                                     ? config->stale_token_min_valid
+                                     : AGENT_STALE_TOKEN_MIN_VALID;
+  return stale_min_valid_period > floor ? stale_min_valid_period : floor;
+}
+
+/**
+ * @brief returns an access token for an account, doing a refresh flow if the
+ * current one is not valid long enough
+ * @param min_valid_period the period of time the access token should be valid
+ * @param stale_min_valid_period if not 0, the caller also accepts a token that
+ * is valid for at least this period (but never less than the
+ * @c stale_token_min_valid_period of the agent config); such a token is
+ * returned immediately and a new one is obtained in the background
+ */
 char* getAccessTokenUsingRefreshFlow(struct oidc_account* account,
-                                     time_t min_valid_period, const char* scope,
-                                     const char*    audience,
+                                     time_t               min_valid_period,
+                                     time_t               stale_min_valid_period,
+                                     const char* scope, const char* audience,
                                      struct ipcPipe pipes) {
   if (scope == NULL && audience == NULL &&
       min_valid_period != FORCE_NEW_TOKEN &&
-      strValid(account_getAccessToken(account)) &&
-      tokenIsValidForSeconds(account, min_valid_period)) {
-    return account_getAccessToken(account);
+      strValid(account_getAccessToken(account))) {
+    if (tokenIsValidForSeconds(account, min_valid_period)) {
+      return account_getAccessToken(account);
+    }
+    if (stale_min_valid_period > 0 &&
+        tokenIsValidForSeconds(account,
+                               staleTokenFloor(stale_min_valid_period)) &&
+        refreshFlowInBackground(account) == OIDC_SUCCESS) {
+      agent_log(DEBUG, "Returning stale access token while refreshing");
+      return account_getAccessToken(account);
+    }
   }
   agent_log(DEBUG, "No access token found that is valid long enough");
   return tryRefreshFlow(account, scope, audience, pipes);
@@ -8,9 +8,15 @@
 #include "utils/oidc_error.h"
 #include "wrapper/list.h"
 
+#ifndef AGENT_STALE_TOKEN_MIN_VALID
+#define AGENT_STALE_TOKEN_MIN_VALID 60
+#endif
+
 char*        getAccessTokenUsingRefreshFlow(struct oidc_account* account,
-                                            time_t min_valid_period, const char* scope,
-                                            const char*    audience,
+                                            time_t      min_valid_period,
+                                            time_t      stale_min_valid_period,
+                                            const char* scope,
+                                            const char* audience,
                                             struct ipcPipe pipes);
 char*        getIdToken(struct oidc_account* p, const char* scope,
                         struct ipcPipe pipes);
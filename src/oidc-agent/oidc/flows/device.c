@@ -1,5 +1,7 @@
 #include "device.h"
 
+#include <time.h>
+
 #include "defines/oidc_values.h"
 #include "oidc-agent/http/http_ipc.h"
 #include "oidc-agent/oidc/parse_oidp.h"
@@ -7,10 +9,17 @@
 #include "oidc.h"
 #include "utils/agentLogger.h"
 #include "utils/config/issuerConfig.h"
+#include "utils/crypt/memoryCrypt.h"
 #include "utils/db/deviceCode_db.h"
 #include "utils/errorUtils.h"
+#include "utils/json.h"
+#include "utils/listUtils.h"
 #include "utils/string/stringUtils.h"
 
+#define DEVICE_POLL_DEFAULT_INTERVAL 5
+#define DEVICE_POLL_DEFAULT_LIFETIME 300
+#define DEVICE_POLL_SLOW_DOWN 5
+
 char* generateDeviceCodePostData(const struct oidc_account* a) {
   return generatePostData(OIDC_KEY_CLIENTID, account_getClientId(a),
                           OIDC_KEY_SCOPE, account_getScope(a), NULL);
@@ -73,12 +82,147 @@ struct oidc_device_code* initDeviceFlow(struct oidc_account* account) {
   struct oidc_device_code* deviceCode = parseDeviceCode(res);
   secFree(res);
   if (deviceCode != NULL) {
-    deviceCodeDB_addValue(
-        createDeviceCodeEntry(deviceCode->device_code, account));
+    struct deviceCodeEntry* entry =
+        createDeviceCodeEntry(deviceCode->device_code, account);
+    time_t now        = time(NULL);
+    entry->interval   = deviceCode->interval ?: DEVICE_POLL_DEFAULT_INTERVAL;
+    entry->next_poll  = now + entry->interval;
+    entry->expires_at = now + (deviceCode->expires_in
+                                   ?: DEVICE_POLL_DEFAULT_LIFETIME);
+    deviceCodeDB_addValue(entry);
   }
   return deviceCode;
 }
 
+/**
+ * Device codes are polled by oidcd itself instead of on each device lookup
+ * request. All codes share the timer of the oidcd main loop, polls are sent
+ * through the async http path and each code keeps its own interval, which is
+ * increased on @c slow_down. A device lookup request only looks at the last
+ * response, so it never waits for the provider and it does not matter how
+ * often clients ask. That response holds the tokens; it is kept encrypted
+ * like other secrets in memory until it is handled.
+ */
+
+static struct deviceCodeEntry* _findEntry(const char* device_code) {
+  struct deviceCodeEntry key = {.device_code = (char*)device_code};
+  return deviceCodeDB_findValue(&key);
+}
+
+static void _devicePollDone(char* res, void* arg) {
+  char*                   device_code = arg;
+  struct deviceCodeEntry* entry       = _findEntry(device_code);
+  secFree(device_code);
+  if (entry == NULL) {  // lookup failed or the code was removed otherwise
+    secFree(res);
+    return;
+  }
+  entry->polling = 0;
+  char* error    = res ? getJSONValueFromString(res, OIDC_KEY_ERROR) : NULL;
+  if (res != NULL && error == NULL) {  // tokens
+    entry->response = memoryEncrypt(res);
+    secFree(res);
+    return;
+  }
+  if (res == NULL || strequal(error, OIDC_AUTHORIZATION_PENDING) ||
+      strequal(error, OIDC_SLOW_DOWN)) {
+    if (strequal(error, OIDC_SLOW_DOWN)) {
+      entry->interval += DEVICE_POLL_SLOW_DOWN;
+      agent_log(DEBUG, "Slowing down device code polling to %zus",
+                entry->interval);
+    }
+    entry->next_poll = time(NULL) + entry->interval;
+    secFree(error);
+    secFree(res);
+    return;
+  }
+  agent_log(DEBUG, "Device code polling ended with error '%s'", error);
+  secFree(error);
+  entry->response = memoryEncrypt(res);
+  secFree(res);
+}
+
+static oidc_error_t _pollDeviceCodeAsync(struct deviceCodeEntry* entry) {
+  const struct oidc_account* account = entry->account;
+  char* data = generateDeviceCodeLookupPostData(account, entry->device_code);
+  if (data == NULL) {
+    return oidc_errno;
+  }
+  char*        cert_path = account_getCertPathOrDefault(account);
+  char*        code      = oidc_strcopy(entry->device_code);
+  oidc_error_t e         = httpsPOSTAsync(
+      account_getTokenEndpoint(account), data, NULL, cert_path,
+      account_getClientId(account), account_getClientSecret(account),
+      _devicePollDone, code);
+  secFree(cert_path);
+  secFree(data);
+  if (e != OIDC_SUCCESS) {
+    secFree(code);
+    return e;
+  }
+  entry->polling = 1;
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief starts a poll request for each device code whose interval passed
+ * @note expired device codes are removed by the time to live of the device
+ * code db
+ */
+void pollDueDeviceCodes() {
+  list_t* entries = deviceCodeDB_getList();
+  if (entries == NULL) {
+    return;
+  }
+  time_t           now = time(NULL);
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(entries, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    struct deviceCodeEntry* entry = node->val;
+    if (entry->next_poll != 0 && !entry->polling && entry->response == NULL &&
+        entry->expires_at > now && entry->next_poll <= now &&
+        _pollDeviceCodeAsync(entry) != OIDC_SUCCESS) {
+      agent_log(NOTICE, "Could not poll device code: %s", oidc_serror());
+      entry->next_poll = now + entry->interval;
+    }
+  }
+  list_iterator_destroy(it);
+}
+
+/**
+ * @brief returns the time when the next device code has to be polled, @c 0
+ * if there is none
+ */
+time_t getNextDeviceCodePoll() {
+  list_t* entries = deviceCodeDB_getList();
+  if (entries == NULL) {
+    return 0;
+  }
+  time_t           now  = time(NULL);
+  time_t           next = 0;
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(entries, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    const struct deviceCodeEntry* entry = node->val;
+    if (entry->next_poll == 0 || entry->response != NULL) {
+      continue;
+    }
+    // The response to a running poll only reschedules the code, but the main
+    // loop does not recompute its timeout then; so wake up in time for the
+    // next poll
+    time_t due = entry->polling ? now + (time_t)entry->interval
+                                : entry->next_poll;
+    if (due >= entry->expires_at) {
+      continue;
+    }
+    if (next == 0 || due < next) {
+      next = due;
+    }
+  }
+  list_iterator_destroy(it);
+  return next;
+}
+
 void handleDeviceLookupError(const char* error, const char* error_description) {
   if (strequal(error, OIDC_SLOW_DOWN) ||
       strequal(error, OIDC_AUTHORIZATION_PENDING)) {
@@ -95,10 +239,37 @@ void handleDeviceLookupError(const char* error, const char* error_description) {
   oidc_errno = OIDC_EOIDC;
 }
 
+static oidc_error_t _parseDeviceLookupResponse(struct oidc_account* account,
+                                               char*                res,
+                                               struct ipcPipe       pipes) {
+  char* access_token = parseTokenResponseCallbacks(
+      TOKENPARSEMODE_RETURN_AT | TOKENPARSEMODE_SAVE_AT, res, account,
+      &handleDeviceLookupError, pipes, 0);
+  secFree(res);
+  return access_token == NULL ? oidc_errno : OIDC_SUCCESS;
+}
+
 oidc_error_t lookUpDeviceCode(struct oidc_account* account,
                               const char* device_code, struct ipcPipe pipes) {
   agent_log(DEBUG, "Doing Device Code Lookup\n");
 
+  struct deviceCodeEntry* entry = _findEntry(device_code);
+  if (entry != NULL && entry->next_poll != 0) {
+    if (entry->response == NULL) {
+      handleDeviceLookupError(entry->expires_at > time(NULL)
+                                  ? OIDC_AUTHORIZATION_PENDING
+                                  : OIDC_EXPIRED_TOKEN,
+                              "the device code expired");
+      return oidc_errno;
+    }
+    char* res = memoryDecrypt(entry->response);
+    secFree(entry->response);
+    if (res == NULL) {
+      return oidc_errno;
+    }
+    return _parseDeviceLookupResponse(account, res, pipes);
+  }
+
   char* data = generateDeviceCodeLookupPostData(account, device_code);
   if (data == NULL) {
     return oidc_errno;
@@ -113,10 +284,5 @@ oidc_error_t lookUpDeviceCode(struct oidc_account* account,
   if (res == NULL) {
     return oidc_errno;
   }
-
-  char* access_token = parseTokenResponseCallbacks(
-      TOKENPARSEMODE_RETURN_AT | TOKENPARSEMODE_SAVE_AT, res, account,
-      &handleDeviceLookupError, pipes, 0);
-  secFree(res);
-  return access_token == NULL ? oidc_errno : OIDC_SUCCESS;
+  return _parseDeviceLookupResponse(account, res, pipes);
 }
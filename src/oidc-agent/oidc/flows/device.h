@@ -1,6 +1,8 @@
 #ifndef OIDC_DEVICE_H
 #define OIDC_DEVICE_H
 
+#include <time.h>
+
 #include "account/account.h"
 #include "ipc/pipe.h"
 #include "oidc-agent/oidc/device_code.h"
@@ -9,5 +11,7 @@ struct oidc_device_code* initDeviceFlow(struct oidc_account* account);
 oidc_error_t             lookUpDeviceCode(struct oidc_account* account,
                                           const char* device_code, struct ipcPipe pipes);
 void handleDeviceLookupError(const char* error, const char* error_description);
+void pollDueDeviceCodes();
+time_t getNextDeviceCodePoll();
 
 #endif  // OIDC_DEVICE_H
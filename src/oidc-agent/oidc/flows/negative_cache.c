@@ -0,0 +1,109 @@
+#include "negative_cache.h"
+
+#include "utils/agentLogger.h"
+#include "utils/hashmap.h"
+#include "utils/listUtils.h"
+#include "utils/memory.h"
+#include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
+
+/**
+ * Refresh requests that were rejected with invalid_grant are remembered for a
+ * short time, so that clients retrying in a loop do not hammer the provider
+ * with a refresh token that is known to be invalid. The entries are keyed by
+ * a hash, so that no refresh token is kept in plain text. Expired entries are
+ * pruned from the main loop of oidcd.
+ */
+struct negative_entry {
+  time_t until;
+  char*  error;
+};
+
+static hashmap_t* negative_cache = NULL;
+
+static void _secFreeNegativeEntry(void* e) {
+  struct negative_entry* entry = e;
+  if (entry == NULL) {
+    return;
+  }
+  secFree(entry->error);
+  secFree(entry);
+}
+
+struct expired_collector {
+  list_t* keys;
+  time_t  next;
+};
+
+static void _collectExpired(const char* key, void* value, void* arg) {
+  const struct negative_entry* entry = value;
+  struct expired_collector*    c     = arg;
+  if (entry->until <= time(NULL)) {
+    list_rpush(c->keys, list_node_new(oidc_strcopy(key)));
+  } else if (c->next == 0 || entry->until < c->next) {
+    c->next = entry->until;
+  }
+}
+
+/**
+ * @brief removes the expired entries of the negative cache
+ * @return the time when the next entry expires, @c 0 if there is none
+ */
+time_t negativeCache_prune() {
+  if (negative_cache == NULL) {
+    return 0;
+  }
+  struct expired_collector c = {.keys = list_new(), .next = 0};
+  c.keys->free               = _secFree;
+  hashmap_foreach(negative_cache, _collectExpired, &c);
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(c.keys, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    _secFreeNegativeEntry(hashmap_remove(negative_cache, node->val));
+  }
+  list_iterator_destroy(it);
+  secFreeList(c.keys);
+  return c.next;
+}
+
+/**
+ * @brief checks if a refresh request was rejected recently
+ * @return @c 1 if it was; the stored error is set as the oidc error. @c 0
+ * otherwise
+ */
+int negativeCache_lookup(const char* key) {
+  if (negative_cache == NULL || key == NULL) {
+    return 0;
+  }
+  struct negative_entry* entry = hashmap_get(negative_cache, key);
+  if (entry == NULL) {
+    return 0;
+  }
+  if (entry->until <= time(NULL)) {
+    _secFreeNegativeEntry(hashmap_remove(negative_cache, key));
+    return 0;
+  }
+  agent_log(DEBUG, "Refresh token was rejected recently; not sending request");
+  oidc_seterror(entry->error);
+  oidc_errno = OIDC_EOIDC;
+  return 1;
+}
+
+/**
+ * @brief remembers that a refresh request was rejected with the current oidc
+ * error
+ */
+void negativeCache_store(const char* key) {
+  if (key == NULL) {
+    return;
+  }
+  if (negative_cache == NULL) {
+    negative_cache = hashmap_new(16, _secFreeNegativeEntry);
+  } else if (hashmap_size(negative_cache) >= AGENT_NEGATIVE_CACHE_PRUNE_SIZE) {
+    negativeCache_prune();
+  }
+  struct negative_entry* entry = secAlloc(sizeof(struct negative_entry));
+  entry->until                 = time(NULL) + AGENT_NEGATIVE_CACHE_TTL;
+  entry->error                 = oidc_strcopy(oidc_serror());
+  hashmap_put(negative_cache, key, entry);
+}
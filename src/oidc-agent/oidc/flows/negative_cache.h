@@ -0,0 +1,15 @@
+#ifndef OIDC_NEGATIVE_CACHE_H
+#define OIDC_NEGATIVE_CACHE_H
+
+#include <time.h>
+
+#ifndef AGENT_NEGATIVE_CACHE_TTL
+#define AGENT_NEGATIVE_CACHE_TTL 30
+#endif
+#define AGENT_NEGATIVE_CACHE_PRUNE_SIZE 128
+
+int    negativeCache_lookup(const char* key);
+void   negativeCache_store(const char* key);
+time_t negativeCache_prune();
+
+#endif  // OIDC_NEGATIVE_CACHE_H
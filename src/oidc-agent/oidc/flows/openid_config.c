@@ -94,9 +94,14 @@ char* getProvidersSupportedByMytoken(const char* issuer_url,
   if (res == NULL) {
     return NULL;
   }
-  char* providers =
-      getJSONValueFromString(res, MYTOKEN_KEY_PROVIDERS_SUPPORTED);
+  cJSON* json = publicStringToJson(res);
   secFree(res);
   secFreeAccountContent(&account);
+  if (json == NULL) {
+    return NULL;
+  }
+  char* providers = getJSONValue(json, MYTOKEN_KEY_PROVIDERS_SUPPORTED);
+  secFreeJson(json);
+  markPublicMem(providers);
   return providers;
 }
@@ -1,15 +1,37 @@
 #include "refresh.h"
 
+#include <fcntl.h>
 #include <stddef.h>
+#include <unistd.h>
 
 #include "account/account.h"
 #include "defines/oidc_values.h"
+#include "ipc/ipc.h"
+#include "negative_cache.h"
+#include "oidc-agent/agent_state.h"
 #include "oidc-agent/http/http_ipc.h"
+#include "oidc-agent/oidcd/internal_request_handler.h"
 #include "oidc.h"
 #include "utils/agentLogger.h"
 #include "utils/config/issuerConfig.h"
+#include "utils/crypt/crypt.h"
+#include "utils/crypt/dbCryptUtils.h"
+#include "utils/crypt/memoryCrypt.h"
+#include "utils/hashmap.h"
+#include "utils/json.h"
+#include "utils/listUtils.h"
+#include "utils/memory.h"
 #include "utils/string/stringUtils.h"
 
+static char* _negativeCacheKey(const struct oidc_account* p, const char* scope,
+                               const char* audience) {
+  char* plain = oidc_sprintf("%s\n%s\n%s", account_getRefreshToken(p) ?: "",
+                             scope ?: "", audience ?: "");
+  char* key   = s256(plain);
+  secFree(plain);
+  return key;
+}
+
 char* generateRefreshPostData(const struct oidc_account* a, const char* scope,
                               const char* audience) {
   char* refresh_token = account_getRefreshToken(a);
@@ -68,10 +90,15 @@ char* refreshFlow(unsigned char return_mode, struct oidc_account* p,
                   const char* scope, const char* audience,
                   struct ipcPipe pipes) {
   agent_log(DEBUG, "Doing RefreshFlow\n");
+  char* cache_key = _negativeCacheKey(p, scope, audience);
+  if (negativeCache_lookup(cache_key)) {
+    secFree(cache_key);
+    return NULL;
+  }
   char* data = generateRefreshPostData(p, scope, audience);
   if (data == NULL) {
+    secFree(cache_key);
     return NULL;
-    ;
   }
   agent_log(DEBUG, "Data to send: %s", data);
   char* cert_path = account_getCertPathOrDefault(p);
@@ -81,13 +108,236 @@ char* refreshFlow(unsigned char return_mode, struct oidc_account* p,
   secFree(cert_path);
   secFree(data);
   if (NULL == res) {
+    secFree(cache_key);
     return NULL;
   }
 
+  oidc_errno         = OIDC_SUCCESS;  // only trust errors set while parsing
   char* access_token = parseTokenResponse(
       return_mode |
           TOKENPARSEMODE_SAVE_AT_IF(!strValid(scope) && !strValid(audience)),
       res, p, pipes, 1);
   secFree(res);
+  if (access_token == NULL && oidc_errno == OIDC_EOIDC &&
+      strstarts(oidc_serror(), OIDC_INVALID_GRANT)) {
+    negativeCache_store(cache_key);
+  }
+  secFree(cache_key);
   return access_token;
 }
+
+/**
+ * A refresh that was started by @c refreshFlowInBackground. The response is
+ * only stored when it arrives, because it might arrive while oidcd waits for
+ * another http response and a request is handled with the account decrypted.
+ * The watch returned by @c backgroundRefreshWatch then applies it from the
+ * main loop. The refresh token and the response are held memory encrypted,
+ * like the loaded accounts.
+ */
+struct background_refresh {
+  char*         account_name;
+  char*         refresh_token;  // memory encrypted
+  char*         response;       // memory encrypted
+  oidc_error_t  error;
+  unsigned char done;
+};
+
+static hashmap_t*       background_refreshes = NULL;
+static int              done_pipe[2]         = {-1, -1};
+static struct ipcPipe   refresh_notify       = {-1, -1};
+static struct ipc_watch refresh_watch;
+
+static void _secFreeBackgroundRefresh(void* r) {
+  struct background_refresh* refresh = r;
+  secFree(refresh->account_name);
+  secFree(refresh->refresh_token);
+  secFree(refresh->response);
+  secFree(refresh);
+}
+
+static void _backgroundRefreshDone(char* res, void* arg) {
+  struct background_refresh* refresh = arg;
+  refresh->error                     = res ? OIDC_SUCCESS : oidc_errno;
+  refresh->response                  = memoryEncrypt(res);
+  secFree(res);
+  refresh->done                      = 1;
+  agent_log(DEBUG, "Background refresh for '%s' done", refresh->account_name);
+  if (done_pipe[1] != -1 && write(done_pipe[1], "", 1) < 0) {
+    agent_log(ERROR, "Could not wake up main loop: %m");
+  }
+}
+
+/**
+ * @brief starts a refresh flow for the default scope and audience of an
+ * account without waiting for the response
+ * @param p the account; its current access token stays in place until the
+ * response arrives
+ * @return @c OIDC_SUCCESS if a refresh was started or is already running for
+ * this account; an error code otherwise
+ */
+oidc_error_t refreshFlowInBackground(const struct oidc_account* p) {
+  if (background_refreshes == NULL) {
+    background_refreshes = hashmap_new(8, _secFreeBackgroundRefresh);
+  }
+  if (hashmap_get(background_refreshes, account_getName(p)) != NULL) {
+    return OIDC_SUCCESS;
+  }
+  char* cache_key = _negativeCacheKey(p, NULL, NULL);
+  int   rejected  = negativeCache_lookup(cache_key);
+  secFree(cache_key);
+  if (rejected) {
+    return oidc_errno;
+  }
+  char* data = generateRefreshPostData(p, NULL, NULL);
+  if (data == NULL) {
+    return oidc_errno;
+  }
+  agent_log(DEBUG, "Starting background refresh for '%s'", account_getName(p));
+  struct background_refresh* refresh =
+      secAlloc(sizeof(struct background_refresh));
+  refresh->account_name  = oidc_strcopy(account_getName(p));
+  refresh->refresh_token = memoryEncrypt(account_getRefreshToken(p));
+  char*        cert_path = account_getCertPathOrDefault(p);
+  oidc_error_t e         = httpsPOSTAsync(
+      account_getTokenEndpoint(p), data, NULL, cert_path,
+      account_getClientId(p), account_getClientSecret(p),
+      _backgroundRefreshDone, refresh);
+  secFree(cert_path);
+  secFree(data);
+  if (e != OIDC_SUCCESS) {
+    _secFreeBackgroundRefresh(refresh);
+    return e;
+  }
+  hashmap_put(background_refreshes, refresh->account_name, refresh);
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief passes a rotated refresh token of a discarded response to oidcp, so
+ * that it is written to the account config; the old one was most likely
+ * revoked by the provider
+ */
+static void _forwardRotatedRefreshToken(const char* account_name,
+                                        const char* old_refresh_token,
+                                        const char* response,
+                                        struct ipcPipe pipes) {
+  char* refresh_token =
+      getJSONValueFromString(response, OIDC_KEY_REFRESHTOKEN);
+  if (strValid(refresh_token) &&
+      !strequal(refresh_token, old_refresh_token)) {
+    agent_log(NOTICE,
+              "Storing refresh token rotated by a discarded background "
+              "refresh for '%s'",
+              account_name);
+    oidcd_handleUpdateRefreshToken(pipes, account_name, refresh_token);
+  }
+  secFree(refresh_token);
+}
+
+static void _applyBackgroundRefresh(const struct background_refresh* refresh,
+                                    struct ipcPipe                   pipes) {
+  if (refresh->response == NULL) {
+    agent_log(NOTICE, "Background refresh for '%s' failed: %s",
+              refresh->account_name, oidc_serrorFor(refresh->error));
+    return;
+  }
+  char* response      = memoryDecrypt(refresh->response);
+  char* refresh_token = memoryDecrypt(refresh->refresh_token);
+  struct oidc_account* a =
+      db_getAccountDecryptedByShortname(refresh->account_name);
+  if (a == NULL || !strequal(account_getRefreshToken(a), refresh_token)) {
+    agent_log(DEBUG,
+              "Account '%s' %s during background refresh; discarding "
+              "response",
+              refresh->account_name, a ? "changed" : "was removed");
+    _forwardRotatedRefreshToken(refresh->account_name, refresh_token,
+                                response, pipes);
+    if (a != NULL) {
+      db_addAccountEncrypted(a);
+    }
+    secFree(response);
+    secFree(refresh_token);
+    return;
+  }
+  secFree(refresh_token);
+  oidc_errno = OIDC_SUCCESS;
+  parseTokenResponse(TOKENPARSEMODE_SAVE_AT, response, a, pipes, 1);
+  secFree(response);
+  if (oidc_errno == OIDC_EOIDC &&
+      strstarts(oidc_serror(), OIDC_INVALID_GRANT)) {
+    char* cache_key = _negativeCacheKey(a, NULL, NULL);
+    negativeCache_store(cache_key);
+    secFree(cache_key);
+  }
+  db_addAccountEncrypted(a);
+}
+
+static void _collectDone(const char* key, void* value, void* arg) {
+  const struct background_refresh* refresh = value;
+  if (refresh->done) {
+    list_rpush(arg, list_node_new(oidc_strcopy(key)));
+  }
+}
+
+/**
+ * @brief applies the responses of finished background refreshes to the loaded
+ * accounts
+ * @param pipes the pipes to oidcp or the notification pipe; used to store a
+ * rotated refresh token
+ * @note must only be called while no account is decrypted and the agent is
+ * not locked
+ */
+void applyBackgroundRefreshes(struct ipcPipe pipes) {
+  if (background_refreshes == NULL || hashmap_size(background_refreshes) == 0) {
+    return;
+  }
+  list_t* done = list_new();
+  done->free   = _secFree;
+  hashmap_foreach(background_refreshes, _collectDone, done);
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(done, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    struct background_refresh* refresh =
+        hashmap_remove(background_refreshes, node->val);
+    _applyBackgroundRefresh(refresh, pipes);
+    _secFreeBackgroundRefresh(refresh);
+  }
+  list_iterator_destroy(it);
+  secFreeList(done);
+}
+
+static void _handleDoneRefreshes() {
+  char buf[64];
+  while (read(done_pipe[0], buf, sizeof(buf)) > 0) {}
+  if (agent_state.lock_state.locked) {
+    return;  // applied with the first request after unlocking
+  }
+  applyBackgroundRefreshes(refresh_notify);
+}
+
+/**
+ * @brief returns the watch that applies the responses of background refreshes
+ * as soon as they arrive; it has to be added to the main loop of oidcd
+ * @param next the watch that is chained after this one; might be @c NULL
+ * @param notify the pipe on which a rotated refresh token is passed to oidcp
+ * without waiting for an answer, see @c oidcd_handleUpdateRefreshToken
+ * @return the watch
+ */
+const struct ipc_watch* backgroundRefreshWatch(const struct ipc_watch* next,
+                                               struct ipcPipe          notify) {
+  if (done_pipe[0] == -1) {
+    if (pipe(done_pipe) != 0) {
+      agent_log(ERROR, "Could not create background refresh pipe: %m");
+      done_pipe[0] = done_pipe[1] = -1;
+    } else {
+      fcntl(done_pipe[0], F_SETFL, O_NONBLOCK);
+      fcntl(done_pipe[0], F_SETFD, FD_CLOEXEC);
+      fcntl(done_pipe[1], F_SETFD, FD_CLOEXEC);
+    }
+  }
+  refresh_notify       = notify;
+  refresh_watch.fd     = done_pipe[0];
+  refresh_watch.handle = _handleDoneRefreshes;
+  refresh_watch.next   = next;
+  return &refresh_watch;
+}
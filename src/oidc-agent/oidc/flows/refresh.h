@@ -1,11 +1,17 @@
 #ifndef OIDC_REFRESH_H
 #define OIDC_REFRESH_H
 
+#include <time.h>
+
 #include "account/account.h"
 #include "ipc/pipe.h"
 
 char* refreshFlow(unsigned char return_mode, struct oidc_account* p,
                   const char* scope, const char* audience,
                   struct ipcPipe pipes);
+oidc_error_t refreshFlowInBackground(const struct oidc_account* p);
+void         applyBackgroundRefreshes(struct ipcPipe pipes);
+const struct ipc_watch* backgroundRefreshWatch(const struct ipc_watch* next,
+                                               struct ipcPipe          notify);
 
 #endif  // OIDC_REFRESH_H
@@ -39,14 +39,16 @@ oidc_error_t parseOpenidConfiguration(char* res, struct oidc_account* account) {
       OIDC_KEY_GRANT_TYPES_SUPPORTED, OIDC_KEY_RESPONSE_TYPES_SUPPORTED,
       OIDC_KEY_CODE_CHALLENGE_METHODS_SUPPORTED, MYTOKEN_KEY_MYTOKEN_ENDPOINT,
       MYTOKEN_KEY_PROVIDERS_SUPPORTED, MYTOKEN_KEY_GRANTTYPES_SUPPORTED);
-  if (CALL_GETJSONVALUES(res) < 0) {
-    secFree(res);
+  cJSON* json = publicStringToJson(res);
+  secFree(res);
+  if (json == NULL || CALL_GETJSONVALUES_FROM_CJSON(json) < 0) {
+    secFreeJson(json);
     if (oidc_errno == OIDC_EJSONPARS) {
       oidc_errno = OIDC_EOPNOJSON;
     }
     return oidc_errno;
   }
-  secFree(res);
+  secFreeJson(json);
   KEY_VALUE_VARS(issuer, token_endpoint, authorization_endpoint,
                  registration_endpoint, revocation_endpoint,
                  device_authorization_endpoint, scopes_supported,
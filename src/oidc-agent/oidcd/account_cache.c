@@ -0,0 +1,275 @@
+#include "account_cache.h"
+
+#include "account/account.h"
+#include "utils/agentLogger.h"
+#include "utils/config/agent_config.h"
+#include "utils/db/account_db.h"
+#include "utils/hashmap.h"
+#include "utils/json.h"
+#include "utils/kernelKeyring.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+/**
+ * Capacity limit for the loaded accounts.
+ *
+ * If the agent config caps the number or the memory of loaded accounts, the
+ * least recently used accounts are evicted from the main loop of oidcd, i.e.
+ * never while a request uses an account. Only accounts that oidcp can load
+ * again without asking the user are evicted; whether that is the case is
+ * recorded when the account is added. An evicted account is remembered until
+ * its lifetime is over, so that it can be loaded again transparently when it
+ * is used the next time.
+ */
+static hashmap_t* records = NULL;  // shortname -> struct evicted_account
+
+static void _secFreeRecord(struct evicted_account* r) {
+  if (r == NULL) {
+    return;
+  }
+  secFree(r->issuer_url);
+  secFree(r);
+}
+
+static void _evict(struct oidc_account* account) {
+  if (records == NULL) {
+    records = hashmap_new(8, (void (*)(void*))_secFreeRecord);
+  }
+  const char*             name = account_getName(account);
+  struct evicted_account* r    = hashmap_get(records, name);
+  if (r == NULL) {
+    r = secAlloc(sizeof(struct evicted_account));
+    hashmap_put(records, name, r);
+  }
+  secFree(r->issuer_url);
+  r->issuer_url    = oidc_strcopy(account_getIssuerUrl(account));
+  r->death         = account_getDeath(account);
+  r->last_used     = account_getLastUsed(account);
+  r->confirm       = account_getConfirmationRequired(account);
+  r->alwaysallowid = account_getAlwaysAllowId(account);
+  r->evicted       = 1;
+  r->evictions++;
+  agent_log(NOTICE, "Evicting idle account '%s'", name);
+  kernelKeyring_removeTokens(name);
+}
+
+static int _canEvict(const struct oidc_account* account) {
+  return account_getReloadable(account) != 0;
+}
+
+static void _applyLimits() {
+  const agent_config_t* config = getAgentConfig();
+  long                  max    = config->max_loaded_accounts;
+  long                  bytes  = config->max_loaded_accounts_bytes;
+  db_setLimits(OIDC_DB_ACCOUNTS,
+               (struct db_limits){
+                   .max_entries = max > 0 ? (size_t)max : 0,
+                   .max_bytes   = bytes > 0 ? (size_t)bytes : 0,
+                   .sizeGetter =
+                       (size_t(*)(void*))account_getMemoryFootprint,
+                   .evict          = (void (*)(void*))_evict,
+                   .canEvict       = (int (*)(void*))_canEvict,
+                   .deferred_evict = 1,
+               });
+}
+
+void accountCache_init() { _applyLimits(); }
+
+static void _collectDead(const char* key, void* value, void* arg) {
+  const struct evicted_account* r = value;
+  if (r->death && r->death <= time(NULL)) {
+    list_rpush(arg, list_node_new(oidc_strcopy(key)));
+  }
+}
+
+/**
+ * @brief forgets the accounts whose lifetime is over
+ */
+static void _pruneRecords() {
+  if (records == NULL) {
+    return;
+  }
+  list_t* dead = list_new();
+  dead->free   = _secFree;
+  hashmap_foreach(records, _collectDead, dead);
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(dead, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    _secFreeRecord(hashmap_remove(records, node->val));
+  }
+  list_iterator_destroy(it);
+  secFreeList(dead);
+}
+
+/**
+ * @brief evicts the least recently used accounts while the loaded accounts
+ * exceed the configured caps; must only be called when no account is in use
+ */
+void accountCache_evictIdle() {
+  _applyLimits();  // the agent config might have been reloaded
+  db_evictOverLimits(OIDC_DB_ACCOUNTS);
+  _pruneRecords();
+}
+
+/**
+ * @brief returns what is remembered about an evicted account
+ * @return the record or @c NULL if the account was not evicted or its
+ * lifetime is over
+ */
+const struct evicted_account* accountCache_getEvicted(const char* shortname) {
+  if (records == NULL || shortname == NULL) {
+    return NULL;
+  }
+  struct evicted_account* r = hashmap_get(records, shortname);
+  if (r == NULL || !r->evicted) {
+    return NULL;
+  }
+  if (r->death && r->death <= time(NULL)) {
+    r->evicted = 0;
+    return NULL;
+  }
+  return r;
+}
+
+struct issuer_collector {
+  const char* issuer_url;
+  list_t*     names;
+};
+
+static void _collectForIssuer(const char* key, void* value, void* arg) {
+  const struct evicted_account* r = value;
+  struct issuer_collector*      c = arg;
+  if (strequal(r->issuer_url, c->issuer_url) &&
+      accountCache_getEvicted(key) != NULL) {
+    list_rpush(c->names, list_node_new(oidc_strcopy(key)));
+  }
+}
+
+/**
+ * @brief returns the names of the evicted accounts for an issuer
+ * @return a list of names, @c NULL if there is none
+ */
+list_t* accountCache_getEvictedForIssuer(const char* issuer_url) {
+  if (records == NULL || issuer_url == NULL) {
+    return NULL;
+  }
+  struct issuer_collector c = {.issuer_url = issuer_url, .names = list_new()};
+  c.names->free             = (void (*)(void*))_secFree;
+  hashmap_foreach(records, _collectForIssuer, &c);
+  if (c.names->len == 0) {
+    secFreeList(c.names);
+  }
+  return c.names;
+}
+
+/**
+ * @brief marks an evicted account as loaded again; its eviction count is kept
+ */
+void accountCache_reloaded(const char* shortname) {
+  struct evicted_account* r =
+      records && shortname ? hashmap_get(records, shortname) : NULL;
+  if (r != NULL) {
+    r->evicted = 0;
+  }
+}
+
+/**
+ * @brief forgets an account that was removed
+ * @return @c 1 if the account was evicted, i.e. still counted as loaded
+ */
+int accountCache_forget(const char* shortname) {
+  if (records == NULL || shortname == NULL) {
+    return 0;
+  }
+  int evicted = accountCache_getEvicted(shortname) != NULL;
+  _secFreeRecord(hashmap_remove(records, shortname));
+  return evicted;
+}
+
+void accountCache_forgetAll() { secFreeHashmap(records); }
+
+static size_t _evictions(const char* shortname) {
+  const struct evicted_account* r =
+      records ? hashmap_get(records, shortname) : NULL;
+  return r ? r->evictions : 0;
+}
+
+struct status_collector {
+  char*  text;
+  cJSON* json;
+};
+
+static void _addStatusEntry(struct status_collector* c, const char* name,
+                            time_t last_used, size_t evictions,
+                            unsigned char evicted) {
+  if (c->json) {
+    cJSON* entry = cJSON_CreateObject();
+    jsonAddNumberValue(entry, "last_used", last_used);
+    jsonAddNumberValue(entry, "evictions", evictions);
+    jsonAddBoolValue(entry, "evicted", evicted);
+    cJSON_AddItemToObject(c->json, name, entry);
+    return;
+  }
+  char* used = last_used ? oidc_sprintf("last used %lu seconds ago",
+                                        (unsigned long)(time(NULL) - last_used))
+                         : oidc_strcopy("not used yet");
+  char* line = oidc_sprintf("  %s: %s, evicted %lu times%s\n", name, used,
+                            (unsigned long)evictions,
+                            evicted ? " (currently evicted)" : "");
+  secFree(used);
+  char* tmp = oidc_strcat(c->text, line);
+  secFree(line);
+  secFree(c->text);
+  c->text = tmp;
+}
+
+static void _collectEvicted(const char* key, void* value, void* arg) {
+  const struct evicted_account* r = value;
+  if (r->evicted && (r->death == 0 || r->death > time(NULL))) {
+    _addStatusEntry(arg, key, r->last_used, r->evictions, 1);
+  }
+}
+
+static void _collectStatus(struct status_collector* c) {
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(accountDB_getList(), LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    const struct oidc_account* a = node->val;
+    _addStatusEntry(c, account_getName(a), account_getLastUsed(a),
+                    _evictions(account_getName(a)), 0);
+  }
+  list_iterator_destroy(it);
+  if (records != NULL) {
+    hashmap_foreach(records, _collectEvicted, c);
+  }
+}
+
+char* accountCache_statusText() {
+  const agent_config_t*   config = getAgentConfig();
+  struct db_stats         stats  = db_getStats(OIDC_DB_ACCOUNTS);
+  struct status_collector c      = {.text = NULL, .json = NULL};
+  c.text = oidc_sprintf("Loaded accounts: %lu (%lu bytes), %lu evictions\n"
+                        "Limits: %ld accounts, %ld bytes (0 means none)\n",
+                        (unsigned long)stats.entries,
+                        (unsigned long)stats.bytes,
+                        (unsigned long)stats.evicted,
+                        config->max_loaded_accounts,
+                        config->max_loaded_accounts_bytes);
+  _collectStatus(&c);
+  return c.text;
+}
+
+cJSON* accountCache_statusJSON() {
+  const agent_config_t*   config = getAgentConfig();
+  struct db_stats         stats  = db_getStats(OIDC_DB_ACCOUNTS);
+  cJSON*                  json   = cJSON_CreateObject();
+  struct status_collector c      = {.text = NULL,
+                                    .json = cJSON_CreateObject()};
+  jsonAddNumberValue(json, "max_accounts", config->max_loaded_accounts);
+  jsonAddNumberValue(json, "max_bytes", config->max_loaded_accounts_bytes);
+  jsonAddNumberValue(json, "bytes", stats.bytes);
+  jsonAddNumberValue(json, "evictions", stats.evicted);
+  _collectStatus(&c);
+  cJSON_AddItemToObject(json, "accounts", c.json);
+  return json;
+}
@@ -0,0 +1,33 @@
+#ifndef OIDCD_ACCOUNT_CACHE_H
+#define OIDCD_ACCOUNT_CACHE_H
+
+#include <time.h>
+
+#include "wrapper/cjson.h"
+#include "wrapper/list.h"
+
+/**
+ * What oidcd remembers about an account it evicted, so that the account can
+ * be loaded again with the same settings
+ */
+struct evicted_account {
+  char*         issuer_url;
+  time_t        death;
+  time_t        last_used;
+  unsigned char confirm;
+  unsigned char alwaysallowid;
+  unsigned char evicted;  // 0 once the account was loaded again
+  size_t        evictions;
+};
+
+void                          accountCache_init();
+void                          accountCache_evictIdle();
+const struct evicted_account* accountCache_getEvicted(const char* shortname);
+list_t* accountCache_getEvictedForIssuer(const char* issuer_url);
+void    accountCache_reloaded(const char* shortname);
+int     accountCache_forget(const char* shortname);
+void    accountCache_forgetAll();
+char*   accountCache_statusText();
+cJSON*  accountCache_statusJSON();
+
+#endif  // OIDCD_ACCOUNT_CACHE_H
@@ -1,5 +1,6 @@
 #include "codeExchangeEntry.h"
 
+#include "defines/settings.h"
 #include "utils/matcher.h"
 
 void secFreeCodeExchangeContent(struct codeExchangeEntry* cee) {
@@ -19,9 +20,12 @@ struct codeExchangeEntry* createCodeExchangeEntry(char*                state,
   cee->account                  = account;
   cee->state                    = state;
   cee->code_verifier            = code_verifier;
+  cee->expires_at               = time(NULL) + AGENT_CODEVERIFIER_TTL;
   return cee;
 }
 
 int cee_matchByState(struct codeExchangeEntry* a, struct codeExchangeEntry* b) {
   return matchStrings(a->state, b->state);
 }
+
+time_t cee_getDeath(struct codeExchangeEntry* cee) { return cee->expires_at; }
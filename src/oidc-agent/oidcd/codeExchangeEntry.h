@@ -1,18 +1,22 @@
 #ifndef OIDC_CODEEXCHANGEENTRY_H
 #define OIDC_CODEEXCHANGEENTRY_H
 
+#include <time.h>
+
 #include "account/account.h"
 
 struct codeExchangeEntry {
   char*                state;
   struct oidc_account* account;
   char*                code_verifier;
+  time_t               expires_at;
 };
 
 int cee_matchByState(struct codeExchangeEntry* a, struct codeExchangeEntry* b);
 struct codeExchangeEntry* createCodeExchangeEntry(char*                state,
                                                   struct oidc_account* account,
                                                   char* code_verifier);
-void secFreeCodeExchangeContent(struct codeExchangeEntry* cee);
+void   secFreeCodeExchangeContent(struct codeExchangeEntry* cee);
+time_t cee_getDeath(struct codeExchangeEntry* cee);
 
 #endif  // OIDC_CODEEXCHANGEENTRY_H
@@ -1,5 +1,6 @@
 #include "deviceCodeEntry.h"
 
+#include "defines/settings.h"
 #include "utils/matcher.h"
 #include "utils/memory.h"
 #include "utils/string/stringUtils.h"
@@ -7,6 +8,7 @@
 void secFreeDeviceCodeEntryContent(struct deviceCodeEntry* entry) {
   secFreeAccount(entry->account);
   secFree(entry->device_code);
+  secFree(entry->response);
 }
 
 struct deviceCodeEntry* createDeviceCodeEntry(const char*          device_code,
@@ -14,9 +16,14 @@ struct deviceCodeEntry* createDeviceCodeEntry(const char*          device_code,
   struct deviceCodeEntry* entry = secAlloc(sizeof(struct deviceCodeEntry));
   entry->account                = account;
   entry->device_code            = oidc_strcopy(device_code);
+  entry->expires_at             = time(NULL) + AGENT_DEVICECODE_TTL;
   return entry;
 }
 
 int dce_match(struct deviceCodeEntry* a, struct deviceCodeEntry* b) {
   return matchStrings(a->device_code, b->device_code);
 }
+
+time_t dce_getDeath(struct deviceCodeEntry* entry) {
+  return entry->expires_at + DEVICECODE_GRACE;
+}
@@ -1,16 +1,31 @@
 #ifndef OIDC_AGENT_DEVICECODEENTRY_H
 #define OIDC_AGENT_DEVICECODEENTRY_H
 
+#include <time.h>
+
 #include "account/account.h"
 
+/**
+ * time in seconds a device code is kept after it expired, so that a late
+ * lookup still gets a meaningful error
+ */
+#define DEVICECODE_GRACE 60
+
 struct deviceCodeEntry {
   char*                device_code;
   struct oidc_account* account;
+  char*                response;  // polled token response, not yet handled;
+                                  // encrypted with memoryEncrypt
+  size_t               interval;
+  time_t               next_poll;  // 0 if the code is not polled by oidcd
+  time_t               expires_at;
+  unsigned char        polling;  // a poll request is in flight
 };
 
 int dce_match(struct deviceCodeEntry* a, struct deviceCodeEntry* b);
 struct deviceCodeEntry* createDeviceCodeEntry(const char*          device_code,
                                               struct oidc_account* account);
 void                    secFreeDeviceCodeEntryContent(struct deviceCodeEntry*);
+time_t                  dce_getDeath(struct deviceCodeEntry* entry);
 
 #endif  // OIDC_AGENT_DEVICECODEENTRY_H
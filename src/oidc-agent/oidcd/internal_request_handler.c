@@ -6,9 +6,25 @@
 #include "utils/memory.h"
 #include "utils/parseJson.h"
 
+/**
+ * @brief passes a refresh token rotated by the provider to oidcp, which writes
+ * it to the account config
+ * @param pipes the pipes to oidcp while it waits for the response to a
+ * request; or the notification pipe (@c rx is @c -1) that oidcp reads in its
+ * main loop and does not answer
+ */
 void oidcd_handleUpdateRefreshToken(const struct ipcPipe pipes,
                                     const char*          short_name,
                                     const char*          refresh_token) {
+  if (pipes.rx == -1) {
+    // notifications are newline terminated, several might be read at once
+    if (ipc_writeToPipe(pipes, INT_REQUEST_UPD_REFRESH "\n", short_name,
+                        refresh_token) != OIDC_SUCCESS) {
+      agent_log(ERROR, "Could not pass updated refresh token to oidcp: %s",
+                oidc_serror());
+    }
+    return;
+  }
   char* res   = ipc_communicateThroughPipe(pipes, INT_REQUEST_UPD_REFRESH,
                                            short_name, refresh_token);
   char* error = parseForError(res);
@@ -1,10 +1,18 @@
 #include "oidcd.h"
 
 #include "account/account.h"
+#include "account_cache.h"
 #include "defines/ipc_values.h"
+#include "defines/settings.h"
 #include "deviceCodeEntry.h"
 #include "oidc-agent/agent_state.h"
+#include "oidc-agent/config_watcher.h"
+#include "oidc-agent/httpserver/termHttpserver.h"
+#include "oidc-agent/http/http_ipc.h"
 #include "oidc-agent/oidc/device_code.h"
+#include "oidc-agent/oidc/flows/device.h"
+#include "oidc-agent/oidc/flows/negative_cache.h"
+#include "oidc-agent/oidc/flows/refresh.h"
 #include "oidc-agent/oidcd/codeExchangeEntry.h"
 #include "oidc-agent/oidcd/oidcd_handler.h"
 #include "utils/accountUtils.h"
@@ -16,12 +24,46 @@
 #include "utils/db/deviceCode_db.h"
 #include "utils/db/file_db.h"
 #include "utils/json.h"
+#include "utils/kernelKeyring.h"
 #include "utils/listUtils.h"
 #include "utils/memory.h"
 #include "utils/oidc_error.h"
 #include "utils/string/stringUtils.h"
 
-int oidcd_main(struct ipcPipe pipes, const struct arguments* arguments) {
+static const db_name limited_dbs[] = {OIDC_DB_CODEVERIFIERS,
+                                      OIDC_DB_DEVICECODES, OIDC_DB_FILES};
+
+static time_t _earlier(time_t a, time_t b) {
+  if (a == 0) {
+    return b;
+  }
+  return b && b < a ? b : a;
+}
+
+/**
+ * @brief drops an expired or evicted code flow; its state is unregistered
+ * from the redirect listener, so that a late redirect is not accepted
+ */
+static void _evictCodeExchange(struct codeExchangeEntry* cee) {
+  termHttpServer(cee->state);
+  secFreeCodeExchangeContent(cee);
+}
+
+/**
+ * @brief removes expired entries from the bounded stores and returns the time
+ * when the next entry expires, @c 0 if none does
+ */
+static time_t _removeExpiredEntries() {
+  time_t next = 0;
+  for (size_t i = 0; i < sizeof(limited_dbs) / sizeof(*limited_dbs); i++) {
+    db_removeExpired(limited_dbs[i]);
+    next = _earlier(next, db_getNextExpiry(limited_dbs[i]));
+  }
+  return next;
+}
+
+int oidcd_main(struct ipcPipe pipes, int notify_fd,
+               const struct arguments* arguments) {
   logger_open("oidc-agent.d");
   initCrypt();
   initMemoryCrypt();
@@ -29,26 +71,48 @@ int oidcd_main(struct ipcPipe pipes, const struct arguments* arguments) {
   codeVerifierDB_new();
   codeVerifierDB_setFreeFunction((freeFunction)_secFree);
   codeVerifierDB_setMatchFunction((matchFunction)cee_matchByState);
+  db_setLimits(OIDC_DB_CODEVERIFIERS,
+               (struct db_limits){
+                   .max_entries = AGENT_CODEVERIFIER_MAX,
+                   .deathGetter = (time_t(*)(void*))cee_getDeath,
+                   .evict       = (void (*)(void*))_evictCodeExchange,
+               });
 
   deviceCodeDB_new();
   deviceCodeDB_setFreeFunction((freeFunction)_secFree);
   deviceCodeDB_setMatchFunction((matchFunction)dce_match);
+  db_setLimits(OIDC_DB_DEVICECODES,
+               (struct db_limits){
+                   .max_entries = AGENT_DEVICECODE_MAX,
+                   .deathGetter = (time_t(*)(void*))dce_getDeath,
+                   .evict = (void (*)(void*))secFreeDeviceCodeEntryContent,
+               });
 
   accountDB_new();
   accountDB_setFreeFunction((freeFunction)_secFreeAccount);
   accountDB_setMatchFunction((matchFunction)account_matchByName);
+  accountCache_init();
 
   fileDB_new();
 
-  time_t minDeath = 0;
+  struct ipcPipe          notify   = {.rx = -1, .tx = notify_fd};
+  const struct ipc_watch* watch    = backgroundRefreshWatch(
+      httpAsyncWatch(configWatcher_init()), notify);
+  time_t                  minDeath = 0;
 
   while (1) {
-    minDeath = getMinAccountDeath();
-    char* q  = ipc_readFromPipeWithTimeout(pipes, minDeath);
+    pollDueDeviceCodes();
+    accountCache_evictIdle();
+    minDeath = _earlier(getMinAccountDeath(), getNextDeviceCodePoll());
+    minDeath = _earlier(minDeath, _removeExpiredEntries());
+    minDeath = _earlier(minDeath, negativeCache_prune());
+    char* q =
+        ipc_readFromPipeWithTimeoutAndWatch(pipes, minDeath, watch);
     if (q == NULL) {
       if (oidc_errno == OIDC_ETIMEOUT) {
         struct oidc_account* death = NULL;
         while ((death = getDeathAccount()) != NULL) {
+          kernelKeyring_removeTokens(account_getName(death));
           accountDB_removeIfFound(death);
         }
         continue;
@@ -72,7 +136,8 @@ int oidcd_main(struct ipcPipe pipes, const struct arguments* arguments) {
         IPC_KEY_NOSCHEME, IPC_KEY_CERTPATH, IPC_KEY_AUDIENCE,
         IPC_KEY_ALWAYSALLOWID, IPC_KEY_FILENAME, IPC_KEY_DATA,
         OIDC_KEY_REGISTRATION_CLIENT_URI, OIDC_KEY_REGISTRATION_ACCESS_TOKEN,
-        IPC_KEY_ONLYAT, AGENT_KEY_CONFIG_ENDPOINT, AGENT_KEY_MYTOKENPROFILE);
+        IPC_KEY_ONLYAT, AGENT_KEY_CONFIG_ENDPOINT, AGENT_KEY_MYTOKENPROFILE,
+        IPC_KEY_STALEMINVALID, IPC_KEY_RELOADABLE);
     if (getJSONValuesFromString(q, pairs, sizeof(pairs) / sizeof(*pairs)) < 0) {
       ipc_writeToPipe(pipes, RESPONSE_BADREQUEST, oidc_serror());
       secFreeKeyValuePairs(pairs, sizeof(pairs) / sizeof(*pairs));
@@ -85,8 +150,8 @@ int oidcd_main(struct ipcPipe pipes, const struct arguments* arguments) {
                    lifetime, password, applicationHint, confirm, issuer,
                    noscheme, cert_path, audience, alwaysallowid, filename, data,
                    registration_client_uri, registration_access_token, only_at,
-                   config_endpoint,
-                   profile);  // Gives variables for key_value values;
+                   config_endpoint, profile, stale_minvalid,
+                   reloadable);  // Gives variables for key_value values;
                               // e.g. _request=pairs[0].value
     if (_request == NULL) {
       ipc_writeToPipe(pipes, RESPONSE_BADREQUEST, "No request type.");
@@ -109,6 +174,20 @@ int oidcd_main(struct ipcPipe pipes, const struct arguments* arguments) {
       secFreeKeyValuePairs(pairs, sizeof(pairs) / sizeof(*pairs));
       continue;
     }
+    // oidcp reads the response to the state snapshot requests directly, so
+    // they are answered before any internal request could be sent
+    if (strequal(_request, INT_REQUEST_VALUE_STATEEXPORT)) {
+      oidcd_handleStateExport(pipes);
+      secFreeKeyValuePairs(pairs, sizeof(pairs) / sizeof(*pairs));
+      continue;
+    }
+    if (strequal(_request, INT_REQUEST_VALUE_STATEIMPORT)) {
+      oidcd_handleStateImport(pipes, _data);
+      secFreeKeyValuePairs(pairs, sizeof(pairs) / sizeof(*pairs));
+      continue;
+    }
+    // refreshes that finished while the agent was locked
+    applyBackgroundRefreshes(pipes);
     if (strequal(_request, REQUEST_VALUE_GEN)) {
       oidcd_handleGen(pipes, _config, _flow, _nowebserver, _noscheme, _only_at,
                       arguments);
@@ -121,7 +200,8 @@ int oidcd_main(struct ipcPipe pipes, const struct arguments* arguments) {
     } else if (strequal(_request, REQUEST_VALUE_DEVICELOOKUP)) {
       oidcd_handleDeviceLookup(pipes, _device, _only_at);
     } else if (strequal(_request, REQUEST_VALUE_ADD)) {
-      oidcd_handleAdd(pipes, _config, _lifetime, _confirm, _alwaysallowid);
+      oidcd_handleAdd(pipes, _config, _lifetime, _confirm, _alwaysallowid,
+                      _reloadable);
     } else if (strequal(_request, REQUEST_VALUE_REMOVE)) {
       oidcd_handleRm(pipes, _shortname);
     } else if (strequal(_request, REQUEST_VALUE_REMOVEALL)) {
@@ -137,11 +217,12 @@ int oidcd_main(struct ipcPipe pipes, const struct arguments* arguments) {
       oidcd_handleAgentStatusJSON(pipes, arguments);
     } else if (strequal(_request, REQUEST_VALUE_ACCESSTOKEN)) {
       if (_shortname) {
-        oidcd_handleToken(pipes, _shortname, _minvalid, _scope,
-                          _applicationHint, _audience, arguments);
+        oidcd_handleToken(pipes, _shortname, _minvalid, _stale_minvalid,
+                          _scope, _applicationHint, _audience, arguments);
       } else if (_issuer) {
-        oidcd_handleTokenIssuer(pipes, _issuer, _minvalid, _scope,
-                                _applicationHint, _audience, arguments);
+        oidcd_handleTokenIssuer(pipes, _issuer, _minvalid, _stale_minvalid,
+                                _scope, _applicationHint, _audience,
+                                arguments);
       } else {
         // global default
         oidc_errno = OIDC_NOTIMPL;  // TODO
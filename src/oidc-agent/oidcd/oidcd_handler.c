@@ -13,10 +13,13 @@
 #include "defines/oidc_values.h"
 #include "defines/version.h"
 #include "deviceCodeEntry.h"
+#include "account_cache.h"
 #include "internal_request_handler.h"
 #include "ipc/pipe.h"
 #include "ipc/serveripc.h"
 #include "oidc-agent/agent_state.h"
+#include "oidc-agent/http/circuit_breaker.h"
+#include "oidc-agent/http/http_ipc.h"
 #include "oidc-agent/httpserver/termHttpserver.h"
 #include "oidc-agent/mytoken/oidc_flow.h"
 #include "oidc-agent/mytoken/submytoken.h"
@@ -37,11 +40,13 @@
 #include "utils/config/gen_config.h"
 #include "utils/crypt/crypt.h"
 #include "utils/crypt/dbCryptUtils.h"
+#include "utils/crypt/memoryCrypt.h"
 #include "utils/db/account_db.h"
 #include "utils/db/codeVerifier_db.h"
 #include "utils/db/deviceCode_db.h"
 #include "utils/db/file_db.h"
 #include "utils/json.h"
+#include "utils/kernelKeyring.h"
 #include "utils/listUtils.h"
 #include "utils/oidc/oidcUtils.h"
 #include "utils/parseJson.h"
@@ -111,7 +116,8 @@ void _handleGenFlows(struct ipcPipe pipes, struct oidc_account* account,
     flowsTried++;
     if (strcaseequal(current_flow->val, FLOW_VALUE_REFRESH)) {
       char* at = NULL;
-      if ((at = getAccessTokenUsingRefreshFlow(account, FORCE_NEW_TOKEN, scope,
+      if ((at = getAccessTokenUsingRefreshFlow(account, FORCE_NEW_TOKEN, 0,
+                                               scope,
                                                account_getAudience(account),
                                                pipes)) != NULL) {
         success = 1;
@@ -272,7 +278,7 @@ oidc_error_t addAccount(struct ipcPipe pipes, struct oidc_account* account) {
   if (!strValid(account_getTokenEndpoint(account))) {
     return oidc_errno;
   }
-  if (getAccessTokenUsingRefreshFlow(account, FORCE_NEW_TOKEN, NULL, NULL,
+  if (getAccessTokenUsingRefreshFlow(account, FORCE_NEW_TOKEN, 0, NULL, NULL,
                                      pipes) == NULL) {
     account_setDeath(account,
                      time(NULL) + 10);  // with short timeout so no password
@@ -281,14 +287,19 @@ oidc_error_t addAccount(struct ipcPipe pipes, struct oidc_account* account) {
     return oidc_errno;
   }
   db_addAccountEncrypted(account);
+  accountCache_reloaded(account_getName(account));
   oidcd_handleUpdateIssuer(pipes, account_getIssuerUrl(account),
                            account_getName(account), INT_ACTION_VALUE_ADD);
   return OIDC_SUCCESS;
 }
 
+/**
+ * @param reloadable set by oidcp if the account can be loaded again without
+ * asking the user; only such accounts are evicted
+ */
 void oidcd_handleAdd(struct ipcPipe pipes, const char* account_json,
                      const char* timeout_str, const char* confirm_str,
-                     const char* alwaysallowid) {
+                     const char* alwaysallowid, const char* reloadable) {
   agent_log(DEBUG, "Handle Add request");
   struct oidc_account* account = getAccountFromJSON(account_json);
   if (account == NULL) {
@@ -304,8 +315,11 @@ void oidcd_handleAdd(struct ipcPipe pipes, const char* account_json,
   if (strToInt(alwaysallowid)) {
     account_setAlwaysAllowId(account);
   }
+  account_setReloadable(account, strToInt(reloadable));
   struct oidc_account* found = NULL;
   if ((found = db_getAccountDecrypted(account)) != NULL) {
+    // the stored password might have changed
+    account_setReloadable(found, account_getReloadable(account));
     if (account_getDeath(found) != account_getDeath(account)) {
       account_setDeath(found, account_getDeath(account));
       char* msg = oidc_sprintf(
@@ -374,7 +388,9 @@ void oidcd_handleDelete(struct ipcPipe pipes, const char* account_json) {
   }
   oidcd_handleUpdateIssuer(pipes, account_getIssuerUrl(account),
                            account_getName(account), INT_ACTION_VALUE_REMOVE);
+  kernelKeyring_removeTokens(account_getName(account));
   accountDB_removeIfFound(account);
+  accountCache_forget(account_getName(account));
   secFreeAccount(account);
   ipc_writeToPipe(pipes, RESPONSE_STATUS_SUCCESS);
 }
@@ -388,17 +404,25 @@ void oidcd_handleRm(struct ipcPipe pipes, char* account_name) {
     return;
   }
   agent_log(DEBUG, "Handle Remove request for config '%s'", account_name);
-  struct oidc_account key = {.shortname = account_name};
+  struct oidc_account key     = {.shortname = account_name};
+  int                 evicted = accountCache_forget(account_name);
   if (accountDB_findValue(&key) == NULL) {
+    if (evicted) {
+      ipc_writeToPipe(pipes, RESPONSE_STATUS_SUCCESS);
+      return;
+    }
     ipc_writeToPipe(pipes, RESPONSE_ERROR, ACCOUNT_NOT_LOADED);
     return;
   }
   accountDB_removeIfFound(&key);
+  kernelKeyring_removeTokens(account_name);
   ipc_writeToPipe(pipes, RESPONSE_STATUS_SUCCESS);
 }
 
 void oidcd_handleRemoveAll(struct ipcPipe pipes) {
   accountDB_reset();
+  accountCache_forgetAll();
+  kernelKeyring_removeTokens(NULL);
   ipc_writeToPipe(pipes, RESPONSE_STATUS_SUCCESS);
 }
 
@@ -426,6 +450,47 @@ oidc_error_t oidcd_autoload(struct ipcPipe pipes, const char* short_name,
   return addAccount(pipes, account);
 }
 
+/**
+ * @brief loads an account that was evicted again, without asking the user
+ * @return @c OIDC_SUCCESS if the account is loaded again; otherwise the
+ * account has to be loaded through autoload
+ */
+oidc_error_t oidcd_reload(struct ipcPipe pipes, const char* short_name) {
+  const struct evicted_account* evicted = accountCache_getEvicted(short_name);
+  if (evicted == NULL) {
+    oidc_errno = OIDC_ENOACCOUNT;
+    return oidc_errno;
+  }
+  agent_log(DEBUG, "Send reload request for evicted account '%s'",
+            short_name);
+  time_t        death         = evicted->death;
+  unsigned char confirm       = evicted->confirm;
+  unsigned char alwaysallowid = evicted->alwaysallowid;
+  char* res = ipc_communicateThroughPipe(pipes, INT_REQUEST_RELOAD, short_name);
+  if (res == NULL) {
+    return oidc_errno;
+  }
+  char* config = parseForConfig(res);
+  if (config == NULL) {
+    agent_log(DEBUG, "Could not reload '%s': %s", short_name, oidc_serror());
+    return oidc_errno;
+  }
+  struct oidc_account* account = getAccountFromJSON(config);
+  secFree(config);
+  if (account == NULL) {
+    return oidc_errno;
+  }
+  account_setDeath(account, death);
+  if (confirm) {
+    account_setConfirmationRequired(account);
+  }
+  if (alwaysallowid) {
+    account_setAlwaysAllowId(account);
+  }
+  account_setReloadable(account, 1);  // it was just loaded without the user
+  return addAccount(pipes, account);
+}
+
 #define CONFIRMATION_MODE_AT 0
 #define CONFIRMATION_MODE_ID 1
 
@@ -509,6 +574,12 @@ struct oidc_account* _getLoadedUnencryptedAccount(
   if (account) {
     return account;
   }
+  if (oidcd_reload(pipes, short_name) == OIDC_SUCCESS) {
+    account = db_getAccountDecryptedByShortname(short_name);
+    if (account) {
+      return account;
+    }
+  }
   if (arguments->no_autoload) {
     ipc_writeToPipe(pipes, RESPONSE_ERROR, ACCOUNT_NOT_LOADED);
     return NULL;
@@ -544,6 +615,19 @@ struct oidc_account* _getLoadedUnencryptedAccountForIssuer(
     const char* application_hint, const struct arguments* arguments) {
   struct oidc_account* account  = NULL;
   list_t*              accounts = db_findAccountsByIssuerUrl(issuer);
+  if (accounts == NULL) {  // maybe they were evicted
+    list_t* evicted = accountCache_getEvictedForIssuer(issuer);
+    if (evicted != NULL) {
+      list_node_t*     node;
+      list_iterator_t* it = list_iterator_new(evicted, LIST_HEAD);
+      while ((node = list_iterator_next(it))) {
+        oidcd_reload(pipes, node->val);
+      }
+      list_iterator_destroy(it);
+      secFreeList(evicted);
+      accounts = db_findAccountsByIssuerUrl(issuer);
+    }
+  }
   if (accounts == NULL) {  // no accounts loaded for this issuer
     if (arguments->no_autoload) {
       ipc_writeToPipe(pipes, RESPONSE_ERROR, ACCOUNT_NOT_LOADED);
@@ -623,6 +707,7 @@ struct oidc_account* _getLoadedUnencryptedAccountForIssuer(
 
 void oidcd_handleTokenIssuer(struct ipcPipe pipes, const char* issuer,
                              const char* min_valid_period_str,
+                             const char* stale_min_valid_period_str,
                              const char* scope, const char* application_hint,
                              const char*             audience,
                              const struct arguments* arguments) {
@@ -630,13 +715,17 @@ void oidcd_handleTokenIssuer(struct ipcPipe pipes, const char* issuer,
             application_hint, issuer);
   time_t min_valid_period =
       min_valid_period_str != NULL ? strToInt(min_valid_period_str) : 0;
+  time_t stale_min_valid_period =
+      stale_min_valid_period_str != NULL ? strToInt(stale_min_valid_period_str)
+                                         : 0;
   struct oidc_account* account = _getLoadedUnencryptedAccountForIssuer(
       pipes, issuer, scope, application_hint, arguments);
   if (account == NULL) {
     return;
   }
-  char* access_token = getAccessTokenUsingRefreshFlow(account, min_valid_period,
-                                                      scope, audience, pipes);
+  char* access_token = getAccessTokenUsingRefreshFlow(
+      account, min_valid_period, stale_min_valid_period, scope, audience,
+      pipes);
   if (access_token == NULL) {
     char* help = getHelpWithAccountInfo(account);
     db_addAccountEncrypted(account);  // reencrypting
@@ -685,7 +774,8 @@ void oidcd_handleReauthenticate(struct ipcPipe pipes, char* short_name,
 }
 
 void oidcd_handleToken(struct ipcPipe pipes, const char* short_name,
-                       const char* min_valid_period_str, const char* scope,
+                       const char* min_valid_period_str,
+                       const char* stale_min_valid_period_str, const char* scope,
                        const char* application_hint, const char* audience,
                        const struct arguments* arguments) {
   agent_log(DEBUG, "Handle Token request from %s", application_hint);
@@ -697,6 +787,9 @@ void oidcd_handleToken(struct ipcPipe pipes, const char* short_name,
   }
   time_t min_valid_period =
       min_valid_period_str != NULL ? strToInt(min_valid_period_str) : 0;
+  time_t stale_min_valid_period =
+      stale_min_valid_period_str != NULL ? strToInt(stale_min_valid_period_str)
+                                         : 0;
   struct oidc_account* account = _getLoadedUnencryptedAccount(
       pipes, short_name, application_hint, arguments);
   if (account == NULL) {
@@ -710,8 +803,9 @@ void oidcd_handleToken(struct ipcPipe pipes, const char* short_name,
       return;
     }
   }
-  char* access_token = getAccessTokenUsingRefreshFlow(account, min_valid_period,
-                                                      scope, audience, pipes);
+  char* access_token = getAccessTokenUsingRefreshFlow(
+      account, min_valid_period, stale_min_valid_period, scope, audience,
+      pipes);
   if (access_token == NULL) {
     char* help = getHelpWithAccountInfo(account);
     db_addAccountEncrypted(account);  // reencrypting
@@ -727,6 +821,17 @@ void oidcd_handleToken(struct ipcPipe pipes, const char* short_name,
   ipc_writeToPipe(pipes, RESPONSE_STATUS_ACCESS, STATUS_SUCCESS, access_token,
                   account_getIssuerUrl(account),
                   account_getTokenExpiresAt(account));
+  // Tokens that need a confirmation for each use must not be readable
+  // without asking the agent
+  if (arguments->kernel_keyring && !arguments->confirm &&
+      !account_getConfirmationRequired(account) && !strValid(audience) &&
+      kernelKeyring_publishToken(short_name, scope, access_token,
+                                 account_getIssuerUrl(account),
+                                 account_getTokenExpiresAt(account)) !=
+          OIDC_SUCCESS) {
+    agent_log(NOTICE, "Could not publish access token in the keyring: %s",
+              oidc_serror());
+  }
   if (strValid(scope)) {
     secFree(access_token);
   }
@@ -1087,6 +1192,7 @@ void oidcd_handleTermHttp(struct ipcPipe pipes, const char* state) {
 void oidcd_handleLock(struct ipcPipe pipes, const char* password, int _lock) {
   if (_lock) {
     if (lock(password) == OIDC_SUCCESS) {
+      kernelKeyring_removeTokens(NULL);
       ipc_writeToPipe(pipes, RESPONSE_SUCCESS_INFO, "Agent locked");
       return;
     }
@@ -1160,6 +1266,84 @@ void oidcd_handleListLoadedAccounts(struct ipcPipe pipes) {
   secFreeList(names);
 }
 
+static void _setDecrypted(cJSON* json, const char* key, const char* cipher) {
+  char* plain = memoryDecrypt(cipher);
+  setJSONValue(json, key, plain ?: "");
+  secFree(plain);
+}
+
+/**
+ * @brief answers oidcp with the loaded accounts for the state snapshot,
+ * including their credentials and access tokens; accounts whose lifetime is
+ * over are left out
+ */
+void oidcd_handleStateExport(struct ipcPipe pipes) {
+  agent_log(DEBUG, "Handle state export request");
+  cJSON*           accounts = cJSON_CreateArray();
+  time_t           now      = time(NULL);
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(accountDB_getList(), LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    const struct oidc_account* a     = node->val;
+    time_t                     death = account_getDeath(a);
+    if (death && death <= now) {
+      continue;
+    }
+    cJSON* json = accountToSnapshotJSON(a);
+    _setDecrypted(json, OIDC_KEY_REFRESHTOKEN, account_getRefreshToken(a));
+    _setDecrypted(json, OIDC_KEY_CLIENTID, account_getClientId(a));
+    _setDecrypted(json, OIDC_KEY_CLIENTSECRET, account_getClientSecret(a));
+    cJSON_AddItemToArray(accounts, json);
+  }
+  list_iterator_destroy(it);
+  char* data = jsonToStringUnformatted(accounts);
+  secFreeJson(accounts);
+  ipc_writeToPipe(pipes, RESPONSE_SUCCESS_INFO_OBJECT, data);
+  secFree(data);
+}
+
+/**
+ * @brief loads the accounts of a state snapshot. The accounts keep their
+ * access tokens and issuer metadata, so no request is sent to the issuers.
+ * Accounts that are already loaded or whose lifetime is over are skipped.
+ */
+void oidcd_handleStateImport(struct ipcPipe pipes, const char* data) {
+  agent_log(DEBUG, "Handle state import request");
+  cJSON* accounts = data ? stringToJson(data) : NULL;
+  if (accounts == NULL || !cJSON_IsArray(accounts)) {
+    secFreeJson(accounts);
+    ipc_writeToPipe(pipes, RESPONSE_BADREQUEST, "No accounts in snapshot.");
+    return;
+  }
+  size_t restored = 0;
+  time_t now      = time(NULL);
+  cJSON* item;
+  cJSON_ArrayForEach(item, accounts) {
+    char*                json    = jsonToStringUnformatted(item);
+    struct oidc_account* account = getAccountFromSnapshotJSON(json);
+    secFree(json);
+    if (account == NULL) {
+      agent_log(ERROR, "Could not restore an account: %s", oidc_serror());
+      continue;
+    }
+    time_t death = account_getDeath(account);
+    if ((death && death <= now) ||
+        !strValid(account_getTokenEndpoint(account)) ||
+        accountDB_findValue(account) != NULL) {
+      secFreeAccount(account);
+      continue;
+    }
+    db_addAccountEncrypted(account);
+    restored++;
+  }
+  secFreeJson(accounts);
+  agent_log(NOTICE, "Restored %lu accounts from the state snapshot",
+            (unsigned long)restored);
+  char* msg = oidc_sprintf("Restored %lu accounts", (unsigned long)restored);
+  ipc_writeToPipe(pipes, RESPONSE_SUCCESS_INFO, msg);
+  secFree(msg);
+}
+
 char* _argumentsToOptionsText(const struct arguments* arguments) {
   const char* const fmt      = "Lifetime:\t\t%s\n"
                                "Confirm:\t\t%s\n"
@@ -1168,6 +1352,7 @@ char* _argumentsToOptionsText(const struct arguments* arguments) {
                                "Use custom URI scheme:\t%s\n"
                                "Webserver:\t\t%s\n"
                                "Allow ID-Token:\t\t%s\n"
+                               "Kernel keyring:\t\t%s\n"
                                "Group:\t\t\t%s\n"
                                "Daemon:\t\t\t%s\n"
                                "Log Debug:\t\t%s\n"
@@ -1182,6 +1367,7 @@ char* _argumentsToOptionsText(const struct arguments* arguments) {
                    arguments->no_scheme ? "false" : "true",
                    arguments->no_webserver ? "false" : "true",
                    arguments->always_allow_idtoken ? "true" : "false",
+                   arguments->kernel_keyring ? "true" : "false",
                    arguments->group ? arguments->group : "false",
                    arguments->console ? "false" : "true",
                    arguments->debug ? "true" : "false",
@@ -1220,6 +1406,9 @@ char* _argumentsToCommandLineOptions(const struct arguments* arguments) {
   if (arguments->always_allow_idtoken) {
     list_rpush(options, list_node_new(oidc_strcopy("--always-allow-idtoken")));
   }
+  if (arguments->kernel_keyring) {
+    list_rpush(options, list_node_new(oidc_strcopy("--kernel-keyring")));
+  }
   if (arguments->group) {
     list_rpush(options,
                list_node_new(oidc_sprintf("--with-group", arguments->group)));
@@ -1238,6 +1427,47 @@ char* _argumentsToCommandLineOptions(const struct arguments* arguments) {
   return opts;
 }
 
+static const struct {
+  db_name     db;
+  const char* name;
+  const char* key;
+} status_stores[] = {
+    {OIDC_DB_CODEVERIFIERS, "code verifiers", "code_verifiers"},
+    {OIDC_DB_DEVICECODES, "device codes", "device_codes"},
+    {OIDC_DB_FILES, "files", "files"},
+};
+
+static char* _storesStatusText() {
+  char* text = oidc_strcopy("Bounded stores:\n");
+  for (size_t i = 0; i < sizeof(status_stores) / sizeof(*status_stores); i++) {
+    struct db_stats stats = db_getStats(status_stores[i].db);
+    char*           line  = oidc_sprintf(
+        "  %s: %lu entries (%lu bytes), %lu expired, %lu evicted\n",
+        status_stores[i].name, (unsigned long)stats.entries,
+        (unsigned long)stats.bytes, (unsigned long)stats.expired,
+        (unsigned long)stats.evicted);
+    char* tmp = oidc_strcat(text, line);
+    secFree(text);
+    secFree(line);
+    text = tmp;
+  }
+  return text;
+}
+
+static cJSON* _storesStatusJSON() {
+  cJSON* stores = cJSON_CreateObject();
+  for (size_t i = 0; i < sizeof(status_stores) / sizeof(*status_stores); i++) {
+    struct db_stats stats = db_getStats(status_stores[i].db);
+    cJSON*          store = cJSON_CreateObject();
+    jsonAddNumberValue(store, "entries", stats.entries);
+    jsonAddNumberValue(store, "bytes", stats.bytes);
+    jsonAddNumberValue(store, "expired", stats.expired);
+    jsonAddNumberValue(store, "evicted", stats.evicted);
+    cJSON_AddItemToObject(stores, status_stores[i].key, store);
+  }
+  return stores;
+}
+
 void oidcd_handleAgentStatus(struct ipcPipe          pipes,
                              const struct arguments* arguments) {
   const char* fmt =
@@ -1245,7 +1475,8 @@ void oidcd_handleAgentStatus(struct ipcPipe          pipes,
       "##       oidc-agent status        ##\n"
       "####################################\n"
       "\nThis agent is running version %s.\n\nThis agent was started with the "
-      "following options:\n%s\nCurrently there are %d accounts loaded: %s\n\n";
+      "following options:\n%s\nCurrently there are %d accounts loaded: %s\n\n"
+      "HTTP connection cache: %s\n\n%s\n%s\n";
   list_t*      names      = _getNameListLoadedAccounts();
   unsigned int num_loaded = 0;
   char*        names_str  = NULL;
@@ -1253,10 +1484,17 @@ void oidcd_handleAgentStatus(struct ipcPipe          pipes,
     num_loaded = names->len;
     names_str  = listToDelimitedString(names, ", ");
   }
-  char* options = _argumentsToOptionsText(arguments);
-  char* status =
-      oidc_sprintf(fmt, VERSION, options, num_loaded, names_str ?: "");
+  char* options    = _argumentsToOptionsText(arguments);
+  char* http_stats = httpCacheStats();
+  char* stores     = _storesStatusText();
+  char* accounts   = accountCache_statusText();
+  char* status     = oidc_sprintf(fmt, VERSION, options, num_loaded,
+                                  names_str ?: "", http_stats ?: "unused",
+                                  accounts, stores);
   secFree(options);
+  secFree(http_stats);
+  secFree(stores);
+  secFree(accounts);
   secFree(names_str);
   ipc_writeToPipe(pipes, RESPONSE_SUCCESS_INFO, status);
   secFreeList(names);
@@ -1275,6 +1513,18 @@ void oidcd_handleAgentStatusJSON(struct ipcPipe          pipes,
   secFree(options);
   cJSON_AddItemToObject(json, "loaded_accounts",
                         names_j);  // names_j will freed with json
+  char* http_stats = httpCacheStats();
+  if (http_stats) {
+    jsonAddObjectValue(json, "http_cache", http_stats);
+    secFree(http_stats);
+  }
+  cJSON_AddItemToObject(json, "account_cache", accountCache_statusJSON());
+  cJSON_AddItemToObject(json, "stores", _storesStatusJSON());
+  char* unavailable = circuitBreaker_status();
+  if (unavailable) {
+    jsonAddObjectValue(json, "unavailable_providers", unavailable);
+    secFree(unavailable);
+  }
   char* info = jsonToString(json);
   secFreeJson(json);
   ipc_writeToPipe(pipes, RESPONSE_SUCCESS_INFO_OBJECT, info);
@@ -13,7 +13,7 @@ void oidcd_handleReauthenticate(struct ipcPipe pipes, char* short_name,
                                 const struct arguments* arguments);
 void oidcd_handleAdd(struct ipcPipe, const char* account_json,
                      const char* timeout_str, const char* confirm_str,
-                     const char* alwaysallowid);
+                     const char* alwaysallowid, const char* reloadable);
 void oidcd_handleDelete(struct ipcPipe, const char* account_json);
 void oidcd_handleDeleteClient(struct ipcPipe pipes, const char* client_uri,
                               const char* registration_access_token,
@@ -21,11 +21,13 @@ void oidcd_handleDeleteClient(struct ipcPipe pipes, const char* client_uri,
 void oidcd_handleRm(struct ipcPipe, char* account_name);
 void oidcd_handleRemoveAll(struct ipcPipe);
 void oidcd_handleToken(struct ipcPipe, const char* short_name,
-                       const char* min_valid_period_str, const char* scope,
+                       const char* min_valid_period_str,
+                       const char* stale_min_valid_period_str, const char* scope,
                        const char* application_hint, const char* audience,
                        const struct arguments*);
 void oidcd_handleTokenIssuer(struct ipcPipe pipes, const char* issuer,
                              const char* min_valid_period_str,
+                             const char* stale_min_valid_period_str,
                              const char* scope, const char* application_hint,
                              const char*             audience,
                              const struct arguments* arguments);
@@ -50,6 +52,8 @@ void oidcd_handleMytokenProvidersLookup(struct ipcPipe pipes,
                                         const char*    config_endpoint,
                                         const char*    cert_path);
 void oidcd_handleListLoadedAccounts(struct ipcPipe pipes);
+void oidcd_handleStateExport(struct ipcPipe pipes);
+void oidcd_handleStateImport(struct ipcPipe pipes, const char* data);
 void oidcd_handleTermHttp(struct ipcPipe, const char* state);
 void oidcd_handleLock(struct ipcPipe, const char* password, int _lock);
 void oidcd_handleAgentStatus(struct ipcPipe          pipes,
@@ -20,10 +20,10 @@ char* parseForConfig(char* res) {
     return NULL;
   }
   secFree(res);
-  KEY_VALUE_VARS(oidc_errno, config);
-  if (_oidc_errno) {
-    oidc_errno = strToInt(_oidc_errno);
-    secFree(_oidc_errno);
+  KEY_VALUE_VARS(errno_str, config);
+  if (_errno_str) {
+    oidc_errno = strToInt(_errno_str);
+    secFree(_errno_str);
   }
   return _config;
 }
@@ -58,10 +58,10 @@ oidc_error_t parseForErrorCode(char* res) {
     return oidc_errno;
   }
   secFree(res);
-  KEY_VALUE_VARS(oidc_errno);
-  if (_oidc_errno) {
-    oidc_errno = strToInt(_oidc_errno);
-    secFree(_oidc_errno);
+  KEY_VALUE_VARS(errno_str);
+  if (_errno_str) {
+    oidc_errno = strToInt(_errno_str);
+    secFree(_errno_str);
     return oidc_errno;
   }
   return OIDC_SUCCESS;
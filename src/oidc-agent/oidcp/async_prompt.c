@@ -0,0 +1,474 @@
+#define _XOPEN_SOURCE 700
+
+#include "async_prompt.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ipc/serveripc.h"
+#include "oidc-agent/oidcp/passwords/agent_prompt.h"
+#include "oidc-agent/oidcp/passwords/askpass.h"
+#include "utils/agentLogger.h"
+#include "utils/listUtils.h"
+#include "utils/memory.h"
+#include "utils/memzero.h"
+#include "utils/string/stringUtils.h"
+#include "utils/system_runner.h"
+#include "wrapper/list.h"
+
+/**
+ * Prompts that are shown without blocking oidcp.
+ *
+ * Each prompt runs in a child process that writes the output of oidc-prompt
+ * to a pipe shared by all prompts and exits. The client that needs the answer
+ * is parked: its connection stays open and its request is kept. When the
+ * prompt finished, the request is handled again from the beginning and the
+ * answer is given to the internal request of oidcd that asks for it. Clients
+ * that need the same answer wait for the same prompt.
+ *
+ * Only ASYNC_PROMPT_MAX_RUNNING prompts run at the same time, the others are
+ * queued (pid 0) and started when a running prompt finished. If the queue is
+ * full, the client is not parked and gets a blocking prompt.
+ */
+struct parked_client {
+  struct connection* con;
+  unsigned char*     ipc_key;
+  char*              request;
+  unsigned char      tries;
+};
+
+struct async_prompt {
+  pid_t         pid;
+  unsigned char type;
+  char*         shortname;
+  char*         issuer;
+  char*         application_hint;
+  list_t*       clients;
+};
+
+struct prompt_result {
+  pid_t  pid;
+  size_t len;
+};
+
+static list_t*              prompts    = NULL;
+static struct async_prompt* resuming   = NULL;
+static struct connection*   client     = NULL;
+static int                  results[2] = {-1, -1};
+static struct ipc_watch     prompt_watch;
+static async_prompt_resume  resume_cb  = NULL;
+static void*                resume_arg = NULL;
+
+// the answer for the client that is resumed
+static struct {
+  unsigned char         pending;
+  struct async_prompt*  prompt;
+  struct parked_client* client;
+  const char*           output;
+} answer;
+
+static void _secFreeParkedClient(struct parked_client* c) {
+  if (c == NULL) {
+    return;
+  }
+  secFree(c->ipc_key);
+  secFree(c->request);
+  secFree(c);
+}
+
+static void _secFreePrompt(struct async_prompt* p) {
+  if (p == NULL) {
+    return;
+  }
+  secFree(p->shortname);
+  secFree(p->issuer);
+  secFree(p->application_hint);
+  secFreeList(p->clients);
+  secFree(p);
+}
+
+static int _promptMatches(const struct async_prompt* p, unsigned char type,
+                          const char* shortname, const char* issuer,
+                          const char* application_hint) {
+  if (p->type != type || !strequal(p->shortname, shortname) ||
+      !strequal(p->issuer, issuer)) {
+    return 0;
+  }
+  // The password of an account does not depend on the application
+  return type == ASYNC_PROMPT_AUTOLOAD ||
+         strequal(p->application_hint, application_hint);
+}
+
+static list_node_t* _findParked(list_t*                  clients,
+                                const struct connection* con) {
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(clients, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    if (((struct parked_client*)node->val)->con == con) {
+      break;
+    }
+  }
+  list_iterator_destroy(it);
+  return node;
+}
+
+static size_t _countPrompts(int running) {
+  if (prompts == NULL) {
+    return 0;
+  }
+  size_t           count = 0;
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(prompts, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    if ((((struct async_prompt*)node->val)->pid != 0) == running) {
+      count++;
+    }
+  }
+  list_iterator_destroy(it);
+  return count;
+}
+
+static void _resumeClients(struct async_prompt* p, const char* output) {
+  resuming = p;
+  list_node_t* node;
+  while ((node = list_lpop(p->clients))) {
+    struct parked_client* c = node->val;
+    LIST_FREE(node);
+    agent_log(DEBUG, "Resuming parked client");
+    server_ipc_restoreKey(c->ipc_key);
+    c->ipc_key     = NULL;
+    answer.pending = 1;
+    answer.prompt  = p;
+    answer.client  = c;
+    answer.output  = output;
+    client         = c->con;
+    resume_cb(c->con, c->request, resume_arg);
+    client         = NULL;
+    answer.pending = 0;
+    _secFreeParkedClient(c);
+  }
+  resuming = NULL;
+}
+
+static void _startQueued();
+
+/**
+ * @brief reads the output of a finished prompt and resumes the clients that
+ * waited for it
+ */
+static void _handleResult() {
+  struct prompt_result res;
+  if (read(results[0], &res, sizeof(res)) != sizeof(res)) {
+    agent_log(ERROR, "Could not read prompt result: %m");
+    return;
+  }
+  char* output = secAlloc(res.len + 1);
+  if (res.len > 0 && read(results[0], output, res.len) != (ssize_t)res.len) {
+    agent_log(ERROR, "Could not read prompt result: %m");
+    secFree(output);
+    return;
+  }
+  waitpid(res.pid, NULL, 0);
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(prompts, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    if (((struct async_prompt*)node->val)->pid == res.pid) {
+      break;
+    }
+  }
+  list_iterator_destroy(it);
+  if (node == NULL) {
+    secFree(output);
+    return;
+  }
+  struct async_prompt* p = node->val;
+  node->val              = NULL;
+  list_remove(prompts, node);
+  agent_log(DEBUG, "Prompt finished, %lu clients waited for it",
+            (unsigned long)p->clients->len);
+  _resumeClients(p, output);
+  secFree(output);
+  _secFreePrompt(p);
+  _startQueued();
+}
+
+/**
+ * @brief returns the watch that handles finished prompts; it has to be added
+ * to the event loop of oidcp
+ * @param next the watch that is chained after this one; might be @c NULL
+ * @param resume called for each parked client when its prompt finished; it
+ * has to handle the request of the client again
+ * @param arg passed to @p resume
+ */
+const struct ipc_watch* asyncPromptWatch(const struct ipc_watch* next,
+                                         async_prompt_resume     resume,
+                                         void*                   arg) {
+  if (results[0] == -1 && pipe(results) != 0) {
+    agent_log(ERROR, "Could not create prompt pipe: %m");
+    results[0] = results[1] = -1;
+  }
+  if (results[0] != -1) {
+    fcntl(results[0], F_SETFD, FD_CLOEXEC);
+    fcntl(results[1], F_SETFD, FD_CLOEXEC);
+  }
+  resume_cb           = resume;
+  resume_arg          = arg;
+  prompt_watch.fd     = results[0];
+  prompt_watch.handle = _handleResult;
+  prompt_watch.next   = next;
+  return &prompt_watch;
+}
+
+/**
+ * @brief sets the client whose request is handled; prompts for it might be
+ * shown asynchronously
+ * @param con the connection of the client or @c NULL if the client cannot
+ * wait, e.g. because its request is part of a batch
+ */
+void asyncPrompt_setClient(struct connection* con) { client = con; }
+
+int asyncPrompt_canPark() {
+  return client != NULL && resume_cb != NULL && results[1] != -1;
+}
+
+static char* _promptCmd(unsigned char type, const char* shortname,
+                        const char* issuer, const char* application_hint) {
+  char* text = type == ASYNC_PROMPT_AUTOLOAD
+                   ? askpass_autoloadText(issuer, shortname, application_hint)
+                   : askpass_confirmationText(
+                         issuer, shortname, application_hint,
+                         type == ASYNC_PROMPT_CONFIRM_ID ? "id" : "access");
+  char* cmd = type == ASYNC_PROMPT_AUTOLOAD
+                  ? agent_promptPasswordCmd(text, "Encryption password")
+                  : agent_promptConsentDefaultYesCmd(text);
+  secFree(text);
+  return cmd;
+}
+
+_Noreturn static void _runPrompt(const char* cmd) {
+  // the prompt might be open for a long time, it must not keep the
+  // connections of oidcp open
+  long max_fd = sysconf(_SC_OPEN_MAX);
+  if (max_fd < 0 || max_fd > ASYNC_PROMPT_MAX_FD) {
+    max_fd = ASYNC_PROMPT_MAX_FD;
+  }
+  for (int fd = STDERR_FILENO + 1; fd < max_fd; fd++) {
+    if (fd != results[1]) {
+      close(fd);
+    }
+  }
+  signal(SIGCHLD, SIG_DFL);
+  char*  output = getOutputFromCommand(cmd);
+  size_t len    = output ? strlen(output) : 0;
+  if (len > PIPE_BUF - sizeof(struct prompt_result)) {
+    len = 0;  // not a valid answer; handled like a canceled prompt
+  }
+  // a single write is atomic, so results of different prompts do not mix
+  char                 buf[PIPE_BUF];
+  struct prompt_result res = {getpid(), len};
+  memcpy(buf, &res, sizeof(res));
+  if (len > 0) {
+    memcpy(buf + sizeof(res), output, len);
+  }
+  secFree(output);
+  if (write(results[1], buf, sizeof(res) + len) < 0) {
+    _exit(EXIT_FAILURE);
+  }
+  moresecure_memzero(buf, sizeof(buf));
+  _exit(EXIT_SUCCESS);
+}
+
+static oidc_error_t _startPrompt(struct async_prompt* p) {
+  char* cmd = _promptCmd(p->type, p->shortname, p->issuer, p->application_hint);
+  pid_t pid = fork();
+  if (pid == -1) {
+    agent_log(ERROR, "fork %m");
+    secFree(cmd);
+    oidc_setErrnoError();
+    return oidc_errno;
+  }
+  if (pid == 0) {
+    _runPrompt(cmd);
+  }
+  secFree(cmd);
+  p->pid = pid;
+  agent_log(DEBUG, "Started prompt for '%s'", p->shortname);
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief starts queued prompts while less than ASYNC_PROMPT_MAX_RUNNING
+ * prompts run; the clients of a prompt that cannot be started are resumed as
+ * if the user canceled it
+ */
+static void _startQueued() {
+  while (prompts != NULL && _countPrompts(1) < ASYNC_PROMPT_MAX_RUNNING) {
+    list_node_t*     node;
+    list_iterator_t* it = list_iterator_new(prompts, LIST_HEAD);
+    while ((node = list_iterator_next(it))) {
+      if (((struct async_prompt*)node->val)->pid == 0) {
+        break;
+      }
+    }
+    list_iterator_destroy(it);
+    if (node == NULL) {
+      return;
+    }
+    struct async_prompt* p = node->val;
+    if (_startPrompt(p) == OIDC_SUCCESS) {
+      continue;
+    }
+    node->val = NULL;
+    list_remove(prompts, node);
+    _resumeClients(p, NULL);
+    _secFreePrompt(p);
+  }
+}
+
+/**
+ * @brief parks the current client until the user answered a prompt; if an
+ * equal prompt is already shown or queued, the client waits for that one
+ * @param tries how often the user already entered a wrong password
+ * @param request the request of the client, it is handled again when the
+ * prompt finished
+ * @return @c OIDC_SUCCESS if the client was parked; in that case the key of
+ * its request was taken and nothing must be written to the client
+ */
+oidc_error_t asyncPrompt_park(unsigned char type, const char* shortname,
+                              const char* issuer, const char* application_hint,
+                              unsigned char tries, const char* request) {
+  if (!asyncPrompt_canPark()) {
+    oidc_errno = OIDC_EERROR;
+    return oidc_errno;
+  }
+  struct async_prompt* p = NULL;
+  if (prompts != NULL) {
+    list_node_t*     node;
+    list_iterator_t* it = list_iterator_new(prompts, LIST_HEAD);
+    while ((node = list_iterator_next(it))) {
+      if (_promptMatches(node->val, type, shortname, issuer,
+                         application_hint)) {
+        p = node->val;
+        break;
+      }
+    }
+    list_iterator_destroy(it);
+  }
+  if (p == NULL) {
+    int start = _countPrompts(1) < ASYNC_PROMPT_MAX_RUNNING;
+    if (!start && _countPrompts(0) >= ASYNC_PROMPT_MAX_QUEUED) {
+      agent_log(NOTICE, "Too many prompts, not parking client");
+      oidc_errno = OIDC_EERROR;
+      oidc_seterror("too many prompts");
+      return oidc_errno;
+    }
+    p                   = secAlloc(sizeof(struct async_prompt));
+    p->type             = type;
+    p->shortname        = oidc_strcopy(shortname);
+    p->issuer           = oidc_strcopy(issuer);
+    p->application_hint = oidc_strcopy(application_hint);
+    if (start && _startPrompt(p) != OIDC_SUCCESS) {
+      _secFreePrompt(p);
+      return oidc_errno;
+    }
+    p->clients       = list_new();
+    p->clients->free = (void (*)(void*)) & _secFreeParkedClient;
+    if (prompts == NULL) {
+      prompts       = list_new();
+      prompts->free = (void (*)(void*)) & _secFreePrompt;
+    }
+    list_rpush(prompts, list_node_new(p));
+    if (!start) {
+      agent_log(DEBUG, "Queued prompt for '%s'", shortname);
+    }
+  }
+  struct parked_client* c = secAlloc(sizeof(struct parked_client));
+  c->con                  = client;
+  c->ipc_key              = server_ipc_takeLastKey();
+  c->request              = oidc_strcopy(request);
+  c->tries                = tries;
+  list_rpush(p->clients, list_node_new(c));
+  agent_log(DEBUG, "Parked client, %lu clients wait for the prompt",
+            (unsigned long)p->clients->len);
+  client = NULL;  // a client can only wait for one prompt
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief returns the answer of the prompt the resumed client waited for, if
+ * it matches the given prompt; the answer is only returned once
+ * @param tries set to the number of wrong passwords; might be @c NULL
+ * @return the output of the prompt, an empty string if the user canceled it,
+ * or @c NULL if there is no answer; has to be freed after usage
+ */
+char* asyncPrompt_takeAnswer(unsigned char type, const char* shortname,
+                             const char* issuer, const char* application_hint,
+                             unsigned char* tries) {
+  if (!answer.pending || !_promptMatches(answer.prompt, type, shortname,
+                                         issuer, application_hint)) {
+    return NULL;
+  }
+  answer.pending = 0;
+  if (tries) {
+    *tries = answer.client->tries;
+  }
+  return oidc_strcopy(answer.output ?: "");
+}
+
+int asyncPrompt_isParked(const struct connection* con) {
+  if (resuming != NULL && _findParked(resuming->clients, con) != NULL) {
+    return 1;
+  }
+  if (prompts == NULL) {
+    return 0;
+  }
+  int              found = 0;
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(prompts, LIST_HEAD);
+  while (!found && (node = list_iterator_next(it))) {
+    found = _findParked(((struct async_prompt*)node->val)->clients, con) !=
+            NULL;
+  }
+  list_iterator_destroy(it);
+  return found;
+}
+
+/**
+ * @brief forgets a parked client; must be called before the connection is
+ * closed. The prompt stays open, its answer might still be used by other
+ * clients; a queued prompt no client waits for is dropped.
+ */
+void asyncPrompt_removeConnection(const struct connection* con) {
+  if (client == con) {
+    client = NULL;
+  }
+  if (resuming != NULL) {
+    list_node_t* node = _findParked(resuming->clients, con);
+    if (node != NULL) {
+      list_remove(resuming->clients, node);
+    }
+  }
+  if (prompts == NULL) {
+    return;
+  }
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(prompts, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    struct async_prompt* p      = node->val;
+    list_node_t*         parked = _findParked(p->clients, con);
+    if (parked != NULL) {
+      agent_log(DEBUG, "Parked client went away");
+      list_remove(p->clients, parked);
+      if (p->pid == 0 && p->clients->len == 0) {
+        list_remove(prompts, node);
+      }
+    }
+  }
+  list_iterator_destroy(it);
+}
@@ -0,0 +1,50 @@
+#ifndef OIDCP_ASYNC_PROMPT_H
+#define OIDCP_ASYNC_PROMPT_H
+
+#include "ipc/connection.h"
+#include "ipc/ipc.h"
+#include "utils/oidc_error.h"
+
+#define ASYNC_PROMPT_CONFIRM 1
+#define ASYNC_PROMPT_CONFIRM_ID 2
+#define ASYNC_PROMPT_AUTOLOAD 3
+
+#ifndef ASYNC_PROMPT_MAX_FD
+#define ASYNC_PROMPT_MAX_FD 4096
+#endif
+
+// prompts that are shown at the same time; further prompts are queued
+#ifndef ASYNC_PROMPT_MAX_RUNNING
+#define ASYNC_PROMPT_MAX_RUNNING 4
+#endif
+
+// queued prompts; beyond that clients get a blocking prompt
+#ifndef ASYNC_PROMPT_MAX_QUEUED
+#define ASYNC_PROMPT_MAX_QUEUED 32
+#endif
+
+/**
+ * @brief called when the prompt a client was parked for finished
+ * @param con the connection of the client
+ * @param request the request of the client that has to be handled again
+ * @param arg the argument passed to @c asyncPromptWatch
+ */
+typedef void (*async_prompt_resume)(struct connection* con,
+                                    const char* request, void* arg);
+
+const struct ipc_watch* asyncPromptWatch(const struct ipc_watch* next,
+                                         async_prompt_resume     resume,
+                                         void*                   arg);
+void         asyncPrompt_setClient(struct connection* con);
+int          asyncPrompt_canPark();
+oidc_error_t asyncPrompt_park(unsigned char type, const char* shortname,
+                              const char* issuer, const char* application_hint,
+                              unsigned char tries, const char* request);
+char*        asyncPrompt_takeAnswer(unsigned char type, const char* shortname,
+                                    const char*    issuer,
+                                    const char*    application_hint,
+                                    unsigned char* tries);
+int          asyncPrompt_isParked(const struct connection* con);
+void         asyncPrompt_removeConnection(const struct connection* con);
+
+#endif  // OIDCP_ASYNC_PROMPT_H
@@ -0,0 +1,41 @@
+#include "no_prompt.h"
+
+#include "defines/ipc_values.h"
+#include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
+
+/**
+ * Some requests are handled for clients that cannot wait for the user, e.g.
+ * the requests of a batch: they are handled one after the other on the
+ * connection of the batch, so a prompt would block oidcp. While no prompt is
+ * allowed, internal requests of oidcd that need the user are answered with
+ * @c OIDC_ENOINTERACT, like the token watch does.
+ */
+static unsigned char noPrompt = 0;
+
+void noPrompt_set(unsigned char no_prompt) { noPrompt = no_prompt; }
+
+int noPrompt_isSet() { return noPrompt; }
+
+/**
+ * @brief answers an internal request of oidcd that would prompt the user
+ * @param request the value of the request key of the internal request
+ * @param final is set to @c 1 if the answer is the final response for the
+ * client, because oidcd does not wait for an answer to @p request
+ * @return the answer or @c NULL if @p request does not need the user; has to
+ * be freed after usage
+ */
+char* noPrompt_answer(const char* request, unsigned char* final) {
+  *final = 0;
+  if (strequal(request, INT_REQUEST_VALUE_AUTOGEN)) {
+    *final = 1;
+    return oidc_sprintf(RESPONSE_ERROR, oidc_serrorFor(OIDC_ENOINTERACT));
+  }
+  if (strequal(request, INT_REQUEST_VALUE_AUTOLOAD) ||
+      strequal(request, INT_REQUEST_VALUE_CONFIRM) ||
+      strequal(request, INT_REQUEST_VALUE_CONFIRMIDTOKEN) ||
+      strequal(request, INT_REQUEST_VALUE_CONFIRMMYTOKEN)) {
+    return oidc_sprintf(INT_RESPONSE_ERROR, OIDC_ENOINTERACT);
+  }
+  return NULL;
+}
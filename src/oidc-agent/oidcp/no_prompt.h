@@ -0,0 +1,8 @@
+#ifndef OIDCP_NO_PROMPT_H
+#define OIDCP_NO_PROMPT_H
+
+void  noPrompt_set(unsigned char no_prompt);
+int   noPrompt_isSet();
+char* noPrompt_answer(const char* request, unsigned char* final);
+
+#endif  // OIDCP_NO_PROMPT_H
@@ -17,18 +17,27 @@
 #include "defines/oidc_values.h"
 #include "defines/settings.h"
 #include "ipc/cryptCommunicator.h"
+#include "ipc/ipc.h"
 #include "ipc/pipe.h"
 #include "ipc/serveripc.h"
 #include "oidc-agent/agent_state.h"
+#include "oidc-agent/config_watcher.h"
 #include "oidc-agent/daemonize.h"
+#include "oidc-agent/http/http_ipc.h"
 #include "oidc-agent/oidc/device_code.h"
 #include "oidc-agent/oidcd/parse_internal.h"
+#include "oidc-agent/oidcp/async_prompt.h"
+#include "oidc-agent/oidcp/no_prompt.h"
 #include "oidc-agent/oidcp/passwords/agent_prompt.h"
 #include "oidc-agent/oidcp/passwords/askpass.h"
 #include "oidc-agent/oidcp/passwords/password_handler.h"
 #include "oidc-agent/oidcp/passwords/password_store.h"
+#include "oidc-agent/oidcp/pending_flow.h"
 #include "oidc-agent/oidcp/proxy_handler.h"
 #include "oidc-agent/oidcp/start_oidcd.h"
+#include "oidc-agent/oidcp/state_snapshot.h"
+#include "oidc-agent/oidcp/token_watch.h"
+#include "oidc-agent/oidcp/unlock_delay.h"
 #include "oidc-agent/stats/statlogger.h"
 #include "oidc-gen/promptAndSet/name.h"
 #include "utils/agentLogger.h"
@@ -62,6 +71,62 @@ static void handleAccountInfo(struct ipcPipe pipes, int sock) {
   secFree(accountsInfo);
 }
 
+/**
+ * Handles the access token requests of a batch one after the other, like
+ * single requests, and sends each response as a newline terminated message.
+ * The batch connection cannot be parked for a single request, so the user is
+ * never asked; such requests fail with @c OIDC_ENOINTERACT.
+ */
+static void handleBatch(struct ipcPipe pipes, int sock, const char* client_req,
+                        const struct arguments* arguments) {
+  unsigned char* ipc_key = server_ipc_takeLastKey();
+
+  char*   requests = getJSONValueFromString(client_req, IPC_KEY_REQUESTS);
+  list_t* reqs     = JSONArrayStringToList(requests);
+  secFree(requests);
+  if (reqs == NULL) {
+    char* res = oidc_sprintf(RESPONSE_BADREQUEST, "no requests in batch");
+    server_ipc_writeLine(sock, ipc_key, res);
+    secFree(res);
+    secFree(ipc_key);
+    return;
+  }
+  agent_log(DEBUG, "Handling batch of %lu requests", (unsigned long)reqs->len);
+  server_ipc_startCapture(sock);
+  noPrompt_set(1);
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(reqs, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    cJSON* json = stringToJson(node->val);
+    char*  res  = NULL;
+    if (json == NULL) {
+      res = oidc_sprintf(RESPONSE_BADREQUEST, oidc_serror());
+    } else {
+      // Only access tokens can be requested in a batch
+      setJSONValue(json, IPC_KEY_REQUEST, REQUEST_VALUE_ACCESSTOKEN);
+      char* req = jsonToStringUnformatted(json);
+      secFreeJson(json);
+      statlog(req);
+      handleOidcdComm(pipes, sock, req, arguments);
+      secFree(req);
+      res = server_ipc_takeCapturedResponse();
+    }
+    if (res == NULL) {
+      res = oidc_sprintf(RESPONSE_ERROR, "no response");
+    }
+    oidc_error_t e = server_ipc_writeLine(sock, ipc_key, res);
+    secFree(res);
+    if (e != OIDC_SUCCESS) {  // client is gone
+      break;
+    }
+  }
+  list_iterator_destroy(it);
+  noPrompt_set(0);
+  server_ipc_stopCapture();
+  secFreeList(reqs);
+  secFree(ipc_key);
+}
+
 static struct connection* unix_listencon;
 
 static pid_t parent_pid = -1;
@@ -72,32 +137,168 @@ static void check_parent_alive(void) {
   }
 }
 
+static struct ipc_watch notify_watch = {.fd = -1};
+
+/**
+ * Handles the notifications oidcd sends on its own, i.e. refresh tokens that
+ * were rotated by a background refresh. They are newline terminated and not
+ * answered.
+ */
+static void handleOidcdNotifications(void) {
+  char* msgs = ipc_read(notify_watch.fd);
+  if (msgs == NULL) {
+    if (oidc_errno == OIDC_EIPCDIS) {
+      agent_log(ERROR, "oidcd died");
+      exit(EXIT_FAILURE);
+    }
+    return;
+  }
+  char* saveptr = NULL;
+  for (char* msg = strtok_r(msgs, "\n", &saveptr); msg != NULL;
+       msg       = strtok_r(NULL, "\n", &saveptr)) {
+    INIT_KEY_VALUE(IPC_KEY_REQUEST, IPC_KEY_SHORTNAME, OIDC_KEY_REFRESHTOKEN);
+    if (CALL_GETJSONVALUES(msg) >= 0) {
+      KEY_VALUE_VARS(request, shortname, refresh_token);
+      if (strequal(_request, INT_REQUEST_VALUE_UPD_REFRESH) &&
+          updateRefreshToken(_shortname, _refresh_token) != OIDC_SUCCESS) {
+        agent_log(WARNING, "Could not update refresh token of '%s': %s",
+                  _shortname, oidc_serror());
+      }
+    }
+    SEC_FREE_KEY_VALUES();
+  }
+  secFree(msgs);
+}
+
+static void _freeConnection(struct connection* con) {
+  tokenWatch_removeConnection(con);
+  asyncPrompt_removeConnection(con);
+  pendingFlow_removeConnection(con);
+  unlockDelay_removeConnection(con);
+  _secFreeConnection(con);
+}
+
+/**
+ * Sets the client whose request is handled; it might be parked while it waits
+ * for the user.
+ */
+static void setCurrentClient(struct connection* con) {
+  asyncPrompt_setClient(con);
+  pendingFlow_setClient(con);
+}
+
+static int isParked(const struct connection* con) {
+  return asyncPrompt_isParked(con) || pendingFlow_isParked(con) ||
+         unlockDelay_isParked(con);
+}
+
+struct resume_context {
+  struct ipcPipe          pipes;
+  const struct arguments* arguments;
+};
+
+/**
+ * Handles the request of a parked client again, after the prompt or flow it
+ * waited for finished.
+ */
+static void resumeClient(struct connection* con, const char* request,
+                         void* arg) {
+  const struct resume_context* ctx = arg;
+  setCurrentClient(con);
+  handleOidcdComm(ctx->pipes, *(con->msgsock), request, ctx->arguments);
+  setCurrentClient(NULL);
+  if (!isParked(con)) {
+    agent_log(DEBUG, "Remove resumed con from pool");
+    connectionDB_removeIfFound(con);
+  }
+}
+
+/**
+ * @brief tells oidcd in an add request if the account can be loaded again
+ * without asking the user, i.e. if it might be evicted; a value sent by the
+ * client is replaced
+ * @return the new request; @p client_req is freed
+ */
+static char* _markReloadable(char* client_req, const char* pw_entry_str) {
+  cJSON* json = stringToJson(client_req);
+  if (json == NULL) {
+    return client_req;
+  }
+  struct password_entry* pw =
+      pw_entry_str ? JSONStringToPasswordEntry(pw_entry_str) : NULL;
+  int reloadable = pw != NULL && canReloadWithoutUser(pw->shortname);
+  secFreePasswordEntry(pw);
+  cJSON_DeleteItemFromObjectCaseSensitive(json, IPC_KEY_RELOADABLE);
+  jsonAddNumberValue(json, IPC_KEY_RELOADABLE, reloadable);
+  char* req = jsonToStringUnformatted(json);
+  secFreeJson(json);
+  if (req == NULL) {
+    return client_req;
+  }
+  secFree(client_req);
+  return req;
+}
+
+static time_t earlierDeadline(time_t a, time_t b) {
+  if (a == 0 || (b != 0 && b < a)) {
+    return b;
+  }
+  return a;
+}
+
 _Noreturn static void handleClientComm(struct ipcPipe          pipes,
+                                       int                     notify_fd,
                                        const struct arguments* arguments,
                                        time_t parent_alive_interval) {
   connectionDB_new();
-  connectionDB_setFreeFunction((void (*)(void*)) & _secFreeConnection);
+  connectionDB_setFreeFunction((void (*)(void*)) & _freeConnection);
   connectionDB_setMatchFunction((matchFunction)connection_comparator);
+  struct resume_context resume_ctx = {pipes, arguments};
+  notify_watch = (struct ipc_watch){.fd     = notify_fd,
+                                    .handle = handleOidcdNotifications,
+                                    .next   = configWatcher_init()};
+  const struct ipc_watch* watch = stateSnapshot_init(
+      pipes, asyncPromptWatch(httpAsyncWatch(&notify_watch), resumeClient,
+                              &resume_ctx));
+  pendingFlow_init(resumeClient, &resume_ctx);
 
   time_t deadline = 0;
   while (1) {
-    deadline = getMinPasswordDeath();
+    deadline =
+        earlierDeadline(getMinPasswordDeath(), tokenWatch_nextDeadline());
+    deadline = earlierDeadline(deadline, pendingFlow_nextDeadline());
+    deadline = earlierDeadline(deadline, unlockDelay_nextDeadline());
+    deadline = earlierDeadline(deadline, stateSnapshot_nextDeadline());
     if (parent_alive_interval > 0) {
-      time_t parent_check = time(NULL) + parent_alive_interval;
-      if (deadline == 0 || deadline > parent_check) {
-        deadline = parent_check;
-      }
+      deadline = earlierDeadline(deadline, time(NULL) + parent_alive_interval);
     }
-    struct connection* con = ipc_readAsyncFromMultipleConnectionsWithTimeout(
-        *unix_listencon, deadline);
+    struct connection* con =
+        ipc_readAsyncFromMultipleConnectionsWithTimeoutAndWatch(
+            *unix_listencon, deadline, watch);
     if (con == NULL) {  // timeout reached
       if (parent_alive_interval != 0) {
         check_parent_alive();
       }
       removeDeathPasswords();
+      tokenWatch_run(pipes);
+      pendingFlow_run(pipes);
+      unlockDelay_run(pipes);
+      stateSnapshot_run(pipes);
+      continue;
+    }
+    if (tokenWatch_isWatching(con)) {
+      // A watching client only closes its connection
+      connectionDB_removeIfFound(con);
       continue;
     }
-    char* client_req = server_ipc_read(*(con->msgsock));
+    if (isParked(con)) {
+      // A parked client does not send anything before it got its response,
+      // it gave up waiting
+      connectionDB_removeIfFound(con);
+      continue;
+    }
+    unsigned char keepConnection = 0;
+    char*         client_req = server_ipc_read(*(con->msgsock));
     if (client_req == NULL) {
       server_ipc_writeOidcErrnoPlain(*(con->msgsock));
     } else {
@@ -109,19 +310,49 @@ _Noreturn static void handleClientComm(struct ipcPipe          pipes,
         KEY_VALUE_VARS(request, passwordentry, shortname);
         if (_request) {
           unsigned char skipOIDCDComm = 0;
-          if (strequal(_request, REQUEST_VALUE_ADD) ||
-              strequal(_request, REQUEST_VALUE_GEN)) {
+          if (strequal(_request, REQUEST_VALUE_ADD)) {
+            pw_handleSave(_passwordentry);
+            client_req = _markReloadable(client_req, _passwordentry);
+          } else if (strequal(_request, REQUEST_VALUE_GEN)) {
             pw_handleSave(_passwordentry);
           } else if (strequal(_request, REQUEST_VALUE_REMOVE)) {
             removePasswordFor(_shortname);
+            stateSnapshot_scheduleNow();
           } else if (strequal(_request, REQUEST_VALUE_REMOVEALL)) {
             removeAllPasswords();
+            stateSnapshot_scheduleNow();
           } else if (strequal(_request, REQUEST_VALUE_ACCOUNTINFO)) {
             handleAccountInfo(pipes, *(con->msgsock));
             skipOIDCDComm = 1;
+          } else if (strequal(_request, REQUEST_VALUE_BATCH)) {
+            handleBatch(pipes, *(con->msgsock), client_req, arguments);
+            skipOIDCDComm = 1;
+          } else if (strequal(_request, REQUEST_VALUE_CODEEXCHANGE)) {
+            handleOidcdComm(pipes, *(con->msgsock), client_req, arguments);
+            pendingFlow_codeExchanged(pipes, client_req);
+            skipOIDCDComm = 1;
+          } else if (strequal(_request, REQUEST_VALUE_WATCH)) {
+            keepConnection = tokenWatch_add(con, server_ipc_takeLastKey(),
+                                            client_req) == OIDC_SUCCESS;
+            skipOIDCDComm  = 1;
+          } else if (strequal(_request, REQUEST_VALUE_LOCK)) {
+            // a restart must not restore the accounts unlocked
+            stateSnapshot_invalidate();
+          } else if (strequal(_request, REQUEST_VALUE_UNLOCK)) {
+            keepConnection = unlockDelay_handle(pipes, con, client_req);
+            skipOIDCDComm  = 1;
+          } else if (strequal(_request, INT_REQUEST_VALUE_STATEEXPORT) ||
+                     strequal(_request, INT_REQUEST_VALUE_STATEIMPORT)) {
+            // only oidcp itself may move the agent state
+            server_ipc_write(*(con->msgsock), RESPONSE_BADREQUEST,
+                             "Unknown request type.");
+            skipOIDCDComm = 1;
           }
           if (!skipOIDCDComm) {
+            setCurrentClient(con);
             handleOidcdComm(pipes, *(con->msgsock), client_req, arguments);
+            setCurrentClient(NULL);
+            keepConnection = isParked(con);
           }
         } else {  //  no request type
           server_ipc_write(*(con->msgsock), RESPONSE_BADREQUEST,
@@ -131,10 +362,16 @@ _Noreturn static void handleClientComm(struct ipcPipe          pipes,
       SEC_FREE_KEY_VALUES();
       secFree(client_req);
     }
-    agent_log(DEBUG, "Remove con from pool");
-    connectionDB_removeIfFound(con);
+    if (!keepConnection) {
+      agent_log(DEBUG, "Remove con from pool");
+      connectionDB_removeIfFound(con);
+    }
     agent_log(DEBUG, "Currently there are %lu connections",
               connectionDB_getSize());
+    tokenWatch_run(pipes);
+    pendingFlow_run(pipes);
+    unlockDelay_run(pipes);
+    stateSnapshot_run(pipes);
   }
 }
 
@@ -277,14 +514,16 @@ int main(int argc, char** argv) {
   parent_pid = getppid();
 
   agent_state.defaultTimeout = arguments.lifetime;
-  struct ipcPipe pipes       = startOidcd(&arguments);
+  int            notify_fd   = -1;
+  struct ipcPipe pipes       = startOidcd(&arguments, &notify_fd);
+  stateSnapshot_restore(pipes);
 
   if (ipc_bindAndListen(unix_listencon, arguments.group) != 0) {
     exit(EXIT_FAILURE);
   }
 
   set_prompt_mode(PROMPT_MODE_GUI);
-  handleClientComm(pipes, &arguments, parent_alive_interval);
+  handleClientComm(pipes, notify_fd, &arguments, parent_alive_interval);
 }
 
 char* _extractShortnameFromReauthenticateInfo(const char* info) {
@@ -314,84 +553,6 @@ char* _extractShortnameFromReauthenticateInfo(const char* info) {
     return;                                                        \
   }
 
-int _waitForCodeExchangeRequest(time_t expiration, const char* expected_state,
-                                struct ipcPipe pipes) {
-  while (1) {
-    struct connection* con = ipc_readAsyncFromMultipleConnectionsWithTimeout(
-        *unix_listencon, expiration);
-    if (con == NULL) {  // timeout reached
-      removeDeathPasswords();
-      return -1;
-    }
-    char* client_req = server_ipc_read(*(con->msgsock));
-    if (client_req == NULL) {
-      connectionDB_removeIfFound(con);
-      agent_log(DEBUG, "Currently there are %lu connections",
-                connectionDB_getSize());
-      continue;
-    }
-    INIT_KEY_VALUE(IPC_KEY_REQUEST, OIDC_KEY_REDIRECTURI);
-    if (CALL_GETJSONVALUES(client_req) < 0) {
-      server_ipc_writeOidcErrno(*(con->msgsock));
-      secFree(client_req);
-      SEC_FREE_KEY_VALUES();
-      connectionDB_removeIfFound(con);
-      agent_log(DEBUG, "Currently there are %lu connections",
-                connectionDB_getSize());
-      continue;
-    }
-    KEY_VALUE_VARS(request, uri);
-    if (!strcaseequal(_request, REQUEST_VALUE_CODEEXCHANGE)) {
-      secFree(client_req);
-      SEC_FREE_KEY_VALUES();
-      time_t remaining_time = expiration - time(NULL);
-      char*  error_msg      = oidc_sprintf(
-          "request currently not acceptable; please try again later (%ds)",
-          remaining_time);
-      server_ipc_write(*(con->msgsock), RESPONSE_ERROR, error_msg);
-      secFree(error_msg);
-      connectionDB_removeIfFound(con);
-      agent_log(DEBUG, "Currently there are %lu connections",
-                connectionDB_getSize());
-      continue;
-    }
-    char* forwarded_res = ipc_communicateThroughPipe(pipes, "%s", client_req);
-    secFree(client_req);
-    if (forwarded_res == NULL) {
-      if (oidc_errno == OIDC_EIPCDIS || oidc_errno == OIDC_EWRITE) {
-        agent_log(ERROR, "oidcd died");
-        server_ipc_write(*(con->msgsock), RESPONSE_ERROR, "oidcd died");
-        exit(EXIT_FAILURE);
-      }
-      agent_log(ERROR, "no response from oidcd");
-      server_ipc_writeOidcErrno(*(con->msgsock));
-      SEC_FREE_KEY_VALUES();
-      connectionDB_removeIfFound(con);
-      agent_log(DEBUG, "Currently there are %lu connections",
-                connectionDB_getSize());
-      continue;
-    }
-    server_ipc_write(*(con->msgsock), "%s", forwarded_res);
-    secFree(forwarded_res);
-    char* state = extractParameterValueFromUri(_uri, "state");
-    if (strequal(expected_state, state)) {
-      secFree(state);
-      SEC_FREE_KEY_VALUES();
-      connectionDB_removeIfFound(con);
-      agent_log(DEBUG, "Currently there are %lu connections",
-                connectionDB_getSize());
-      agent_log(DEBUG, "Returning");
-      return 0;
-    }
-    secFree(state);
-    agent_log(DEBUG, "Once again");
-    SEC_FREE_KEY_VALUES();
-    connectionDB_removeIfFound(con);
-    agent_log(DEBUG, "Currently there are %lu connections",
-              connectionDB_getSize());
-  }
-}
-
 const char* _getMytokenURLToUse(struct ipcPipe pipes, const char* issuer) {
   unsigned char useMytokenServer = 0;
   if (!getGenConfig()->prefer_mytoken_over_oidc ||
@@ -444,68 +605,38 @@ void _parseInternalGen(struct ipcPipe pipes, int sock, char* res,
   }
   secFree(res);
   KEY_VALUE_VARS(device, url, state, request, action, issuer, shortname);
-  if (_url) {
-    agent_displayAuthCodeURL(_url, shortname, reauth_intro);
-    time_t timeout = time(NULL) + AGENT_PROMPT_TIMEOUT;
-    if (_waitForCodeExchangeRequest(timeout, _state, pipes)) {
-      server_ipc_write(sock, error_res_fmt, error_res_arg);
-      SEC_FREE_KEY_VALUES();
-      return;
-    }
-
-    char* lookup_res =
-        ipc_communicateThroughPipe(pipes, REQUEST_STATELOOKUP, _state);
-    SHUTDOWN_IF_D_DIED(lookup_res);
-    char* config = parseStateLookupRes(lookup_res, pipes);
-    if (config == NULL) {
-      server_ipc_write(sock, error_res_fmt, error_res_arg);
-      SEC_FREE_KEY_VALUES();
-      return;
-    }
-    SEC_FREE_KEY_VALUES();
-    if (writeOIDCFile(config, shortname) != OIDC_SUCCESS) {
-      server_ipc_write(sock, error_res_fmt, error_res_arg);
-      secFree(config);
-      return;
-    }
-    secFree(config);
-
-    char* final_res =
-        ipc_communicateThroughPipe(pipes, "%s", original_client_req);
-    server_ipc_write(sock, "%s", final_res);
-    secFree(final_res);
-    return;
-  }
-  if (_device) {
-    struct oidc_device_code* dc = getDeviceCodeFromJSON(_device);
-    if (dc == NULL) {
-      SEC_FREE_KEY_VALUES();
-      server_ipc_write(sock, error_res_fmt, error_res_arg);
-      return;
-    }
-    agent_displayDeviceCode(dc, shortname, reauth_intro);
-    if (dc->expires_in > AGENT_PROMPT_TIMEOUT) {
-      dc->expires_in = AGENT_PROMPT_TIMEOUT;
+  if (_url || _device) {
+    // The flow is finished from the main loop, so other clients are served
+    // while the user authenticates
+    char* error_res = oidc_sprintf(error_res_fmt, error_res_arg);
+    int   parked    = 0;
+    if (_url) {
+      agent_displayAuthCodeURL(_url, shortname, reauth_intro);
+      parked = pendingFlow_startCode(_state, time(NULL) + AGENT_PROMPT_TIMEOUT,
+                                     shortname, original_client_req,
+                                     error_res);
+    } else {
+      struct oidc_device_code* dc = getDeviceCodeFromJSON(_device);
+      if (dc == NULL) {
+        SEC_FREE_KEY_VALUES();
+        server_ipc_write(sock, "%s", error_res);
+        secFree(error_res);
+        return;
+      }
+      agent_displayDeviceCode(dc, shortname, reauth_intro);
+      if (dc->expires_in == 0 || dc->expires_in > AGENT_PROMPT_TIMEOUT) {
+        dc->expires_in = AGENT_PROMPT_TIMEOUT;
+      }
+      parked = pendingFlow_startDevice(
+          _device, dc->interval ?: 5, time(NULL) + dc->expires_in, shortname,
+          original_client_req, error_res);
+      secFreeDeviceCode(dc);
     }
-    char* config = agent_pollDeviceCode(
-        _device, dc->interval, dc->expires_in ? time(NULL) + dc->expires_in : 0,
-        0, &pipes);
     SEC_FREE_KEY_VALUES();
-    if (config == NULL) {
-      server_ipc_write(sock, error_res_fmt, error_res_arg);
-      return;
+    if (!parked) {
+      server_ipc_write(sock, "%s", error_res);
     }
-    if (writeOIDCFile(config, shortname) != OIDC_SUCCESS) {
-      secFree(config);
-      server_ipc_write(sock, error_res_fmt, error_res_arg);
-      return;
-    }
-    secFree(config);
-
-    char* final_res =
-        ipc_communicateThroughPipe(pipes, "%s", original_client_req);
-    server_ipc_write(sock, "%s", final_res);
-    secFree(final_res);
+    secFree(error_res);
     return;
   }
   if (strcaseequal(_request, INT_REQUEST_VALUE_UPD_ISSUER)) {
@@ -630,8 +761,104 @@ void doReauthenticate(struct ipcPipe pipes, int sock,
   secFree(shortname);
 }
 
+/**
+ * Answers a confirmation request of oidcd. If the user has to be asked and
+ * the client can wait, the prompt is shown without blocking and the client is
+ * parked; the request is denied for now and handled again when the user
+ * answered.
+ */
+static char* _confirm(unsigned char type, const char* shortname,
+                      const char* issuer, const char* application_hint,
+                      const char* msg, unsigned char* parked) {
+  if (*parked) {  // the request is handled again anyway
+    return oidc_sprintf(INT_RESPONSE_ERROR, OIDC_EFORBIDDEN);
+  }
+  char* answer =
+      asyncPrompt_takeAnswer(type, shortname, issuer, application_hint, NULL);
+  if (answer != NULL) {
+    oidc_errno = strcaseequal(answer, "yes") ? OIDC_SUCCESS : OIDC_EFORBIDDEN;
+    secFree(answer);
+  } else if (asyncPrompt_canPark() &&
+             asyncPrompt_park(type, shortname, issuer, application_hint, 0,
+                              msg) == OIDC_SUCCESS) {
+    *parked    = 1;
+    oidc_errno = OIDC_EFORBIDDEN;
+  } else if (type == ASYNC_PROMPT_CONFIRM_ID) {
+    oidc_errno = issuer ? askpass_getIdTokenConfirmationWithIssuer(
+                              issuer, shortname, application_hint)
+                        : askpass_getIdTokenConfirmation(shortname,
+                                                         application_hint);
+  } else {
+    oidc_errno = issuer ? askpass_getConfirmationWithIssuer(issuer, shortname,
+                                                            application_hint)
+                        : askpass_getConfirmation(shortname, application_hint);
+  }
+  return oidc_errno == OIDC_SUCCESS
+             ? oidc_strcopy(RESPONSE_SUCCESS)
+             : oidc_sprintf(INT_RESPONSE_ERROR, oidc_errno);
+}
+
+/**
+ * Answers an autoload request of oidcd. Like for confirmations the password
+ * prompt is shown without blocking if the client can wait; after a wrong
+ * password the client is parked again.
+ */
+static char* _autoload(const char* shortname, const char* issuer,
+                       const char* application_hint, const char* msg,
+                       unsigned char* parked) {
+  if (*parked) {
+    return oidc_sprintf(INT_RESPONSE_ERROR, OIDC_EUSRPWCNCL);
+  }
+  char*         config   = NULL;
+  unsigned char tries    = 0;
+  char*         password = asyncPrompt_takeAnswer(
+      ASYNC_PROMPT_AUTOLOAD, shortname, issuer, application_hint, &tries);
+  if (password != NULL) {
+    unsigned char canceled = !strValid(password);
+    if (!canceled) {
+      config = getAutoloadConfigWithPassword(shortname, issuer, password);
+    }
+    secFree(password);
+    if (config == NULL) {
+      oidc_errno = OIDC_EUSRPWCNCL;
+      if (!canceled && tries + 1 < MAX_PASS_TRIES &&
+          asyncPrompt_park(ASYNC_PROMPT_AUTOLOAD, shortname, issuer,
+                           application_hint, tries + 1,
+                           msg) == OIDC_SUCCESS) {
+        *parked = 1;
+      }
+    }
+  } else if (asyncPrompt_canPark() && autoloadNeedsPassword(shortname) &&
+             asyncPrompt_park(ASYNC_PROMPT_AUTOLOAD, shortname, issuer,
+                              application_hint, 0, msg) == OIDC_SUCCESS) {
+    *parked    = 1;
+    oidc_errno = OIDC_EUSRPWCNCL;
+  } else {
+    config = getAutoloadConfig(shortname, issuer, application_hint);
+  }
+  char* send =
+      config ? oidc_sprintf(RESPONSE_STATUS_CONFIG, STATUS_SUCCESS, config)
+             : oidc_sprintf(INT_RESPONSE_ERROR, oidc_errno);
+  secFree(config);
+  return send;
+}
+
+/**
+ * Answers a reload request of oidcd for an account it evicted. The user is
+ * not asked; if the password is not stored, oidcd falls back to autoload.
+ */
+static char* _reload(const char* shortname) {
+  char* config = getReloadConfig(shortname);
+  char* send =
+      config ? oidc_sprintf(RESPONSE_STATUS_CONFIG, STATUS_SUCCESS, config)
+             : oidc_sprintf(INT_RESPONSE_ERROR, oidc_errno);
+  secFree(config);
+  return send;
+}
+
 void handleOidcdComm(struct ipcPipe pipes, int sock, const char* msg,
                      const struct arguments* arguments) {
+  unsigned char parked = 0;
   char* send = oidc_strcopy(msg);
   INIT_KEY_VALUE(IPC_KEY_REQUEST, OIDC_KEY_REFRESHTOKEN, IPC_KEY_SHORTNAME,
                  IPC_KEY_APPLICATIONHINT, IPC_KEY_ISSUERURL, OIDC_KEY_ERROR,
@@ -652,12 +879,17 @@ void handleOidcdComm(struct ipcPipe pipes, int sock, const char* msg,
                    error, info, action, scope);
     if (_request == NULL) {  // if the response is the final response, forward
                              // it to the client
+      if (parked) {  // the request is handled again after the prompt
+        secFree(oidcd_res);
+        SEC_FREE_KEY_VALUES();
+        return;
+      }
       if (_error != NULL && _info != NULL &&
           (strstarts(_error, "invalid_grant:") ||
            strstarts(_error, "invalid_token:") ||
            errorMessageIsForError(_error, OIDC_ENOREFRSH)) &&
           strSubString(_info, "--reauthenticate") &&
-          !arguments->no_autoreauthenticate) {
+          !arguments->no_autoreauthenticate && !noPrompt_isSet()) {
         doReauthenticate(pipes, sock, msg, oidcd_res, _info);
         SEC_FREE_KEY_VALUES();
         secFree(oidcd_res);
@@ -671,6 +903,20 @@ void handleOidcdComm(struct ipcPipe pipes, int sock, const char* msg,
     }
     statlog(oidcd_res);
     secFree(oidcd_res);
+    if (noPrompt_isSet()) {
+      unsigned char final  = 0;
+      char*         answer = noPrompt_answer(_request, &final);
+      if (answer != NULL) {
+        SEC_FREE_KEY_VALUES();
+        if (!final) {
+          send = answer;
+          continue;
+        }
+        server_ipc_write(sock, "%s", answer);  // oidcd does not wait for it
+        secFree(answer);
+        return;
+      }
+    }
     if (strequal(_request, INT_REQUEST_VALUE_UPD_REFRESH)) {
       oidc_error_t e = updateRefreshToken(_shortname, _refresh_token);
       send           = e == OIDC_SUCCESS ? oidc_strcopy(RESPONSE_SUCCESS)
@@ -683,33 +929,27 @@ void handleOidcdComm(struct ipcPipe pipes, int sock, const char* msg,
       SEC_FREE_KEY_VALUES();
       continue;
     } else if (strequal(_request, INT_REQUEST_VALUE_AUTOLOAD)) {
-      char* config = getAutoloadConfig(_shortname, _issuer, _application_hint);
-      send         = config
-                         ? oidc_sprintf(RESPONSE_STATUS_CONFIG, STATUS_SUCCESS, config)
-                         : oidc_sprintf(INT_RESPONSE_ERROR, oidc_errno);
-      secFree(config);
+      send = _autoload(_shortname, _issuer, _application_hint, msg, &parked);
+      SEC_FREE_KEY_VALUES();
+      continue;
+    } else if (strequal(_request, INT_REQUEST_VALUE_RELOAD)) {
+      send = _reload(_shortname);
       SEC_FREE_KEY_VALUES();
       continue;
     } else if (strequal(_request, INT_REQUEST_VALUE_AUTOGEN)) {
-      handleAutoGen(pipes, sock, msg, _issuer, _scope, _application_hint);
+      if (!parked) {
+        handleAutoGen(pipes, sock, msg, _issuer, _scope, _application_hint);
+      }
       SEC_FREE_KEY_VALUES();
       return;
     } else if (strequal(_request, INT_REQUEST_VALUE_CONFIRM)) {
-      oidc_error_t e =
-          _issuer ? askpass_getConfirmationWithIssuer(_issuer, _shortname,
-                                                      _application_hint)
-                  : askpass_getConfirmation(_shortname, _application_hint);
-      send = e == OIDC_SUCCESS ? oidc_strcopy(RESPONSE_SUCCESS)
-                               : oidc_sprintf(INT_RESPONSE_ERROR, oidc_errno);
+      send = _confirm(ASYNC_PROMPT_CONFIRM, _shortname, _issuer,
+                      _application_hint, msg, &parked);
       SEC_FREE_KEY_VALUES();
       continue;
     } else if (strequal(_request, INT_REQUEST_VALUE_CONFIRMIDTOKEN)) {
-      oidc_error_t e = _issuer ? askpass_getIdTokenConfirmationWithIssuer(
-                                     _issuer, _shortname, _application_hint)
-                               : askpass_getIdTokenConfirmation(
-                                     _shortname, _application_hint);
-      send           = e == OIDC_SUCCESS ? oidc_strcopy(RESPONSE_SUCCESS)
-                                         : oidc_sprintf(INT_RESPONSE_ERROR, oidc_errno);
+      send = _confirm(ASYNC_PROMPT_CONFIRM_ID, _shortname, _issuer,
+                      _application_hint, msg, &parked);
       SEC_FREE_KEY_VALUES();
       continue;
     } else if (strequal(_request, INT_REQUEST_VALUE_CONFIRMMYTOKEN)) {
@@ -33,6 +33,25 @@ char* agent_promptMytokenConsent(const char* base64_html) {
   return promptMytokenConsentGUI(base64_html, AGENT_PROMPT_TIMEOUT);
 }
 
+/**
+ * @brief returns the command that shows the same prompt as
+ * @c agent_promptPassword; it prints the password or nothing if the user
+ * canceled
+ */
+char* agent_promptPasswordCmd(const char* text, const char* label) {
+  return oidcPromptCmd("password", "oidc-agent password prompt", text, label,
+                       "", AGENT_PROMPT_TIMEOUT);
+}
+
+/**
+ * @brief returns the command that shows the same prompt as
+ * @c agent_promptConsentDefaultYes; it prints @c yes if the user agreed
+ */
+char* agent_promptConsentDefaultYesCmd(const char* text) {
+  return oidcPromptCmd("confirm-default-yes", "oidc-agent prompt confirm",
+                       text, "", "", AGENT_PROMPT_TIMEOUT);
+}
+
 static const char* const intro_fmt =
     "An error occurred while using the '%s' account configuration.\n"
     "Most likely the refresh token expired. To solve the problem you have to "
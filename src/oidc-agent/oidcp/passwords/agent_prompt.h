@@ -10,6 +10,8 @@ char* agent_promptPassword(const char* text, const char* label,
                            const char* init);
 int   agent_promptConsentDefaultYes(const char* text);
 char* agent_promptMytokenConsent(const char* base64_html);
+char* agent_promptPasswordCmd(const char* text, const char* label);
+char* agent_promptConsentDefaultYesCmd(const char* text);
 
 void agent_displayAuthCodeURL(const char* url, const char* shortname,
                               unsigned char reauth_intro);
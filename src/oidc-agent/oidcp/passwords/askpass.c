@@ -28,6 +28,21 @@ char* askpass_getPasswordForUpdate(const char* shortname) {
   return ret;
 }
 
+/**
+ * @brief returns the text of the password prompt for loading an account
+ * @param issuer might be @c NULL
+ */
+char* askpass_autoloadText(const char* issuer, const char* shortname,
+                           const char* application_hint) {
+  cJSON* data = generateJSONObject("shortname", cJSON_String, shortname, NULL);
+  data        = jsonAddStringValue(data, "issuer", issuer);
+  data        = jsonAddStringValue(data, "application-hint", application_hint);
+  char* msg   = issuer ? getprompt(PROMPTTEMPLATE(UNLOCK_ACCOUNT_ISSUER), data)
+                       : getprompt(PROMPTTEMPLATE(UNLOCK_ACCOUNT), data);
+  secFreeJson(data);
+  return msg;
+}
+
 char* askpass_getPasswordForAutoload(const char* shortname,
                                      const char* application_hint) {
   if (shortname == NULL) {
@@ -37,10 +52,7 @@ char* askpass_getPasswordForAutoload(const char* shortname,
   agent_log(DEBUG,
             "Prompting user for encryption password for autoload config '%s'",
             shortname);
-  cJSON* data = generateJSONObject("shortname", cJSON_String, shortname, NULL);
-  data        = jsonAddStringValue(data, "application-hint", application_hint);
-  char* msg   = getprompt(PROMPTTEMPLATE(UNLOCK_ACCOUNT), data);
-  secFreeJson(data);
+  char* msg = askpass_autoloadText(NULL, shortname, application_hint);
   char* ret = agent_promptPassword(msg, "Encryption password", NULL);
   secFree(msg);
   if (ret == NULL) {
@@ -61,11 +73,7 @@ char* askpass_getPasswordForAutoloadWithIssuer(const char* issuer,
       "Prompting user for encryption password for autoload config '%s' for "
       "issuer '%s'",
       shortname, issuer);
-  cJSON* data = generateJSONObject("shortname", cJSON_String, shortname,
-                                   "issuer", cJSON_String, issuer, NULL);
-  data        = jsonAddStringValue(data, "application-hint", application_hint);
-  char* msg   = getprompt(PROMPTTEMPLATE(UNLOCK_ACCOUNT_ISSUER), data);
-  secFreeJson(data);
+  char* msg = askpass_autoloadText(issuer, shortname, application_hint);
   char* ret = agent_promptPassword(msg, "Encryption password", NULL);
   secFree(msg);
   if (ret == NULL) {
@@ -74,9 +82,14 @@ char* askpass_getPasswordForAutoloadWithIssuer(const char* issuer,
   return ret;
 }
 
-oidc_error_t _askpass_getConfirmation(const char* issuer, const char* shortname,
-                                      const char* application_hint,
-                                      const char* token_type) {
+/**
+ * @brief returns the text of the confirmation prompt for using an account
+ * @param issuer might be @c NULL
+ * @param token_type @c "access" or @c "id"
+ */
+char* askpass_confirmationText(const char* issuer, const char* shortname,
+                               const char* application_hint,
+                               const char* token_type) {
   cJSON* data =
       generateJSONObject("shortname", cJSON_String, shortname, "token-type",
                          cJSON_String, token_type, NULL);
@@ -87,6 +100,14 @@ oidc_error_t _askpass_getConfirmation(const char* issuer, const char* shortname,
   }
   char* msg = getprompt(PROMPTTEMPLATE(CONFIRM), data);
   secFreeJson(data);
+  return msg;
+}
+
+oidc_error_t _askpass_getConfirmation(const char* issuer, const char* shortname,
+                                      const char* application_hint,
+                                      const char* token_type) {
+  char* msg =
+      askpass_confirmationText(issuer, shortname, application_hint, token_type);
   oidc_errno =
       agent_promptConsentDefaultYes(msg) ? OIDC_SUCCESS : OIDC_EFORBIDDEN;
   secFree(msg);
@@ -19,5 +19,10 @@ oidc_error_t askpass_getIdTokenConfirmation(const char* shortname,
 oidc_error_t askpass_getIdTokenConfirmationWithIssuer(
     const char* issuer, const char* shortname, const char* application_hint);
 char* askpass_getMytokenConfirmation(const char* base64_html);
+char* askpass_autoloadText(const char* issuer, const char* shortname,
+                           const char* application_hint);
+char* askpass_confirmationText(const char* issuer, const char* shortname,
+                               const char* application_hint,
+                               const char* token_type);
 
 #endif  // OIDC_ASKPASS_RUNNER_H
@@ -7,6 +7,7 @@
 #include "utils/crypt/passwordCrypt.h"
 #include "utils/db/password_db.h"
 #include "utils/file_io/file_io.h"
+#include "utils/json.h"
 #include "utils/memory.h"
 #include "utils/oidc_error.h"
 #include "utils/password_entry.h"
@@ -149,20 +150,8 @@ char* getGPGKeyFor(const char* shortname) {
   return NULL;
 }
 
-char* getPasswordFor(const char* shortname) {
-  if (shortname == NULL) {
-    oidc_setArgNullFuncError(__func__);
-    return NULL;
-  }
-  agent_log(DEBUG, "Getting password for '%s'", shortname);
-  struct password_entry  key = {.shortname = oidc_strcopy(shortname)};
-  struct password_entry* pw  = passwordDB_findValue(&key);
-  secFree(key.shortname);
-  if (pw == NULL) {
-    agent_log(DEBUG, "No password found for '%s'", shortname);
-    agent_log(DEBUG, "Try getting password from user prompt");
-    return askpass_getPasswordForUpdate(shortname);
-  }
+static char* _getStoredPassword(const struct password_entry* pw,
+                                const char*                  shortname) {
   unsigned char type = pw->type;
   agent_log(DEBUG, "Password type is %hhu", type);
   char* res = NULL;
@@ -184,16 +173,75 @@ char* getPasswordFor(const char* shortname) {
     res        = getLineFromFile(file);
     secFree(file);
   }
-  if (!res && type & PW_TYPE_PRMT) {
+  return res;
+}
+
+char* getPasswordFor(const char* shortname) {
+  if (shortname == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return NULL;
+  }
+  agent_log(DEBUG, "Getting password for '%s'", shortname);
+  struct password_entry  key = {.shortname = oidc_strcopy(shortname)};
+  struct password_entry* pw  = passwordDB_findValue(&key);
+  secFree(key.shortname);
+  if (pw == NULL) {
+    agent_log(DEBUG, "No password found for '%s'", shortname);
+    agent_log(DEBUG, "Try getting password from user prompt");
+    return askpass_getPasswordForUpdate(shortname);
+  }
+  char* res = _getStoredPassword(pw, shortname);
+  if (!res && pw->type & PW_TYPE_PRMT) {
     agent_log(DEBUG, "Try getting password from user prompt");
     res = askpass_getPasswordForUpdate(shortname);
-    if (res && type & PW_TYPE_MEM) {
+    if (res && pw->type & PW_TYPE_MEM) {
       pwe_setPassword(pw, encryptPassword(res, shortname));
     }
   }
   return res;
 }
 
+/**
+ * @brief like @c getPasswordFor, but never prompts the user
+ * @return the password or @c NULL if it is not stored in the agent and cannot
+ * be obtained from a command or file
+ */
+char* getStoredPasswordFor(const char* shortname) {
+  if (shortname == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return NULL;
+  }
+  struct password_entry  key = {.shortname = oidc_strcopy(shortname)};
+  struct password_entry* pw  = passwordDB_findValue(&key);
+  secFree(key.shortname);
+  char* res = pw ? _getStoredPassword(pw, shortname) : NULL;
+  if (res == NULL) {
+    agent_log(DEBUG, "No stored password for '%s'", shortname);
+    oidc_errno = OIDC_EPWNOTFOUND;
+  }
+  return res;
+}
+
+/**
+ * @brief checks if a password for an account can be obtained without asking
+ * the user, also later on; a password with a lifetime does not count
+ */
+int hasLastingPasswordFor(const char* shortname) {
+  if (shortname == NULL) {
+    return 0;
+  }
+  struct password_entry  key = {.shortname = oidc_strcopy(shortname)};
+  struct password_entry* pw  = passwordDB_findValue(&key);
+  secFree(key.shortname);
+  if (pw == NULL) {
+    return 0;
+  }
+  if (pw->type & (PW_TYPE_CMD | PW_TYPE_FILE)) {
+    return 1;
+  }
+  return pw->type & PW_TYPE_MEM && pw->password != NULL && !pw->expires_at;
+}
+
 time_t getMinPasswordDeath() {
   agent_log(DEBUG, "Getting min death time for passwords");
   return passwordDB_getMinDeath((time_t(*)(void*))pwe_getExpiresAt);
@@ -210,3 +258,71 @@ void removeDeathPasswords() {
     expirePasswordFor(death_pwe->shortname);
   }
 }
+
+/**
+ * @brief converts the stored passwords into json for the state snapshot; the
+ * entries are decrypted. A password with a lifetime is left out, as if it had
+ * expired, so that it does not outlive its lifetime on disk.
+ * @return a json array; has to be freed after usage
+ */
+cJSON* passwordsToJSON() {
+  cJSON*  passwords = cJSON_CreateArray();
+  list_t* list      = passwordDB_getList();
+  if (list == NULL) {
+    return passwords;
+  }
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(list, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    const struct password_entry* pw    = node->val;
+    struct password_entry        plain = {
+        .shortname     = pw->shortname,
+        .type          = pw->type,
+        .expires_after = pw->expires_after,
+        .command       = decryptPassword(pw->command, pw->shortname),
+        .filepath      = decryptPassword(pw->filepath, pw->shortname),
+        .gpg_key       = decryptPassword(pw->gpg_key, pw->shortname),
+    };
+    if (!pw->expires_at) {
+      plain.password = decryptPassword(pw->password, pw->shortname);
+    }
+    cJSON_AddItemToArray(passwords, passwordEntryToJSON(&plain));
+    secFree(plain.password);
+    secFree(plain.command);
+    secFree(plain.filepath);
+    secFree(plain.gpg_key);
+  }
+  list_iterator_destroy(it);
+  return passwords;
+}
+
+/**
+ * @brief stores the passwords of a state snapshot; passwords that are already
+ * stored are kept and expired passwords are dropped
+ */
+void restorePasswords(const cJSON* passwords) {
+  const cJSON* item;
+  time_t       now = time(NULL);
+  cJSON_ArrayForEach(item, passwords) {
+    char*                  json = jsonToStringUnformatted((cJSON*)item);
+    struct password_entry* pw   = JSONStringToPasswordEntry(json);
+    secFree(json);
+    if (pw == NULL) {
+      continue;
+    }
+    initPasswordStore();
+    if (passwordDB_findValue(pw) != NULL) {
+      secFreePasswordEntry(pw);
+      continue;
+    }
+    if (pw->expires_at && pw->expires_at <= now) {
+      pwe_setPassword(pw, NULL);
+      pwe_setExpiresAt(pw, 0);
+    }
+    if (savePassword(pw) != OIDC_SUCCESS) {
+      agent_log(ERROR, "Could not restore password for '%s': %s",
+                pw->shortname, oidc_serror());
+      secFreePasswordEntry(pw);
+    }
+  }
+}
@@ -5,13 +5,18 @@
 
 #include "utils/oidc_error.h"
 #include "utils/password_entry.h"
+#include "wrapper/cjson.h"
 
 oidc_error_t savePassword(struct password_entry* pw);
 char*        getGPGKeyFor(const char* shortname);
 char*        getPasswordFor(const char* shortname);
+char*        getStoredPasswordFor(const char* shortname);
+int          hasLastingPasswordFor(const char* shortname);
 oidc_error_t removePasswordFor(const char* shortname);
 oidc_error_t removeAllPasswords();
 void         removeDeathPasswords();
 time_t       getMinPasswordDeath();
+cJSON*       passwordsToJSON();
+void         restorePasswords(const cJSON* passwords);
 
 #endif  // OIDC_PASSWORD_STORE_H
@@ -0,0 +1,301 @@
+#include "pending_flow.h"
+
+#include "defines/ipc_values.h"
+#include "defines/oidc_values.h"
+#include "ipc/serveripc.h"
+#include "oidc-agent/oidcd/parse_internal.h"
+#include "oidc-agent/oidcp/config_updater.h"
+#include "utils/agentLogger.h"
+#include "utils/db/connection_db.h"
+#include "utils/json.h"
+#include "utils/memory.h"
+#include "utils/oidc/device.h"
+#include "utils/string/stringUtils.h"
+#include "utils/uriUtils.h"
+#include "wrapper/list.h"
+
+/**
+ * An authorization code or device flow that oidcp started for autogen or
+ * reauthentication.
+ *
+ * Instead of waiting for the user in a loop of its own, oidcp parks the client
+ * whose request needs the account and keeps serving other clients. A code
+ * flow finishes when the code exchange request with its state was handled by
+ * the main loop; a device flow is polled from the main loop whenever its
+ * interval passed. If the flow succeeds, the account config is written and
+ * the original request of the client is handled again; otherwise the client
+ * gets the error response. A flow whose client went away still writes the
+ * account config.
+ */
+struct pending_flow {
+  struct connection* con;
+  unsigned char*     ipc_key;
+  char*              request;
+  char*              error_res;
+  char*              shortname;
+  char*              state;
+  char*              device;
+  size_t             interval;
+  time_t             next_poll;
+  time_t             expires_at;
+};
+
+static list_t*             flows      = NULL;
+static struct connection*  client     = NULL;
+static pending_flow_resume resume_cb  = NULL;
+static void*               resume_arg = NULL;
+
+static void _secFreeFlow(struct pending_flow* f) {
+  if (f == NULL) {
+    return;
+  }
+  secFree(f->ipc_key);
+  secFree(f->request);
+  secFree(f->error_res);
+  secFree(f->shortname);
+  secFree(f->state);
+  secFree(f->device);
+  secFree(f);
+}
+
+/**
+ * @param resume called for the client of a flow that succeeded; it has to
+ * handle the original request of the client again
+ * @param arg passed to @p resume
+ */
+void pendingFlow_init(pending_flow_resume resume, void* arg) {
+  resume_cb  = resume;
+  resume_arg = arg;
+}
+
+/**
+ * @brief sets the client whose request is handled; it is parked if its
+ * request starts a flow
+ * @param con the connection of the client or @c NULL if the client cannot
+ * wait, e.g. because its request is part of a batch
+ */
+void pendingFlow_setClient(struct connection* con) { client = con; }
+
+static int _start(struct pending_flow* f, const char* shortname,
+                  time_t expires_at, const char* original_client_req,
+                  const char* error_res) {
+  f->shortname  = oidc_strcopy(shortname);
+  f->expires_at = expires_at;
+  f->request    = oidc_strcopy(original_client_req);
+  f->error_res  = oidc_strcopy(error_res);
+  if (client != NULL && resume_cb != NULL) {
+    f->con     = client;
+    f->ipc_key = server_ipc_takeLastKey();
+    client     = NULL;  // a client can only wait for one flow
+  }
+  if (flows == NULL) {
+    flows       = list_new();
+    flows->free = (void (*)(void*)) & _secFreeFlow;
+  }
+  list_rpush(flows, list_node_new(f));
+  agent_log(DEBUG, "Started pending flow for '%s', client %s", shortname,
+            f->con ? "parked" : "not waiting");
+  return f->con != NULL;
+}
+
+/**
+ * @brief starts waiting for the code exchange of an authorization code flow
+ * @param error_res the response for the client if the flow fails
+ * @return @c 1 if the current client was parked; in that case the key of its
+ * request was taken and nothing must be written to the client. Otherwise the
+ * caller has to answer the client.
+ */
+int pendingFlow_startCode(const char* state, time_t expires_at,
+                          const char* shortname,
+                          const char* original_client_req,
+                          const char* error_res) {
+  struct pending_flow* f = secAlloc(sizeof(struct pending_flow));
+  f->state               = oidc_strcopy(state);
+  return _start(f, shortname, expires_at, original_client_req, error_res);
+}
+
+/**
+ * @brief starts polling a device flow
+ * @return like @c pendingFlow_startCode
+ */
+int pendingFlow_startDevice(const char* json_device, size_t interval,
+                            time_t expires_at, const char* shortname,
+                            const char* original_client_req,
+                            const char* error_res) {
+  struct pending_flow* f = secAlloc(sizeof(struct pending_flow));
+  f->device              = oidc_strcopy(json_device);
+  f->interval            = interval;
+  f->next_poll           = time(NULL) + interval;
+  return _start(f, shortname, expires_at, original_client_req, error_res);
+}
+
+/**
+ * @brief takes a flow out of the list
+ */
+static struct pending_flow* _take(list_node_t* node) {
+  struct pending_flow* f = node->val;
+  node->val              = NULL;
+  list_remove(flows, node);
+  return f;
+}
+
+/**
+ * @brief writes the account config of a finished flow and resumes or answers
+ * its client
+ * @param config the config or @c NULL if the flow failed; ownership is taken
+ */
+static void _finish(struct pending_flow* f, char* config) {
+  oidc_error_t e = config ? writeOIDCFile(config, f->shortname) : OIDC_EERROR;
+  secFree(config);
+  agent_log(DEBUG, "Pending flow for '%s' %s", f->shortname,
+            e == OIDC_SUCCESS ? "succeeded" : "failed");
+  struct connection* con = f->con;
+  if (con != NULL) {
+    server_ipc_restoreKey(f->ipc_key);
+    f->ipc_key = NULL;
+    if (e == OIDC_SUCCESS) {
+      resume_cb(con, f->request, resume_arg);
+    } else {
+      server_ipc_write(*(con->msgsock), "%s", f->error_res);
+      connectionDB_removeIfFound(con);
+    }
+  }
+  _secFreeFlow(f);
+}
+
+/**
+ * @brief finishes the code flow the code exchange request belongs to; must be
+ * called after the code exchange request was handled
+ */
+void pendingFlow_codeExchanged(struct ipcPipe pipes, const char* client_req) {
+  if (flows == NULL) {
+    return;
+  }
+  char* uri   = getJSONValueFromString(client_req, OIDC_KEY_REDIRECTURI);
+  char* state = extractParameterValueFromUri(uri, "state");
+  secFree(uri);
+  if (state == NULL) {
+    return;
+  }
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(flows, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    if (strequal(((struct pending_flow*)node->val)->state, state)) {
+      break;
+    }
+  }
+  list_iterator_destroy(it);
+  if (node == NULL) {
+    secFree(state);
+    return;
+  }
+  struct pending_flow* f = _take(node);
+  char* lookup_res = ipc_communicateThroughPipe(pipes, REQUEST_STATELOOKUP,
+                                                state);
+  secFree(state);
+  _finish(f, lookup_res ? parseStateLookupRes(lookup_res, pipes) : NULL);
+}
+
+static time_t _deadline(const struct pending_flow* f) {
+  if (f->device != NULL && f->next_poll < f->expires_at) {
+    return f->next_poll;
+  }
+  return f->expires_at;
+}
+
+/**
+ * @brief returns the time when a flow has to be polled or expires, @c 0 if
+ * there is no flow
+ */
+time_t pendingFlow_nextDeadline() {
+  if (flows == NULL) {
+    return 0;
+  }
+  time_t           next = 0;
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(flows, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    time_t deadline = _deadline(node->val);
+    if (next == 0 || deadline < next) {
+      next = deadline;
+    }
+  }
+  list_iterator_destroy(it);
+  return next;
+}
+
+static list_node_t* _nextDue(time_t now) {
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(flows, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    if (_deadline(node->val) <= now) {
+      break;
+    }
+  }
+  list_iterator_destroy(it);
+  return node;
+}
+
+/**
+ * @brief polls the device flows that are due and fails expired flows
+ */
+void pendingFlow_run(struct ipcPipe pipes) {
+  if (flows == NULL) {
+    return;
+  }
+  time_t       now = time(NULL);
+  list_node_t* node;
+  while ((node = _nextDue(now))) {
+    struct pending_flow* f = node->val;
+    if (f->expires_at <= now) {
+      agent_log(DEBUG, "Pending flow for '%s' expired", f->shortname);
+      _finish(_take(node), NULL);
+      continue;
+    }
+    unsigned char pending = 0;
+    char*         config =
+        agent_pollDeviceCodeOnce(f->device, &f->interval, pipes, &pending);
+    if (pending) {
+      f->next_poll = now + f->interval;
+      continue;
+    }
+    _finish(_take(node), config);
+  }
+}
+
+static list_node_t* _findFlow(const struct connection* con) {
+  if (flows == NULL) {
+    return NULL;
+  }
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(flows, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    if (((struct pending_flow*)node->val)->con == con) {
+      break;
+    }
+  }
+  list_iterator_destroy(it);
+  return node;
+}
+
+int pendingFlow_isParked(const struct connection* con) {
+  return con != NULL && _findFlow(con) != NULL;
+}
+
+/**
+ * @brief forgets a parked client; must be called before the connection is
+ * closed. The flow itself goes on.
+ */
+void pendingFlow_removeConnection(const struct connection* con) {
+  if (client == con) {
+    client = NULL;
+  }
+  list_node_t* node = con ? _findFlow(con) : NULL;
+  if (node != NULL) {
+    struct pending_flow* f = node->val;
+    agent_log(DEBUG, "Client waiting for the flow of '%s' went away",
+              f->shortname);
+    f->con = NULL;
+    secFree(f->ipc_key);
+  }
+}
@@ -0,0 +1,36 @@
+#ifndef OIDCP_PENDING_FLOW_H
+#define OIDCP_PENDING_FLOW_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include "ipc/connection.h"
+#include "ipc/pipe.h"
+
+/**
+ * @brief called when the flow a client was parked for succeeded
+ * @param con the connection of the client
+ * @param request the original request of the client that has to be handled
+ * again
+ * @param arg the argument passed to @c pendingFlow_init
+ */
+typedef void (*pending_flow_resume)(struct connection* con,
+                                    const char* request, void* arg);
+
+void   pendingFlow_init(pending_flow_resume resume, void* arg);
+void   pendingFlow_setClient(struct connection* con);
+int    pendingFlow_startCode(const char* state, time_t expires_at,
+                             const char* shortname,
+                             const char* original_client_req,
+                             const char* error_res);
+int    pendingFlow_startDevice(const char* json_device, size_t interval,
+                               time_t expires_at, const char* shortname,
+                               const char* original_client_req,
+                               const char* error_res);
+void   pendingFlow_codeExchanged(struct ipcPipe pipes, const char* client_req);
+time_t pendingFlow_nextDeadline();
+void   pendingFlow_run(struct ipcPipe pipes);
+int    pendingFlow_isParked(const struct connection* con);
+void   pendingFlow_removeConnection(const struct connection* con);
+
+#endif  // OIDCP_PENDING_FLOW_H
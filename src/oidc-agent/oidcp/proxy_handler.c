@@ -5,6 +5,8 @@
 #include "defines/settings.h"
 #include "oidc-agent/oidcp/passwords/askpass.h"
 #include "oidc-agent/oidcp/passwords/password_store.h"
+#include "oidc-agent/oidcp/state_snapshot.h"
+#include "utils/config/accountIndex.h"
 #include "utils/config/issuerConfig.h"
 #include "utils/crypt/cryptUtils.h"
 #include "utils/crypt/gpg/gpg.h"
@@ -19,6 +21,8 @@ oidc_error_t updateRefreshToken(const char* shortname,
     oidc_setArgNullFuncError(__func__);
     return oidc_errno;
   }
+  // A snapshot with the old refresh token must not outlive the rotation
+  stateSnapshot_scheduleNow();
   char* encrypted_content = readOidcFile(shortname);
   if (!isPGPMessage(encrypted_content)) {
     oidc_error_t e = OIDC_EERROR;
@@ -47,6 +51,38 @@ oidc_error_t updateRefreshToken(const char* shortname,
   }
 }
 
+/**
+ * @brief decrypts an encrypted account config with a password given by the
+ * user and stores the password if the issuer config asks for it
+ * @return the decrypted config or @c NULL if the password is wrong
+ */
+static char* _decryptAutoloadConfig(const char* crypt_content,
+                                    const char* shortname, const char* issuer,
+                                    const char* password) {
+  char* config = decryptFileContent(crypt_content, password);
+  if (config == NULL) {
+    return NULL;
+  }
+  char* issFromConfig = NULL;
+  if (issuer == NULL) {
+    issFromConfig = getJSONValueFromString(config, OIDC_KEY_ISSUER);
+    if (issFromConfig == NULL) {
+      issFromConfig = getJSONValueFromString(config, AGENT_KEY_ISSUERURL);
+    }
+    issuer = issFromConfig;
+  }
+  const struct issuerConfig* iss_c = getIssuerConfig(issuer);
+  secFree(issFromConfig);
+  if (iss_c && iss_c->store_pw) {
+    struct password_entry* pw = secAlloc(sizeof(struct password_entry));
+    pwe_setShortname(pw, oidc_strcopy(shortname));
+    pwe_setPassword(pw, oidc_strcopy(password));
+    pwe_setType(pw, PW_TYPE_PRMT | PW_TYPE_MEM);
+    savePassword(pw);
+  }
+  return config;
+}
+
 char* getAutoloadConfig(const char* shortname, const char* issuer,
                         const char* application_hint) {
   if (shortname == NULL) {
@@ -75,53 +111,131 @@ char* getAutoloadConfig(const char* shortname, const char* issuer,
       secFree(crypt_content);
       return NULL;
     }
-    char* config = decryptFileContent(crypt_content, password);
-    if (config == NULL) {
-      secFree(password);
-      continue;
+    char* config =
+        _decryptAutoloadConfig(crypt_content, shortname, issuer, password);
+    secFree(password);
+    if (config != NULL) {
+      secFree(crypt_content);
+      return config;
     }
+  }
+  secFree(crypt_content);
+  return NULL;
+}
 
-    char* issFromConfig = NULL;
-    if (issuer == NULL) {
-      issFromConfig = getJSONValueFromString(config, OIDC_KEY_ISSUER);
-      if (issFromConfig == NULL) {
-        issFromConfig = getJSONValueFromString(config, AGENT_KEY_ISSUERURL);
-      }
-      issuer = issFromConfig;
-    }
-    const struct issuerConfig* iss_c = getIssuerConfig(issuer);
-    secFree(issFromConfig);
-    if (iss_c && iss_c->store_pw) {
-      struct password_entry* pw = secAlloc(sizeof(struct password_entry));
-      pwe_setShortname(pw, oidc_strcopy(shortname));
-      pwe_setPassword(pw, oidc_strcopy(password));
-      pwe_setType(pw, PW_TYPE_PRMT | PW_TYPE_MEM);
-      savePassword(pw);
-    }
+/**
+ * @brief tells if loading an account config needs the encryption password,
+ * i.e. if @c getAutoloadConfig would prompt the user
+ */
+int autoloadNeedsPassword(const char* shortname) {
+  if (shortname == NULL || !oidcFileDoesExist(shortname)) {
+    return 0;
+  }
+  char* crypt_content = readOidcFile(shortname);
+  int   ret = crypt_content != NULL && !isPGPMessage(crypt_content);
+  secFree(crypt_content);
+  return ret;
+}
 
-    secFree(password);
+/**
+ * @brief like @c getAutoloadConfig, but uses a password the user already
+ * entered instead of prompting
+ * @return the decrypted config or @c NULL on failure, e.g. if the password is
+ * wrong
+ */
+char* getAutoloadConfigWithPassword(const char* shortname, const char* issuer,
+                                    const char* password) {
+  if (shortname == NULL || password == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return NULL;
+  }
+  char* crypt_content = readOidcFile(shortname);
+  if (crypt_content == NULL) {
+    return NULL;
+  }
+  char* config =
+      _decryptAutoloadConfig(crypt_content, shortname, issuer, password);
+  secFree(crypt_content);
+  return config;
+}
+
+/**
+ * @brief loads the config of an account oidcd evicted again; unlike
+ * @c getAutoloadConfig the user is never prompted
+ * @return the decrypted config or @c NULL if it cannot be decrypted with the
+ * password stored for the account
+ */
+char* getReloadConfig(const char* shortname) {
+  if (shortname == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return NULL;
+  }
+  if (!oidcFileDoesExist(shortname)) {
+    oidc_errno = OIDC_ENOACCOUNT;
+    return NULL;
+  }
+  char* crypt_content = readOidcFile(shortname);
+  if (crypt_content == NULL) {
+    return NULL;
+  }
+  if (isPGPMessage(crypt_content)) {
+    char* config = decryptPGPFileContent(crypt_content);
     secFree(crypt_content);
     return config;
   }
+  char* password = getStoredPasswordFor(shortname);
+  if (password == NULL) {
+    secFree(crypt_content);
+    return NULL;
+  }
+  char* config = decryptFileContent(crypt_content, password);
+  secFree(password);
   secFree(crypt_content);
-  return NULL;
+  return config;
 }
 
+/**
+ * @brief checks if @c getReloadConfig will be able to decrypt the account
+ * config without asking the user
+ */
+int canReloadWithoutUser(const char* shortname) {
+  if (shortname == NULL || !hasLastingPasswordFor(shortname)) {
+    return 0;
+  }
+  char* crypt_content = readOidcFile(shortname);
+  int   ok            = crypt_content != NULL && !isPGPMessage(crypt_content);
+  secFree(crypt_content);
+  return ok;
+}
+
+/**
+ * @brief returns the account config to use for an issuer
+ * @return the default account of the issuer config, else the first listed
+ * account whose config still exists, else the indexed account config of the
+ * issuer that was changed last; @c NULL if there is none
+ */
 const char* getDefaultAccountConfigForIssuer(const char* issuer_url) {
   if (issuer_url == NULL) {
     oidc_setArgNullFuncError(__func__);
     return NULL;
   }
   const struct issuerConfig* c = getIssuerConfig(issuer_url);
-  if (c == NULL) {
-    return NULL;
-  }
-  if (strValid(c->default_account)) {
+  if (c != NULL && strValid(c->default_account)) {
     return c->default_account;
   }
-  if (!listValid(c->accounts)) {
-    return NULL;
+  if (c != NULL && listValid(c->accounts)) {
+    const char*      account = NULL;
+    list_node_t*     node;
+    list_iterator_t* it = list_iterator_new(c->accounts, LIST_HEAD);
+    while (account == NULL && (node = list_iterator_next(it))) {
+      if (oidcFileDoesExist(node->val)) {
+        account = node->val;
+      }
+    }
+    list_iterator_destroy(it);
+    if (account != NULL) {
+      return account;
+    }
   }
-  list_node_t* firstAccount = list_at(c->accounts, 0);
-  return firstAccount ? firstAccount->val : NULL;
+  return accountIndex_getAccountForIssuer(issuer_url);
 }
@@ -15,6 +15,12 @@ oidc_error_t updateRefreshTokenUsingGPG(const char* shortname,
                                         const char* gpg_key);
 char*        getAutoloadConfig(const char* shortname, const char* issuer,
                                const char* application_hint);
+char*        getAutoloadConfigWithPassword(const char* shortname,
+                                           const char* issuer,
+                                           const char* password);
+int          autoloadNeedsPassword(const char* shortname);
+char*        getReloadConfig(const char* shortname);
+int          canReloadWithoutUser(const char* shortname);
 const char*  getDefaultAccountConfigForIssuer(const char* issuer_url);
 
 #endif  // OIDC_PROXY_HANDLER_H
@@ -12,9 +12,16 @@
 #include "oidc-agent/oidcd/oidcd.h"
 #include "utils/agentLogger.h"
 
-struct ipcPipe startOidcd(const struct arguments* arguments) {
+/**
+ * @brief forks oidcd
+ * @param notify_fd is set to the read end of the pipe on which oidcd sends
+ * notifications that are not answered
+ * @return the pipes to oidcd
+ */
+struct ipcPipe startOidcd(const struct arguments* arguments, int* notify_fd) {
   struct pipeSet pipes = ipc_pipe_init();
-  if (pipes.pipe1.rx == -1) {
+  int            notify[2];
+  if (pipes.pipe1.rx == -1 || pipe(notify) != 0) {
     agent_log(ERROR, "could not create pipes");
     exit(EXIT_FAILURE);
   }
@@ -39,10 +46,13 @@ struct ipcPipe startOidcd(const struct arguments* arguments) {
       exit(EXIT_FAILURE);
     }
     struct ipcPipe childPipes = toClientPipes(pipes);
-    oidcd_main(childPipes, arguments);
+    close(notify[0]);
+    oidcd_main(childPipes, notify[1], arguments);
     exit(EXIT_FAILURE);
   } else {  // parent
     struct ipcPipe parentPipes = toServerPipes(pipes);
+    close(notify[1]);
+    *notify_fd = notify[0];
     return parentPipes;
   }
 }
@@ -3,6 +3,6 @@
 
 #include "oidc-agent/oidc-agent_options.h"
 
-struct ipcPipe startOidcd(const struct arguments* arguments);
+struct ipcPipe startOidcd(const struct arguments* arguments, int* notify_fd);
 
 #endif /* OIDCP_START_OIDCD_H */
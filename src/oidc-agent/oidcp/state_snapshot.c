@@ -0,0 +1,285 @@
+#define _XOPEN_SOURCE 500
+#include "state_snapshot.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "defines/agent_values.h"
+#include "defines/ipc_values.h"
+#include "defines/settings.h"
+#include "oidc-agent/oidcd/parse_internal.h"
+#include "oidc-agent/oidcp/passwords/password_store.h"
+#include "utils/agentLogger.h"
+#include "utils/config/agent_config.h"
+#include "utils/crypt/crypt.h"
+#include "utils/crypt/cryptUtils.h"
+#include "utils/file_io/oidc_file_io.h"
+#include "utils/json.h"
+#include "utils/kernelKeyring.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+#include "utils/system_runner.h"
+
+/**
+ * Snapshot of the loaded agent state for fast restarts.
+ *
+ * If enabled in the agent config, oidcp writes the loaded accounts (with
+ * their access tokens and issuer metadata) and the password store entries
+ * encrypted to a file in the oidc-agent directory: on shutdown and
+ * periodically, if something changed. On startup the snapshot is restored,
+ * so that the agent can serve tokens right away, without a burst of
+ * discovery and refresh requests against the OPs.
+ *
+ * The snapshot is encrypted with the output of the configured key command
+ * or with a random key kept in the user's kernel keyring. Restoring never
+ * creates a key; a snapshot that cannot be decrypted is ignored. When the
+ * agent is locked, the snapshot is replaced by a marker, so that restarting
+ * a locked agent does not restore its accounts unlocked.
+ */
+static struct ipcPipe        snapshot_pipes;
+static int                   term_pipe[2]  = {-1, -1};
+static volatile sig_atomic_t terminating   = 0;
+static struct ipc_watch      term_watch;
+static time_t                next_snapshot = 0;
+static char*                 last_hash     = NULL;
+
+static int _enabled() { return getAgentConfig()->state_snapshot; }
+
+static time_t _interval() {
+  const agent_config_t* config = getAgentConfig();
+  return config->state_snapshot_interval_set ? config->state_snapshot_interval
+                                             : AGENT_STATE_SNAPSHOT_INTERVAL;
+}
+
+/**
+ * @brief returns the key for the snapshot
+ * @param create if a key should be created if there is none
+ * @return the key or @c NULL; has to be freed after usage
+ */
+static char* _getKey(int create) {
+  const char* cmd = getAgentConfig()->state_snapshot_key_cmd;
+  if (strValid(cmd)) {
+    char* key = getOutputFromCommand(cmd);
+    if (!strValid(key)) {
+      secFree(key);
+      oidc_errno = OIDC_EERROR;
+      oidc_seterror("state snapshot key command did not print a key");
+      return NULL;
+    }
+    return key;
+  }
+  char* key = kernelKeyring_getSnapshotKey();
+  if (key != NULL || !create) {
+    if (key == NULL) {
+      oidc_errno = OIDC_EERROR;
+      oidc_seterror("no state snapshot key in the kernel keyring");
+    }
+    return key;
+  }
+  key = randomString(STATE_SNAPSHOT_KEY_LEN);
+  if (kernelKeyring_setSnapshotKey(key) != OIDC_SUCCESS) {
+    secFree(key);
+    return NULL;
+  }
+  return key;
+}
+
+static char* _serialize(struct ipcPipe pipes) {
+  char* res      = ipc_communicateThroughPipe(pipes, INT_REQUEST_STATEEXPORT);
+  char* accounts = res ? parseForInfo(res) : NULL;
+  if (accounts == NULL) {
+    return NULL;
+  }
+  cJSON* state = cJSON_CreateObject();
+  jsonAddJSON(state, AGENT_KEY_ACCOUNTS, stringToJson(accounts));
+  secFree(accounts);
+  jsonAddJSON(state, SNAPSHOT_KEY_PASSWORDS, passwordsToJSON());
+  char* text = jsonToStringUnformatted(state);
+  secFreeJson(state);
+  return text;
+}
+
+oidc_error_t stateSnapshot_write(struct ipcPipe pipes) {
+  if (!_enabled()) {
+    return OIDC_SUCCESS;
+  }
+  char* text = _serialize(pipes);
+  if (text == NULL) {  // e.g. locked; keep the last snapshot
+    agent_log(NOTICE, "Not writing state snapshot: %s", oidc_serror());
+    return oidc_errno;
+  }
+  char* hash = s256(text);
+  if (strequal(hash, last_hash) &&
+      oidcFileDoesExist(STATE_SNAPSHOT_FILENAME)) {
+    secFree(hash);
+    secFree(text);
+    return OIDC_SUCCESS;
+  }
+  cJSON* state = stringToJson(text);
+  secFree(text);
+  jsonAddNumberValue(state, SNAPSHOT_KEY_CREATED, time(NULL));
+  text = jsonToStringUnformatted(state);
+  secFreeJson(state);
+  char* key = _getKey(1);
+  if (key == NULL) {
+    agent_log(ERROR, "Could not get state snapshot key: %s", oidc_serror());
+    secFree(hash);
+    secFree(text);
+    return oidc_errno;
+  }
+  char* crypt = encryptWithVersionLine(text, key);
+  secFree(key);
+  secFree(text);
+  if (crypt == NULL ||
+      writeOidcFileAtomic(STATE_SNAPSHOT_FILENAME, crypt) != OIDC_SUCCESS) {
+    agent_log(ERROR, "Could not write state snapshot: %s", oidc_serror());
+    secFree(crypt);
+    secFree(hash);
+    return oidc_errno;
+  }
+  secFree(crypt);
+  secFree(last_hash);
+  last_hash = hash;
+  agent_log(DEBUG, "Wrote state snapshot");
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief restores the snapshot; must be called before clients are served
+ */
+oidc_error_t stateSnapshot_restore(struct ipcPipe pipes) {
+  if (!_enabled()) {
+    return OIDC_SUCCESS;
+  }
+  char* content = readOidcFile(STATE_SNAPSHOT_FILENAME);
+  if (content == NULL) {
+    return OIDC_SUCCESS;
+  }
+  if (strequal(content, STATE_SNAPSHOT_LOCKED)) {
+    agent_log(NOTICE, "Not restoring state snapshot: the agent was locked");
+    secFree(content);
+    return OIDC_SUCCESS;
+  }
+  char* key = _getKey(0);
+  if (key == NULL) {
+    agent_log(NOTICE, "Not restoring state snapshot: %s", oidc_serror());
+    secFree(content);
+    return oidc_errno;
+  }
+  char* text = decryptFileContent(content, key);
+  secFree(key);
+  secFree(content);
+  cJSON* state = text ? stringToJson(text) : NULL;
+  secFree(text);
+  if (state == NULL) {
+    agent_log(ERROR, "Could not decrypt state snapshot: %s", oidc_serror());
+    return oidc_errno;
+  }
+  restorePasswords(cJSON_GetObjectItemCaseSensitive(state,
+                                                    SNAPSHOT_KEY_PASSWORDS));
+  cJSON* accounts = cJSON_GetObjectItemCaseSensitive(state, AGENT_KEY_ACCOUNTS);
+  char*  data     = accounts ? jsonToStringUnformatted(accounts) : NULL;
+  secFreeJson(state);
+  if (data == NULL) {
+    return OIDC_SUCCESS;
+  }
+  char* res = ipc_communicateThroughPipe(pipes, INT_REQUEST_STATEIMPORT, data);
+  secFree(data);
+  char* info = res ? parseForInfo(res) : NULL;
+  if (info == NULL) {
+    agent_log(NOTICE, "Did not restore accounts: %s", oidc_serror());
+    return oidc_errno;
+  }
+  agent_log(DEBUG, "%s from state snapshot", info);
+  secFree(info);
+  return OIDC_SUCCESS;
+}
+
+static void _handleTerm(int sig) {
+  if (terminating) {  // a second signal terminates right away
+    signal(sig, SIG_DFL);
+    raise(sig);
+    return;
+  }
+  terminating = 1;
+  char c      = 0;
+  if (write(term_pipe[1], &c, 1) != 1) {
+    signal(sig, SIG_DFL);
+    raise(sig);
+  }
+}
+
+static void _terminate() {
+  agent_log(NOTICE, "Writing state snapshot before terminating");
+  stateSnapshot_write(snapshot_pipes);
+  signal(SIGTERM, SIG_DFL);
+  raise(SIGTERM);
+}
+
+/**
+ * @brief installs the SIGTERM handler that writes the snapshot on shutdown
+ * @return the watch that has to be passed to the main loop
+ */
+const struct ipc_watch* stateSnapshot_init(struct ipcPipe          pipes,
+                                           const struct ipc_watch* next) {
+  snapshot_pipes = pipes;
+  if (!_enabled() || pipe(term_pipe) != 0) {
+    return next;
+  }
+  fcntl(term_pipe[0], F_SETFD, FD_CLOEXEC);
+  fcntl(term_pipe[1], F_SETFD, FD_CLOEXEC);
+  term_watch = (struct ipc_watch){
+      .fd = term_pipe[0], .handle = _terminate, .next = next};
+  signal(SIGTERM, _handleTerm);
+  return &term_watch;
+}
+
+/**
+ * @brief replaces the snapshot with the lock marker; must be called before
+ * the agent is locked. The next snapshot after unlocking replaces the marker.
+ */
+void stateSnapshot_invalidate() {
+  secFree(last_hash);
+  last_hash = NULL;
+  if (!_enabled() && !oidcFileDoesExist(STATE_SNAPSHOT_FILENAME)) {
+    return;
+  }
+  if (writeOidcFileAtomic(STATE_SNAPSHOT_FILENAME, STATE_SNAPSHOT_LOCKED) !=
+      OIDC_SUCCESS) {
+    agent_log(ERROR, "Could not invalidate state snapshot: %s", oidc_serror());
+    removeOidcFile(STATE_SNAPSHOT_FILENAME);
+  }
+}
+
+/**
+ * @brief makes the next snapshot due now, e.g. after accounts were removed
+ */
+void stateSnapshot_scheduleNow() {
+  if (_enabled()) {
+    next_snapshot = time(NULL);
+  }
+}
+
+/**
+ * @brief returns the time when the next snapshot is due, @c 0 if snapshots
+ * are only written on shutdown
+ */
+time_t stateSnapshot_nextDeadline() {
+  if (!_enabled()) {
+    return 0;
+  }
+  if (next_snapshot == 0 && _interval() > 0) {
+    next_snapshot = time(NULL) + _interval();
+  }
+  return next_snapshot;
+}
+
+void stateSnapshot_run(struct ipcPipe pipes) {
+  if (next_snapshot == 0 || next_snapshot > time(NULL)) {
+    return;
+  }
+  next_snapshot = 0;
+  stateSnapshot_write(pipes);
+}
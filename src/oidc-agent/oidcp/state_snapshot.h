@@ -0,0 +1,23 @@
+#ifndef OIDCP_STATE_SNAPSHOT_H
+#define OIDCP_STATE_SNAPSHOT_H
+
+#include <time.h>
+
+#include "ipc/ipc.h"
+#include "ipc/pipe.h"
+#include "utils/oidc_error.h"
+
+#define STATE_SNAPSHOT_KEY_LEN 64
+// replaces the snapshot while the agent is locked
+#define STATE_SNAPSHOT_LOCKED "locked"
+
+const struct ipc_watch* stateSnapshot_init(struct ipcPipe          pipes,
+                                           const struct ipc_watch* next);
+oidc_error_t            stateSnapshot_restore(struct ipcPipe pipes);
+oidc_error_t            stateSnapshot_write(struct ipcPipe pipes);
+void                    stateSnapshot_scheduleNow();
+void                    stateSnapshot_invalidate();
+time_t                  stateSnapshot_nextDeadline();
+void                    stateSnapshot_run(struct ipcPipe pipes);
+
+#endif  // OIDCP_STATE_SNAPSHOT_H
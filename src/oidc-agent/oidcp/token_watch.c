@@ -0,0 +1,266 @@
+#include "token_watch.h"
+
+#include "defines/ipc_values.h"
+#include "ipc/serveripc.h"
+#include "oidc-agent/oidcp/proxy_handler.h"
+#include "utils/agentLogger.h"
+#include "utils/config/issuerConfig.h"
+#include "utils/db/connection_db.h"
+#include "utils/json.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+#include "wrapper/list.h"
+
+/**
+ * A client that subscribed to the access tokens of an account.
+ *
+ * The connection of the client is kept open. Shortly before the token the
+ * client has expires (i.e. before it is valid for less than the
+ * @c min_valid_period of the client) a new token is obtained from oidcd and
+ * pushed to the client as a single newline terminated message. Errors are
+ * pushed the same way and the token is requested again after
+ * @c AGENT_WATCH_RETRY seconds. Pushing never blocks; a client that does not
+ * read its messages is dropped.
+ */
+struct token_watcher {
+  struct connection* con;
+  unsigned char*     ipc_key;
+  cJSON*             request;
+  time_t             min_valid;
+  time_t             expires_at;
+  time_t             next;
+};
+
+static list_t* watchers = NULL;
+
+static void _secFreeWatcher(struct token_watcher* w) {
+  if (w == NULL) {
+    return;
+  }
+  secFree(w->ipc_key);
+  secFreeJson(w->request);
+  secFree(w);
+}
+
+static void _schedule(struct token_watcher* w) {
+  time_t now = time(NULL);
+  w->next    = w->expires_at - w->min_valid - AGENT_WATCH_REFRESH_AHEAD;
+  if (w->next <= now) {
+    // The provider issues tokens that are shorter lived than requested; do
+    // not ask oidcd again and again
+    w->next = now + AGENT_WATCH_RETRY;
+  }
+}
+
+static list_node_t* _findWatcher(const struct connection* con) {
+  if (watchers == NULL) {
+    return NULL;
+  }
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(watchers, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    if (((struct token_watcher*)node->val)->con == con) {
+      break;
+    }
+  }
+  list_iterator_destroy(it);
+  return node;
+}
+
+/**
+ * @brief registers a connection for token updates
+ * @param con the connection of the client; it must not be removed from the
+ * connection db as long as it is watched
+ * @param ipc_key the key to encrypt the pushed messages with, as obtained by
+ * @c server_ipc_takeLastKey; ownership is taken
+ * @param client_req the watch request of the client; contains the same
+ * parameters as an access token request and the expiration of the token the
+ * client already has
+ * @return @c OIDC_SUCCESS if the connection is watched; otherwise an error
+ * was sent to the client and the connection should be closed
+ */
+oidc_error_t tokenWatch_add(struct connection* con, unsigned char* ipc_key,
+                            const char* client_req) {
+  cJSON* request = stringToJson(client_req);
+  if (request == NULL) {
+    char* res = oidc_sprintf(RESPONSE_BADREQUEST, oidc_serror());
+    server_ipc_writeLine(*(con->msgsock), ipc_key, res);
+    secFree(res);
+    secFree(ipc_key);
+    return oidc_errno;
+  }
+  char* min_valid  = getJSONValue(request, IPC_KEY_MINVALID);
+  char* expires_at = getJSONValue(request, AGENT_KEY_EXPIRESAT);
+  cJSON_DeleteItemFromObjectCaseSensitive(request, IPC_KEY_REQUEST);
+  cJSON_DeleteItemFromObjectCaseSensitive(request, IPC_KEY_MINVALID);
+  cJSON_DeleteItemFromObjectCaseSensitive(request, IPC_KEY_STALEMINVALID);
+  cJSON_DeleteItemFromObjectCaseSensitive(request, AGENT_KEY_EXPIRESAT);
+
+  struct token_watcher* w = secAlloc(sizeof(struct token_watcher));
+  w->con                  = con;
+  w->ipc_key              = ipc_key;
+  w->request              = request;
+  w->min_valid            = strToLong(min_valid);
+  w->expires_at           = strToLong(expires_at);
+  secFree(min_valid);
+  secFree(expires_at);
+  _schedule(w);
+
+  if (server_ipc_writeLine(*(con->msgsock), ipc_key, RESPONSE_SUCCESS) !=
+      OIDC_SUCCESS) {
+    _secFreeWatcher(w);
+    return oidc_errno;
+  }
+  if (watchers == NULL) {
+    watchers       = list_new();
+    watchers->free = (void (*)(void*)) & _secFreeWatcher;
+  }
+  list_rpush(watchers, list_node_new(w));
+  agent_log(DEBUG, "Watching tokens for a client, next update in %ld s",
+            (long)(w->next - time(NULL)));
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief stops watching a connection; must be called before the connection
+ * is closed
+ */
+void tokenWatch_removeConnection(const struct connection* con) {
+  list_node_t* node = _findWatcher(con);
+  if (node != NULL) {
+    agent_log(DEBUG, "Client stopped watching tokens");
+    list_remove(watchers, node);
+  }
+}
+
+int tokenWatch_isWatching(const struct connection* con) {
+  return _findWatcher(con) != NULL;
+}
+
+/**
+ * @brief returns the time of the next due token update, @c 0 if there is none
+ */
+time_t tokenWatch_nextDeadline() {
+  if (watchers == NULL) {
+    return 0;
+  }
+  time_t           next = 0;
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(watchers, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    struct token_watcher* w = node->val;
+    if (next == 0 || w->next < next) {
+      next = w->next;
+    }
+  }
+  list_iterator_destroy(it);
+  return next;
+}
+
+/**
+ * @brief requests an access token from oidcd without any user interaction
+ * @return the final response of oidcd or @c NULL if oidcd did not answer
+ */
+static char* _requestToken(struct ipcPipe pipes, struct token_watcher* w) {
+  cJSON* json = cJSON_Duplicate(w->request, 1);
+  jsonAddStringValue(json, IPC_KEY_REQUEST, REQUEST_VALUE_ACCESSTOKEN);
+  // Ask for a token that is valid long enough that oidcd has to refresh
+  jsonAddNumberValue(json, IPC_KEY_MINVALID,
+                     w->min_valid + AGENT_WATCH_REFRESH_AHEAD + 1);
+  char* send = jsonToStringUnformatted(json);
+  secFreeJson(json);
+  while (1) {
+    char* res = ipc_communicateThroughPipe(pipes, "%s", send);
+    secFree(send);
+    if (res == NULL) {
+      return NULL;
+    }
+    INIT_KEY_VALUE(IPC_KEY_REQUEST, OIDC_KEY_REFRESHTOKEN, IPC_KEY_SHORTNAME,
+                   IPC_KEY_ISSUERURL, INT_IPC_KEY_ACTION);
+    if (CALL_GETJSONVALUES(res) < 0) {
+      SEC_FREE_KEY_VALUES();
+      return res;
+    }
+    KEY_VALUE_VARS(request, refresh_token, shortname, issuer, action);
+    if (_request == NULL) {
+      SEC_FREE_KEY_VALUES();
+      return res;
+    }
+    secFree(res);
+    if (strequal(_request, INT_REQUEST_VALUE_UPD_REFRESH)) {
+      oidc_error_t e = updateRefreshToken(_shortname, _refresh_token);
+      send           = e == OIDC_SUCCESS
+                               ? oidc_strcopy(RESPONSE_SUCCESS)
+                               : oidc_sprintf(RESPONSE_ERROR, oidc_serror());
+    } else if (strequal(_request, INT_REQUEST_VALUE_UPD_ISSUER)) {
+      oidcp_updateIssuerConfig(_action, _issuer, _shortname);
+      send = oidc_strcopy(RESPONSE_SUCCESS);
+    } else if (strequal(_request, INT_REQUEST_VALUE_QUERY_ACCDEFAULT)) {
+      const char* account =
+          strValid(_issuer) ? getDefaultAccountConfigForIssuer(_issuer) : NULL;
+      send = oidc_sprintf(INT_RESPONSE_ACCDEFAULT, account ?: "");
+    } else if (strequal(_request, INT_REQUEST_VALUE_AUTOGEN)) {
+      // oidcd does not wait for an answer to this one
+      SEC_FREE_KEY_VALUES();
+      return oidc_sprintf(RESPONSE_ERROR, ACCOUNT_NOT_LOADED);
+    } else if (strequal(_request, INT_REQUEST_VALUE_AUTOLOAD)) {
+      // Loading an account needs the user, who is not asked for a watch
+      send = oidc_sprintf(INT_RESPONSE_ERROR, OIDC_ENOACCOUNT);
+    } else if (strequal(_request, INT_REQUEST_VALUE_RELOAD)) {
+      char* config = getReloadConfig(_shortname);
+      send = config ? oidc_sprintf(RESPONSE_STATUS_CONFIG, STATUS_SUCCESS,
+                                   config)
+                    : oidc_sprintf(INT_RESPONSE_ERROR, oidc_errno);
+      secFree(config);
+    } else {  // confirmations
+      send = oidc_sprintf(INT_RESPONSE_ERROR, OIDC_EFORBIDDEN);
+    }
+    SEC_FREE_KEY_VALUES();
+  }
+}
+
+/**
+ * @return @c OIDC_SUCCESS unless the update could not be pushed to the client
+ */
+static oidc_error_t _update(struct ipcPipe pipes, struct token_watcher* w) {
+  char* res = _requestToken(pipes, w);
+  if (res == NULL) {
+    res = oidc_sprintf(RESPONSE_ERROR, oidc_serror());
+  }
+  char*  expires_at_str = getJSONValueFromString(res, AGENT_KEY_EXPIRESAT);
+  time_t expires_at     = strToLong(expires_at_str);
+  secFree(expires_at_str);
+  if (expires_at > w->expires_at) {
+    w->expires_at = expires_at;
+    _schedule(w);
+  } else {
+    w->next = time(NULL) + AGENT_WATCH_RETRY;
+    if (expires_at != 0) {  // unchanged, the client already has this token
+      secFree(res);
+      return OIDC_SUCCESS;
+    }
+  }
+  oidc_error_t e = server_ipc_pushLine(*(w->con->msgsock), w->ipc_key, res);
+  secFree(res);
+  return e;
+}
+
+/**
+ * @brief updates the tokens of all watchers that are due
+ */
+void tokenWatch_run(struct ipcPipe pipes) {
+  if (watchers == NULL) {
+    return;
+  }
+  time_t           now = time(NULL);
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(watchers, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    struct token_watcher* w = node->val;
+    if (w->next <= now && _update(pipes, w) != OIDC_SUCCESS) {
+      agent_log(DEBUG, "Could not push token, dropping watching client");
+      connectionDB_removeIfFound(w->con);  // also removes the watcher
+    }
+  }
+  list_iterator_destroy(it);
+}
@@ -0,0 +1,24 @@
+#ifndef OIDCP_TOKEN_WATCH_H
+#define OIDCP_TOKEN_WATCH_H
+
+#include <time.h>
+
+#include "ipc/connection.h"
+#include "ipc/pipe.h"
+#include "utils/oidc_error.h"
+
+#ifndef AGENT_WATCH_REFRESH_AHEAD
+#define AGENT_WATCH_REFRESH_AHEAD 60
+#endif
+#ifndef AGENT_WATCH_RETRY
+#define AGENT_WATCH_RETRY 30
+#endif
+
+oidc_error_t tokenWatch_add(struct connection* con, unsigned char* ipc_key,
+                            const char* client_req);
+void         tokenWatch_removeConnection(const struct connection* con);
+int          tokenWatch_isWatching(const struct connection* con);
+time_t       tokenWatch_nextDeadline();
+void         tokenWatch_run(struct ipcPipe pipes);
+
+#endif  // OIDCP_TOKEN_WATCH_H
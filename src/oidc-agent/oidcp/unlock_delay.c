@@ -0,0 +1,203 @@
+#include "unlock_delay.h"
+
+#include <stdlib.h>
+
+#include "defines/ipc_values.h"
+#include "defines/oidc_values.h"
+#include "ipc/serveripc.h"
+#include "oidc-agent/oidcp/state_snapshot.h"
+#include "utils/agentLogger.h"
+#include "utils/db/connection_db.h"
+#include "utils/json.h"
+#include "utils/memory.h"
+#include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
+#include "wrapper/list.h"
+
+/**
+ * Brute-force protection for unlocking the agent.
+ *
+ * A wrong password is answered only after a delay that grows quadratically
+ * with the number of failed attempts. The delay is not a sleep: the client
+ * that sent the wrong password is parked until its response is due, while
+ * all other clients are served. The attempt budget is global; while a delay
+ * is running, further unlock requests are not checked but queued and tried
+ * one after another once the delay is over. So parallel connections do not
+ * give more guesses. At most @c UNLOCK_DELAY_MAX_WAITING clients are parked;
+ * further unlock requests during a delay are rejected right away.
+ */
+struct delayed_unlock {
+  struct connection* con;
+  unsigned char*     ipc_key;
+  char*              request;   // not tried yet
+  char*              response;  // failed attempt, written when the delay ends
+};
+
+static list_t*       waiting       = NULL;
+static unsigned char fail_count    = 0;
+static time_t        blocked_until = 0;
+
+static void _secFreeDelayedUnlock(struct delayed_unlock* d) {
+  if (d == NULL) {
+    return;
+  }
+  secFree(d->ipc_key);
+  secFree(d->request);
+  secFree(d->response);
+  secFree(d);
+}
+
+/**
+ * @brief parks a client; the key of its request is taken
+ * @param request the request that has to be tried later or @c NULL
+ * @param response the response that is written later or @c NULL; ownership
+ * is taken
+ */
+static void _park(struct connection* con, const char* request,
+                  char* response) {
+  if (waiting == NULL) {
+    waiting       = list_new();
+    waiting->free = (void (*)(void*)) & _secFreeDelayedUnlock;
+  }
+  struct delayed_unlock* d = secAlloc(sizeof(struct delayed_unlock));
+  d->con                   = con;
+  d->ipc_key               = server_ipc_takeLastKey();
+  d->request               = oidc_strcopy(request);
+  d->response              = response;
+  // A failed attempt is answered before the queued requests are tried
+  if (response != NULL) {
+    list_lpush(waiting, list_node_new(d));
+  } else {
+    list_rpush(waiting, list_node_new(d));
+  }
+}
+
+/**
+ * @brief forwards an unlock request to oidcd
+ * @return @c 1 if the client was parked because the password was wrong,
+ * @c 0 if it was answered
+ */
+static int _try(struct ipcPipe pipes, struct connection* con,
+                const char* request) {
+  char* res = ipc_communicateThroughPipe(pipes, "%s", request);
+  if (res == NULL) {
+    if (oidc_errno == OIDC_EIPCDIS || oidc_errno == OIDC_EWRITE) {
+      agent_log(ERROR, "oidcd died");
+      server_ipc_write(*(con->msgsock), RESPONSE_ERROR, "oidcd died");
+      exit(EXIT_FAILURE);
+    }
+    server_ipc_writeOidcErrno(*(con->msgsock));
+    return 0;
+  }
+  char* error = getJSONValueFromString(res, OIDC_KEY_ERROR);
+  if (error == NULL || !errorMessageIsForError(error, OIDC_EPASS)) {
+    if (error == NULL) {
+      fail_count = 0;
+      stateSnapshot_scheduleNow();  // replace the lock marker
+    }
+    secFree(error);
+    server_ipc_write(*(con->msgsock), "%s", res);
+    secFree(res);
+    return 0;
+  }
+  secFree(error);
+  if (fail_count < UNLOCK_DELAY_MAX_FAILS) {
+    fail_count++;
+  }
+  // 100 ms times the square of the failed attempts, rounded up to seconds
+  time_t delay  = (fail_count * fail_count + 9) / 10;
+  blocked_until = time(NULL) + delay;
+  agent_log(DEBUG, "unlock failed, delaying %lu seconds",
+            (unsigned long)delay);
+  _park(con, NULL, res);
+  return 1;
+}
+
+/**
+ * @brief handles an unlock request
+ * @return @c 1 if the client was parked; the connection must be kept open.
+ * @c 0 if the client was answered.
+ */
+int unlockDelay_handle(struct ipcPipe pipes, struct connection* con,
+                       const char* request) {
+  if (time(NULL) < blocked_until) {
+    if (waiting != NULL && waiting->len >= UNLOCK_DELAY_MAX_WAITING) {
+      agent_log(NOTICE, "Too many unlock attempts during delay, rejecting");
+      server_ipc_write(*(con->msgsock), RESPONSE_ERROR,
+                       "Too many unlock attempts. Try again later.");
+      return 0;
+    }
+    agent_log(DEBUG, "unlock attempt during delay, queueing it");
+    _park(con, request, NULL);
+    return 1;
+  }
+  return _try(pipes, con, request);
+}
+
+/**
+ * @brief returns the time when the running delay ends, @c 0 if no client
+ * waits for it
+ */
+time_t unlockDelay_nextDeadline() {
+  if (waiting == NULL || waiting->len == 0) {
+    return 0;
+  }
+  return blocked_until;
+}
+
+/**
+ * @brief answers the failed attempt whose delay ended and tries the queued
+ * requests until one of them fails again
+ */
+void unlockDelay_run(struct ipcPipe pipes) {
+  if (waiting == NULL) {
+    return;
+  }
+  list_node_t* node;
+  while (time(NULL) >= blocked_until && (node = list_lpop(waiting))) {
+    struct delayed_unlock* d = node->val;
+    LIST_FREE(node);
+    server_ipc_restoreKey(d->ipc_key);
+    d->ipc_key    = NULL;
+    int keepAlive = 0;
+    if (d->response != NULL) {
+      server_ipc_write(*(d->con->msgsock), "%s", d->response);
+    } else {
+      keepAlive = _try(pipes, d->con, d->request);
+    }
+    if (!keepAlive) {
+      connectionDB_removeIfFound(d->con);
+    }
+    _secFreeDelayedUnlock(d);
+  }
+}
+
+static list_node_t* _find(const struct connection* con) {
+  if (waiting == NULL || con == NULL) {
+    return NULL;
+  }
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(waiting, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    if (((struct delayed_unlock*)node->val)->con == con) {
+      break;
+    }
+  }
+  list_iterator_destroy(it);
+  return node;
+}
+
+int unlockDelay_isParked(const struct connection* con) {
+  return _find(con) != NULL;
+}
+
+/**
+ * @brief forgets a parked client; must be called before the connection is
+ * closed
+ */
+void unlockDelay_removeConnection(const struct connection* con) {
+  list_node_t* node = _find(con);
+  if (node != NULL) {
+    list_remove(waiting, node);
+  }
+}
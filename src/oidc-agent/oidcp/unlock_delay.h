@@ -0,0 +1,21 @@
+#ifndef OIDCP_UNLOCK_DELAY_H
+#define OIDCP_UNLOCK_DELAY_H
+
+#include <time.h>
+
+#include "ipc/connection.h"
+#include "ipc/pipe.h"
+
+#define UNLOCK_DELAY_MAX_FAILS 25
+#ifndef UNLOCK_DELAY_MAX_WAITING
+#define UNLOCK_DELAY_MAX_WAITING 16
+#endif
+
+int    unlockDelay_handle(struct ipcPipe pipes, struct connection* con,
+                          const char* request);
+time_t unlockDelay_nextDeadline();
+void   unlockDelay_run(struct ipcPipe pipes);
+int    unlockDelay_isParked(const struct connection* con);
+void   unlockDelay_removeConnection(const struct connection* con);
+
+#endif  // OIDCP_UNLOCK_DELAY_H
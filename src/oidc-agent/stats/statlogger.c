@@ -121,12 +121,42 @@ static size_t charPos = 0;
 #define STATS_SERVER "https://oidc-agent.test.fedcloud.eu"
 #endif
 
-static oidc_error_t sendStatPayload(const char* payload) {
-  char* res = sendJSONPostWithoutBasicAuth(STATS_SERVER, payload, NULL, NULL);
-  oidc_error_t ret =
-      strcaseequal(res, "Thank you!") ? OIDC_SUCCESS : OIDC_EERROR;
+/**
+ * @brief the stats that are currently being sent
+ */
+struct stat_upload {
+  size_t len;
+  time_t time;
+};
+
+static unsigned char uploading = 0;
+
+static void statPayloadSent(char* res, void* arg) {
+  struct stat_upload* upload = arg;
+  if (strcaseequal(res, "Thank you!")) {
+    charPos += upload->len;
+    lastSendTime = upload->time;
+    appendOidcFile(STATS_FILE, SYNC_BLOCK);
+  }
+  uploading = 0;
+  secFree(upload);
   secFree(res);
-  return ret;
+}
+
+/**
+ * @brief sends the stats in the background, so the request that triggered the
+ * upload is not delayed by the stats server
+ */
+static void sendStatPayload(const char* payload, struct stat_upload* upload) {
+  struct curl_slist* headers =
+      curl_slist_append(NULL, HTTP_HEADER_CONTENTTYPE_JSON);
+  if (httpsPOSTAsync(STATS_SERVER, payload, headers, NULL, NULL, NULL,
+                     statPayloadSent, upload) == OIDC_SUCCESS) {
+    uploading = 1;
+  } else {
+    secFree(upload);
+  }
+  curl_slist_free_all(headers);
 }
 
 static void sendStats() {
@@ -134,7 +164,7 @@ static void sendStats() {
     return;
   }
   time_t now = time(NULL);
-  if (now < lastSendTime + ONE_DAY) {
+  if (uploading || now < lastSendTime + ONE_DAY) {
     return;
   }
   char* new_stats = getFileContentFromOidcFileAfterLine(STATS_FILE, SYNC_BLOCK,
@@ -148,11 +178,10 @@ static void sendStats() {
     return;
   }
   char* jsonStats = delimitedStringToJSONArrayFmt(new_stats, '\n', "%s");
-  if (sendStatPayload(jsonStats) == OIDC_SUCCESS) {
-    charPos += strlen(new_stats);
-    lastSendTime = now;
-    appendOidcFile(STATS_FILE, SYNC_BLOCK);
-  }
+  struct stat_upload* upload = secAlloc(sizeof(struct stat_upload));
+  upload->len                = strlen(new_stats);
+  upload->time               = now;
+  sendStatPayload(jsonStats, upload);
   secFree(jsonStats);
   secFree(new_stats);
 }
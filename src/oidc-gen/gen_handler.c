@@ -26,6 +26,7 @@
 #include "oidc-gen/parse_ipc.h"
 #include "oidc-gen/promptAndSet/promptAndSet.h"
 #include "utils/accountUtils.h"
+#include "utils/config/accountIndex.h"
 #include "utils/config/gen_config.h"
 #include "utils/config/issuerConfig.h"
 #include "utils/crypt/crypt.h"
@@ -261,6 +262,8 @@ void gen_handleRename(const char*             shortname,
   } else {
     if (removeOidcFile(shortname) != 0) {
       printError("error removing old configuration file: %s", oidc_serror());
+    } else {
+      accountIndex_remove(shortname);
     }
   }
   secFree(json);
@@ -893,6 +896,7 @@ void deleteAccount(char* short_name, char* file_json, int revoke,
         "You don't have to run oidc-add.\n");
     SEC_FREE_KEY_VALUES();
     if (removeOidcFile(short_name) == 0) {
+      accountIndex_remove(short_name);
       printStdout("Successfully deleted account configuration.\n");
     } else {
       printError("error removing configuration file: %s", oidc_serror());
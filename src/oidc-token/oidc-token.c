@@ -16,9 +16,12 @@ int main(int argc, char** argv) {
   initArguments(&arguments);
   argp_parse(&argp, argc, argv, 0, 0, &arguments);
 
-  struct agent_response (*getAgentResponseFnc)(const char*, time_t, const char*,
-                                               const char*, const char*) =
-      getAgentTokenResponse;
+  if (arguments.batch) {
+    exit(token_handleBatch(&arguments) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+  struct agent_response (*getAgentResponseFnc)(
+      const char*, time_t, time_t, const char*, const char*, const char*) =
+      getAgentTokenResponseAllowStale;
   unsigned char useIssuerInsteadOfShortname = 0;
   if (strstarts(arguments.args[0], "https://")) {
     useIssuerInsteadOfShortname = 1;
@@ -46,13 +49,17 @@ int main(int argc, char** argv) {
     secFreeAgentResponse(response);
     return 0;
   }
+  if (arguments.watch) {
+    token_handleWatch(useIssuerInsteadOfShortname, &arguments);
+    exit(EXIT_FAILURE);  // only returns if the agent went away
+  }
   if (useIssuerInsteadOfShortname) {
-    getAgentResponseFnc = getAgentTokenResponseForIssuer;
+    getAgentResponseFnc = getAgentTokenResponseForIssuerAllowStale;
   }
   struct agent_response response = getAgentResponseFnc(
       arguments.args[0],
       arguments.forceNewToken ? FORCE_NEW_TOKEN : arguments.min_valid_period,
-      arguments.scopes,
+      arguments.stale_min_valid_period, arguments.scopes,
       strValid(arguments.application_name) ? arguments.application_name
                                            : "oidc-token",
       arguments.audience);  // for getting a valid access token just call the
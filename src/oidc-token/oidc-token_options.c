@@ -7,6 +7,10 @@
 #define OPT_NAME 2
 #define OPT_AUDIENCE 3
 #define OPT_IDTOKEN 4
+#define OPT_ALLOWSTALE 5
+#define OPT_WATCH 6
+#define OPT_WATCHFILE 7
+#define OPT_BATCH 8
 
 static struct argp_option options[] = {
     {0, 0, 0, 0, "General:", 1},
@@ -48,6 +52,29 @@ static struct argp_option options[] = {
      1},
     {"force-new", 'f', 0, 0,
      "Forces that a new access token is issued and returned.", 1},
+    {"allow-stale", OPT_ALLOWSTALE, "SECONDS", 0,
+     "If the current access token is not valid long enough, but still valid "
+     "for at least SECONDS seconds, return it immediately and let the agent "
+     "obtain a new one in the background. The agent might enforce a higher "
+     "minimum.",
+     1},
+    {"watch", OPT_WATCH, 0, 0,
+     "Do not exit after the first access token, but keep running and print "
+     "every new access token the agent obtains shortly before the previous one "
+     "is valid for less than the minimum period set with -t. Each token is "
+     "printed as a single line JSON object.",
+     1},
+    {"watch-file", OPT_WATCHFILE, "FILE", 0,
+     "Like --watch, but atomically replace FILE with each new access token "
+     "instead of printing it.",
+     1},
+    {"batch", OPT_BATCH, "FILE", OPTION_ARG_OPTIONAL,
+     "Request access tokens for many accounts at once. Each line of FILE (or "
+     "stdin if FILE is not given or '-') is an account shortname, an issuer "
+     "url or a JSON object with the keys 'account' or 'issuer' and optionally "
+     "'min_valid_period', 'scope', 'audience'. Other options like -t, -s and "
+     "--aud set the defaults. For each line one JSON object is printed.",
+     1},
 
     {0, 0, 0, 0, "Advanced:", 2},
     {"scope", 's', "SCOPE", 0,
@@ -104,6 +131,19 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
       arguments->min_valid_period   = strToInt(arg);
       min_valid_period_set_from_arg = 1;
       break;
+    case OPT_ALLOWSTALE:
+      if (!isdigit(*arg)) {
+        return ARGP_ERR_UNKNOWN;
+      }
+      arguments->stale_min_valid_period = strToInt(arg);
+      break;
+    case OPT_WATCHFILE: arguments->watch_file = arg;
+    // fall through
+    case OPT_WATCH: arguments->watch = 1; break;
+    case OPT_BATCH:
+      arguments->batch      = 1;
+      arguments->batch_file = arg;
+      break;
     case OPT_IDTOKEN: arguments->idtoken = 1; break;
     case OPT_NAME: arguments->application_name = arg; break;
     case OPT_AUDIENCE: arguments->audience = arg; break;
@@ -141,7 +181,7 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
       arguments->args[state->arg_num] = arg;
       break;
     case ARGP_KEY_END:
-      if (state->arg_num < 1) {
+      if (state->arg_num < 1 && !arguments->batch) {
         argp_usage(state);
       }
       break;
@@ -150,7 +190,7 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
   return 0;
 }
 
-static char args_doc[] = "ACCOUNT_SHORTNAME | ISSUER_URL";
+static char args_doc[] = "ACCOUNT_SHORTNAME | ISSUER_URL\n--batch[=FILE]";
 
 static char doc[] =
     "oidc-token -- A client for oidc-agent for getting OIDC access tokens.";
@@ -158,20 +198,25 @@ static char doc[] =
 struct argp argp = {options, parse_opt, args_doc, doc, 0, 0, 0};
 
 void initArguments(struct arguments* arguments) {
-  arguments->min_valid_period     = getClientConfig()->default_min_lifetime;
-  arguments->args[0]              = NULL;
-  arguments->scopes               = NULL;
-  arguments->application_name     = NULL;
-  arguments->audience             = NULL;
-  arguments->expiration_env.str   = NULL;
-  arguments->expiration_env.useIt = 0;
-  arguments->token_env.str        = NULL;
-  arguments->token_env.useIt      = 0;
-  arguments->issuer_env.str       = NULL;
-  arguments->issuer_env.useIt     = 0;
-  arguments->mytoken.str          = NULL;
-  arguments->mytoken.useIt        = 0;
-  arguments->printAll             = 0;
-  arguments->idtoken              = 0;
-  arguments->forceNewToken        = 0;
+  arguments->min_valid_period       = getClientConfig()->default_min_lifetime;
+  arguments->stale_min_valid_period = 0;
+  arguments->args[0]                = NULL;
+  arguments->scopes                 = NULL;
+  arguments->application_name       = NULL;
+  arguments->audience               = NULL;
+  arguments->expiration_env.str     = NULL;
+  arguments->expiration_env.useIt   = 0;
+  arguments->token_env.str          = NULL;
+  arguments->token_env.useIt        = 0;
+  arguments->issuer_env.str         = NULL;
+  arguments->issuer_env.useIt       = 0;
+  arguments->mytoken.str            = NULL;
+  arguments->mytoken.useIt          = 0;
+  arguments->printAll               = 0;
+  arguments->idtoken                = 0;
+  arguments->forceNewToken          = 0;
+  arguments->watch                  = 0;
+  arguments->watch_file             = NULL;
+  arguments->batch                  = 0;
+  arguments->batch_file             = NULL;
 }
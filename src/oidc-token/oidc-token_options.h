@@ -31,8 +31,14 @@ struct arguments {
   unsigned char printAll;
   unsigned char idtoken;
   unsigned char forceNewToken;
+  unsigned char watch;
+  unsigned char batch;
+
+  char* watch_file;
+  char* batch_file;
 
   time_t min_valid_period;
+  time_t stale_min_valid_period;
 };
 
 void initArguments(struct arguments* arguments);
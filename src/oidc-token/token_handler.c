@@ -1,14 +1,24 @@
+#define _GNU_SOURCE
 #include "token_handler.h"
 
+#include <ctype.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "api/watch.h"
 #include "defines/ipc_values.h"
 #include "ipc/cryptCommunicator.h"
+#include "ipc/cryptIpc.h"
+#include "ipc/ipc.h"
+#include "utils/crypt/ipcCryptUtils.h"
+#include "utils/file_io/file_io.h"
 #include "utils/file_io/oidc_file_io.h"
 #include "utils/json.h"
 #include "utils/key_value.h"
 #include "utils/oidc_error.h"
 #include "utils/printer.h"
+#include "utils/string/stringUtils.h"
 
 void token_handleIdToken(const unsigned char useIssuerInsteadOfShortname,
                          const char*         name) {
@@ -42,3 +52,230 @@ void token_handleIdToken(const unsigned char useIssuerInsteadOfShortname,
   printStdout("%s\n", _id_token);
   SEC_FREE_KEY_VALUES();
 }
+
+static void _printTokenLine(struct agent_response res) {
+  cJSON* json;
+  if (res.type == AGENT_RESPONSE_TYPE_TOKEN) {
+    json = generateJSONObject(
+        OIDC_KEY_ACCESSTOKEN, cJSON_String, res.token_response.token,
+        OIDC_KEY_ISSUER, cJSON_String, res.token_response.issuer, NULL);
+    jsonAddNumberValue(json, AGENT_KEY_EXPIRESAT,
+                       res.token_response.expires_at);
+  } else {
+    json = generateJSONObject(OIDC_KEY_ERROR, cJSON_String,
+                              res.error_response.error, NULL);
+    if (res.error_response.help) {
+      jsonAddStringValue(json, IPC_KEY_INFO, res.error_response.help);
+    }
+  }
+  char* line = jsonToStringUnformatted(json);
+  secFreeJson(json);
+  printf("%s\n", line);
+  fflush(stdout);
+  secFree(line);
+}
+
+/**
+ * @brief subscribes to the access tokens of an account and prints every new
+ * token, or writes it to a file; only returns if the agent closed the
+ * connection
+ */
+void token_handleWatch(const unsigned char     useIssuerInsteadOfShortname,
+                       const struct arguments* arguments) {
+  const char* hint = strValid(arguments->application_name)
+                         ? arguments->application_name
+                         : "oidc-token";
+  oidcagent_watch_t* watch =
+      useIssuerInsteadOfShortname
+          ? oidcagent_startWatchForIssuer(arguments->args[0],
+                                          arguments->min_valid_period,
+                                          arguments->scopes, hint,
+                                          arguments->audience)
+          : oidcagent_startWatch(arguments->args[0],
+                                 arguments->min_valid_period,
+                                 arguments->scopes, hint, arguments->audience);
+  if (watch == NULL) {
+    oidc_perror();
+    return;
+  }
+  while (1) {
+    struct agent_response res = oidcagent_watchNext(watch);
+    if (arguments->watch_file == NULL) {
+      _printTokenLine(res);
+    } else if (res.type == AGENT_RESPONSE_TYPE_TOKEN) {
+      if (writeFileAtomic(arguments->watch_file, res.token_response.token) !=
+          OIDC_SUCCESS) {
+        oidc_perror();
+      }
+    } else {  // keep the old token, it might still be valid
+      oidcagent_printErrorResponse(res.error_response);
+    }
+    secFreeAgentResponse(res);
+    if (oidcagent_watchClosed(watch)) {
+      break;
+    }
+  }
+  oidcagent_stopWatch(watch);
+}
+
+// number of token requests that are sent to the agent in one batch; the agent
+// does not serve other clients while it handles a batch
+#define BATCH_SIZE 64
+
+static cJSON* _batchRequestFromSpec(const char*             spec,
+                                    const struct arguments* arguments) {
+  cJSON* json;
+  if (spec[0] == '{') {
+    json = stringToJson(spec);
+  } else {
+    const char* key =
+        strstarts(spec, "https://") ? IPC_KEY_ISSUERURL : IPC_KEY_SHORTNAME;
+    json = generateJSONObject(key, cJSON_String, spec, NULL);
+  }
+  if (json == NULL) {
+    return NULL;
+  }
+  if (!jsonHasKey(json, IPC_KEY_MINVALID)) {
+    jsonAddNumberValue(json, IPC_KEY_MINVALID, arguments->min_valid_period);
+  }
+  if (arguments->scopes) {
+    setJSONValueIfNotSet(json, OIDC_KEY_SCOPE, arguments->scopes);
+  }
+  if (arguments->audience) {
+    setJSONValueIfNotSet(json, IPC_KEY_AUDIENCE, arguments->audience);
+  }
+  setJSONValueIfNotSet(json, IPC_KEY_APPLICATIONHINT,
+                       strValid(arguments->application_name)
+                           ? arguments->application_name
+                           : "oidc-token");
+  return json;
+}
+
+/**
+ * @brief prints the response for one request of a batch as a single line
+ * @return @c 0 if the response contains a token, @c 1 otherwise
+ */
+static int _printBatchResponse(const cJSON* request, const char* response) {
+  cJSON* json = response ? stringToJson(response) : NULL;
+  if (json == NULL) {
+    json = generateJSONObject(OIDC_KEY_ERROR, cJSON_String, oidc_serror(),
+                              NULL);
+  }
+  cJSON_DeleteItemFromObjectCaseSensitive(json, IPC_KEY_STATUS);
+  // So that the caller can tell the lines apart
+  char* account = getJSONValue(request, IPC_KEY_SHORTNAME);
+  if (account != NULL) {
+    setJSONValue(json, IPC_KEY_SHORTNAME, account);
+    secFree(account);
+  } else {
+    char* issuer = getJSONValue(request, IPC_KEY_ISSUERURL);
+    setJSONValueIfNotSet(json, IPC_KEY_ISSUERURL, issuer ?: "");
+    secFree(issuer);
+  }
+  int   failed = jsonHasKey(json, OIDC_KEY_ERROR);
+  char* line   = jsonToStringUnformatted(json);
+  secFreeJson(json);
+  printf("%s\n", line);
+  secFree(line);
+  return failed;
+}
+
+/**
+ * @brief sends a batch of token requests over a single connection
+ * @return the number of requests that did not return a token
+ */
+static int _sendBatch(cJSON* requests) {
+  int               n   = cJSON_GetArraySize(requests);
+  struct connection con = {0};
+  unsigned char*    key = NULL;
+  char*             msg = NULL;
+  oidc_error_t      e   = ipc_client_init(&con, 0);
+  if (e == OIDC_SUCCESS && (e = ipc_connect(con)) == OIDC_SUCCESS) {
+    key = client_keyExchange(*(con.sock));
+    e   = key ? OIDC_SUCCESS : oidc_errno;
+  }
+  if (e == OIDC_SUCCESS) {
+    cJSON* batch = generateJSONObject(IPC_KEY_REQUEST, cJSON_String,
+                                      REQUEST_VALUE_BATCH, NULL);
+    cJSON_AddItemReferenceToObject(batch, IPC_KEY_REQUESTS, requests);
+    msg = jsonToStringUnformatted(batch);
+    secFreeJson(batch);
+    e = ipc_cryptWrite(*(con.sock), key, "%s", msg);
+    secFree(msg);
+  }
+  int failed = 0;
+  for (int i = 0; i < n; i++) {
+    char* res = NULL;
+    if (e == OIDC_SUCCESS) {
+      char* line = ipc_readLine(*(con.sock));
+      if (line != NULL && !isJSONObject(line)) {
+        res = decryptForIpc(line, key);
+        secFree(line);
+      } else {
+        res = line;
+      }
+      e = res ? OIDC_SUCCESS : oidc_errno;
+    }
+    failed += _printBatchResponse(cJSON_GetArrayItem(requests, i), res);
+    secFree(res);
+  }
+  fflush(stdout);
+  secFree(key);
+  ipc_closeConnection(&con);
+  return failed;
+}
+
+/**
+ * @brief requests access tokens for all specs read from a file or stdin and
+ * prints one JSON object per spec
+ * @return the number of specs for which no token could be obtained
+ */
+int token_handleBatch(const struct arguments* arguments) {
+  FILE* in = arguments->batch_file == NULL ||
+                     strequal(arguments->batch_file, "-")
+                 ? stdin
+                 : fopen(arguments->batch_file, "r");
+  if (in == NULL) {
+    oidc_setErrnoError();
+    oidc_perror();
+    return -1;
+  }
+  int     failed   = 0;
+  char*   line     = NULL;
+  size_t  len      = 0;
+  cJSON*  requests = generateJSONArray(NULL);
+  ssize_t read;
+  while ((read = getline(&line, &len, in)) != -1) {
+    while (read > 0 && isspace((unsigned char)line[read - 1])) {
+      line[--read] = '\0';
+    }
+    const char* spec = line;
+    while (isspace((unsigned char)*spec)) {
+      spec++;
+    }
+    if (!strValid(spec) || spec[0] == '#') {
+      continue;
+    }
+    cJSON* request = _batchRequestFromSpec(spec, arguments);
+    if (request == NULL) {
+      printError("Invalid batch line: %s\n", spec);
+      failed++;
+    } else {
+      cJSON_AddItemToArray(requests, request);
+    }
+    if (cJSON_GetArraySize(requests) >= BATCH_SIZE) {
+      failed += _sendBatch(requests);
+      secFreeJson(requests);
+      requests = generateJSONArray(NULL);
+    }
+  }
+  if (cJSON_GetArraySize(requests) > 0) {
+    failed += _sendBatch(requests);
+  }
+  secFreeJson(requests);
+  free(line);
+  if (in != stdin) {
+    fclose(in);
+  }
+  return failed;
+}
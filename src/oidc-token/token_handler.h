@@ -5,5 +5,8 @@
 
 void token_handleIdToken(const unsigned char useIssuerInsteadOfShortname,
                          const char*         name);
+int  token_handleBatch(const struct arguments* arguments);
+void token_handleWatch(const unsigned char     useIssuerInsteadOfShortname,
+                       const struct arguments* arguments);
 
 #endif /* OIDC_TOKEN_HANDLER_H */
@@ -0,0 +1,333 @@
+#define _XOPEN_SOURCE 700
+#include "accountIndex.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#ifndef MINGW
+#include <sys/file.h>
+#endif
+
+#include "defines/agent_values.h"
+#include "defines/msys.h"
+#include "defines/oidc_values.h"
+#include "defines/settings.h"
+#include "utils/file_io/oidc_file_io.h"
+#include "utils/hashmap.h"
+#include "utils/json.h"
+#include "utils/logger.h"
+#include "utils/matcher.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+/**
+ * The account index is a plaintext file in the oidc dir that maps the
+ * shortnames of the account configs to their issuer and scope. It only holds
+ * non-secret values, so the accounts of an issuer can be found without
+ * decrypting any account config. An entry is only trusted while the account
+ * config file has the modification time it had when it was indexed; entries
+ * of account configs that were changed otherwise are ignored until the
+ * account is written or loaded again.
+ *
+ * Several processes update the index, so changes are made while holding a
+ * lock on a separate lock file and the index is replaced atomically.
+ */
+static hashmap_t* entries    = NULL;  // shortname -> struct accountIndexEntry
+static time_t     file_mtime = 0;
+static off_t      file_size  = 0;
+
+static void _secFreeEntry(struct accountIndexEntry* e) {
+  if (e == NULL) {
+    return;
+  }
+  secFree(e->shortname);
+  secFree(e->issuer_url);
+  secFree(e->scope);
+  secFree(e);
+}
+
+static int _statOidcFile(const char* filename, struct stat* buf) {
+  char* path = concatToOidcDir(filename);
+  if (path == NULL) {
+    return -1;
+  }
+  int ret = stat(path, buf);
+  secFree(path);
+  return ret;
+}
+
+static time_t _accountMtime(const char* shortname) {
+  struct stat buf;
+  return _statOidcFile(shortname, &buf) == 0 ? buf.st_mtime : 0;
+}
+
+static int _isValid(const struct accountIndexEntry* e) {
+  time_t mtime = _accountMtime(e->shortname);
+  return mtime != 0 && mtime == e->mtime;
+}
+
+static struct accountIndexEntry* _newEntry(const char* shortname,
+                                           const char* issuer_url,
+                                           const char* scope, time_t mtime) {
+  struct accountIndexEntry* e = secAlloc(sizeof(struct accountIndexEntry));
+  e->shortname                = oidc_strcopy(shortname);
+  e->issuer_url               = oidc_strcopy(issuer_url);
+  e->scope                    = oidc_strcopy(scope);
+  e->mtime                    = mtime;
+  return e;
+}
+
+/**
+ * @brief (re)reads the index file if it changed since it was read last
+ * @param force if the file should be read even if it seems unchanged
+ * @return @c 0 on success; @c -1 if the file could not be parsed, then the
+ * entries read before are kept
+ */
+static int _load(int force) {
+  struct stat buf;
+  int         exists = _statOidcFile(ACCOUNT_INDEX_FILENAME, &buf) == 0;
+  if (!force && entries != NULL &&
+      (exists ? buf.st_mtime == file_mtime && buf.st_size == file_size
+              : file_mtime == 0)) {
+    return 0;
+  }
+  cJSON* json = NULL;
+  if (exists) {
+    char* content = readOidcFile(ACCOUNT_INDEX_FILENAME);
+    json = content && isJSONObject(content) ? stringToJson(content) : NULL;
+    secFree(content);
+    if (json == NULL) {
+      logger(NOTICE, "Could not parse the account index");
+      if (entries == NULL) {
+        entries = hashmap_new(16, (void (*)(void*))_secFreeEntry);
+      }
+      return -1;
+    }
+  }
+  secFreeHashmap(entries);
+  entries    = hashmap_new(16, (void (*)(void*))_secFreeEntry);
+  file_mtime = exists ? buf.st_mtime : 0;
+  file_size  = exists ? buf.st_size : 0;
+  cJSON* item;
+  cJSON_ArrayForEach(item, json) {
+    char*        issuer_url = getJSONValue(item, AGENT_KEY_ISSUERURL);
+    char*        scope      = getJSONValue(item, OIDC_KEY_SCOPE);
+    const cJSON* mtime =
+        cJSON_GetObjectItemCaseSensitive(item, ACCOUNTINDEX_KEY_MTIME);
+    if (item->string != NULL && issuer_url != NULL && cJSON_IsNumber(mtime)) {
+      hashmap_put(entries, item->string,
+                  _newEntry(item->string, issuer_url, scope,
+                            (time_t)mtime->valuedouble));
+    }
+    secFree(issuer_url);
+    secFree(scope);
+  }
+  secFreeJson(json);
+  return 0;
+}
+
+/**
+ * @brief locks the index against changes by other processes and reads it
+ * @return the lock that has to be passed to @c _unlock; @c -1 if the index
+ * could not be read and must not be written
+ */
+static int _lockAndLoad() {
+  int fd = -2;  // not locked, but the index can be written
+#ifndef MINGW
+  char* path = concatToOidcDir(ACCOUNT_INDEX_LOCK_FILENAME);
+  if (path != NULL) {
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    secFree(path);
+  }
+  if (fd >= 0 && flock(fd, LOCK_EX) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  if (fd < 0) {
+    logger(NOTICE, "Could not lock the account index: %m");
+    fd = -2;
+  }
+#endif
+  // With the lock held the file cannot be half written; if it cannot be
+  // parsed it is kept as it is instead of being replaced by what we know
+  if (_load(1) != 0) {
+#ifndef MINGW
+    if (fd >= 0) {
+      close(fd);
+    }
+#endif
+    return -1;
+  }
+  return fd;
+}
+
+static void _unlock(int fd) {
+#ifndef MINGW
+  if (fd >= 0) {
+    close(fd);  // releases the lock
+  }
+#endif
+}
+
+static void _addToJSON(const char* key, void* value, void* arg) {
+  const struct accountIndexEntry* e    = value;
+  cJSON*                          item = cJSON_CreateObject();
+  jsonAddStringValue(item, AGENT_KEY_ISSUERURL, e->issuer_url);
+  if (e->scope != NULL) {
+    jsonAddStringValue(item, OIDC_KEY_SCOPE, e->scope);
+  }
+  jsonAddNumberValue(item, ACCOUNTINDEX_KEY_MTIME, e->mtime);
+  cJSON_AddItemToObject(arg, key, item);
+}
+
+static void _write() {
+  initCJSON();
+  cJSON* json = cJSON_CreateObject();
+  hashmap_foreach(entries, _addToJSON, json);
+  char* content = jsonToString(json);
+  secFreeJson(json);
+  markPublicMem(content);
+  writeOidcFileAtomic(ACCOUNT_INDEX_FILENAME, content);
+  secFree(content);
+  struct stat buf;
+  if (_statOidcFile(ACCOUNT_INDEX_FILENAME, &buf) == 0) {
+    file_mtime = buf.st_mtime;
+    file_size  = buf.st_size;
+  }
+}
+
+/**
+ * @brief indexes an account config file
+ * @param scope the scope of the account or @c NULL if it is not known; then
+ * a known scope is kept as long as the account config was not changed
+ * @note nothing is indexed if the account config file does not exist in the
+ * oidc dir
+ */
+void accountIndex_update(const char* shortname, const char* issuer_url,
+                         const char* scope) {
+  if (!strValid(shortname) || !strValid(issuer_url)) {
+    return;
+  }
+  time_t mtime = _accountMtime(shortname);
+  if (mtime == 0) {
+    return;
+  }
+  int lock = _lockAndLoad();
+  if (lock == -1) {
+    return;
+  }
+  const struct accountIndexEntry* old = hashmap_get(entries, shortname);
+  if (old != NULL && old->mtime == mtime) {
+    if (scope == NULL) {
+      scope = old->scope;
+    }
+    if (strequal(old->issuer_url, issuer_url) && strequal(old->scope, scope)) {
+      _unlock(lock);
+      return;
+    }
+  }
+  hashmap_put(entries, shortname,
+              _newEntry(shortname, issuer_url, scope, mtime));
+  _write();
+  _unlock(lock);
+}
+
+/**
+ * @brief indexes an account config file from its decrypted content
+ * @param config the content of the account config; other content is ignored
+ */
+void accountIndex_updateFromConfig(const char* shortname, const char* config) {
+  if (shortname == NULL || config == NULL || !isJSONObject(config)) {
+    return;
+  }
+  INIT_KEY_VALUE(AGENT_KEY_SHORTNAME, AGENT_KEY_ISSUERURL, OIDC_KEY_ISSUER,
+                 OIDC_KEY_SCOPE);
+  if (CALL_GETJSONVALUES(config) < 0) {
+    SEC_FREE_KEY_VALUES();
+    return;
+  }
+  KEY_VALUE_VARS(name, issuer_url, issuer, scope);
+  if (strequal(_name, shortname)) {
+    accountIndex_update(shortname, _issuer_url ?: _issuer, _scope ?: "");
+  }
+  SEC_FREE_KEY_VALUES();
+}
+
+void accountIndex_remove(const char* shortname) {
+  if (shortname == NULL) {
+    return;
+  }
+  int lock = _lockAndLoad();
+  if (lock == -1) {
+    return;
+  }
+  struct accountIndexEntry* e = hashmap_remove(entries, shortname);
+  if (e != NULL) {
+    _secFreeEntry(e);
+    _write();
+  }
+  _unlock(lock);
+}
+
+struct issuer_search {
+  const char*                     issuer_url;
+  const struct accountIndexEntry* found;
+};
+
+static void _findForIssuer(const char* key __attribute__((unused)),
+                           void* value, void* arg) {
+  const struct accountIndexEntry* e = value;
+  struct issuer_search*           s = arg;
+  if (!matchUrls(e->issuer_url, s->issuer_url) || !_isValid(e)) {
+    return;
+  }
+  if (s->found == NULL || e->mtime > s->found->mtime ||
+      (e->mtime == s->found->mtime &&
+       strcmp(e->shortname, s->found->shortname) < 0)) {
+    s->found = e;
+  }
+}
+
+/**
+ * @brief returns the shortname of an indexed account config for an issuer;
+ * if there are several, the one changed last
+ * @return the shortname or @c NULL; it is only valid until the next call of
+ * an @c accountIndex function
+ */
+const char* accountIndex_getAccountForIssuer(const char* issuer_url) {
+  if (issuer_url == NULL) {
+    return NULL;
+  }
+  _load(0);
+  struct issuer_search s = {.issuer_url = issuer_url, .found = NULL};
+  hashmap_foreach(entries, _findForIssuer, &s);
+  return s.found ? s.found->shortname : NULL;
+}
+
+struct foreach_call {
+  void (*f)(const struct accountIndexEntry*, void*);
+  void* arg;
+};
+
+static void _callIfValid(const char* key __attribute__((unused)), void* value,
+                         void* arg) {
+  struct foreach_call* c = arg;
+  if (_isValid(value)) {
+    c->f(value, c->arg);
+  }
+}
+
+/**
+ * @brief calls @p f for every indexed account config that is up to date
+ */
+void accountIndex_foreach(void (*f)(const struct accountIndexEntry*, void*),
+                          void* arg) {
+  if (f == NULL) {
+    return;
+  }
+  _load(0);
+  struct foreach_call c = {.f = f, .arg = arg};
+  hashmap_foreach(entries, _callIfValid, &c);
+}
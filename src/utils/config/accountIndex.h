@@ -0,0 +1,27 @@
+#ifndef OIDC_AGENT_ACCOUNTINDEX_H
+#define OIDC_AGENT_ACCOUNTINDEX_H
+
+#include <time.h>
+
+/**
+ * What the account index knows about an account config file without
+ * decrypting it
+ */
+struct accountIndexEntry {
+  char*  shortname;
+  char*  issuer_url;
+  char*  scope;  // NULL if not known
+  time_t mtime;  // of the account config file when it was indexed
+};
+
+void        accountIndex_update(const char* shortname, const char* issuer_url,
+                                const char* scope);
+void        accountIndex_updateFromConfig(const char* shortname,
+                                          const char* config);
+void        accountIndex_remove(const char* shortname);
+const char* accountIndex_getAccountForIssuer(const char* issuer_url);
+void        accountIndex_foreach(void (*f)(const struct accountIndexEntry*,
+                                           void*),
+                                 void* arg);
+
+#endif  // OIDC_AGENT_ACCOUNTINDEX_H
@@ -17,12 +17,14 @@ void _secFreeAgentConfig(agent_config_t* c) {
   secFree(c->cert_path);
   secFree(c->bind_address);
   secFree(c->group);
+  secFree(c->state_snapshot_key_cmd);
   secFree(c);
 }
 
 static agent_config_t* agent_config = NULL;
 
-static agent_config_t* _getAgentConfig(const char* json) {
+static agent_config_t* _getAgentConfig(const char*   json,
+                                       unsigned char exitOnError) {
   if (NULL == json) {
     return secAlloc(sizeof(agent_config_t));
   }
@@ -33,17 +35,30 @@ static agent_config_t* _getAgentConfig(const char* json) {
                  CONFIG_KEY_DEBUGLOGGING, IPC_KEY_LIFETIME, CONFIG_KEY_GROUP,
                  IPC_KEY_ALWAYSALLOWID, CONFIG_KEY_AUTOGEN,
                  CONFIG_KEY_AUTOGENSCOPEMODE, CONFIG_KEY_STATSCOLLECT,
-                 CONFIG_KEY_STATSCOLLECTSHARE, CONFIG_KEY_STATSCOLLECTLOCATION);
+                 CONFIG_KEY_STATSCOLLECTSHARE, CONFIG_KEY_STATSCOLLECTLOCATION,
+                 CONFIG_KEY_HTTPDNSCACHETTL, CONFIG_KEY_HTTPCONNMAXIDLE,
+                 CONFIG_KEY_STALETOKENMINVALID, CONFIG_KEY_KERNELKEYRING,
+                 CONFIG_KEY_MAXLOADEDACCOUNTS,
+                 CONFIG_KEY_MAXLOADEDACCOUNTSBYTES, CONFIG_KEY_STATESNAPSHOT,
+                 CONFIG_KEY_STATESNAPSHOTINTERVAL,
+                 CONFIG_KEY_STATESNAPSHOTKEYCMD);
   if (getJSONValuesFromString(json, pairs, sizeof(pairs) / sizeof(*pairs)) <
       0) {
     SEC_FREE_KEY_VALUES();
+    if (!exitOnError) {
+      return NULL;
+    }
     oidc_perror();
     exit(oidc_errno);
   }
   KEY_VALUE_VARS(cert_path, bind_address, confirm, autoload, autoreauth,
                  customurischeme, webserver, debug, lifetime, group,
                  alwaysallowidtoken, autogen, autogenscopemode, stats_collect,
-                 stats_collect_share, stats_collect_location);
+                 stats_collect_share, stats_collect_location,
+                 http_dns_cache_ttl, http_conn_max_idle,
+                 stale_token_min_valid, kernel_keyring, max_loaded_accounts,
+                 max_loaded_accounts_bytes, state_snapshot,
+                 state_snapshot_interval, state_snapshot_key_cmd);
   agent_config_t* c         = secAlloc(sizeof(agent_config_t));
   c->cert_path              = oidc_strcopy(_cert_path);
   c->bind_address           = oidc_strcopy(_bind_address);
@@ -58,6 +73,21 @@ static agent_config_t* _getAgentConfig(const char* json) {
   c->stats_collect          = strToBit(_stats_collect);
   c->stats_collect_share    = strToBit(_stats_collect_share);
   c->stats_collect_location = strToBit(_stats_collect_location);
+  c->kernel_keyring         = strToBit(_kernel_keyring);
+  c->http_dns_cache_ttl     = strToLong(_http_dns_cache_ttl);
+  c->http_dns_cache_ttl_set = _http_dns_cache_ttl != NULL;
+  c->http_conn_max_idle     = strToLong(_http_conn_max_idle);
+  c->http_conn_max_idle_set = _http_conn_max_idle != NULL;
+
+  c->stale_token_min_valid     = strToLong(_stale_token_min_valid);
+  c->stale_token_min_valid_set = _stale_token_min_valid != NULL;
+  c->max_loaded_accounts       = strToLong(_max_loaded_accounts);
+  c->max_loaded_accounts_bytes = strToLong(_max_loaded_accounts_bytes);
+
+  c->state_snapshot              = strToBit(_state_snapshot);
+  c->state_snapshot_interval     = strToLong(_state_snapshot_interval);
+  c->state_snapshot_interval_set = _state_snapshot_interval != NULL;
+  c->state_snapshot_key_cmd      = oidc_strcopy(_state_snapshot_key_cmd);
   if (strValid(_autogenscopemode)) {
     if (strcaseequal(_autogenscopemode, CONFIG_VALUE_SCOPEMODE_EXACT)) {
       c->autogenscopemode = AGENTCONFIG_AUTOGENSCOPEMODE_EXACT;
@@ -69,6 +99,11 @@ static agent_config_t* _getAgentConfig(const char* json) {
           "value '%s'\n",
           CONFIG_KEY_AUTOGENSCOPEMODE, _autogenscopemode);
       SEC_FREE_KEY_VALUES();
+      if (!exitOnError) {
+        _secFreeAgentConfig(c);
+        oidc_errno = OIDC_EBADCONFIG;
+        return NULL;
+      }
       exit(EXIT_FAILURE);
     }
   }
@@ -94,7 +129,35 @@ const agent_config_t* getAgentConfig() {
     oidc_perror();
     exit(oidc_errno);
   }
-  agent_config = _getAgentConfig(agent_json);
+  agent_config = _getAgentConfig(agent_json, 1);
   secFree(agent_json);
   return agent_config;
 }
+
+oidc_error_t reloadAgentConfig() {
+  if (agent_config == NULL) {
+    return OIDC_SUCCESS;
+  }
+  cJSON* json = tryReadConfig();
+  if (json == NULL && oidc_errno != OIDC_SUCCESS) {
+    return oidc_errno;
+  }
+  char* agent_json = json ? getJSONValue(json, CONFIG_KEY_AGENT) : NULL;
+  secFreeJson(json);
+  agent_config_t* c = _getAgentConfig(agent_json, 0);
+  secFree(agent_json);
+  if (c == NULL) {
+    return oidc_errno;
+  }
+  // bind_address and group are only used on startup and might still be
+  // referenced, so they are kept
+  secFree(c->bind_address);
+  secFree(c->group);
+  c->bind_address = agent_config->bind_address;
+  c->group        = agent_config->group;
+  secFree(agent_config->cert_path);
+  secFree(agent_config->state_snapshot_key_cmd);
+  *agent_config = *c;
+  secFree(c);
+  return OIDC_SUCCESS;
+}
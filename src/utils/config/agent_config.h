@@ -3,6 +3,8 @@
 
 #include <time.h>
 
+#include "utils/oidc_error.h"
+
 #define AGENTCONFIG_AUTOGENSCOPEMODE_ALL 0
 #define AGENTCONFIG_AUTOGENSCOPEMODE_EXACT 1
 #define AGENTCONFIG_AUTOGENSCOPEMODE_RESERVED 2
@@ -23,12 +25,31 @@ struct agent_config {
   unsigned char stats_collect : 1;
   unsigned char stats_collect_share : 1;
   unsigned char stats_collect_location : 1;
+  unsigned char http_dns_cache_ttl_set : 1;
+  unsigned char http_conn_max_idle_set : 1;
+  unsigned char stale_token_min_valid_set : 1;
+  unsigned char kernel_keyring : 1;
+  unsigned char state_snapshot : 1;
+  unsigned char state_snapshot_interval_set : 1;
   time_t        lifetime;
   char*         group;
+  long          http_dns_cache_ttl;
+  long          http_conn_max_idle;
+  long          stale_token_min_valid;
+  long          max_loaded_accounts;        // 0 for no cap
+  long          max_loaded_accounts_bytes;  // 0 for no cap
+  long          state_snapshot_interval;    // 0 for only on shutdown
+  char*         state_snapshot_key_cmd;
 };
 
 typedef struct agent_config agent_config_t;
 
 const agent_config_t* getAgentConfig();
+/**
+ * @brief re-reads the agent config if it was already loaded
+ * @note @c bind_address and @c group are only read once
+ * @return an error code; on error the current config is kept
+ */
+oidc_error_t reloadAgentConfig();
 
 #endif  // OIDC_AGENT_AGENT_CONFIG_H
@@ -39,7 +39,7 @@ static char* readGlobalConfig() {
   return data;
 }
 
-cJSON* readConfig() {
+static cJSON* _readConfig(unsigned char exitOnError) {
   char* global = readGlobalConfig();
   char* user   = readUserConfig();
   if (!strValid(global)) {
@@ -49,32 +49,54 @@ cJSON* readConfig() {
     secFree(user);
   }
   if (global == NULL && user == NULL) {
+    oidc_errno = OIDC_SUCCESS;
     return NULL;
   }
-  cJSON* g = stringToJson(global);
-  cJSON* u = stringToJson(user);
+  markPublicMem(global);
+  markPublicMem(user);
+  cJSON* g = publicStringToJson(global);
+  cJSON* u = publicStringToJson(user);
   secFree(global);
   secFree(user);
   if (u == NULL) {
     if (oidc_errno == OIDC_EJSONPARS) {
+      if (!exitOnError) {
+        secFreeJson(g);
+        return NULL;
+      }
       printError("error in user configuration file: %s\n", oidc_serror());
       exit(oidc_errno);
     }
+    oidc_errno = OIDC_SUCCESS;
     return g;
   }
   if (g == NULL) {
     if (oidc_errno == OIDC_EJSONPARS) {
+      if (!exitOnError) {
+        secFreeJson(u);
+        return NULL;
+      }
       printError("error in global configuration file: %s\n", oidc_serror());
       exit(oidc_errno);
     }
+    oidc_errno = OIDC_SUCCESS;
     return u;
   }
   cJSON* c = jsonMergePatch(g, u);
   secFreeJson(g);
   secFreeJson(u);
   if (c == NULL) {
+    if (!exitOnError) {
+      oidc_errno = OIDC_EJSONMERGE;
+      return NULL;
+    }
     printError("error while merging global and user config\n");
     exit(EXIT_FAILURE);
   }
+  oidc_errno = OIDC_SUCCESS;
   return c;
 }
+
+cJSON* readConfig() { return _readConfig(1); }
+
+cJSON* tryReadConfig() { return _readConfig(0); }
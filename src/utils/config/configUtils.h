@@ -4,5 +4,11 @@
 #include "wrapper/cjson.h"
 
 cJSON* readConfig();
+/**
+ * @brief reads the config like @c readConfig but does not exit on errors
+ * @return the config or @c NULL; if @c NULL is returned and @c oidc_errno is
+ * not @c OIDC_SUCCESS the config could not be parsed
+ */
+cJSON* tryReadConfig();
 
 #endif  // OIDC_AGENT_CONFIGUTILS_H
@@ -24,7 +24,8 @@ void _secFreeGenConfig(gen_config_t* c) {
 
 static gen_config_t* gen_config = NULL;
 
-static gen_config_t* _getGenConfig(const char* json) {
+static gen_config_t* _getGenConfig(const char*   json,
+                                   unsigned char exitOnError) {
   if (NULL == json) {
     return secAlloc(sizeof(gen_config_t));
   }
@@ -38,6 +39,9 @@ static gen_config_t* _getGenConfig(const char* json) {
   if (getJSONValuesFromString(json, pairs, sizeof(pairs) / sizeof(*pairs)) <
       0) {
     SEC_FREE_KEY_VALUES();
+    if (!exitOnError) {
+      return NULL;
+    }
     oidc_perror();
     exit(oidc_errno);
   }
@@ -64,6 +68,16 @@ static gen_config_t* _getGenConfig(const char* json) {
       printError("error in oidc-gen config: config attribute '%s' cannot have "
                  "value '%s'\n",
                  CONFIG_KEY_ANSWERCONFIRMPROMPTS, _answer_confirm_prompts);
+      if (!exitOnError) {
+        secFree(_answer_confirm_prompts);
+        secFree(_default_mytoken_server);
+        secFree(_default_mytoken_profile);
+        secFree(_prefer_mytoken_over_oidc);
+        secFree(_debug);
+        _secFreeGenConfig(c);
+        oidc_errno = OIDC_EBADCONFIG;
+        return NULL;
+      }
       exit(EXIT_FAILURE);
     }
   }
@@ -93,7 +107,27 @@ const gen_config_t* getGenConfig() {
     oidc_perror();
     exit(oidc_errno);
   }
-  gen_config = _getGenConfig(gen_json);
+  gen_config = _getGenConfig(gen_json, 1);
   secFree(gen_json);
   return gen_config;
 }
+
+oidc_error_t reloadGenConfig() {
+  if (gen_config == NULL) {
+    return OIDC_SUCCESS;
+  }
+  cJSON* json = tryReadConfig();
+  if (json == NULL && oidc_errno != OIDC_SUCCESS) {
+    return oidc_errno;
+  }
+  char* gen_json = json ? getJSONValue(json, CONFIG_KEY_GEN) : NULL;
+  secFreeJson(json);
+  gen_config_t* c = _getGenConfig(gen_json, 0);
+  secFree(gen_json);
+  if (c == NULL) {
+    return oidc_errno;
+  }
+  _secFreeGenConfig(gen_config);
+  gen_config = c;
+  return OIDC_SUCCESS;
+}
@@ -1,6 +1,8 @@
 #ifndef OIDC_AGENT_GEN_CONFIG_H
 #define OIDC_AGENT_GEN_CONFIG_H
 
+#include "utils/oidc_error.h"
+
 #define CONFIRM_PROMPT_MODE_UNSET 0
 #define CONFIRM_PROMPT_MODE_DEFAULT 1
 #define CONFIRM_PROMPT_MODE_NO 2
@@ -22,5 +24,10 @@ struct gen_config {
 typedef struct gen_config gen_config_t;
 
 const gen_config_t* getGenConfig();
+/**
+ * @brief re-reads the gen config if it was already loaded
+ * @return an error code; on error the current config is kept
+ */
+oidc_error_t reloadGenConfig();
 
 #endif  // OIDC_AGENT_GEN_CONFIG_H
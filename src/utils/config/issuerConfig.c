@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include "issuerConfig.h"
 
 #include <stdlib.h>
@@ -7,9 +8,11 @@
 #include "defines/ipc_values.h"
 #include "defines/oidc_values.h"
 #include "defines/settings.h"
+#include "utils/config/accountIndex.h"
 #include "utils/file_io/fileUtils.h"
 #include "utils/file_io/file_io.h"
 #include "utils/file_io/oidc_file_io.h"
+#include "utils/hashmap.h"
 #include "utils/json.h"
 #include "utils/listUtils.h"
 #include "utils/matcher.h"
@@ -160,42 +163,75 @@ cJSON* issuerConfigToJSON(const struct issuerConfig* c) {
   return json;
 }
 
-static cJSON* collection = NULL;
+/**
+ * @brief returns the key under which an issuer is stored in the issuer index
+ * @note issuer urls that only differ in a trailing slash share the same key
+ * (see @c compIssuerUrls)
+ * @return the normalized issuer url; has to be freed after usage
+ */
+static char* issuerKey(const char* iss) {
+  size_t len = strlen(iss);
+  if (len > 0 && iss[len - 1] == '/') {
+    len--;
+  }
+  return oidc_strncopy(iss, len);
+}
 
+// issuer objects in the order they were first read and an index (normalized
+// issuer url -> element of collection) to merge later sources in one pass
+static cJSON*     collection       = NULL;
+static hashmap_t* collection_index = NULL;
+
+/**
+ * @brief adds an issuer object to the collection; takes ownership of @p j
+ * @note values from earlier sources take precedence over later ones
+ */
 static void collect_handleObject(cJSON* j) {
-  char*  iss    = getJSONValue(j, OIDC_KEY_ISSUER);
-  cJSON* parent = cJSON_CreateObject();
-  cJSON_AddItemReferenceToObject(parent, iss, j);
+  char* iss = getJSONValue(j, OIDC_KEY_ISSUER);
+  if (iss == NULL) {
+    secFreeJson(j);
+    return;
+  }
+  char* key = issuerKey(iss);
   secFree(iss);
-  cJSON* tmp = jsonMergePatch(parent, collection);
-  secFreeJson(parent);
-  secFreeJson(collection);
-  collection = tmp;
+  if (collection == NULL) {
+    collection = cJSON_CreateArray();
+  }
+  cJSON* existing = hashmap_get(collection_index, key);
+  if (existing == NULL) {
+    cJSON_AddItemToArray(collection, j);
+    hashmap_put(collection_index, key, j);
+  } else {
+    cJSON* merged = jsonMergePatch(j, existing);
+    secFreeJson(j);
+    cJSON_ReplaceItemViaPointer(collection, existing, merged);
+    hashmap_put(collection_index, key, merged);
+  }
+  secFree(key);
 }
 
 static void collectJSONIssuers(const char* json) {
   if (json == NULL) {
     return;
   }
-  if (collection == NULL) {
-    collection = cJSON_CreateObject();
-  }
-  cJSON* j = cJSON_Parse(json);
+  cJSON* j = publicStringToJson(json);
   if (j == NULL) {
     return;
   }
   if (cJSON_IsObject(j)) {
     collect_handleObject(j);
-  } else if (cJSON_IsArray(j)) {
-    j = j->child;
-    while (j) {
-      collect_handleObject(j);
-      j = j->next;
+    return;
+  }
+  if (cJSON_IsArray(j)) {
+    while (j->child) {
+      collect_handleObject(cJSON_DetachItemViaPointer(j, j->child));
     }
   }
+  secFreeJson(j);
 }
 
-static list_t* _issuers = NULL;
+static list_t*    _issuers      = NULL;
+static hashmap_t* _issuer_index = NULL;  // normalized url -> issuerConfig
 
 static int issuerConfig_matchByIssuerUrl(const struct issuerConfig* c1,
                                          const struct issuerConfig* c2) {
@@ -236,13 +272,26 @@ static list_t* assert_issuers() {
     _issuers        = list_new();
     _issuers->free  = (freeFunction)_secFreeIssuerConfig;
     _issuers->match = (matchFunction)issuerConfig_matchByIssuerUrl;
+    _issuer_index   = hashmap_new(0, NULL);
   }
   return _issuers;
 }
 
+static void indexIssuerConfig(struct issuerConfig* c) {
+  if (c == NULL || c->issuer == NULL) {
+    return;
+  }
+  char* key = issuerKey(c->issuer);
+  if (!hashmap_contains(_issuer_index, key)) {
+    hashmap_put(_issuer_index, key, c);
+  }
+  secFree(key);
+}
+
 static char* updateIssuerConfigFileFormat(char* content) {
   cJSON* iss_list_json = cJSON_CreateArray();
-  char*  elem          = strtok(content, "\n");
+  char*  saveptr       = NULL;
+  char*  elem          = strtok_r(content, "\n", &saveptr);
   while (elem != NULL) {
     char* space = strchr(elem, ' ');
     if (space) {
@@ -257,22 +306,56 @@ static char* updateIssuerConfigFileFormat(char* content) {
     };
     cJSON_AddItemToArray(iss_list_json, issuerConfigToJSON(&this_config));
     secFreeList(accounts);
-    elem = strtok(NULL, "\n");
+    elem = strtok_r(NULL, "\n", &saveptr);
   }
   secFree(content);
   char* new_content = jsonToString(iss_list_json);
   secFreeJson(iss_list_json);
+  markPublicMem(new_content);
   writeOidcFile(ISSUER_CONFIG_FILENAME, new_content);
   return new_content;
 }
 
-static void readIssuerConfigs() {
+// the content of all issuer config sources as "<path>\n<content>" in the order
+// they were read; the first one is the user's issuer.config. Reloading is
+// skipped if none of them changed, e.g. after the agent wrote issuer.config
+// itself.
+static list_t* _sources = NULL;
+
+/**
+ * @brief adds a source to @p sources; takes ownership of @p content
+ */
+static void addSource(list_t* sources, const char* path, char* content) {
+  char* source = oidc_sprintf("%s\n%s", path, content ?: "");
+  markPublicMem(source);
+  list_rpush(sources, list_node_new(source));
+  secFree(content);
+}
+
+static void addSourceDir(list_t* sources, list_t* conf_list,
+                         char* (*readFunc)(const char*)) {
+  if (conf_list == NULL) {
+    return;
+  }
+  list_iterator_t* it = list_iterator_new(conf_list, LIST_HEAD);
+  list_node_t*     node;
+  while ((node = list_iterator_next(it))) {
+    addSource(sources, node->val, readFunc(node->val));
+  }
+  list_iterator_destroy(it);
+  secFreeList(conf_list);
+}
+
+static list_t* readIssuerSources() {
+  list_t* sources = list_new();
+  sources->free   = (void (*)(void*)) & _secFree;
+
   char* content = readOidcFile(ISSUER_CONFIG_FILENAME);
-  if (!isJSONArray(content)) {  // old config file
+  markPublicMem(content);
+  if (content != NULL && !isJSONArray(content)) {  // old config file
     content = updateIssuerConfigFileFormat(content);
   }
-  collectJSONIssuers(content);
-  secFree(content);
+  addSource(sources, ISSUER_CONFIG_FILENAME, content);
 
   char*   oidcIssuerConfDir = concatToOidcDir(ISSUER_CONFIG_DIRNAME);
   list_t* conf_list =
@@ -280,26 +363,16 @@ static void readIssuerConfigs() {
   secFree(oidcIssuerConfDir);
   if (conf_list) {
     list_mergeSort(conf_list, (matchFunction)compareOidcFilesByDateModified);
-    list_iterator_t* it = list_iterator_new(conf_list, LIST_HEAD);
-    list_node_t*     node;
-    while ((node = list_iterator_next(it))) {
-      content = readOidcFile(node->val);
-      collectJSONIssuers(content);
-      secFree(content);
-    }
-    secFreeList(conf_list);
-    list_iterator_destroy(it);
   }
+  addSourceDir(sources, conf_list, readOidcFile);
 
-  content = readFile(
+  const char* etc_iss_file =
 #ifdef ANY_MSYS
-      ETC_ISSUER_CONFIG_FILE()
+      ETC_ISSUER_CONFIG_FILE();
 #else
-      ETC_ISSUER_CONFIG_FILE
+      ETC_ISSUER_CONFIG_FILE;
 #endif
-  );
-  collectJSONIssuers(content);
-  secFree(content);
+  addSource(sources, etc_iss_file, readFile(etc_iss_file));
 
   const char* etc_iss_dir =
 #ifdef ANY_MSYS
@@ -307,28 +380,136 @@ static void readIssuerConfigs() {
 #else
       ETC_ISSUER_CONFIG_DIR;
 #endif
-  conf_list = getFileListForDir(etc_iss_dir, etc_iss_dir);
-  if (conf_list) {
-    list_iterator_t* it = list_iterator_new(conf_list, LIST_HEAD);
-    list_node_t*     node;
-    while ((node = list_iterator_next(it))) {
-      content = readFile(node->val);
+  addSourceDir(sources, getFileListForDir(etc_iss_dir, etc_iss_dir),
+               readFile);
+  return sources;
+}
+
+static int sameSources(list_t* a, list_t* b) {
+  if (a == NULL || b == NULL || a->len != b->len) {
+    return 0;
+  }
+  for (list_node_t *na = a->head, *nb = b->head; na && nb;
+       na = na->next, nb = nb->next) {
+    if (!strequal(na->val, nb->val)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * @brief remembers @p content as the content of the user's issuer.config, so
+ * that the agent's own writes do not trigger a reload
+ */
+static void setOwnIssuerConfigSource(const char* content) {
+  if (_sources == NULL || _sources->len == 0) {
+    return;
+  }
+  list_node_t* node = _sources->head;
+  secFree(node->val);
+  node->val = oidc_sprintf("%s\n%s", ISSUER_CONFIG_FILENAME, content ?: "");
+  markPublicMem(node->val);
+}
+
+/**
+ * @brief parses the issuer configs of @p sources
+ * @return a list of the merged issuer configs
+ */
+static list_t* parseIssuerSources(list_t* sources) {
+  collection_index    = hashmap_new(0, NULL);
+  list_iterator_t* it = list_iterator_new(sources, LIST_HEAD);
+  list_node_t*     node;
+  while ((node = list_iterator_next(it))) {
+    const char* content = strchr(node->val, '\n') + 1;
+    if (strValid(content)) {
       collectJSONIssuers(content);
-      secFree(content);
     }
-    secFreeList(conf_list);
-    list_iterator_destroy(it);
   }
+  list_iterator_destroy(it);
+  secFreeHashmap(collection_index);
 
-  cJSON* item = collection->child;
-  do {
+  list_t* configs = list_new();
+  configs->free   = (freeFunction)_secFreeIssuerConfig;
+  if (collection == NULL) {
+    return configs;
+  }
+  for (cJSON* item = collection->child; item; item = item->next) {
     struct issuerConfig* issConfig = getIssuerConfigFromJSON(item);
-    list_lpush(assert_issuers(), list_node_new(issConfig));
-    item = item->next;
-  } while (item);
+    if (issConfig != NULL) {
+      list_rpush(configs, list_node_new(issConfig));
+    }
+  }
   secFreeJson(collection);
-  list_mergeSort(assert_issuers(),
-                 (matchFunction)issuerConfig_compByAccountCount);
+  return configs;
+}
+
+static int sameIssuerConfig(const struct issuerConfig* a,
+                            const struct issuerConfig* b) {
+  cJSON* a_json = issuerConfigToJSON(a);
+  cJSON* b_json = issuerConfigToJSON(b);
+  char*  a_str  = jsonToStringUnformatted(a_json);
+  char*  b_str  = jsonToStringUnformatted(b_json);
+  int    same   = strequal(a_str, b_str);
+  secFreeJson(a_json);
+  secFreeJson(b_json);
+  secFree(a_str);
+  secFree(b_str);
+  return same;
+}
+
+/**
+ * @brief applies the parsed issuer configs to the loaded ones: unchanged
+ * configs are kept, changed configs are updated in place, so that pointers
+ * returned by @c getIssuerConfig stay valid, and configs that are gone are
+ * removed
+ * @param configs the parsed configs; they are consumed
+ */
+static void applyIssuerConfigs(list_t* configs) {
+  hashmap_t* seen = hashmap_new(configs->len, NULL);
+  while (configs->len > 0) {
+    list_node_t*         node = list_lpop(configs);
+    struct issuerConfig* c    = node->val;
+    LIST_FREE(node);
+    char* key = issuerKey(c->issuer);
+    hashmap_put(seen, key, NULL);
+    struct issuerConfig* old = hashmap_get(_issuer_index, key);
+    secFree(key);
+    if (old == NULL) {
+      list_lpush(_issuers, list_node_new(c));
+      indexIssuerConfig(c);
+      continue;
+    }
+    if (!sameIssuerConfig(old, c)) {
+      struct issuerConfig tmp = *old;
+      *old                    = *c;
+      *c                      = tmp;
+    }
+    secFreeIssuerConfig(c);
+  }
+  list_destroy(configs);
+
+  list_iterator_t* it = list_iterator_new(_issuers, LIST_HEAD);
+  list_node_t*     node;
+  while ((node = list_iterator_next(it))) {
+    struct issuerConfig* c   = node->val;
+    char*                key = issuerKey(c->issuer);
+    if (!hashmap_contains(seen, key)) {
+      if (hashmap_get(_issuer_index, key) == c) {
+        hashmap_remove(_issuer_index, key);
+      }
+      list_remove(_issuers, node);
+    }
+    secFree(key);
+  }
+  list_iterator_destroy(it);
+  secFreeHashmap(seen);
+  list_mergeSort(_issuers, (matchFunction)issuerConfig_compByAccountCount);
+}
+
+static void readIssuerConfigs() {
+  _sources = readIssuerSources();
+  applyIssuerConfigs(parseIssuerSources(_sources));
 }
 
 static list_t* issuers() {
@@ -339,6 +520,20 @@ static list_t* issuers() {
   return _issuers;
 }
 
+void reloadIssuerConfigs() {
+  if (_issuers == NULL) {  // not loaded yet
+    return;
+  }
+  list_t* sources = readIssuerSources();
+  if (sameSources(sources, _sources)) {
+    secFreeList(sources);
+    return;
+  }
+  secFreeList(_sources);
+  _sources = sources;
+  applyIssuerConfigs(parseIssuerSources(_sources));
+}
+
 list_t* getSuggestableIssuers() {
   list_t* suggestions   = list_new();
   suggestions->match    = (matchFunction)matchUrls;
@@ -354,14 +549,19 @@ list_t* getSuggestableIssuers() {
   return suggestions;
 }
 
-list_node_t* getIssuerNode(const char* iss) {
-  struct issuerConfig key = {.issuer = (char*)iss};
-  return findInList(issuers(), &key);
+static struct issuerConfig* findIssuerConfig(const char* iss) {
+  if (iss == NULL) {
+    return NULL;
+  }
+  issuers();
+  char*                key = issuerKey(iss);
+  struct issuerConfig* c   = hashmap_get(_issuer_index, key);
+  secFree(key);
+  return c;
 }
 
 const struct issuerConfig* getIssuerConfig(const char* iss) {
-  const list_node_t* node = getIssuerNode(iss);
-  return node ? node->val : NULL;
+  return findIssuerConfig(iss);
 }
 
 list_t* defaultRedirectURIs() {
@@ -384,14 +584,15 @@ void oidcp_updateIssuerConfigAdd(const char* issuer_url,
   if (issuer_url == NULL || shortname == NULL) {
     return;
   }
-  list_node_t* node = getIssuerNode(issuer_url);
-  if (node == NULL) {
-    struct issuerConfig* c = secAlloc(sizeof(struct issuerConfig));
-    c->issuer              = oidc_strcopy(issuer_url);
-    c->accounts            = newListWithSingleValue(shortname);
+  accountIndex_update(shortname, issuer_url, NULL);
+  struct issuerConfig* c = findIssuerConfig(issuer_url);
+  if (c == NULL) {
+    c           = secAlloc(sizeof(struct issuerConfig));
+    c->issuer   = oidc_strcopy(issuer_url);
+    c->accounts = newListWithSingleValue(shortname);
     list_rpush(issuers(), list_node_new(c));
+    indexIssuerConfig(c);
   } else {
-    struct issuerConfig* c = node->val;
     if (c->accounts) {
       if (findInList(c->accounts, shortname)) {
         return;
@@ -405,7 +606,9 @@ void oidcp_updateIssuerConfigAdd(const char* issuer_url,
       listToJSONArray(issuers(), (cJSON * (*)(void*)) issuerConfigToJSON);
   char* new_content = jsonToString(iss_list_json);
   secFreeJson(iss_list_json);
+  markPublicMem(new_content);
   writeOidcFile(ISSUER_CONFIG_FILENAME, new_content);
+  setOwnIssuerConfigSource(new_content);
   secFree(new_content);
 }
 
@@ -421,18 +624,19 @@ void oidcp_updateIssuerConfigDelete(const char* issuer_url,
   if (issuer_url == NULL || shortname == NULL) {
     return;
   }
-  list_node_t* node = getIssuerNode(issuer_url);
-  if (node == NULL) {
+  accountIndex_remove(shortname);
+  struct issuerConfig* c = findIssuerConfig(issuer_url);
+  if (c == NULL) {
     return;
-  } else {
-    struct issuerConfig* c = node->val;
-    list_removeIfFound(c->accounts, (char*)shortname);
   }
+  list_removeIfFound(c->accounts, (char*)shortname);
   cJSON* iss_list_json =
       listToJSONArray(issuers(), (cJSON * (*)(void*)) issuerConfigToJSON);
   char* new_content = jsonToString(iss_list_json);
   secFreeJson(iss_list_json);
+  markPublicMem(new_content);
   writeOidcFile(ISSUER_CONFIG_FILENAME, new_content);
+  setOwnIssuerConfigSource(new_content);
   secFree(new_content);
 }
 
@@ -469,6 +673,38 @@ const list_t* getPubClientFlows(const char* issuer_url) {
   return pub->flows;
 }
 
+struct account_infos {
+  cJSON*  json;
+  list_t* loaded;
+};
+
+// Adds the indexed accounts that issuer.config does not list
+static void addIndexedAccountInfo(const struct accountIndexEntry* e,
+                                  void*                           arg) {
+  struct account_infos*      infos = arg;
+  const struct issuerConfig* c     = getIssuerConfig(e->issuer_url);
+  const char*                iss   = c ? c->issuer : e->issuer_url;
+
+  cJSON* issObj = cJSON_GetObjectItemCaseSensitive(infos->json, iss);
+  if (issObj == NULL) {
+    issObj = cJSON_CreateObject();
+    cJSON_AddBoolToObject(issObj, ACCOUNTINFO_KEY_HASPUBCLIENT,
+                          c != NULL && c->pub_client != NULL &&
+                              c->pub_client->client_id != NULL);
+    cJSON_AddItemToObject(infos->json, iss, issObj);
+  }
+  cJSON* accounts =
+      cJSON_GetObjectItemCaseSensitive(issObj, AGENT_KEY_ACCOUNTS);
+  if (accounts == NULL) {
+    accounts = cJSON_CreateObject();
+    cJSON_AddItemToObject(issObj, AGENT_KEY_ACCOUNTS, accounts);
+  }
+  if (!cJSON_HasObjectItem(accounts, e->shortname)) {
+    cJSON_AddBoolToObject(accounts, e->shortname,
+                          findInList(infos->loaded, e->shortname) != NULL);
+  }
+}
+
 char* getAccountInfos(list_t* loaded) {
   cJSON*           json = cJSON_CreateObject();
   list_iterator_t* it   = list_iterator_new(issuers(), LIST_HEAD);
@@ -500,6 +736,8 @@ char* getAccountInfos(list_t* loaded) {
     cJSON_AddItemToObject(json, c->issuer, issObj);
   }
   list_iterator_destroy(it);
+  struct account_infos infos = {.json = json, .loaded = loaded};
+  accountIndex_foreach(addIndexedAccountInfo, &infos);
   char* json_str = jsonToStringUnformatted(json);
   secFreeJson(json);
   return json_str;
@@ -38,6 +38,7 @@ list_t*                    defaultRedirectURIs();
 void  oidcp_updateIssuerConfig(const char* action, const char* issuer,
                                const char* shortname);
 char* getAccountInfos(list_t* loaded);
+void  reloadIssuerConfigs();
 
 #ifndef secFreeIssuerConfig
 #define secFreeIssuerConfig(ptr) \
@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include "cryptUtils.h"
 
 #include <string.h>
@@ -35,10 +36,11 @@ char* decryptFileContent(const char* fileContent, const char* password) {
  */
 char* decryptHexFileContent(const char* cipher, const char* password) {
   char*         fileText       = oidc_strcopy(cipher);
-  unsigned long cipher_len     = strToInt(strtok(fileText, ":"));
-  char*         salt_encoded   = strtok(NULL, ":");
-  char*         nonce_encoded  = strtok(NULL, ":");
-  char*         cipher_encoded = strtok(NULL, ":");
+  char*         saveptr        = NULL;
+  unsigned long cipher_len     = strToInt(strtok_r(fileText, ":", &saveptr));
+  char*         salt_encoded   = strtok_r(NULL, ":", &saveptr);
+  char*         nonce_encoded  = strtok_r(NULL, ":", &saveptr);
+  char*         cipher_encoded = strtok_r(NULL, ":", &saveptr);
   if (cipher_len == 0 || salt_encoded == NULL || nonce_encoded == NULL ||
       cipher_encoded == NULL) {
     oidc_errno = OIDC_ECRYPM;
@@ -90,6 +90,7 @@ struct oidc_account* _db_decryptFoundAccount(struct oidc_account* account) {
   if (account == NULL) {
     return NULL;
   }
+  account_setLastUsed(account, time(NULL));
   char* tmp = memoryDecrypt(account_getRefreshToken(account));
   if (tmp != NULL) {
     account_setRefreshToken(account, tmp);
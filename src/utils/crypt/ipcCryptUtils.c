@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include "ipcCryptUtils.h"
 
 #include <string.h>
@@ -26,10 +27,11 @@ char* decryptForIpc(const char* msg, const unsigned char* key) {
     oidc_setArgNullFuncError(__func__);
     return NULL;
   }
+  char*  saveptr          = NULL;
   char*  msg_tmp          = oidc_strcopy(msg);
-  char*  len_str          = strtok(msg_tmp, ":");
-  char*  nonce_base64     = strtok(NULL, ":");
-  char*  encrypted_base64 = strtok(NULL, ":");
+  char*  len_str          = strtok_r(msg_tmp, ":", &saveptr);
+  char*  nonce_base64     = strtok_r(NULL, ":", &saveptr);
+  char*  encrypted_base64 = strtok_r(NULL, ":", &saveptr);
   size_t msg_len          = strToULong(len_str);
   if (nonce_base64 == NULL || encrypted_base64 == NULL) {
     secFree(msg_tmp);
@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include "memoryCrypt.h"
 
 #include <sodium.h>
@@ -42,8 +43,9 @@ char* memoryDecrypt(const char* cipher) {
   }
   // logger(DEBUG, "memory decryption '%s'", cipher);
   char*  tmp           = oidc_strcopy(cipher);
-  size_t len           = strToInt(strtok(tmp, ":"));
-  char*  cipher_base64 = strtok(NULL, ":");
+  char*  saveptr       = NULL;
+  size_t len           = strToInt(strtok_r(tmp, ":", &saveptr));
+  char*  cipher_base64 = strtok_r(NULL, ":", &saveptr);
   if (len == 0 || cipher_base64 == NULL) {
     secFree(tmp);
     oidc_errno = OIDC_ECRYPM;
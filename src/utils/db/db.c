@@ -8,8 +8,11 @@
 static list_t* dbs = NULL;
 
 struct oidc_db {
-  db_name db;
-  list_t* list;
+  db_name          db;
+  list_t*          list;
+  struct db_limits limits;
+  size_t           expired;
+  size_t           evicted;
 };
 
 int matchDBs(const struct oidc_db* a, const struct oidc_db* b) {
@@ -32,6 +35,95 @@ list_node_t* _getDBNode(const db_name db) {
   return findInList(dbs, &key);
 }
 
+static struct oidc_db* _getDBStruct(const db_name db) {
+  list_node_t* node = _getDBNode(db);
+  return node ? node->val : NULL;
+}
+
+static int _isLimited(const struct oidc_db* db_s) {
+  return db_s->limits.max_entries || db_s->limits.max_bytes ||
+         db_s->limits.deathGetter;
+}
+
+/**
+ * @brief returns the bytes the entries of a db use; entries can change their
+ * size while they are stored, so it is not kept up to date
+ */
+static size_t _totalBytes(const struct oidc_db* db_s) {
+  if (db_s->limits.sizeGetter == NULL) {
+    return 0;
+  }
+  size_t           bytes = 0;
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(db_s->list, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    bytes += db_s->limits.sizeGetter(node->val);
+  }
+  list_iterator_destroy(it);
+  return bytes;
+}
+
+/**
+ * @brief removes a node from a db; if @p evict is set, the evict function of
+ * the db is called first
+ */
+static void _removeNode(struct oidc_db* db_s, list_node_t* node,
+                        unsigned char evict) {
+  if (evict && db_s->limits.evict) {
+    db_s->limits.evict(node->val);
+  }
+  list_remove(db_s->list, node);
+}
+
+/**
+ * @brief moves a node to the tail of the db, so that the head is the least
+ * recently used entry; the node is relinked, so it stays valid
+ */
+static void _touchNode(struct oidc_db* db_s, list_node_t* node) {
+  list_t* list = db_s->list;
+  if (node == list->tail) {
+    return;
+  }
+  node->prev ? (node->prev->next = node->next) : (list->head = node->next);
+  node->next->prev = node->prev;
+  node->prev       = list->tail;
+  node->next       = NULL;
+  list->tail->next = node;
+  list->tail       = node;
+}
+
+/**
+ * @brief returns the least recently used entry that might be evicted; the
+ * newest entry is never evicted
+ */
+static list_node_t* _evictionCandidate(const struct oidc_db* db_s) {
+  list_node_t* node = db_s->list->head;
+  while (node != NULL && node != db_s->list->tail) {
+    if (db_s->limits.canEvict == NULL || db_s->limits.canEvict(node->val)) {
+      return node;
+    }
+    node = node->next;
+  }
+  return NULL;
+}
+
+static void _evictOverLimits(struct oidc_db* db_s) {
+  const struct db_limits* l     = &db_s->limits;
+  size_t                  bytes = l->max_bytes ? _totalBytes(db_s) : 0;
+  list_node_t*            node;
+  while (((l->max_entries && db_s->list->len > l->max_entries) ||
+          (l->max_bytes && bytes > l->max_bytes)) &&
+         (node = _evictionCandidate(db_s)) != NULL) {
+    logger(DEBUG, "Evicting least recently used entry from db %hhu",
+           db_s->db);
+    if (l->max_bytes) {
+      bytes -= l->sizeGetter(node->val);
+    }
+    _removeNode(db_s, node, 1);
+    db_s->evicted++;
+  }
+}
+
 list_t* db_getDB(const db_name db) {
   list_node_t* found = _getDBNode(db);
   if (found == NULL) {
@@ -76,11 +168,22 @@ freeFunction db_setFreeFunction(const db_name db, void (*free_fn)(void*)) {
 }
 
 void db_removeIfFound(const db_name db, void* value) {
-  list_removeIfFound(db_getDB(db), value);
+  struct oidc_db* db_s = _getDBStruct(db);
+  if (db_s == NULL || value == NULL) {
+    return;
+  }
+  list_node_t* node = findInList(db_s->list, value);
+  if (node != NULL) {
+    _removeNode(db_s, node, 0);
+  }
 }
 
 void db_addValue(const db_name db, void* value) {
-  list_rpush(db_getDB(db), list_node_new(value));
+  struct oidc_db* db_s = _getDBStruct(db);
+  list_rpush(db_s->list, list_node_new(value));
+  if (!db_s->limits.deferred_evict) {
+    _evictOverLimits(db_s);
+  }
   logger(DEBUG, "Added value to db %hhu. Now there are %lu entries.", db,
          db_getSize(db));
 }
@@ -92,7 +195,15 @@ size_t db_getSize(const db_name db) {
 
 void* db_findValue(const db_name db, void* key) {
   list_node_t* node = findInList(db_getDB(db), key);
-  return node ? node->val : NULL;
+  if (node == NULL) {
+    return NULL;
+  }
+  void*           value = node->val;
+  struct oidc_db* db_s  = _getDBStruct(db);
+  if (_isLimited(db_s)) {
+    _touchNode(db_s, node);
+  }
+  return value;
 }
 
 list_t* db_findAllValues(const db_name db, void* key) {
@@ -129,3 +240,88 @@ time_t db_getMinDeath(const db_name db, time_t (*deathGetter)(void*)) {
 void* db_getDeathEntry(const db_name db, time_t (*deathGetter)(void*)) {
   return getDeathElementFrom(db_getDB(db), deathGetter);
 }
+
+/**
+ * @brief sets the limits of a db; unless eviction is deferred, entries over
+ * the new caps are evicted
+ */
+void db_setLimits(const db_name db, struct db_limits limits) {
+  db_init();
+  struct oidc_db* db_s = _getDBStruct(db);
+  if (db_s == NULL) {
+    db_newDB(db);
+    db_s = _getDBStruct(db);
+  }
+  db_s->limits = limits;
+  if (!limits.deferred_evict) {
+    _evictOverLimits(db_s);
+  }
+}
+
+/**
+ * @brief evicts the least recently used entries of a db until it is within
+ * its caps; for dbs with deferred eviction this must be called when none of
+ * the entries is in use
+ */
+void db_evictOverLimits(const db_name db) {
+  struct oidc_db* db_s = _getDBStruct(db);
+  if (db_s != NULL) {
+    _evictOverLimits(db_s);
+  }
+}
+
+/**
+ * @brief removes the entries of a db whose time to live is over
+ */
+void db_removeExpired(const db_name db) {
+  struct oidc_db* db_s = _getDBStruct(db);
+  if (db_s == NULL || db_s->limits.deathGetter == NULL) {
+    return;
+  }
+  time_t           now = time(NULL);
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(db_s->list, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    time_t death = db_s->limits.deathGetter(node->val);
+    if (death > 0 && death <= now) {
+      logger(DEBUG, "Removing expired entry from db %hhu", db);
+      _removeNode(db_s, node, 1);
+      db_s->expired++;
+    }
+  }
+  list_iterator_destroy(it);
+}
+
+/**
+ * @brief returns the time when the next entry of a db expires, @c 0 if none
+ * expires
+ */
+time_t db_getNextExpiry(const db_name db) {
+  struct oidc_db* db_s = _getDBStruct(db);
+  if (db_s == NULL || db_s->limits.deathGetter == NULL) {
+    return 0;
+  }
+  time_t           next = 0;
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(db_s->list, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    time_t death = db_s->limits.deathGetter(node->val);
+    if (death > 0 && (next == 0 || death < next)) {
+      next = death;
+    }
+  }
+  list_iterator_destroy(it);
+  return next;
+}
+
+struct db_stats db_getStats(const db_name db) {
+  struct db_stats       stats = {0, 0, 0, 0};
+  const struct oidc_db* db_s  = _getDBStruct(db);
+  if (db_s != NULL) {
+    stats.entries = db_s->list->len;
+    stats.bytes   = _totalBytes(db_s);
+    stats.expired = db_s->expired;
+    stats.evicted = db_s->evicted;
+  }
+  return stats;
+}
@@ -13,6 +13,29 @@ typedef unsigned short db_name;
 #define OIDC_DB_FILES 5
 #define OIDC_DB_DEVICECODES 6
 
+/**
+ * Limits of a db. A db without limits keeps its entries until they are
+ * removed explicitly; otherwise entries expire and the least recently used
+ * entries are evicted when a cap is exceeded. Lookups through
+ * @c db_findValue count as use.
+ */
+struct db_limits {
+  size_t max_entries;            // 0 for no cap
+  size_t max_bytes;              // 0 for no cap; requires sizeGetter
+  time_t (*deathGetter)(void*);  // time an entry expires, 0 for never
+  size_t (*sizeGetter)(void*);
+  void (*evict)(void*);  // frees what the free function of the db does not
+  int (*canEvict)(void*);  // NULL if every entry might be evicted
+  unsigned char deferred_evict;  // only evict in db_evictOverLimits
+};
+
+struct db_stats {
+  size_t entries;
+  size_t bytes;
+  size_t expired;
+  size_t evicted;
+};
+
 void          db_newDB(const db_name db);
 list_t*       db_getDB(const db_name db);
 matchFunction db_setMatchFunction(const db_name db, matchFunction);
@@ -26,5 +49,10 @@ void*  db_findValueWithFunction(const db_name db, void* key, matchFunction);
 void   db_reset(const db_name db);
 time_t db_getMinDeath(const db_name db, time_t (*deathGetter)(void*));
 void*  db_getDeathEntry(const db_name db, time_t (*deathGetter)(void*));
+void   db_setLimits(const db_name db, struct db_limits limits);
+void   db_evictOverLimits(const db_name db);
+void   db_removeExpired(const db_name db);
+time_t db_getNextExpiry(const db_name db);
+struct db_stats db_getStats(const db_name db);
 
 #endif  // OIDC_DB_H
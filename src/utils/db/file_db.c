@@ -1,5 +1,9 @@
 #include "file_db.h"
 
+#include <string.h>
+#include <time.h>
+
+#include "defines/settings.h"
 #include "utils/crypt/memoryCrypt.h"
 #include "utils/matcher.h"
 #include "utils/memory.h"
@@ -7,7 +11,8 @@
 
 struct file_dummy {
   char* filename;
-  char* data;
+  char*  data;
+  time_t expires_at;
 };
 
 void secFreeFileDummy(struct file_dummy* fd) {
@@ -23,17 +28,25 @@ int _fd_match(const struct file_dummy* fd1, const struct file_dummy* fd2) {
   return matchStrings(fd1 ? fd1->filename : NULL, fd2 ? fd2->filename : NULL);
 }
 
+static time_t _fd_getDeath(const struct file_dummy* fd) {
+  return fd->expires_at;
+}
+
+static size_t _fd_getSize(const struct file_dummy* fd) {
+  return strlen(fd->filename) + (fd->data ? strlen(fd->data) : 0);
+}
+
 void fileDB_new() {
   db_newDB(OIDC_DB_FILES);
   db_setFreeFunction(OIDC_DB_FILES, (freeFunction)secFreeFileDummy);
   db_setMatchFunction(OIDC_DB_FILES, (matchFunction)_fd_match);
-}
-
-void fileDB_addValue(const char* key, const char* data) {
-  struct file_dummy* value = secAlloc(sizeof(struct file_dummy));
-  value->filename          = oidc_strcopy(key);
-  value->data              = memoryEncrypt(data);
-  db_addValue(OIDC_DB_FILES, value);
+  db_setLimits(OIDC_DB_FILES,
+               (struct db_limits){
+                   .max_entries = AGENT_FILE_MAX,
+                   .max_bytes   = AGENT_FILE_MAX_BYTES,
+                   .deathGetter = (time_t(*)(void*))_fd_getDeath,
+                   .sizeGetter  = (size_t(*)(void*))_fd_getSize,
+               });
 }
 
 struct file_dummy* _findValue(const char* filename) {
@@ -44,6 +57,16 @@ struct file_dummy* _findValue(const char* filename) {
   return fd;
 }
 
+void fileDB_addValue(const char* key, const char* data) {
+  // Only the latest data of a file is kept
+  db_removeIfFound(OIDC_DB_FILES, _findValue(key));
+  struct file_dummy* value = secAlloc(sizeof(struct file_dummy));
+  value->filename          = oidc_strcopy(key);
+  value->data              = memoryEncrypt(data);
+  value->expires_at        = time(NULL) + AGENT_FILE_TTL;
+  db_addValue(OIDC_DB_FILES, value);
+}
+
 char* fileDB_findValue(const char* filename) {
   struct file_dummy* fd = _findValue(filename);
   return fd ? memoryDecrypt(fd->data) : NULL;
@@ -30,6 +30,8 @@
 
 #define passwordDB_getSize() db_getSize(OIDC_DB_PASSWORDS)
 
+#define passwordDB_getList() db_getDB(OIDC_DB_PASSWORDS)
+
 #define passwordDB_reset() \
   do { db_reset(OIDC_DB_PASSWORDS); } while (0)
 
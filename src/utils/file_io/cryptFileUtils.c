@@ -1,5 +1,6 @@
 #include "cryptFileUtils.h"
 
+#include "utils/config/accountIndex.h"
 #include "utils/crypt/cryptUtils.h"
 #include "utils/crypt/gpg/gpg.h"
 #include "utils/file_io/file_io.h"
@@ -46,6 +47,9 @@ oidc_error_t encryptAndWriteToOidcFile(const char* text, const char* filename,
   char*        filepath = concatToOidcDir(filename);
   oidc_error_t ret = encryptAndWriteToFile(text, filepath, password, gpg_key);
   secFree(filepath);
+  if (ret == OIDC_SUCCESS) {
+    accountIndex_updateFromConfig(filename, text);
+  }
   return ret;
 }
 
@@ -4,6 +4,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -190,6 +191,41 @@ oidc_error_t writeFile(const char* path, const char* text) {
   return OIDC_SUCCESS;
 }
 
+/**
+ * @brief replaces a file with text, so that readers and a crash never see a
+ * partially written file; the text is written to a temporary file with mode
+ * 0600 in the same directory that is then renamed over the file
+ * @return OIDC_SUCCESS or an error code
+ */
+oidc_error_t writeFileAtomic(const char* path, const char* text) {
+  if (path == NULL || text == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return oidc_errno;
+  }
+#ifdef MINGW
+  return writeFile(path, text);
+#else
+  char* tmp = oidc_sprintf("%s.XXXXXX", path);
+  int   fd  = mkstemp(tmp);
+  if (fd < 0) {
+    oidc_setErrnoError();
+    secFree(tmp);
+    return oidc_errno;
+  }
+  size_t len  = strlen(text);
+  int    fail = write(fd, text, len) != (ssize_t)len || fsync(fd) != 0;
+  fail        = close(fd) != 0 || fail;
+  if (fail || rename(tmp, path) != 0) {
+    oidc_setErrnoError();
+    unlink(tmp);
+    secFree(tmp);
+    return oidc_errno;
+  }
+  secFree(tmp);
+  return OIDC_SUCCESS;
+#endif
+}
+
 oidc_error_t appendFile(const char* path, const char* text) {
   if (path == NULL || text == NULL) {
     oidc_setArgNullFuncError(__func__);
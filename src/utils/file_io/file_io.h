@@ -15,6 +15,7 @@
 #define DEFAULT_COMMENT_CHAR '#'
 
 oidc_error_t writeFile(const char* filepath, const char* text);
+oidc_error_t writeFileAtomic(const char* path, const char* text);
 oidc_error_t appendFile(const char* path, const char* text);
 char*        readFile(const char* path);
 char*        readFILE(FILE* fp);
@@ -41,6 +41,18 @@ oidc_error_t writeOidcFile(const char* filename, const char* text) {
   return er;
 }
 
+/**
+ * @brief replaces a file located in the oidc directory without ever leaving a
+ * partially written file
+ * @see writeFileAtomic
+ */
+oidc_error_t writeOidcFileAtomic(const char* filename, const char* text) {
+  char*        path = concatToOidcDir(filename);
+  oidc_error_t er   = writeFileAtomic(path, text);
+  secFree(path);
+  return er;
+}
+
 oidc_error_t appendOidcFile(const char* filename, const char* text) {
   char*        path = concatToOidcDir(filename);
   oidc_error_t er   = appendFile(path, text);
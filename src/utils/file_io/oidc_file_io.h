@@ -7,6 +7,7 @@
 char*        getOidcDir();
 oidc_error_t createOidcDir();
 oidc_error_t writeOidcFile(const char* filename, const char* text);
+oidc_error_t writeOidcFileAtomic(const char* filename, const char* text);
 oidc_error_t appendOidcFile(const char* filename, const char* text);
 char*        readOidcFile(const char* filename);
 int          oidcFileDoesExist(const char* filename);
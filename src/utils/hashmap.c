@@ -0,0 +1,219 @@
+#include "hashmap.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+/**
+ * The map uses open addressing with linear probing. Removed entries are marked
+ * with a tombstone, so probing sequences stay intact. The capacity is always a
+ * power of two and the map grows when more than 3/4 of the slots are used
+ * (including tombstones).
+ */
+
+#define HASHMAP_MIN_CAP 16
+
+static char tombstone;
+#define TOMBSTONE (&tombstone)
+
+struct hashmap_entry {
+  char*    key;
+  void*    value;
+  uint64_t hash;
+};
+
+struct hashmap {
+  struct hashmap_entry* entries;
+  size_t                cap;
+  size_t                len;
+  size_t                used;  // len + tombstones
+  void (*free_value)(void*);
+};
+
+static uint64_t hash_str(const char* s) {
+  // FNV-1a
+  uint64_t h = 14695981039346656037ULL;
+  for (; *s; s++) {
+    h ^= (unsigned char)*s;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static size_t capForExpected(size_t expected) {
+  size_t cap = HASHMAP_MIN_CAP;
+  while (cap * 3 / 4 < expected) { cap <<= 1; }
+  return cap;
+}
+
+hashmap_t* hashmap_new(size_t expected, void (*free_value)(void*)) {
+  hashmap_t* map  = secAlloc(sizeof(hashmap_t));
+  map->cap        = capForExpected(expected);
+  map->entries    = pubCalloc(map->cap, sizeof(struct hashmap_entry));
+  map->free_value = free_value;
+  return map;
+}
+
+void _secFreeHashmap(hashmap_t* map) {
+  if (map == NULL) {
+    return;
+  }
+  for (size_t i = 0; i < map->cap; i++) {
+    struct hashmap_entry* e = &map->entries[i];
+    if (e->key == NULL || e->key == TOMBSTONE) {
+      continue;
+    }
+    secFree(e->key);
+    if (map->free_value) {
+      map->free_value(e->value);
+    }
+  }
+  secFree(map->entries);
+  secFree(map);
+}
+
+static struct hashmap_entry* findEntry(const hashmap_t* map, const char* key,
+                                       uint64_t hash) {
+  size_t mask = map->cap - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    struct hashmap_entry* e = &map->entries[i];
+    if (e->key == NULL) {
+      return NULL;
+    }
+    if (e->key != TOMBSTONE && e->hash == hash && strcmp(e->key, key) == 0) {
+      return e;
+    }
+  }
+}
+
+static void insertEntry(hashmap_t* map, char* key, void* value,
+                        uint64_t hash) {
+  size_t mask = map->cap - 1;
+  size_t i    = hash & mask;
+  while (map->entries[i].key != NULL && map->entries[i].key != TOMBSTONE) {
+    i = (i + 1) & mask;
+  }
+  if (map->entries[i].key == NULL) {
+    map->used++;
+  }
+  map->entries[i] = (struct hashmap_entry){key, value, hash};
+  map->len++;
+}
+
+static void grow(hashmap_t* map) {
+  struct hashmap_entry* old     = map->entries;
+  size_t                old_cap = map->cap;
+  map->cap                      = capForExpected(map->len + 1) * 2;
+  map->entries = pubCalloc(map->cap, sizeof(struct hashmap_entry));
+  map->len     = 0;
+  map->used    = 0;
+  for (size_t i = 0; i < old_cap; i++) {
+    if (old[i].key != NULL && old[i].key != TOMBSTONE) {
+      insertEntry(map, old[i].key, old[i].value, old[i].hash);
+    }
+  }
+  secFree(old);
+}
+
+/**
+ * @brief replaces the value of @p key if it is in the map
+ * @return @c 1 if the value was replaced, @c 0 if @p key is not in the map
+ */
+static int replaceValue(hashmap_t* map, const char* key, uint64_t hash,
+                        void* value) {
+  struct hashmap_entry* e = findEntry(map, key, hash);
+  if (e == NULL) {
+    return 0;
+  }
+  if (map->free_value && e->value != value) {
+    map->free_value(e->value);
+  }
+  e->value = value;
+  return 1;
+}
+
+void hashmap_put(hashmap_t* map, const char* key, void* value) {
+  if (map == NULL || key == NULL) {
+    return;
+  }
+  uint64_t hash = hash_str(key);
+  if (replaceValue(map, key, hash, value)) {
+    return;
+  }
+  if ((map->used + 1) * 4 > map->cap * 3) {
+    grow(map);
+  }
+  insertEntry(map, oidc_strcopy(key), value, hash);
+}
+
+void hashmap_putOwnedKey(hashmap_t* map, char* key, void* value) {
+  if (map == NULL || key == NULL) {
+    return;
+  }
+  uint64_t hash = hash_str(key);
+  if (replaceValue(map, key, hash, value)) {
+    secFree(key);
+    return;
+  }
+  if ((map->used + 1) * 4 > map->cap * 3) {
+    grow(map);
+  }
+  insertEntry(map, key, value, hash);
+}
+
+void* hashmap_get(const hashmap_t* map, const char* key) {
+  if (map == NULL || key == NULL) {
+    return NULL;
+  }
+  struct hashmap_entry* e = findEntry(map, key, hash_str(key));
+  return e ? e->value : NULL;
+}
+
+const char* hashmap_getKey(const hashmap_t* map, const char* key) {
+  if (map == NULL || key == NULL) {
+    return NULL;
+  }
+  struct hashmap_entry* e = findEntry(map, key, hash_str(key));
+  return e ? e->key : NULL;
+}
+
+int hashmap_contains(const hashmap_t* map, const char* key) {
+  if (map == NULL || key == NULL) {
+    return 0;
+  }
+  return findEntry(map, key, hash_str(key)) != NULL;
+}
+
+void* hashmap_remove(hashmap_t* map, const char* key) {
+  if (map == NULL || key == NULL) {
+    return NULL;
+  }
+  struct hashmap_entry* e = findEntry(map, key, hash_str(key));
+  if (e == NULL) {
+    return NULL;
+  }
+  void* value = e->value;
+  secFree(e->key);
+  e->key   = TOMBSTONE;
+  e->value = NULL;
+  map->len--;
+  return value;
+}
+
+size_t hashmap_size(const hashmap_t* map) { return map ? map->len : 0; }
+
+void hashmap_foreach(const hashmap_t* map,
+                     void (*f)(const char* key, void* value, void* arg),
+                     void* arg) {
+  if (map == NULL || f == NULL) {
+    return;
+  }
+  for (size_t i = 0; i < map->cap; i++) {
+    struct hashmap_entry* e = &map->entries[i];
+    if (e->key != NULL && e->key != TOMBSTONE) {
+      f(e->key, e->value, arg);
+    }
+  }
+}
@@ -0,0 +1,95 @@
+#ifndef OIDC_HASHMAP_H
+#define OIDC_HASHMAP_H
+
+#include <stddef.h>
+
+struct hashmap;
+typedef struct hashmap hashmap_t;
+
+/**
+ * @brief Creates a hash map with string keys.
+ * @param expected the number of entries expected; used to size the map
+ * @param free_value function used to free values when they are replaced,
+ * removed or the map is freed; might be @c NULL
+ * @return the hash map, must be freed using @c secFreeHashmap
+ */
+hashmap_t* hashmap_new(size_t expected, void (*free_value)(void*));
+
+/**
+ * @brief Frees a hash map, including all keys and (if a free function is set)
+ * values.
+ * @param map the hash map
+ */
+void _secFreeHashmap(hashmap_t* map);
+
+/**
+ * @brief Inserts or replaces a value.
+ * @param map the hash map
+ * @param key the key; the map stores a copy
+ * @param value the value
+ * @note a replaced value is freed with the map's free function
+ */
+void hashmap_put(hashmap_t* map, const char* key, void* value);
+
+/**
+ * @brief Inserts or replaces a value without copying the key.
+ * @param map the hash map
+ * @param key the key; ownership is taken. If @p key is already in the map,
+ * the value is replaced and @p key is freed.
+ * @param value the value
+ */
+void hashmap_putOwnedKey(hashmap_t* map, char* key, void* value);
+
+/**
+ * @brief Looks up a value.
+ * @param map the hash map
+ * @param key the key
+ * @return the value or @c NULL if @p key is not in the map
+ */
+void* hashmap_get(const hashmap_t* map, const char* key);
+
+/**
+ * @brief Looks up the key stored in the map.
+ * @param map the hash map
+ * @param key a key with the same value
+ * @return the map's own copy of @p key, which is valid until the entry is
+ * removed, or @c NULL if @p key is not in the map
+ */
+const char* hashmap_getKey(const hashmap_t* map, const char* key);
+
+/**
+ * @brief Checks if a key is in the map.
+ * @return @c 1 if @p key is in the map, @c 0 otherwise
+ */
+int hashmap_contains(const hashmap_t* map, const char* key);
+
+/**
+ * @brief Removes an entry without freeing its value.
+ * @param map the hash map
+ * @param key the key
+ * @return the removed value or @c NULL if @p key was not in the map
+ */
+void* hashmap_remove(hashmap_t* map, const char* key);
+
+/**
+ * @brief Returns the number of entries in the map.
+ */
+size_t hashmap_size(const hashmap_t* map);
+
+/**
+ * @brief Calls @p f for every entry of the map in an unspecified order.
+ * @note @p f must not modify the map
+ */
+void hashmap_foreach(const hashmap_t* map,
+                     void (*f)(const char* key, void* value, void* arg),
+                     void* arg);
+
+#ifndef secFreeHashmap
+#define secFreeHashmap(ptr) \
+  do {                      \
+    _secFreeHashmap((ptr)); \
+    (ptr) = NULL;           \
+  } while (0)
+#endif  // secFreeHashmap
+
+#endif  // OIDC_HASHMAP_H
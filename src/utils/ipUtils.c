@@ -54,9 +54,10 @@ int isValidIPOrHostname(const char* iph) {
 // The given string might have an port, e.g.
 // <ip/host> or <ip/host>:<port>
 int isValidIPOrHostnameOptionalPort(const char* iph) {
-  char* tmp = oidc_strcopy(iph);
-  char* ip  = strtok(tmp, ":");
-  int   ret = isValidIPOrHostname(ip);
+  char* tmp     = oidc_strcopy(iph);
+  char* saveptr = NULL;
+  char* ip      = strtok_r(tmp, ":", &saveptr);
+  int   ret     = isValidIPOrHostname(ip);
   secFree(tmp);
   return ret;
 }
@@ -8,22 +8,39 @@
 #include "utils/pass.h"
 #include "utils/string/stringUtils.h"
 
-static cJSON_Hooks hooks;
-static int         jsonInitDone = 0;
+static OIDC_THREAD_LOCAL unsigned char cjsonUsePublicMemory = 0;
+
+static void* _cjsonAlloc(size_t size) {
+  return cjsonUsePublicMemory ? pubAlloc(size) : secAlloc(size);
+}
 
 /**
  * @brief initializes the cJSON memory allocator and deallocator if not done yet
- * @internal
+ * @note the hooks are the same on every call, so concurrent calls from several
+ * threads are harmless; needed before the first direct use of cJSON
  */
 void initCJSON() {
+  static int jsonInitDone = 0;
   if (!jsonInitDone) {
-    hooks.malloc_fn = secAlloc;
-    hooks.free_fn   = _secFree;
+    cJSON_Hooks hooks = {.malloc_fn = _cjsonAlloc, .free_fn = _secFree};
     cJSON_InitHooks(&hooks);
     jsonInitDone = 1;
   }
 }
 
+/**
+ * @brief switches the cJSON memory allocator of the calling thread between
+ * secret and public memory
+ * @param public if @c 0 cJSON allocates with @c secAlloc, otherwise with
+ * @c pubAlloc
+ * @note memory is always freed with @c _secFree, which handles both classes
+ * @internal
+ */
+static void useCJSONPublicMemory(unsigned char public) {
+  initCJSON();
+  cjsonUsePublicMemory = public;
+}
+
 /**
  * @brief converts a cJSON object into a string
  * @param cjson the cJSON object to be converted
@@ -52,16 +69,23 @@ char* jsonToStringUnformatted(cJSON* cjson) {
  * @return a pointer to a cJSON object. Has to be freed after usage.
  * @internal
  */
-cJSON* _stringToJson(const char* json, int logError) {
+cJSON* _stringToJson(const char* json, int logError, unsigned char public) {
   if (NULL == json) {
     oidc_setArgNullFuncError(__func__);
     return NULL;
   }
   initCJSON();
   char* minJson = oidc_strcopy(json);
+  if (public) {
+    markPublicMem(minJson);
+    useCJSONPublicMemory(1);
+  }
   cJSON_Minify(minJson);
   logger(DEBUG, "Parsing json '%s'", minJson);
   cJSON* cj = cJSON_Parse(minJson);
+  if (public) {
+    useCJSONPublicMemory(0);
+  }
   if (cj == NULL) {
     oidc_errno = OIDC_EJSONPARS;
     if (logError) {
@@ -78,7 +102,7 @@ cJSON* _stringToJson(const char* json, int logError) {
  * @return a pointer to a cJSON object. Has to be freed after usage.
  * @note this function logs parsing error
  */
-cJSON* stringToJson(const char* json) { return _stringToJson(json, 1); }
+cJSON* stringToJson(const char* json) { return _stringToJson(json, 1, 0); }
 
 /**
  * @brief parses a string into an cJSON object
@@ -88,7 +112,20 @@ cJSON* stringToJson(const char* json) { return _stringToJson(json, 1); }
  * checking if a string would parse correctly into a cJSON object
  */
 cJSON* stringToJsonDontLogError(const char* json) {
-  return _stringToJson(json, 0);
+  return _stringToJson(json, 0, 0);
+}
+
+/**
+ * @brief parses a string that does not contain any secrets into an cJSON
+ * object
+ * @param json the json string
+ * @return a pointer to a cJSON object. Has to be freed after usage.
+ * @note the cJSON object is allocated in public memory and therefore not zeroed
+ * when freed; only use this for public data like discovery documents or
+ * configuration.
+ */
+cJSON* publicStringToJson(const char* json) {
+  return _stringToJson(json, 1, 1);
 }
 
 /**
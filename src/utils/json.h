@@ -6,6 +6,7 @@
 #include "wrapper/cjson.h"
 #include "wrapper/list.h"
 
+void initCJSON();
 void _secFreeJson(cJSON* cjson);
 
 char*        getJSONValue(const cJSON* cjson, const char* key);
@@ -25,6 +26,7 @@ char*   jsonToString(cJSON* cjson);
 char*   jsonToStringUnformatted(cJSON* cjson);
 cJSON*  stringToJson(const char* json);
 cJSON*  stringToJsonDontLogError(const char* json);
+cJSON*  publicStringToJson(const char* json);
 list_t* JSONArrayToList(const cJSON* cjson);
 list_t* JSONArrayStringToList(const char* json);
 char*   JSONArrayToDelimitedString(const cJSON* cjson, char* delim);
@@ -0,0 +1,238 @@
+#define _GNU_SOURCE
+#include "kernelKeyring.h"
+
+/**
+ * Access tokens published by oidcd in the session keyring of the user, so
+ * that clients in the same session can read them without talking to the
+ * agent. Each token is a key of type "user" that is named after the account
+ * and the requested scope and holds "<expires_at>\n<issuer>\n<token>". The
+ * key times out when the token expires and only processes that possess the
+ * session keyring can access it.
+ *
+ * The key that protects the state snapshot of the agent is kept in the user
+ * keyring instead, so that a restarted agent finds it even in another session.
+ */
+
+#ifdef __linux__
+#include <linux/keyctl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+#define KERNELKEYRING_TYPE "user"
+#define KERNELKEYRING_PREFIX "oidc-agent:"
+// view, read, write, search, link and setattr for possessors only
+#define KERNELKEYRING_PERM 0x3f000000
+#define KERNELKEYRING_SNAPSHOTKEY "oidc-agent-snapshot-key"
+// additionally view, read and search for processes of the user
+#define KERNELKEYRING_SNAPSHOTKEY_PERM 0x3f0b0000
+
+// The account is prefixed with its length, so that account names and scopes
+// containing ':' cannot produce the same description
+static char* _accountPrefix(const char* account) {
+  return oidc_sprintf(KERNELKEYRING_PREFIX "%lu:%s:",
+                      (unsigned long)strlen(account), account);
+}
+
+static char* _description(const char* account, const char* scope) {
+  char* prefix = _accountPrefix(account);
+  char* desc   = oidc_strcat(prefix, scope ?: "");
+  secFree(prefix);
+  return desc;
+}
+
+/**
+ * @brief reads the payload of a key or the contents of a keyring
+ * @param len is set to the length of the returned data
+ * @return the data or @c NULL on failure; has to be freed after usage
+ */
+static char* _read(long id, long keyctl_cmd, size_t* len) {
+  size_t size = 4096;
+  while (1) {
+    char* buf = secAlloc(size + 1);
+    long  n   = syscall(SYS_keyctl, keyctl_cmd, id, buf, size);
+    if (n < 0) {
+      secFree(buf);
+      oidc_setErrnoError();
+      return NULL;
+    }
+    if ((size_t)n <= size) {
+      *len = n;
+      return buf;
+    }
+    secFree(buf);
+    size = n;
+  }
+}
+
+/**
+ * @brief publishes an access token in the session keyring; an already
+ * published token for the same account and scope is replaced
+ */
+oidc_error_t kernelKeyring_publishToken(const char* account, const char* scope,
+                                        const char* token, const char* issuer,
+                                        time_t expires_at) {
+  if (account == NULL || token == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return oidc_errno;
+  }
+  time_t ttl = expires_at - time(NULL);
+  if (ttl <= 0) {
+    return OIDC_SUCCESS;
+  }
+  char* desc    = _description(account, scope);
+  char* payload = oidc_sprintf("%ld\n%s\n%s", (long)expires_at, issuer ?: "",
+                               token);
+  long  id      = syscall(SYS_add_key, KERNELKEYRING_TYPE, desc, payload,
+                          strlen(payload), KEY_SPEC_SESSION_KEYRING);
+  secFree(payload);
+  secFree(desc);
+  if (id < 0 ||
+      syscall(SYS_keyctl, KEYCTL_SETPERM, id, KERNELKEYRING_PERM) < 0 ||
+      syscall(SYS_keyctl, KEYCTL_SET_TIMEOUT, id, (unsigned int)ttl) < 0) {
+    oidc_setErrnoError();
+    return oidc_errno;
+  }
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief looks up an access token in the session keyring
+ * @param issuer if not @c NULL, set to the issuer of the token; has to be
+ * freed after usage
+ * @param expires_at set to the expiration time of the token
+ * @return the access token or @c NULL if none was published; has to be freed
+ * after usage
+ */
+char* kernelKeyring_getToken(const char* account, const char* scope,
+                             char** issuer, time_t* expires_at) {
+  if (account == NULL) {
+    return NULL;
+  }
+  char* desc = _description(account, scope);
+  long  id   = syscall(SYS_keyctl, KEYCTL_SEARCH, KEY_SPEC_SESSION_KEYRING,
+                       KERNELKEYRING_TYPE, desc, 0);
+  secFree(desc);
+  if (id < 0) {
+    return NULL;
+  }
+  size_t len;
+  char*  payload = _read(id, KEYCTL_READ, &len);
+  if (payload == NULL) {
+    return NULL;
+  }
+  char* iss = strchr(payload, '\n');
+  char* tok = iss ? strchr(iss + 1, '\n') : NULL;
+  if (tok == NULL) {
+    secFree(payload);
+    return NULL;
+  }
+  *iss++      = '\0';
+  *tok++      = '\0';
+  *expires_at = strToLong(payload);
+  if (issuer != NULL) {
+    *issuer = oidc_strcopy(iss);
+  }
+  char* token = oidc_strcopy(tok);
+  secFree(payload);
+  return token;
+}
+
+/**
+ * @brief removes the published tokens of an account, or of all accounts if
+ * @p account is @c NULL
+ */
+void kernelKeyring_removeTokens(const char* account) {
+  size_t   len;
+  int32_t* ids = (int32_t*)_read(KEY_SPEC_SESSION_KEYRING, KEYCTL_READ, &len);
+  if (ids == NULL) {
+    return;
+  }
+  char* prefix =
+      account ? _accountPrefix(account) : oidc_strcopy(KERNELKEYRING_PREFIX);
+  for (size_t i = 0; i < len / sizeof(int32_t); i++) {
+    size_t dlen;
+    char*  info = _read(ids[i], KEYCTL_DESCRIBE, &dlen);
+    if (info == NULL) {
+      continue;
+    }
+    // "<type>;<uid>;<gid>;<perm>;<description>"
+    char* desc = info;
+    for (int field = 0; field < 4 && desc != NULL; field++) {
+      desc = strchr(desc, ';');
+      desc = desc ? desc + 1 : NULL;
+    }
+    if (desc != NULL && strstarts(info, KERNELKEYRING_TYPE ";") &&
+        strstarts(desc, prefix)) {
+      if (syscall(SYS_keyctl, KEYCTL_INVALIDATE, ids[i]) < 0) {
+        syscall(SYS_keyctl, KEYCTL_UNLINK, ids[i], KEY_SPEC_SESSION_KEYRING);
+      }
+    }
+    secFree(info);
+  }
+  secFree(prefix);
+  secFree(ids);
+}
+
+/**
+ * @brief looks up the key of the state snapshot in the user keyring
+ * @return the key or @c NULL if there is none; has to be freed after usage
+ */
+char* kernelKeyring_getSnapshotKey() {
+  long id = syscall(SYS_keyctl, KEYCTL_SEARCH, KEY_SPEC_USER_KEYRING,
+                    KERNELKEYRING_TYPE, KERNELKEYRING_SNAPSHOTKEY, 0);
+  if (id < 0) {
+    return NULL;
+  }
+  size_t len;
+  return _read(id, KEYCTL_READ, &len);
+}
+
+/**
+ * @brief stores the key of the state snapshot in the user keyring; it does not
+ * time out
+ */
+oidc_error_t kernelKeyring_setSnapshotKey(const char* key) {
+  if (key == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return oidc_errno;
+  }
+  long id = syscall(SYS_add_key, KERNELKEYRING_TYPE, KERNELKEYRING_SNAPSHOTKEY,
+                    key, strlen(key), KEY_SPEC_USER_KEYRING);
+  if (id < 0 || syscall(SYS_keyctl, KEYCTL_SETPERM, id,
+                        KERNELKEYRING_SNAPSHOTKEY_PERM) < 0) {
+    oidc_setErrnoError();
+    return oidc_errno;
+  }
+  return OIDC_SUCCESS;
+}
+
+#else
+
+oidc_error_t kernelKeyring_publishToken(const char* account, const char* scope,
+                                        const char* token, const char* issuer,
+                                        time_t expires_at) {
+  oidc_errno = OIDC_NOTIMPL;
+  return oidc_errno;
+}
+
+char* kernelKeyring_getToken(const char* account, const char* scope,
+                             char** issuer, time_t* expires_at) {
+  return NULL;
+}
+
+void kernelKeyring_removeTokens(const char* account) {}
+
+char* kernelKeyring_getSnapshotKey() { return NULL; }
+
+oidc_error_t kernelKeyring_setSnapshotKey(const char* key) {
+  oidc_errno = OIDC_NOTIMPL;
+  return oidc_errno;
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef OIDC_KERNEL_KEYRING_H
+#define OIDC_KERNEL_KEYRING_H
+
+#include <time.h>
+
+#include "utils/oidc_error.h"
+
+oidc_error_t kernelKeyring_publishToken(const char* account, const char* scope,
+                                        const char* token, const char* issuer,
+                                        time_t expires_at);
+char*        kernelKeyring_getToken(const char* account, const char* scope,
+                                    char** issuer, time_t* expires_at);
+void         kernelKeyring_removeTokens(const char* account);
+char*        kernelKeyring_getSnapshotKey();
+oidc_error_t kernelKeyring_setSnapshotKey(const char* key);
+
+#endif  // OIDC_KERNEL_KEYRING_H
@@ -1,8 +1,10 @@
+#define _POSIX_C_SOURCE 200809L
 #include "listUtils.h"
 
 #include <stdarg.h>
 #include <string.h>
 
+#include "hashmap.h"
 #include "json.h"
 #include "memory.h"
 #include "utils/oidc_error.h"
@@ -20,14 +22,15 @@ char* delimitedStringToJSONArrayFmt(const char* str, char delimiter,
     return NULL;
   }
 
-  size_t size  = strCountChar(str, delimiter) + 1;
-  char*  copy  = oidc_sprintf("%s", str);
-  char*  delim = oidc_sprintf("%c", delimiter);
-  char*  json  = oidc_sprintf(valueFmt, strtok(copy, delim));
+  size_t size    = strCountChar(str, delimiter) + 1;
+  char*  copy    = oidc_sprintf("%s", str);
+  char*  delim   = oidc_sprintf("%c", delimiter);
+  char*  saveptr = NULL;
+  char*  json    = oidc_sprintf(valueFmt, strtok_r(copy, delim, &saveptr));
   size_t i;
   char*  fmt = oidc_strcat("%s, ", valueFmt);
   for (i = 1; i < size; i++) {
-    char* tok = strtok(NULL, delim);
+    char* tok = strtok_r(NULL, delim, &saveptr);
     if (!strValid(tok)) {
       continue;
     }
@@ -86,10 +89,11 @@ list_t* delimitedStringToList(const char* str, char delimiter) {
   list_t* list  = list_new();
   list->free    = (void (*)(void*)) & _secFree;
   list->match   = (matchFunction)strequal;
-  char* elem    = strtok(copy, delim);
+  char* saveptr = NULL;
+  char* elem    = strtok_r(copy, delim, &saveptr);
   while (elem != NULL) {
     list_rpush(list, list_node_new(oidc_strcopy(elem)));
-    elem = strtok(NULL, delim);
+    elem = strtok_r(NULL, delim, &saveptr);
   }
   secFree(delim);
   secFree(copy);
@@ -103,17 +107,27 @@ char* listToDelimitedString(list_t* list, char* delimiter) {
   if (list->len == 0) {
     return oidc_strcopy("");
   }
-  list_node_t* node = list_at(list, 0);
-  char*        tmp  = NULL;
-  char*        str  = oidc_sprintf("%s", (char*)node->val);
-  unsigned int i;
-  for (i = 1; i < list->len; i++) {
-    tmp = oidc_sprintf("%s%s%s", str, delimiter, (char*)list_at(list, i)->val);
-    secFree(str);
-    if (tmp == NULL) {
-      return NULL;
+  const char*  null_str  = "(null)";  // what oidc_sprintf("%s", NULL) prints
+  size_t       delim_len = strlen(delimiter);
+  size_t       len       = delim_len * (list->len - 1);
+  list_node_t* node;
+  for (node = list->head; node; node = node->next) {
+    len += strlen(node->val ?: null_str);
+  }
+  char* str = secAlloc(len + 1);
+  if (str == NULL) {
+    return NULL;
+  }
+  char* p = str;
+  for (node = list->head; node; node = node->next) {
+    if (node != list->head) {
+      memcpy(p, delimiter, delim_len);
+      p += delim_len;
     }
-    str = tmp;
+    const char* val     = node->val ?: null_str;
+    size_t      val_len = strlen(val);
+    memcpy(p, val, val_len);
+    p += val_len;
   }
   return str;
 }
@@ -128,8 +142,9 @@ const char** listToArray(list_t* list) {
   const char** arr =
       secAlloc(sizeof(const char*) *
                (list->len + 1));  // the +1 will add a NULL pointer to the end
-  for (unsigned int i = 0; i < list->len; i++) {
-    arr[i] = (const char*)list_at(list, (int)i)->val;
+  size_t i = 0;
+  for (list_node_t* node = list->head; node; node = node->next) {
+    arr[i++] = (const char*)node->val;
   }
   return arr;
 }
@@ -158,19 +173,61 @@ list_t* createList(int copyValues, char* s, ...) {
   return list;
 }
 
+#ifndef LIST_HASH_THRESHOLD
+#define LIST_HASH_THRESHOLD 16
+#endif
+
+/**
+ * @brief builds a hash index from the values of a string list to their first
+ * node
+ * @param l the list
+ * @return the index or @c NULL if the list is too short or its values are not
+ * compared with @c strequal; a linear search has to be used then.
+ */
+static hashmap_t* _stringIndex(list_t* l) {
+  if (l == NULL || l->len < LIST_HASH_THRESHOLD ||
+      l->match != (matchFunction)strequal) {
+    return NULL;
+  }
+  hashmap_t*       index = hashmap_new(l->len, NULL);
+  list_node_t*     node;
+  list_iterator_t* it = list_iterator_new(l, LIST_HEAD);
+  while ((node = list_iterator_next(it))) {
+    if (node->val == NULL) {
+      // NULL values cannot be hashed; fall back to linear search
+      secFreeHashmap(index);
+      break;
+    }
+    if (!hashmap_contains(index, node->val)) {
+      hashmap_put(index, node->val, node);
+    }
+  }
+  list_iterator_destroy(it);
+  return index;
+}
+
+static list_node_t* _findInList(list_t* l, hashmap_t* index, const void* v) {
+  if (index) {
+    return v == NULL ? NULL : hashmap_get(index, v);
+  }
+  return findInList(l, v);
+}
+
 list_t* intersectLists(list_t* a, list_t* b) {
   list_t* l = list_new();
   l->free   = _secFree;
   l->match  = a->match;
+  hashmap_t*       index = _stringIndex(b);
   list_node_t*     node;
   list_iterator_t* it = list_iterator_new(a, LIST_HEAD);
   while ((node = list_iterator_next(it))) {
-    list_node_t* n = findInList(b, node->val);
+    list_node_t* n = _findInList(b, index, node->val);
     if (n) {
       list_rpush(l, list_node_new(oidc_strcopy(n->val)));
     }
   }
   list_iterator_destroy(it);
+  secFreeHashmap(index);
   return l;
 }
 
@@ -188,16 +245,17 @@ list_t* copyList(const list_t* a) {
 }
 
 list_t* mergeLists(list_t* a, list_t* b) {
-  list_t*          l = copyList(a);
+  list_t*          l     = copyList(a);
+  hashmap_t*       index = _stringIndex(a);
   list_node_t*     node;
   list_iterator_t* it = list_iterator_new(b, LIST_HEAD);
   while ((node = list_iterator_next(it))) {
-    list_node_t* n = findInList(a, node->val);
-    if (n == NULL) {
+    if (!_findInList(a, index, node->val)) {
       list_rpush(l, list_node_new(oidc_strcopy(node->val)));
     }
   }
   list_iterator_destroy(it);
+  secFreeHashmap(index);
   return l;
 }
 
@@ -208,15 +266,16 @@ list_t* subtractLists(list_t* a, list_t* b) {
   list_t* l = list_new();
   l->free   = a->free;
   l->match  = a->match;
+  hashmap_t*       index = _stringIndex(b);
   list_node_t*     node;
   list_iterator_t* it = list_iterator_new(a, LIST_HEAD);
   while ((node = list_iterator_next(it))) {
-    list_node_t* n = findInList(b, node->val);
-    if (n == NULL) {
+    if (!_findInList(b, index, node->val)) {
       list_rpush(l, list_node_new(oidc_strcopy(node->val)));
     }
   }
   list_iterator_destroy(it);
+  secFreeHashmap(index);
   return l;
 }
 
@@ -261,20 +320,14 @@ list_t* findAllInList(list_t* l, const void* v) {
   founds->match  = l->match;
   // Don't copy the free function over. We copy the same value pointer, the
   // values should not be freed, only the list
-  list_iterator_t* it = list_iterator_new(l, LIST_HEAD);
-  list_node_t*     node;
-  while ((node = list_iterator_next(it))) {
-    if (l->match) {
-      if (l->match((void*)v, node->val)) {
-        list_rpush(founds, list_node_new(node->val));
-      }
-    } else {
-      if (v == node->val) {
-        list_rpush(founds, list_node_new(node->val));
-      }
+  // A single lookup has to look at every node anyway, so a hash index would
+  // not pay off here; just walk the nodes directly.
+  matchFunction match = l->match;
+  for (list_node_t* node = l->head; node; node = node->next) {
+    if (match ? match((void*)v, node->val) : v == node->val) {
+      list_rpush(founds, list_node_new(node->val));
     }
   }
-  list_iterator_destroy(it);
   if (!listValid(founds)) {
     secFreeList(founds);
     founds = NULL;
@@ -293,77 +346,81 @@ void list_removeIfFound(list_t* l, const void* v) {
   return list_remove(l, node);
 }
 
-// Merges two subarrays of arr[].
-// First subarray is arr[l..m]
-// Second subarray is arr[m+1..r]
-void _merge(void* arr[], unsigned int l, unsigned int m, unsigned int r,
-            matchFunction comp) {
-  unsigned int i, j, k;
-  unsigned int n1 = m - l + 1;
-  unsigned int n2 = r - m;
-
-  /* create temp arrays */
-  void* L[n1];
-  void* R[n2];
-
-  /* Copy data to temp arrays L[] and R[] */
-  for (i = 0; i < n1; i++) L[i] = arr[l + i];
-  for (j = 0; j < n2; j++) R[j] = arr[m + 1 + j];
-
-  /* Merge the temp arrays back into arr[l..r]*/
-  i = 0;  // Initial index of first subarray
-  j = 0;  // Initial index of second subarray
-  k = l;  // Initial index of merged subarray
-  while (i < n1 && j < n2) {
-    if (comp(L[i], R[j]) <= 0) {
-      arr[k] = L[i];
-      i++;
+/**
+ * @brief merges the two sorted runs starting at @p a and @p b into one sorted
+ * run
+ * Equal elements are taken from @p a first, so the sort is stable.
+ * @param a the first sorted run, @c NULL terminated
+ * @param b the second sorted run, @c NULL terminated
+ * @param comp the compare function
+ * @param tail is set to the last node of the merged run
+ * @return the first node of the merged run
+ */
+static list_node_t* _mergeRuns(list_node_t* a, list_node_t* b,
+                               matchFunction comp, list_node_t** tail) {
+  list_node_t  head = {0};
+  list_node_t* t    = &head;
+  while (a && b) {
+    if (comp(a->val, b->val) <= 0) {
+      t->next = a;
+      a->prev = t;
+      a       = a->next;
     } else {
-      arr[k] = R[j];
-      j++;
+      t->next = b;
+      b->prev = t;
+      b       = b->next;
     }
-    k++;
-  }
-
-  /* Copy the remaining elements of L[], if there
-  are any */
-  while (i < n1) {
-    arr[k] = L[i];
-    i++;
-    k++;
-  }
-
-  /* Copy the remaining elements of R[], if there
-  are any */
-  while (j < n2) {
-    arr[k] = R[j];
-    j++;
-    k++;
+    t = t->next;
   }
+  t->next       = a ?: b;
+  t->next->prev = t;
+  while (t->next) { t = t->next; }
+  *tail = t;
+  return head.next;
 }
 
-/* l is for left index and r is right index of the
-sub-array of arr to be sorted */
-void mergeSort(void* arr[], unsigned int l, unsigned int r,
-               matchFunction comp) {
-  if (l < r) {
-    // Same as (l+r)/2, but avoids overflow for
-    // large l and h
-    unsigned int m = l + (r - l) / 2;
-
-    // Sort first and second halves
-    mergeSort(arr, l, m, comp);
-    mergeSort(arr, m + 1, r, comp);
-
-    _merge(arr, l, m, r, comp);
+/**
+ * @brief splits off the first @p n nodes of the run starting at @p node
+ * @return the first node after the split off part, or @c NULL
+ */
+static list_node_t* _splitRun(list_node_t* node, size_t n) {
+  for (size_t i = 1; node && i < n; i++) { node = node->next; }
+  if (node == NULL) {
+    return NULL;
   }
+  list_node_t* rest = node->next;
+  node->next        = NULL;
+  return rest;
 }
 
+/**
+ * @brief sorts a list in place using a bottom-up merge sort
+ * The nodes are relinked, no values are copied and no additional memory is
+ * needed. The sort is stable and runs in O(n log n).
+ * @param l the list to sort
+ * @param comp the compare function
+ */
 void list_mergeSort(list_t* l, matchFunction comp) {
-  void* arr[l->len];
-  for (size_t i = 0; i < l->len; i++) { arr[i] = list_ats(l, i)->val; }
-  mergeSort(arr, 0, l->len - 1, comp);
-  for (size_t i = 0; i < l->len; i++) { list_ats(l, i)->val = arr[i]; }
+  if (l == NULL || comp == NULL || l->len < 2) {
+    return;
+  }
+  for (size_t width = 1; width < l->len; width <<= 1) {
+    list_node_t* rest = l->head;
+    list_node_t  head = {0};
+    list_node_t* tail = &head;
+    while (rest) {
+      list_node_t* a = rest;
+      list_node_t* b = _splitRun(a, width);
+      rest           = _splitRun(b, width);
+      list_node_t* merged_tail;
+      tail->next       = _mergeRuns(a, b, comp, &merged_tail);
+      tail->next->prev = tail;
+      tail             = merged_tail;
+    }
+    l->head       = head.next;
+    l->head->prev = NULL;
+    l->tail       = tail;
+  }
 }
 
 void _secFreeList(list_t* l) {
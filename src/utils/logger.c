@@ -15,13 +15,29 @@
 
 static const char* logger_name;
 
+// log level set by the current thread with logger_setThreadLoglevel; -1 if
+// only the process wide settings apply
+static OIDC_THREAD_LOCAL int thread_log_level = -1;
+
+/**
+ * @brief sets a log level that only applies to the calling thread; messages
+ * are logged only if they pass this level and the process wide settings
+ * @param level the log level or @c -1 to reset it
+ * @return the previous thread log level
+ */
+int logger_setThreadLoglevel(int level) {
+  int old          = thread_log_level;
+  thread_log_level = level;
+  return old;
+}
+
 char* format_time() {
-  char* s = secAlloc(sizeof(char) * (19 + 1));
+  char* s = pubAlloc(sizeof(char) * (19 + 1));
   if (s == NULL) {
     return NULL;
   }
   time_t     now = time(NULL);
-  struct tm* t   = secAlloc(sizeof(struct tm));
+  struct tm* t   = pubAlloc(sizeof(struct tm));
   if (localtime_r(&now, t) == NULL) {
     oidc_perror();
     secFree(t);
@@ -33,8 +49,10 @@ char* format_time() {
 }
 
 char* create_log_message(int _log_level, const char* msg, va_list args) {
+  // log messages are written out anyway, there is no point in zeroing them
   char*             logmsg   = oidc_vsprintf(msg, args);
   char*             time_str = format_time();
+  markPublicMem(logmsg);
   const char* const fmt      = "%s %s %s: %s";
   const char*       level;
   switch (_log_level) {
@@ -48,6 +66,7 @@ char* create_log_message(int _log_level, const char* msg, va_list args) {
     default: level = ""; break;
   }
   char* log = oidc_sprintf(fmt, time_str, logger_name, level, logmsg);
+  markPublicMem(log);
   secFree(time_str);
   secFree(logmsg);
   return log;
@@ -63,13 +82,24 @@ void logger_open(const char* _logger_name) {
   logger_name = _logger_name;
 }
 
+static int thread_logs(int log_level) {
+  return thread_log_level < 0 ||
+         (LOG_MASK(log_level) & LOG_UPTO(thread_log_level));
+}
+
 void _logger(int log_level, const char* msg, ...) {
+  if (!thread_logs(log_level)) {
+    return;
+  }
   va_list args;
   va_start(args, msg);
   vsyslog(LOG_AUTHPRIV | log_level, msg, args);
 }
 
 void _loggerTerminal(int log_level, const char* msg, ...) {
+  if (!thread_logs(log_level)) {
+    return;
+  }
   va_list args, copy;
   va_start(args, msg);
   va_copy(copy, args);
@@ -108,7 +138,8 @@ void logger_open(const char* _logger_name) {
 }
 
 void __logger(int terminal, int _log_level, const char* msg, va_list args) {
-  if (_log_level >= log_level) {
+  if (_log_level >= log_level &&
+      (thread_log_level < 0 || _log_level >= thread_log_level)) {
     own_log(terminal, _log_level, msg, args);
   }
 }
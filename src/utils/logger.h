@@ -34,6 +34,7 @@ void _logger(int log_level, const char* msg, ...);
 void _loggerTerminal(int log_level, const char* msg, ...);
 int  logger_setlogmask(int);
 int  logger_setloglevel(int);
+int  logger_setThreadLoglevel(int);
 #define logger(LOG_LEVEL, MSG, ...) \
   _logger(LOG_LEVEL, LOG_FMT(MSG), ##__VA_ARGS__)
 #define loggerTerminal(LOG_LEVEL, MSG, ...) \
@@ -3,16 +3,38 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define MEM_USABLE_SIZE(fp) malloc_usable_size((fp))
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define MEM_USABLE_SIZE(fp) malloc_size((fp))
+#endif
+
 #include "memzero.h"
 #include "oidc_error.h"
 #include "utils/logger.h"
 
-void* secCalloc(size_t nmemb, size_t size) { return secAlloc(nmemb * size); }
+/**
+ * Every block allocated through this module is prefixed with a @c size_t
+ * header holding the usable size. The most significant bit of that header
+ * marks the block as public, i.e. the block does not hold any secret data and
+ * therefore does not have to be zeroed before it is freed.
+ */
+#define MEM_PUBLIC_FLAG ((size_t)1 << (sizeof(size_t) * 8 - 1))
+#define MEM_HEADER(p) (*(size_t*)((char*)(p) - sizeof(size_t)))
+#define MEM_SIZE(p) (MEM_HEADER(p) & ~MEM_PUBLIC_FLAG)
 
-void* secAlloc(size_t size) {
+static void* _memAlloc(size_t size, unsigned char public) {
   if (size == 0) {
     return NULL;
   }
+  if (size & MEM_PUBLIC_FLAG) {
+    oidc_errno = OIDC_EALLOC;
+    logger(ALERT, "Memory alloc failed when trying to allocate %lu bytes",
+           size);
+    return NULL;
+  }
   size_t sizesize = sizeof(size);
   void*  p        = calloc(size + sizesize, 1);
   if (p == NULL) {
@@ -21,10 +43,63 @@ void* secAlloc(size_t size) {
            size);
     return NULL;
   }
-  *(size_t*)p = size;
+  *(size_t*)p = public ? size | MEM_PUBLIC_FLAG : size;
   return p + sizeof(size);
 }
 
+void* secCalloc(size_t nmemb, size_t size) { return secAlloc(nmemb * size); }
+
+void* secAlloc(size_t size) { return _memAlloc(size, 0); }
+
+/**
+ * @brief allocates memory that does not hold any secret data
+ * Memory allocated with this function can be used exactly like memory from
+ * @c secAlloc and must also be freed with @c secFree, but it is not zeroed
+ * before being freed. Only use it for data that is public anyway, e.g.
+ * discovery documents, configuration or log messages.
+ * @param size the number of bytes to allocate
+ * @return a pointer to the zero-initialized memory
+ */
+void* pubAlloc(size_t size) { return _memAlloc(size, 1); }
+
+void* pubCalloc(size_t nmemb, size_t size) { return pubAlloc(nmemb * size); }
+
+/**
+ * @brief marks memory allocated with @c secAlloc as public, so it is not
+ * zeroed when it is freed
+ * @param p a pointer to memory allocated through this module
+ */
+void markPublicMem(void* p) {
+  if (p == NULL) {
+    return;
+  }
+  MEM_HEADER(p) |= MEM_PUBLIC_FLAG;
+}
+
+int isPublicMem(const void* p) {
+  if (p == NULL) {
+    return 0;
+  }
+  return (MEM_HEADER(p) & MEM_PUBLIC_FLAG) != 0;
+}
+
+static void* pubRealloc(void* p, size_t size) {
+  size_t oldsize = MEM_SIZE(p);
+  void*  fp      = realloc(p - sizeof(size_t), size + sizeof(size_t));
+  if (fp == NULL) {
+    oidc_errno = OIDC_EALLOC;
+    logger(ALERT, "Memory realloc failed when trying to allocate %lu bytes",
+           size);
+    return NULL;
+  }
+  *(size_t*)fp = size | MEM_PUBLIC_FLAG;
+  void* newp   = fp + sizeof(size_t);
+  if (size > oldsize) {
+    memset(newp + oldsize, 0, size - oldsize);
+  }
+  return newp;
+}
+
 void* secRealloc(void* p, size_t size) {
   if (p == NULL) {
     return secAlloc(size);
@@ -33,7 +108,23 @@ void* secRealloc(void* p, size_t size) {
     secFree(p);
     return NULL;
   }
-  size_t oldsize = *(size_t*)(p - sizeof(size_t));
+  if (isPublicMem(p)) {
+    return pubRealloc(p, size);
+  }
+  size_t oldsize = MEM_SIZE(p);
+#ifdef MEM_USABLE_SIZE
+  if (size + sizeof(size_t) <= MEM_USABLE_SIZE(p - sizeof(size_t))) {
+    // The allocator already reserved enough memory behind the block, so we can
+    // resize in place without copying the secret data around.
+    if (size < oldsize) {
+      moresecure_memzero(p + size, oldsize - size);
+    } else {
+      memset(p + oldsize, 0, size - oldsize);
+    }
+    MEM_HEADER(p) = size;
+    return p;
+  }
+#endif
   size_t movelen = oldsize < size ? oldsize : size;
   void*  newp    = secAlloc(size);
   if (newp == NULL) {
@@ -54,9 +145,13 @@ void _secFree(void* p) {
   if (p == NULL) {
     return;
   }
-  void*  fp  = p - sizeof(size_t);
-  size_t len = *(size_t*)fp;
-  secFreeN(fp, len);
+  void* fp = p - sizeof(size_t);
+  if (isPublicMem(p)) {
+    free(fp);
+    return;
+  }
+  size_t len = MEM_SIZE(p);
+  secFreeN(fp, len + sizeof(size_t));
 }
 /** @fn void secFree(void* p, size_t len)
  * @brief clears and frees allocated memory.
@@ -8,6 +8,10 @@
 void*           secAlloc(size_t size);
 void*           secCalloc(size_t nmemb, size_t size);
 void*           secRealloc(void* p, size_t size);
+void*           pubAlloc(size_t size);
+void*           pubCalloc(size_t nmemb, size_t size);
+void            markPublicMem(void* p);
+int             isPublicMem(const void* p);
 LIB_PUBLIC void _secFree(void* p);
 void            _secFreeN(void* p, size_t len);
 void            _secFreeArray(char** arr, size_t size);
@@ -13,60 +13,87 @@
 #include "utils/printer.h"
 #include "utils/string/stringUtils.h"
 
-char* _pollDeviceCode(const char* json_device, size_t interval,
-                      time_t expires_at, const unsigned char only_at,
-                      const unsigned char remote, struct ipcPipe* pipes) {
-  while (expires_at ? expires_at > time(NULL) : 1) {
-    sleep(interval);
-    char* res = pipes ? ipc_communicateThroughPipe(*pipes, REQUEST_DEVICE,
-                                                   json_device, only_at)
-                      : ipc_cryptCommunicate(remote, REQUEST_DEVICE,
-                                             json_device, only_at);
-  parse_response:
-    if (NULL == res) {
-      return NULL;
-    }
-    INIT_KEY_VALUE(IPC_KEY_STATUS, OIDC_KEY_ERROR, IPC_KEY_CONFIG,
-                   OIDC_KEY_ACCESSTOKEN, IPC_KEY_REQUEST, INT_IPC_KEY_ACTION,
-                   IPC_KEY_ISSUERURL, IPC_KEY_SHORTNAME);
-    if (CALL_GETJSONVALUES(res) < 0) {
-      printError("Could not decode json: %s\n", res);
-      printError("This seems to be a bug. Please hand in a bug report.\n");
-      SEC_FREE_KEY_VALUES();
-      secFree(res);
-      return NULL;
-    }
+/**
+ * @brief polls the token endpoint once for a device flow
+ * @param interval the polling interval; increased if the provider asks to
+ * slow down
+ * @param pending set to @c 1 if the user did not finish the flow yet
+ * @return the config (or the access token if @p only_at is set) or @c NULL
+ */
+static char* _pollDeviceCodeOnce(const char* json_device, size_t* interval,
+                                 const unsigned char only_at,
+                                 const unsigned char remote,
+                                 struct ipcPipe*     pipes,
+                                 unsigned char*      pending) {
+  *pending  = 0;
+  char* res = pipes ? ipc_communicateThroughPipe(*pipes, REQUEST_DEVICE,
+                                                 json_device, only_at)
+                    : ipc_cryptCommunicate(remote, REQUEST_DEVICE, json_device,
+                                           only_at);
+parse_response:
+  if (NULL == res) {
+    return NULL;
+  }
+  INIT_KEY_VALUE(IPC_KEY_STATUS, OIDC_KEY_ERROR, IPC_KEY_CONFIG,
+                 OIDC_KEY_ACCESSTOKEN, IPC_KEY_REQUEST, INT_IPC_KEY_ACTION,
+                 IPC_KEY_ISSUERURL, IPC_KEY_SHORTNAME);
+  if (CALL_GETJSONVALUES(res) < 0) {
+    printError("Could not decode json: %s\n", res);
+    printError("This seems to be a bug. Please hand in a bug report.\n");
+    SEC_FREE_KEY_VALUES();
     secFree(res);
-    KEY_VALUE_VARS(status, error, config, at, request, action, issuer,
-                   shortname);
-    if (_error) {
-      if (strequal(_error, OIDC_SLOW_DOWN)) {
-        interval++;
-        SEC_FREE_KEY_VALUES();
-        continue;
-      }
-      if (strequal(_error, OIDC_AUTHORIZATION_PENDING)) {
-        SEC_FREE_KEY_VALUES();
-        continue;
-      }
-      oidc_seterror(_error);
-      oidc_errno = OIDC_EERROR;
+    return NULL;
+  }
+  secFree(res);
+  KEY_VALUE_VARS(status, error, config, at, request, action, issuer,
+                 shortname);
+  if (_error) {
+    if (strequal(_error, OIDC_SLOW_DOWN)) {
+      (*interval)++;
+      *pending = 1;
       SEC_FREE_KEY_VALUES();
       return NULL;
     }
-    if (pipes && strcaseequal(_request, INT_REQUEST_VALUE_UPD_ISSUER)) {
-      oidcp_updateIssuerConfig(_action, _issuer, _shortname);
+    if (strequal(_error, OIDC_AUTHORIZATION_PENDING)) {
+      *pending = 1;
       SEC_FREE_KEY_VALUES();
-      res = ipc_communicateThroughPipe(*pipes, RESPONSE_SUCCESS);
-      goto parse_response;
+      return NULL;
     }
-    secFree(_status);
-    if (only_at) {
-      secFree(_config);
-    } else {
-      secFree(_at);
+    oidc_seterror(_error);
+    oidc_errno = OIDC_EERROR;
+    SEC_FREE_KEY_VALUES();
+    return NULL;
+  }
+  if (pipes && strcaseequal(_request, INT_REQUEST_VALUE_UPD_ISSUER)) {
+    oidcp_updateIssuerConfig(_action, _issuer, _shortname);
+    SEC_FREE_KEY_VALUES();
+    res = ipc_communicateThroughPipe(*pipes, RESPONSE_SUCCESS);
+    goto parse_response;
+  }
+  secFree(_status);
+  secFree(_request);
+  secFree(_action);
+  secFree(_issuer);
+  secFree(_shortname);
+  if (only_at) {
+    secFree(_config);
+  } else {
+    secFree(_at);
+  }
+  return only_at ? _at : _config;
+}
+
+char* _pollDeviceCode(const char* json_device, size_t interval,
+                      time_t expires_at, const unsigned char only_at,
+                      const unsigned char remote, struct ipcPipe* pipes) {
+  while (expires_at ? expires_at > time(NULL) : 1) {
+    sleep(interval);
+    unsigned char pending = 0;
+    char*         ret     = _pollDeviceCodeOnce(json_device, &interval, only_at,
+                                                remote, pipes, &pending);
+    if (!pending) {
+      return ret;
     }
-    return only_at ? _at : _config;
   }
   oidc_seterror("Device code is not valid any more!");
   oidc_errno = OIDC_EERROR;
@@ -86,3 +113,13 @@ char* agent_pollDeviceCode(const char* json_device, size_t interval,
   return _pollDeviceCode(json_device, interval, expires_at ?: time(NULL) + 300,
                          only_at, 0, pipes);
 }
+
+/**
+ * @brief polls the token endpoint once for a device flow of the agent; used
+ * to poll without blocking oidcp
+ * @see _pollDeviceCodeOnce
+ */
+char* agent_pollDeviceCodeOnce(const char* json_device, size_t* interval,
+                               struct ipcPipe pipes, unsigned char* pending) {
+  return _pollDeviceCodeOnce(json_device, interval, 0, 0, &pipes, pending);
+}
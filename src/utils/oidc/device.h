@@ -12,5 +12,7 @@ char* pollDeviceCode(const char* json_device, size_t interval,
 char* agent_pollDeviceCode(const char* json_device, size_t interval,
                            time_t expires_at, unsigned char only_at,
                            struct ipcPipe* pipes);
+char* agent_pollDeviceCodeOnce(const char* json_device, size_t* interval,
+                               struct ipcPipe pipes, unsigned char* pending);
 
 #endif  // OIDC_AGENT_DEVICE_H
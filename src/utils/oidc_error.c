@@ -8,8 +8,8 @@
 #include "utils/printer.h"
 #include "utils/string/stringUtils.h"
 
-int  oidc_errno;
-char oidc_error[1024];
+OIDC_THREAD_LOCAL int  oidc_thread_errno;
+OIDC_THREAD_LOCAL char oidc_thread_error[1024];
 
 void oidc_seterror(const char* error) {
   moresecure_memzero(oidc_error, sizeof(oidc_error));
@@ -108,6 +108,9 @@ char* oidc_serrorFor(oidc_error_t err) {
              "redirect uris.";
     case OIDC_ENOREURI: return "No redirect_uri specified";
     case OIDC_EHTTP0: return "Internal error: Http sent 0";
+    case OIDC_EPROVDOWN:
+      return "OpenID provider is temporarily unavailable; not contacting it "
+             "again yet";
     case OIDC_ENOSTATE: return "redirected uri did not contain state parameter";
     case OIDC_ENOCODE: return "redirected uri did not contain code parameter";
     case OIDC_ENOBASEURI: return "could not get base uri from redirected uri";
@@ -127,6 +130,9 @@ char* oidc_serrorFor(oidc_error_t err) {
     case OIDC_EGERROR: return oidc_error;
     case OIDC_EUSRPWCNCL: return "user cancelled password prompt";
     case OIDC_EFORBIDDEN: return "operation forbidden";
+    case OIDC_ENOINTERACT:
+      return "the request needs user interaction, which is not possible for "
+             "requests in a batch";
     case OIDC_NOTIMPL: return "Not yet implemented";
     case OIDC_ENOPE: return "Computer says NO!";
     default: return "Computer says NO!";
@@ -179,3 +185,18 @@ void secFreeErrorState(struct oidc_error_state* state) {
   secFree(state->oidc_error);
   secFree(state);
 }
+
+// The error state as seen by applications built against liboidc-agent 5.0.x
+#undef oidc_errno
+#undef oidc_error
+int  oidc_errno;
+char oidc_error[1024];
+
+/**
+ * @brief copies the error state of the calling thread to the process-wide
+ * @c oidc_errno and @c oidc_error objects
+ */
+void oidc_publishErrorState() {
+  oidc_errno = oidc_thread_errno;
+  memcpy(oidc_error, oidc_thread_error, sizeof(oidc_error));
+}
@@ -73,6 +73,7 @@ enum _oidc_error {
   OIDC_EHTTPPORTS = -80,
   OIDC_ENOREURI   = -82,
   OIDC_EHTTP0     = -83,
+  OIDC_EPROVDOWN  = -84,
 
   OIDC_ENOSTATE         = -85,
   OIDC_ENOCODE          = -86,
@@ -89,6 +90,7 @@ enum _oidc_error {
   OIDC_EGERROR     = -111,
   OIDC_EUSRPWCNCL  = -112,
   OIDC_EFORBIDDEN  = -113,
+  OIDC_ENOINTERACT = -114,
 
   OIDC_ELOCKED    = -120,
   OIDC_ENOTLOCKED = -121,
@@ -102,8 +104,31 @@ enum _oidc_error {
 
 typedef enum _oidc_error oidc_error_t;
 
-extern int  oidc_errno;
-extern char oidc_error[1024];
+/**
+ * The error state is kept per thread, so that threads using the library in
+ * parallel do not overwrite each others errors. @c oidc_errno and
+ * @c oidc_error refer to the state of the calling thread.
+ *
+ * Applications built against liboidc-agent 5.0.x link to plain objects with
+ * these names. They are still provided and updated when an api function
+ * returns (@c oidc_publishErrorState), but are not thread-safe; applications
+ * should use @c oidcagent_errno instead.
+ */
+#ifndef OIDC_THREAD_LOCAL
+#if defined __cplusplus && __cplusplus >= 201103L
+#define OIDC_THREAD_LOCAL thread_local
+#elif defined __STDC_VERSION__ && __STDC_VERSION__ >= 201112L
+#define OIDC_THREAD_LOCAL _Thread_local
+#else
+#define OIDC_THREAD_LOCAL __thread
+#endif
+#endif
+
+extern OIDC_THREAD_LOCAL int  oidc_thread_errno;
+extern OIDC_THREAD_LOCAL char oidc_thread_error[1024];
+
+#define oidc_errno oidc_thread_errno
+#define oidc_error oidc_thread_error
 
 struct oidc_error_state {
   int   oidc_errno;
@@ -118,6 +143,7 @@ char* oidc_serrorFor(oidc_error_t err);
 char* oidc_serror();
 int   errorMessageIsForError(const char* error_msg, oidc_error_t err);
 void  oidc_perror();
+void  oidc_publishErrorState();
 
 struct oidc_error_state* saveErrorState();
 void                     restoreErrorState(struct oidc_error_state* state);
@@ -12,6 +12,8 @@
 typedef char* (*promptFnc)(const char*, const char*, const char*,
                            unsigned char);
 
+char* oidcPromptCmd(const char* type, const char* title, const char* text,
+                    const char* label, const char* init, const int timeout);
 char* _promptPasswordGUI(const char* text, const char* label, const char* init,
                          const int timeout);
 int   _promptConsentGUIDefaultYes(const char* text, const int timeout);
@@ -0,0 +1,122 @@
+#include "intern.h"
+
+#include <string.h>
+
+#include "utils/hashmap.h"
+#include "utils/memory.h"
+
+#ifdef NO_STRING_INTERNING
+
+// Every user keeps its own copy, as before strings were interned; only used
+// to measure the memory interning saves (see account_memory_bench).
+char* intern_take(char* str) { return str; }
+
+void intern_release(char* str) { secFree(str); }
+
+size_t intern_footprint(const char* str) {
+  return str == NULL ? 0 : strlen(str) + 1;
+}
+
+struct intern_stats intern_getStats() { return (struct intern_stats){0, 0, 0}; }
+
+#else
+
+/**
+ * A pool for strings that many accounts hold with the same value, e.g. the
+ * endpoints of an issuer. Every distinct value is stored once: the interned
+ * string is the key the pool stores for it. The pool is not thread safe.
+ */
+struct interned_string {
+  size_t refs;
+};
+
+static hashmap_t* pool = NULL;  // value -> struct interned_string
+
+/**
+ * @brief returns the interned string with the value of @p str or @c NULL
+ */
+static char* _interned(const char* str) {
+  return (char*)hashmap_getKey(pool, str);
+}
+
+/**
+ * @brief interns a string
+ * @param str the string; ownership is taken. If the value is already
+ * interned, @p str is freed.
+ * @return the interned string with the value of @p str; must be released
+ * with @c intern_release
+ */
+char* intern_take(char* str) {
+  if (str == NULL) {
+    return NULL;
+  }
+  if (pool == NULL) {
+    pool = hashmap_new(64, _secFree);
+  }
+  struct interned_string* s = hashmap_get(pool, str);
+  if (s == NULL) {
+    s       = secAlloc(sizeof(struct interned_string));
+    s->refs = 1;
+    hashmap_putOwnedKey(pool, str, s);
+    return str;
+  }
+  s->refs++;
+  char* interned = _interned(str);
+  if (interned != str) {
+    secFree(str);
+  }
+  return interned;
+}
+
+/**
+ * @brief drops one reference of an interned string and frees it with the
+ * last one
+ * @note a string that was not interned is freed
+ */
+void intern_release(char* str) {
+  if (str == NULL) {
+    return;
+  }
+  if (_interned(str) != str) {
+    secFree(str);
+    return;
+  }
+  struct interned_string* s = hashmap_get(pool, str);
+  if (--s->refs == 0) {
+    _secFree(hashmap_remove(pool, str));  // also frees str
+  }
+}
+
+/**
+ * @brief returns the share of a string's memory one of its users accounts
+ * for, in bytes
+ */
+size_t intern_footprint(const char* str) {
+  if (str == NULL) {
+    return 0;
+  }
+  size_t size = strlen(str) + 1;
+  if (_interned(str) != str) {
+    return size;
+  }
+  const struct interned_string* s = hashmap_get(pool, str);
+  return (size + s->refs - 1) / s->refs;
+}
+
+static void _addStats(const char* key, void* value, void* arg) {
+  const struct interned_string* s     = value;
+  struct intern_stats*          stats = arg;
+  stats->strings++;
+  stats->references += s->refs;
+  stats->bytes += strlen(key) + 1;
+}
+
+struct intern_stats intern_getStats() {
+  struct intern_stats stats = {0, 0, 0};
+  if (pool != NULL) {
+    hashmap_foreach(pool, _addStats, &stats);
+  }
+  return stats;
+}
+
+#endif  // NO_STRING_INTERNING
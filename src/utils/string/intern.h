@@ -0,0 +1,22 @@
+#ifndef OIDC_INTERN_H
+#define OIDC_INTERN_H
+
+#include <stddef.h>
+
+/**
+ * Interned strings are shared between all their users and counted by
+ * reference. They must not be modified and must be released with
+ * @c intern_release instead of being freed.
+ */
+struct intern_stats {
+  size_t strings;     // distinct strings in the pool
+  size_t references;  // users of these strings
+  size_t bytes;       // size of the distinct strings
+};
+
+char*               intern_take(char* str);
+void                intern_release(char* str);
+size_t              intern_footprint(const char* str);
+struct intern_stats intern_getStats();
+
+#endif  // OIDC_INTERN_H
@@ -1,11 +1,18 @@
 #include "oidc_string.h"
 
+#include <string.h>
+
 #include "utils/logger.h"
 #include "utils/memory.h"
 
+#ifndef OIDC_STRING_INITIAL_CAP
+#define OIDC_STRING_INITIAL_CAP 256
+#endif
+
 oidc_error_t init_string(struct string* s) {
   s->len = 0;
-  s->ptr = secAlloc(s->len + 1);
+  s->cap = 0;
+  s->ptr = secAlloc(s->cap + 1);
 
   if (s->ptr == NULL) {
     logger(EMERGENCY, "%s (%s:%d) alloc() failed: %m\n", __func__, __FILE__,
@@ -15,3 +22,57 @@ oidc_error_t init_string(struct string* s) {
   }
   return OIDC_SUCCESS;
 }
+
+/**
+ * @brief makes sure that @p s can hold at least @p cap bytes without
+ * reallocating
+ * @param s the string buffer
+ * @param cap the needed capacity
+ * @return an oidc_error code
+ * @note the memory class (secret / public) of the buffer is kept
+ */
+oidc_error_t string_reserve(struct string* s, size_t cap) {
+  if (s == NULL || s->ptr == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return oidc_errno;
+  }
+  if (cap <= s->cap) {
+    return OIDC_SUCCESS;
+  }
+  char* tmp = secRealloc(s->ptr, cap + 1);
+  if (tmp == NULL) {
+    return oidc_errno;
+  }
+  s->ptr = tmp;
+  s->cap = cap;
+  return OIDC_SUCCESS;
+}
+
+/**
+ * @brief appends @p len bytes from @p data to @p s
+ * The capacity grows geometrically, so appending n bytes in small chunks only
+ * needs O(log n) reallocations.
+ * @param s the string buffer
+ * @param data the data to append
+ * @param len the number of bytes to append
+ * @return an oidc_error code
+ */
+oidc_error_t string_append(struct string* s, const char* data, size_t len) {
+  if (s == NULL || (data == NULL && len > 0)) {
+    oidc_setArgNullFuncError(__func__);
+    return oidc_errno;
+  }
+  size_t needed = s->len + len;
+  if (needed > s->cap) {
+    size_t cap = s->cap ? s->cap : OIDC_STRING_INITIAL_CAP;
+    while (cap < needed) { cap <<= 1; }
+    oidc_error_t e = string_reserve(s, cap);
+    if (e != OIDC_SUCCESS) {
+      return e;
+    }
+  }
+  memcpy(s->ptr + s->len, data, len);
+  s->len         = needed;
+  s->ptr[s->len] = '\0';
+  return OIDC_SUCCESS;
+}
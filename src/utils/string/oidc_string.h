@@ -5,11 +5,19 @@
 
 #include "utils/oidc_error.h"
 
+/**
+ * A growable string buffer. @c ptr is always @c '\0' terminated, @c len is the
+ * length of the content and @c cap the number of usable bytes in @c ptr
+ * (without the terminating @c '\0').
+ */
 struct string {
   char*  ptr;
   size_t len;
+  size_t cap;
 };
 
 oidc_error_t init_string(struct string* s);
+oidc_error_t string_reserve(struct string* s, size_t cap);
+oidc_error_t string_append(struct string* s, const char* data, size_t len);
 
 #endif  // OIDC_STRING_H
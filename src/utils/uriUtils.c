@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include "uriUtils.h"
 
 #include <ctype.h>
@@ -52,7 +53,8 @@ char* getBaseUri(const char* uri) {
     return NULL;
   }
   char* tmp     = oidc_strcopy(uri);
-  char* tmp_uri = strtok(tmp, "?");
+  char* saveptr = NULL;
+  char* tmp_uri = strtok_r(tmp, "?", &saveptr);
   char* base    = oidc_strcopy(tmp_uri);
   secFree(tmp);
   urldecode(base, base);
@@ -79,6 +81,24 @@ char* getTopHost(const char* uri) {
   return extracted;
 }
 
+/**
+ * @brief strips the query and fragment from an uri
+ * @param uri the uri, e.g. @c https://op.example.com/realms/a/token?x=y
+ * @return the endpoint, e.g. @c https://op.example.com/realms/a/token or
+ * @c NULL if @p uri has no scheme; has to be freed after usage
+ */
+char* getUriEndpoint(const char* uri) {
+  if (uri == NULL) {
+    oidc_setArgNullFuncError(__func__);
+    return NULL;
+  }
+  if (strstr(uri, "://") == NULL) {
+    oidc_errno = OIDC_EURL;
+    return NULL;
+  }
+  return oidc_strncopy(uri, strcspn(uri, "?#"));
+}
+
 struct codeState codeStateFromURI(const char* uri) {
   if (uri == NULL) {
     oidc_setArgNullFuncError(__func__);
@@ -129,8 +149,9 @@ char* extractParameterValueFromUri(const char* uri, const char* parameter) {
     return NULL;
   }
   params++;
-  char* param_k = strtok(params, "=");
-  char* param_v = strtok(NULL, "&");
+  char* saveptr = NULL;
+  char* param_k = strtok_r(params, "=", &saveptr);
+  char* param_v = strtok_r(NULL, "&", &saveptr);
   char* value   = NULL;
   while (value == NULL && param_k != NULL && param_v != NULL) {
     // logger(DEBUG, "URI contains parameter: %s - %s",
@@ -139,8 +160,8 @@ char* extractParameterValueFromUri(const char* uri, const char* parameter) {
       value = oidc_strcopy(param_v);
       break;
     }
-    param_k = strtok(NULL, "=");
-    param_v = strtok(NULL, "&");
+    param_k = strtok_r(NULL, "=", &saveptr);
+    param_v = strtok_r(NULL, "&", &saveptr);
   }
   secFree(tmp);
   urldecode(value, value);
@@ -16,6 +16,7 @@ char*            findCustomSchemeUri(list_t* uris);
 char* extractParameterValueFromUri(const char* uri, const char* parameter);
 char* getBaseUri(const char* uri);
 char* getTopHost(const char* uri);
+char* getUriEndpoint(const char* uri);
 oidc_error_t checkRedirectUrisForErrors(list_t* redirect_uris);
 
 #endif  // OIDC_URIUTILS_H
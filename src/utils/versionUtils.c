@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include "versionUtils.h"
 
 #include <stdio.h>
@@ -43,7 +44,8 @@ char* versionLineToSimpleVersion(const char* version_line) {
     return NULL;
   }
   char* tmp      = oidc_strcopy(version_line);
-  char* location = strtok(tmp, VERSION_LINE_FMT);
+  char* saveptr  = NULL;
+  char* location = strtok_r(tmp, VERSION_LINE_FMT, &saveptr);
   char* version  = oidc_strcopy(location);
   secFree(tmp);
   return version;
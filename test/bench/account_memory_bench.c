@@ -0,0 +1,110 @@
+/**
+ * Measures the memory oidcd needs per loaded account. The accounts are
+ * created like oidcd loads them: from their config and then updated with the
+ * metadata of their issuer. Most accounts share one of a few issuers.
+ *
+ * Usage: account_memory_bench [accounts]...
+ */
+#define _GNU_SOURCE
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "account/account.h"
+#include "utils/json.h"
+#include "utils/memory.h"
+#include "utils/string/intern.h"
+#include "utils/string/stringUtils.h"
+
+#define BENCH_ISSUERS 4
+
+static const char* scopes_supported =
+    "openid profile email offline_access eduperson_entitlement "
+    "eduperson_scoped_affiliation eduperson_unique_id eduperson_assurance "
+    "voperson_id ssh_public_key orcid entitlements storage.read:/ "
+    "storage.modify:/ storage.create:/ compute.read compute.modify "
+    "compute.create compute.cancel";
+static const char* grant_types_supported =
+    "[\"authorization_code\",\"refresh_token\",\"password\","
+    "\"client_credentials\",\"urn:ietf:params:oauth:grant-type:token-"
+    "exchange\",\"urn:ietf:params:oauth:grant-type:device_code\"]";
+static const char* response_types_supported =
+    "[\"code\",\"token\",\"id_token\",\"code id_token\",\"code token\","
+    "\"id_token token\",\"code id_token token\"]";
+
+static size_t heapUsed() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  return mallinfo2().uordblks;
+#else
+  return 0;
+#endif
+}
+
+static void setIssuerMetadata(struct oidc_account* a) {
+  struct oidc_issuer* iss = account_getIssuer(a);
+  const char*         url = issuer_getIssuerUrl(iss);
+  issuer_setTokenEndpoint(iss, oidc_sprintf("%sprotocol/openid-connect/token",
+                                            url));
+  issuer_setAuthorizationEndpoint(
+      iss, oidc_sprintf("%sprotocol/openid-connect/auth", url));
+  issuer_setRevocationEndpoint(
+      iss, oidc_sprintf("%sprotocol/openid-connect/revoke", url));
+  issuer_setRegistrationEndpoint(
+      iss, oidc_sprintf("%sclients-registrations/openid-connect", url));
+  issuer_setDeviceAuthorizationEndpoint(
+      iss, oidc_sprintf("%sprotocol/openid-connect/auth/device", url), 0);
+  issuer_setConfigurationEndpoint(
+      iss, oidc_sprintf("%s.well-known/openid-configuration", url));
+  issuer_setScopesSupported(iss, oidc_strcopy(scopes_supported));
+  issuer_setGrantTypesSupported(iss, oidc_strcopy(grant_types_supported));
+  issuer_setResponseTypesSupported(iss,
+                                   oidc_strcopy(response_types_supported));
+}
+
+static struct oidc_account* newAccount(long i) {
+  char* json = oidc_sprintf(
+      "{\"name\":\"account%ld\",\"issuer_url\":\"https://"
+      "issuer%ld.example.com/auth/realms/bench/\",\"client_id\":\"client-"
+      "%08ld\",\"client_secret\":\"secret-%032ld\",\"refresh_token\":"
+      "\"refresh-%0120ld\",\"cert_path\":\"/etc/ssl/certs/"
+      "ca-certificates.crt\",\"scope\":\"openid profile email "
+      "offline_access\",\"redirect_uris\":[\"http://localhost:4242\","
+      "\"http://localhost:8080\"]}",
+      i, i % BENCH_ISSUERS, i, i, i);
+  struct oidc_account* a = getAccountFromJSON(json);
+  secFree(json);
+  setIssuerMetadata(a);
+  char* at = oidc_sprintf("access-%0800ld", i);
+  account_setAccessToken(a, at);
+  return a;
+}
+
+static void bench(long n) {
+  struct oidc_account** accounts = secAlloc(sizeof(struct oidc_account*) * n);
+  size_t                before   = heapUsed();
+  for (long i = 0; i < n; i++) { accounts[i] = newAccount(i); }
+  size_t heap      = heapUsed() - before;
+  size_t footprint = 0;
+  for (long i = 0; i < n; i++) {
+    footprint += account_getMemoryFootprint(accounts[i]);
+  }
+  struct intern_stats stats = intern_getStats();
+  printf("%6ld accounts %10.0f heap bytes/account %10.0f footprint "
+         "bytes/account %6lu interned strings (%lu bytes)\n",
+         n, (double)heap / n, (double)footprint / n,
+         (unsigned long)stats.strings, (unsigned long)stats.bytes);
+  for (long i = 0; i < n; i++) { secFreeAccount(accounts[i]); }
+  secFree(accounts);
+}
+
+int main(int argc, char** argv) {
+  initCJSON();
+  if (argc < 2) {
+    bench(1000);
+    bench(10000);
+    return EXIT_SUCCESS;
+  }
+  for (int i = 1; i < argc; i++) { bench(atol(argv[i])); }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+/**
+ * Requests access tokens from many threads in parallel, each thread using its
+ * own library context, and checks that every thread gets a token and its own
+ * error state. Requires a running agent with the given account loaded.
+ *
+ * Usage: api_stress <account> [threads] [calls per thread]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "api/context.h"
+#include "api/error.h"
+#include "api/tokens.h"
+#include "test/bench/bench.h"
+#include "utils/memory.h"
+
+struct stress_run {
+  const char* account;
+  long        calls;
+  long        failed;
+  long        wrong_error;
+};
+
+static void* runCalls(void* arg) {
+  struct stress_run*   run = arg;
+  oidcagent_context_t* ctx = oidcagent_newContext(NULL);
+  if (ctx == NULL) {
+    run->failed = run->calls;
+    return NULL;
+  }
+  for (long i = 0; i < run->calls; i++) {
+    // Every other call fails, so errors of other threads would show up
+    const char*           account = i % 2 ? "api_stress_no_such_account"
+                                          : run->account;
+    struct agent_response res     = oidcagent_ctx_getAgentTokenResponse(
+        ctx, account, 60, NULL, "api_stress", NULL);
+    if (i % 2 == 0 && res.type != AGENT_RESPONSE_TYPE_TOKEN) {
+      run->failed++;
+    }
+    if ((i % 2 == 0) != (oidcagent_ctx_serror(ctx) == NULL)) {
+      run->wrong_error++;
+    }
+    secFreeAgentResponse(res);
+  }
+  oidcagent_freeContext(ctx);
+  return NULL;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <account> [threads] [calls per thread]\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char* account = argv[1];
+  int         threads = argc > 2 ? atoi(argv[2]) : 64;
+  long        calls   = argc > 3 ? atol(argv[3]) : 100;
+
+  char* token = getAccessToken(account, 60, NULL, "api_stress", NULL);
+  if (token == NULL) {
+    oidcagent_perror();
+    return EXIT_FAILURE;
+  }
+  secFree(token);
+
+  pthread_t*         tids  = secAlloc(sizeof(pthread_t) * threads);
+  struct stress_run* runs  = secAlloc(sizeof(struct stress_run) * threads);
+  double             start = now_s();
+  for (int i = 0; i < threads; i++) {
+    runs[i] = (struct stress_run){account, calls, 0, 0};
+    pthread_create(&tids[i], NULL, runCalls, &runs[i]);
+  }
+  long failed = 0, wrong_error = 0;
+  for (int i = 0; i < threads; i++) {
+    pthread_join(tids[i], NULL);
+    failed += runs[i].failed;
+    wrong_error += runs[i].wrong_error;
+  }
+  double elapsed = now_s() - start;
+  printf("%8ld calls %3d threads %8.3f s %10.0f calls/s %ld failed %ld wrong "
+         "errors\n",
+         calls * threads, threads, elapsed, calls * threads / elapsed, failed,
+         wrong_error);
+  secFree(tids);
+  secFree(runs);
+  return failed == 0 && wrong_error == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,117 @@
+/**
+ * Compares blocking access token requests with asynchronous requests that are
+ * driven by a single poll loop with many requests outstanding at the same
+ * time. Also serves as an example of how to integrate the asynchronous api
+ * into an event loop. Requires a running agent with the given account loaded.
+ *
+ * Usage: async_bench <account> [calls] [outstanding]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "api/async.h"
+#include "api/error.h"
+#include "api/tokens.h"
+#include "test/bench/bench.h"
+#include "utils/memory.h"
+
+struct bench_state {
+  long done;
+  long failed;
+};
+
+static void report(const char* name, long calls, long outstanding,
+                   double elapsed, long failed) {
+  printf("%-10s %8ld calls %4ld outstanding %8.3f s %10.0f calls/s %ld "
+         "failed\n",
+         name, calls, outstanding, elapsed, calls / elapsed, failed);
+}
+
+static void onResponse(struct agent_response res, void* arg) {
+  struct bench_state* state = arg;
+  state->done++;
+  if (res.type != AGENT_RESPONSE_TYPE_TOKEN) {
+    state->failed++;
+  }
+  secFreeAgentResponse(res);
+}
+
+static void benchBlocking(const char* account, long calls) {
+  long   failed = 0;
+  double start  = now_s();
+  for (long i = 0; i < calls; i++) {
+    struct agent_response res =
+        getAgentTokenResponse(account, 60, NULL, "async_bench", NULL);
+    if (res.type != AGENT_RESPONSE_TYPE_TOKEN) {
+      failed++;
+    }
+    secFreeAgentResponse(res);
+  }
+  report("blocking", calls, 1, now_s() - start, failed);
+}
+
+static void benchAsync(const char* account, long calls, long outstanding) {
+  oidcagent_request_t** reqs =
+      secAlloc(sizeof(oidcagent_request_t*) * outstanding);
+  struct pollfd*     fds     = secAlloc(sizeof(struct pollfd) * outstanding);
+  struct bench_state state   = {0, 0};
+  long               started = 0;
+  double             start   = now_s();
+  while (state.done < calls) {
+    // Keep the given number of requests in flight
+    for (long i = 0; i < outstanding && started < calls; i++) {
+      if (reqs[i] == NULL) {
+        reqs[i] = oidcagent_startTokenRequest(
+            NULL, account, 60, NULL, "async_bench", NULL, onResponse, &state);
+        started++;
+        if (reqs[i] == NULL) {
+          state.done++;
+          state.failed++;
+        }
+      }
+    }
+    for (long i = 0; i < outstanding; i++) {
+      fds[i].fd     = reqs[i] ? oidcagent_requestFd(reqs[i]) : -1;
+      fds[i].events = reqs[i] ? oidcagent_requestEvents(reqs[i]) : 0;
+    }
+    if (poll(fds, outstanding, 1000) < 0) {
+      perror("poll");
+      break;
+    }
+    for (long i = 0; i < outstanding; i++) {
+      if (reqs[i] != NULL && fds[i].revents &&
+          oidcagent_requestStep(reqs[i]) == OIDCAGENT_REQUEST_DONE) {
+        reqs[i] = NULL;
+      }
+    }
+  }
+  report("async", calls, outstanding, now_s() - start, state.failed);
+  secFree(reqs);
+  secFree(fds);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <account> [calls] [outstanding]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char* account     = argv[1];
+  long        calls       = argc > 2 ? atol(argv[2]) : 1000;
+  long        outstanding = argc > 3 ? atol(argv[3]) : 32;
+
+  char* token = getAccessToken(account, 60, NULL, "async_bench", NULL);
+  if (token == NULL) {
+    oidcagent_perror();
+    return EXIT_FAILURE;
+  }
+  secFree(token);
+
+  benchBlocking(account, calls);
+  benchAsync(account, calls, 1);
+  benchAsync(account, calls, outstanding);
+  return EXIT_SUCCESS;
+}
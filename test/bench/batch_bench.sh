@@ -0,0 +1,47 @@
+#!/bin/sh
+# Compares requesting the access tokens of many accounts with one oidc-token
+# call per account (as a shell loop would do) to a single oidc-token --batch
+# call. Requires a running agent with the given accounts loaded.
+#
+# Usage: batch_bench.sh <oidc-token> <calls> <account>...
+
+if [ $# -lt 3 ]; then
+  echo "Usage: $0 <oidc-token> <calls> <account>..." >&2
+  exit 1
+fi
+TOKEN=$1
+CALLS=$2
+shift 2
+
+SPECS=$(mktemp)
+trap 'rm -f "$SPECS"' EXIT
+i=0
+while [ $i -lt "$CALLS" ]; do
+  for account in "$@"; do
+    echo "$account"
+  done
+  i=$((i + 1))
+done >"$SPECS"
+N=$(wc -l <"$SPECS")
+
+now() {
+  date +%s.%N
+}
+
+# report <name> <start> <failed>
+report() {
+  echo "$1 $N $2 $(now) $3" |
+    awk '{ t = $4 - $3; printf "%-6s %8d tokens %8.3f s %10.0f tokens/s " \
+           "%d failed\n", $1, $2, t, $2 / t, $5 }'
+}
+
+failed=0
+start=$(now)
+while read -r account; do
+  "$TOKEN" "$account" >/dev/null 2>&1 || failed=$((failed + 1))
+done <"$SPECS"
+report loop "$start" $failed
+
+start=$(now)
+failed=$("$TOKEN" --batch="$SPECS" 2>/dev/null | grep -c '"error"')
+report batch "$start" "$failed"
@@ -0,0 +1,16 @@
+#ifndef TEST_BENCH_BENCH_H
+#define TEST_BENCH_BENCH_H
+
+#include <time.h>
+
+/**
+ * @brief returns the time of the monotonic clock in seconds
+ * @note the including file has to define @c _POSIX_C_SOURCE
+ */
+static inline double now_s() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#endif  // TEST_BENCH_BENCH_H
@@ -0,0 +1,159 @@
+/**
+ * Compares blocking http requests with requests driven by the curl multi
+ * engine against a local stand-in OP that answers every request after a fixed
+ * delay.
+ *
+ * Usage: http_bench [requests] [latency in ms]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "oidc-agent/http/http.h"
+#include "oidc-agent/http/http_multi.h"
+#include "test/bench/bench.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+#define BENCH_RESPONSE_BODY \
+  "{\"access_token\":\"bench\",\"token_type\":\"Bearer\",\"expires_in\":3600}"
+
+static void serveConnection(int con, long latency_ms) {
+  char   buf[4096];
+  size_t len = 0;
+  while (len < sizeof(buf) - 1) {
+    ssize_t r = read(con, buf + len, sizeof(buf) - 1 - len);
+    if (r <= 0) {
+      break;
+    }
+    len += r;
+    buf[len] = '\0';
+    if (strstr(buf, "\r\n\r\n")) {
+      break;
+    }
+  }
+  struct timespec delay = {latency_ms / 1000, (latency_ms % 1000) * 1000000};
+  nanosleep(&delay, NULL);
+  char* res = oidc_sprintf(
+      "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: "
+      "%lu\r\nConnection: close\r\n\r\n%s",
+      (unsigned long)strlen(BENCH_RESPONSE_BODY), BENCH_RESPONSE_BODY);
+  if (write(con, res, strlen(res)) < 0) {
+    perror("write");
+  }
+  secFree(res);
+  close(con);
+}
+
+/**
+ * @brief starts the stand-in OP; every connection is served by its own
+ * process, so the OP itself never serializes requests
+ * @return the pid of the server
+ */
+static pid_t startStandInOP(long latency_ms, unsigned short* port) {
+  int                sock = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = {0};
+  addr.sin_family         = AF_INET;
+  addr.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len      = sizeof(addr);
+  if (sock < 0 || bind(sock, (struct sockaddr*)&addr, addr_len) != 0 ||
+      listen(sock, 256) != 0 ||
+      getsockname(sock, (struct sockaddr*)&addr, &addr_len) != 0) {
+    perror("stand-in OP");
+    exit(EXIT_FAILURE);
+  }
+  *port     = ntohs(addr.sin_port);
+  pid_t pid = fork();
+  if (pid != 0) {
+    close(sock);
+    return pid;
+  }
+  signal(SIGCHLD, SIG_IGN);
+  while (1) {
+    int con = accept(sock, NULL, NULL);
+    if (con < 0) {
+      continue;
+    }
+    if (fork() == 0) {
+      close(sock);
+      serveConnection(con, latency_ms);
+      exit(EXIT_SUCCESS);
+    }
+    close(con);
+  }
+}
+
+static double benchBlocking(const char* url, int n) {
+  double start = now_s();
+  for (int i = 0; i < n; i++) {
+    char* res = _httpsGET(url, NULL, NULL);
+    if (res == NULL) {
+      fprintf(stderr, "request %d failed\n", i);
+    }
+    secFree(res);
+  }
+  return now_s() - start;
+}
+
+static void benchDone(struct http_request* req, oidc_error_t err, void* arg) {
+  int*  done = arg;
+  char* res  = http_finishRequest(req, err);
+  if (res == NULL) {
+    fprintf(stderr, "request failed\n");
+  }
+  secFree(res);
+  (*done)++;
+}
+
+static double benchMulti(const char* url, int n) {
+  double start = now_s();
+  int    done  = 0;
+  for (int i = 0; i < n; i++) {
+    struct http_request* req = _httpsPrepareGET(url, NULL, NULL);
+    if (req == NULL || httpMulti_add(req, benchDone, &done) != OIDC_SUCCESS) {
+      fprintf(stderr, "could not start request %d\n", i);
+      done++;
+    }
+  }
+  while (done < n) {
+    fd_set read_fds, write_fds;
+    FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    int             maxfd = httpMulti_fdset(&read_fds, &write_fds, -1);
+    struct timeval  tv;
+    struct timeval* timeout = httpMulti_timeout(&tv);
+    select(maxfd + 1, &read_fds, &write_fds, NULL, timeout);
+    httpMulti_perform(&read_fds, &write_fds);
+  }
+  return now_s() - start;
+}
+
+int main(int argc, char** argv) {
+  int  n          = argc > 1 ? atoi(argv[1]) : 50;
+  long latency_ms = argc > 2 ? atol(argv[2]) : 200;
+  if (n <= 0 || latency_ms < 0) {
+    fprintf(stderr, "Usage: %s [requests] [latency in ms]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  unsigned short port;
+  pid_t          op  = startStandInOP(latency_ms, &port);
+  char*          url = oidc_sprintf("http://127.0.0.1:%hu/token", port);
+
+  double blocking = benchBlocking(url, n);
+  double multi    = benchMulti(url, n);
+  printf("%d requests, %ld ms latency\n", n, latency_ms);
+  printf("blocking:   %8.3f s (%8.1f req/s)\n", blocking, n / blocking);
+  printf("curl multi: %8.3f s (%8.1f req/s)\n", multi, n / multi);
+
+  secFree(url);
+  kill(op, SIGTERM);
+  return EXIT_SUCCESS;
+}
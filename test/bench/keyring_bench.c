@@ -0,0 +1,82 @@
+/**
+ * Compares access token requests that are answered by the agent over its
+ * socket with requests that are served from the kernel keyring. Requires a
+ * running agent that was started with --kernel-keyring and has the given
+ * account loaded.
+ *
+ * Usage: keyring_bench <account> [calls]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "api/context.h"
+#include "api/error.h"
+#include "api/tokens.h"
+#include "test/bench/bench.h"
+#include "utils/memory.h"
+
+static void report(const char* name, long calls, double elapsed,
+                   long failed) {
+  printf("%-8s %8ld calls %8.3f s %12.0f calls/s %8.2f us/call %ld failed\n",
+         name, calls, elapsed, calls / elapsed, elapsed * 1e6 / calls,
+         failed);
+}
+
+// Requests through a context always go to the agent
+static void benchAgent(const char* account, long calls) {
+  oidcagent_context_t* ctx = oidcagent_newContext(NULL);
+  if (ctx == NULL) {
+    oidcagent_perror();
+    return;
+  }
+  long   failed = 0;
+  double start  = now_s();
+  for (long i = 0; i < calls; i++) {
+    struct agent_response res = oidcagent_ctx_getAgentTokenResponse(
+        ctx, account, 60, NULL, "keyring_bench", NULL);
+    if (res.type != AGENT_RESPONSE_TYPE_TOKEN) {
+      failed++;
+    }
+    secFreeAgentResponse(res);
+  }
+  report("agent", calls, now_s() - start, failed);
+  oidcagent_freeContext(ctx);
+}
+
+static void benchKeyring(const char* account, long calls) {
+  long   failed = 0;
+  double start  = now_s();
+  for (long i = 0; i < calls; i++) {
+    struct agent_response res =
+        getAgentTokenResponse(account, 60, NULL, "keyring_bench", NULL);
+    if (res.type != AGENT_RESPONSE_TYPE_TOKEN) {
+      failed++;
+    }
+    secFreeAgentResponse(res);
+  }
+  report("keyring", calls, now_s() - start, failed);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <account> [calls]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char* account = argv[1];
+  long        calls   = argc > 2 ? atol(argv[2]) : 1000;
+
+  // The agent publishes the token in the keyring with the first request
+  char* token = getAccessToken(account, 60, NULL, "keyring_bench", NULL);
+  if (token == NULL) {
+    oidcagent_perror();
+    return EXIT_FAILURE;
+  }
+  secFree(token);
+
+  benchAgent(account, calls);
+  benchKeyring(account, calls * 100);
+  return EXIT_SUCCESS;
+}
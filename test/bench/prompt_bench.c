@@ -0,0 +1,103 @@
+/**
+ * Measures the latency of access token requests while the agent shows a
+ * prompt for another request. A request for the first account is started that
+ * makes the agent prompt the user, e.g. because the account was loaded with
+ * confirmation or is not loaded and has to be decrypted; the prompt is left
+ * open while tokens for the second, loaded account are requested. The latency
+ * must stay as low as without an open prompt. Requires a running agent.
+ *
+ * Usage: prompt_bench <prompting account> <account> [calls]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "api/async.h"
+#include "api/error.h"
+#include "api/tokens.h"
+#include "test/bench/bench.h"
+#include "utils/memory.h"
+
+static void onResponse(struct agent_response res, void* arg) {
+  int* done = arg;
+  *done     = res.type == AGENT_RESPONSE_TYPE_TOKEN ? 1 : -1;
+  secFreeAgentResponse(res);
+}
+
+static int step(oidcagent_request_t* req, int timeout_ms) {
+  struct pollfd fd = {oidcagent_requestFd(req), oidcagent_requestEvents(req),
+                      0};
+  if (poll(&fd, 1, timeout_ms) > 0) {
+    return oidcagent_requestStep(req);
+  }
+  return OIDCAGENT_REQUEST_PENDING;
+}
+
+static double bench(const char* name, const char* account, long calls) {
+  double max    = 0;
+  long   failed = 0;
+  double start  = now_s();
+  for (long i = 0; i < calls; i++) {
+    double                s   = now_s();
+    struct agent_response res =
+        getAgentTokenResponse(account, 60, NULL, "prompt_bench", NULL);
+    double d = now_s() - s;
+    if (d > max) {
+      max = d;
+    }
+    if (res.type != AGENT_RESPONSE_TYPE_TOKEN) {
+      failed++;
+    }
+    secFreeAgentResponse(res);
+  }
+  double avg = (now_s() - start) / calls;
+  printf("%-14s %8ld calls %10.3f ms avg %10.3f ms max %ld failed\n", name,
+         calls, avg * 1e3, max * 1e3, failed);
+  return avg;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s <prompting account> <account> [calls]\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char* prompting = argv[1];
+  const char* account   = argv[2];
+  long        calls     = argc > 3 ? atol(argv[3]) : 1000;
+
+  char* token = getAccessToken(account, 60, NULL, "prompt_bench", NULL);
+  if (token == NULL) {
+    oidcagent_perror();
+    return EXIT_FAILURE;
+  }
+  secFree(token);
+  double idle = bench("no prompt", account, calls);
+
+  int                  done = 0;
+  oidcagent_request_t* req  = oidcagent_startTokenRequest(
+      NULL, prompting, 60, NULL, "prompt_bench", NULL, onResponse, &done);
+  if (req == NULL) {
+    oidcagent_perror();
+    return EXIT_FAILURE;
+  }
+  // Give the agent some time to start the prompt
+  double until = now_s() + 1;
+  while (now_s() < until && step(req, 100) == OIDCAGENT_REQUEST_PENDING) {
+  }
+  if (done != 0) {
+    fprintf(stderr, "The agent did not prompt for '%s'\n", prompting);
+    return EXIT_FAILURE;
+  }
+  double busy = bench("open prompt", account, calls);
+
+  printf("Answer the prompt to finish\n");
+  while (step(req, 1000) == OIDCAGENT_REQUEST_PENDING) {
+  }
+  printf("Prompted request %s\n", done > 0 ? "succeeded" : "failed");
+  // Without asynchronous prompts the requests would wait for the user
+  return busy < idle * 10 + 0.01 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
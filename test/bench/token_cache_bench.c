@@ -0,0 +1,129 @@
+/**
+ * Measures how many access token requests per second liboidc-agent serves
+ * with and without the in-process token cache. Requires a running agent with
+ * the given account loaded. Without an account only the eviction benchmark,
+ * which does not need an agent, is run.
+ *
+ * Usage: token_cache_bench [<account> [calls] [threads]]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "api/error.h"
+#include "api/token_cache.h"
+#include "api/tokens.h"
+#include "test/bench/bench.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+#define EVICTION_ROUNDS 2000
+
+struct bench_run {
+  const char* account;
+  long        calls;
+  long        failed;
+};
+
+static void* runCalls(void* arg) {
+  struct bench_run* run = arg;
+  for (long i = 0; i < run->calls; i++) {
+    struct agent_response res = getAgentTokenResponse(
+        run->account, 60, NULL, "token_cache_bench", NULL);
+    if (res.type != AGENT_RESPONSE_TYPE_TOKEN) {
+      run->failed++;
+    }
+    secFreeAgentResponse(res);
+  }
+  return NULL;
+}
+
+static void bench(const char* name, const char* account, long calls,
+                  int threads) {
+  pthread_t*        tids  = secAlloc(sizeof(pthread_t) * threads);
+  struct bench_run* runs  = secAlloc(sizeof(struct bench_run) * threads);
+  double            start = now_s();
+  for (int i = 0; i < threads; i++) {
+    runs[i] = (struct bench_run){account, calls / threads, 0};
+    pthread_create(&tids[i], NULL, runCalls, &runs[i]);
+  }
+  long failed = 0;
+  for (int i = 0; i < threads; i++) {
+    pthread_join(tids[i], NULL);
+    failed += runs[i].failed;
+  }
+  double elapsed = now_s() - start;
+  printf("%-24s %8ld calls %3d threads %8.3f s %12.0f calls/s %ld failed\n",
+         name, calls, threads, elapsed, calls / elapsed, failed);
+  secFree(tids);
+  secFree(runs);
+}
+
+static void cacheRequest(const char* account, long* hits) {
+  struct agent_response res;
+  if (tokenCache_get(account, NULL, 60, NULL, NULL, &res)) {
+    (*hits)++;
+    secFreeAgentResponse(res);
+    return;
+  }
+  res.type           = AGENT_RESPONSE_TYPE_TOKEN;
+  res.token_response = (struct token_response){
+      "token", "https://issuer.example.com", time(NULL) + 3600};
+  tokenCache_update(account, NULL, NULL, NULL, &res);
+}
+
+// Requests a hot set of half the cache size, each request followed by one for
+// an account that is only used once, as an application serving many users
+// would. Reports how many requests of the hot set were served by the cache.
+static void benchEviction(long rounds) {
+  oidcagent_enableTokenCache(1);
+  long   hot   = TOKEN_CACHE_MAX_ENTRIES / 2;
+  long   hits  = 0;
+  long   cold  = 0;
+  long   other = 0;
+  double start = now_s();
+  for (long r = 0; r < rounds; r++) {
+    for (long i = 0; i < hot; i++) {
+      char* account = oidc_sprintf("hot%ld", i);
+      cacheRequest(account, &hits);
+      secFree(account);
+      account = oidc_sprintf("cold%ld", cold++);
+      cacheRequest(account, &other);
+      secFree(account);
+    }
+  }
+  double elapsed = now_s() - start;
+  long   calls   = 2 * rounds * hot;
+  printf("%-24s %8ld calls %8.3f s %12.0f calls/s %5.1f%% hot hits\n",
+         "eviction", calls, elapsed, calls / elapsed,
+         100.0 * hits / (rounds * hot));
+  oidcagent_enableTokenCache(0);
+}
+
+int main(int argc, char** argv) {
+  benchEviction(EVICTION_ROUNDS);
+  if (argc < 2) {
+    return EXIT_SUCCESS;
+  }
+  const char* account = argv[1];
+  long        calls   = argc > 2 ? atol(argv[2]) : 1000;
+  int         threads = argc > 3 ? atoi(argv[3]) : 4;
+
+  char* token = getAccessToken(account, 60, NULL, "token_cache_bench", NULL);
+  if (token == NULL) {
+    oidcagent_perror();
+    return EXIT_FAILURE;
+  }
+  secFree(token);
+
+  // Round trips to the agent, as a baseline for the cache
+  bench("agent", account, calls, 1);
+  oidcagent_enableTokenCache(1);
+  bench("cache", account, calls * 100, 1);
+  bench("cache", account, calls * 100, threads);
+  oidcagent_enableTokenCache(0);
+  return EXIT_SUCCESS;
+}
@@ -1,9 +1,11 @@
 #include "suite.h"
 
 #include "tc_defineUsableScopes.h"
+#include "tc_snapshot.h"
 
 Suite* test_suite_account() {
   Suite* ts_account = suite_create("account");
   suite_add_tcase(ts_account, test_case_defineUsableScopes());
+  suite_add_tcase(ts_account, test_case_snapshot());
   return ts_account;
 }
@@ -0,0 +1,67 @@
+#include "tc_snapshot.h"
+
+#include "account/account.h"
+#include "utils/json.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+static struct oidc_account* newAccount() {
+  struct oidc_account* a = getAccountFromJSON(
+      "{\"name\":\"test\",\"issuer_url\":\"https://example.com/\","
+      "\"client_id\":\"id\",\"client_secret\":\"secret\","
+      "\"refresh_token\":\"refresh\",\"scope\":\"openid profile\"}");
+  struct oidc_issuer* iss = account_getIssuer(a);
+  issuer_setTokenEndpoint(iss, oidc_strcopy("https://example.com/token"));
+  issuer_setScopesSupported(iss, oidc_strcopy("openid profile email"));
+  account_setAccessToken(a, oidc_strcopy("access"));
+  account_setTokenExpiresAt(a, 4242);
+  account_setDeath(a, 2424);
+  account_setConfirmationRequired(a);
+  return a;
+}
+
+static struct oidc_account* roundTrip(const struct oidc_account* a) {
+  cJSON* json = accountToSnapshotJSON(a);
+  char*  str  = jsonToStringUnformatted(json);
+  secFreeJson(json);
+  struct oidc_account* b = getAccountFromSnapshotJSON(str);
+  secFree(str);
+  return b;
+}
+
+START_TEST(test_roundTrip) {
+  initCJSON();
+  struct oidc_account* a = newAccount();
+  struct oidc_account* b = roundTrip(a);
+  ck_assert_ptr_ne(b, NULL);
+  ck_assert_str_eq(account_getName(b), "test");
+  ck_assert_str_eq(account_getRefreshToken(b), "refresh");
+  ck_assert_str_eq(account_getAccessToken(b), "access");
+  ck_assert_str_eq(issuer_getTokenEndpoint(account_getIssuer(b)),
+                   "https://example.com/token");
+  ck_assert_str_eq(issuer_getScopesSupported(account_getIssuer(b)),
+                   "openid profile email");
+  ck_assert_str_eq(account_getScope(b), "openid profile");
+  ck_assert(account_getTokenExpiresAt(b) == 4242);
+  ck_assert(account_getDeath(b) == 2424);
+  ck_assert(account_getConfirmationRequired(b));
+  ck_assert(!account_getAlwaysAllowId(b));
+  secFreeAccount(a);
+  secFreeAccount(b);
+}
+END_TEST
+
+START_TEST(test_noMetadata) {
+  initCJSON();
+  struct oidc_account* a = getAccountFromSnapshotJSON(
+      "{\"name\":\"test\",\"issuer_url\":\"https://example.com/\"}");
+  ck_assert_ptr_eq(a, NULL);
+}
+END_TEST
+
+TCase* test_case_snapshot() {
+  TCase* tc = tcase_create("snapshot");
+  tcase_add_test(tc, test_roundTrip);
+  tcase_add_test(tc, test_noMetadata);
+  return tc;
+}
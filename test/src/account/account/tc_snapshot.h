@@ -0,0 +1,8 @@
+#ifndef TEST_ACCOUNT_ACCOUNT_SNAPSHOT_H
+#define TEST_ACCOUNT_ACCOUNT_SNAPSHOT_H
+
+#include <check.h>
+
+TCase* test_case_snapshot();
+
+#endif  // TEST_ACCOUNT_ACCOUNT_SNAPSHOT_H
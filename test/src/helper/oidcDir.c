@@ -0,0 +1,40 @@
+#define _XOPEN_SOURCE 700
+#include "oidcDir.h"
+
+#include <stdlib.h>
+
+#include "defines/settings.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+/**
+ * @brief creates an empty temporary directory and uses it as oidc dir
+ * @return the path of the directory or @c NULL; has to be passed to
+ * @c test_removeOidcDir
+ */
+char* test_newOidcDir() {
+  char* dir = oidc_strcopy("/tmp/oidc-test-XXXXXX");
+  if (mkdtemp(dir) == NULL) {
+    secFree(dir);
+    return NULL;
+  }
+  setenv(OIDC_CONFIG_DIR_ENV_NAME, dir, 1);
+  return dir;
+}
+
+/**
+ * @brief removes a directory created by @c test_newOidcDir, so that later
+ * tests do not use it
+ * @return @c 0 on success
+ */
+int test_removeOidcDir(char* dir) {
+  unsetenv(OIDC_CONFIG_DIR_ENV_NAME);
+  if (dir == NULL) {
+    return -1;
+  }
+  char* cmd = oidc_sprintf("rm -rf '%s'", dir);
+  int   ret = system(cmd);
+  secFree(cmd);
+  secFree(dir);
+  return ret;
+}
@@ -0,0 +1,7 @@
+#ifndef TEST_HELPER_OIDCDIR_H
+#define TEST_HELPER_OIDCDIR_H
+
+char* test_newOidcDir();
+int   test_removeOidcDir(char* dir);
+
+#endif  // TEST_HELPER_OIDCDIR_H
@@ -3,9 +3,23 @@
 #include <syslog.h>
 
 #include "test/src/account/account/suite.h"
+#include "test/src/oidc-agent/http/circuit_breaker/suite.h"
+#include "test/src/oidc-agent/oidc/flows/negative_cache/suite.h"
+#include "test/src/oidc-agent/oidcp/async_prompt/suite.h"
+#include "test/src/oidc-agent/oidcp/no_prompt/suite.h"
+#include "test/src/utils/accountIndex/suite.h"
 #include "test/src/utils/crypt/crypt/suite.h"
 #include "test/src/utils/crypt/memoryCrypt/suite.h"
+#include "test/src/utils/db/suite.h"
+#include "test/src/utils/hashmap/suite.h"
+#include "test/src/utils/intern/suite.h"
+#include "test/src/utils/issuerConfig/suite.h"
 #include "test/src/utils/json/suite.h"
+#include "test/src/utils/kernelKeyring/suite.h"
+#include "test/src/utils/listUtils/suite.h"
+#include "test/src/utils/memory/suite.h"
+#include "test/src/utils/oidc_error/suite.h"
+#include "test/src/utils/oidc_string/suite.h"
 #include "test/src/utils/portUtils/suite.h"
 #include "test/src/utils/stringUtils/suite.h"
 #include "test/src/utils/uriUtils/suite.h"
@@ -29,5 +43,19 @@ int main() {
   number_failed |= runSuite(test_suite_crypt());
   number_failed |= runSuite(test_suite_account());
   number_failed |= runSuite(test_suite_uriUtils());
+  number_failed |= runSuite(test_suite_memory());
+  number_failed |= runSuite(test_suite_oidc_string());
+  number_failed |= runSuite(test_suite_listUtils());
+  number_failed |= runSuite(test_suite_hashmap());
+  number_failed |= runSuite(test_suite_issuerConfig());
+  number_failed |= runSuite(test_suite_oidc_error());
+  number_failed |= runSuite(test_suite_kernelKeyring());
+  number_failed |= runSuite(test_suite_db());
+  number_failed |= runSuite(test_suite_intern());
+  number_failed |= runSuite(test_suite_accountIndex());
+  number_failed |= runSuite(test_suite_asyncPrompt());
+  number_failed |= runSuite(test_suite_negativeCache());
+  number_failed |= runSuite(test_suite_circuitBreaker());
+  number_failed |= runSuite(test_suite_noPrompt());
   return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_circuitBreaker.h"
+
+Suite* test_suite_circuitBreaker() {
+  Suite* ts_circuitBreaker = suite_create("circuitBreaker");
+  suite_add_tcase(ts_circuitBreaker, test_case_circuitBreaker());
+  return ts_circuitBreaker;
+}
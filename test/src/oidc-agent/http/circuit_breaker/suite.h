@@ -0,0 +1,8 @@
+#ifndef TEST_OIDCAGENT_HTTP_CIRCUITBREAKER_SUITE_H
+#define TEST_OIDCAGENT_HTTP_CIRCUITBREAKER_SUITE_H
+
+#include <check.h>
+
+Suite* test_suite_circuitBreaker();
+
+#endif  // TEST_OIDCAGENT_HTTP_CIRCUITBREAKER_SUITE_H
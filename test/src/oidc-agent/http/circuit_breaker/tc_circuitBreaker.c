@@ -0,0 +1,58 @@
+#include "tc_circuitBreaker.h"
+
+#include "oidc-agent/http/circuit_breaker.h"
+#include "utils/oidc_error.h"
+
+#define HOST "https://op.example.com/realms/"
+#define TOKEN_ENDPOINT "/protocol/openid-connect/token"
+
+static void _fail(const char* url) {
+  for (int i = 0; i < AGENT_CB_FAILURE_THRESHOLD; i++) {
+    ck_assert_int_eq(circuitBreaker_allow(url), OIDC_SUCCESS);
+    circuitBreaker_record(url, 503);
+  }
+}
+
+START_TEST(test_sharedHost) {
+  const char* a = HOST "a" TOKEN_ENDPOINT;
+  const char* b = HOST "b" TOKEN_ENDPOINT;
+  _fail(a);
+  ck_assert_int_eq(circuitBreaker_allow(a), OIDC_EPROVDOWN);
+  // another issuer on the same host is still available
+  ck_assert_int_eq(circuitBreaker_allow(b), OIDC_SUCCESS);
+  circuitBreaker_record(b, OIDC_SUCCESS);
+  ck_assert_int_eq(circuitBreaker_allow(a), OIDC_EPROVDOWN);
+}
+END_TEST
+
+START_TEST(test_query) {
+  const char* c = HOST "c" TOKEN_ENDPOINT;
+  _fail(HOST "c" TOKEN_ENDPOINT "?attempt=1");
+  ck_assert_int_eq(circuitBreaker_allow(c), OIDC_EPROVDOWN);
+  ck_assert_int_eq(circuitBreaker_allow(HOST "c" TOKEN_ENDPOINT "#x"),
+                   OIDC_EPROVDOWN);
+}
+END_TEST
+
+START_TEST(test_success) {
+  const char* d = HOST "d" TOKEN_ENDPOINT;
+  for (int i = 0; i < AGENT_CB_FAILURE_THRESHOLD - 1; i++) {
+    ck_assert_int_eq(circuitBreaker_allow(d), OIDC_SUCCESS);
+    circuitBreaker_record(d, OIDC_EURL);
+  }
+  // an error answer shows that the provider is reachable
+  ck_assert_int_eq(circuitBreaker_allow(d), OIDC_SUCCESS);
+  circuitBreaker_record(d, 400);
+  ck_assert_int_eq(circuitBreaker_allow(d), OIDC_SUCCESS);
+  circuitBreaker_record(d, OIDC_EURL);
+  ck_assert_int_eq(circuitBreaker_allow(d), OIDC_SUCCESS);
+}
+END_TEST
+
+TCase* test_case_circuitBreaker() {
+  TCase* tc = tcase_create("circuitBreaker");
+  tcase_add_test(tc, test_sharedHost);
+  tcase_add_test(tc, test_query);
+  tcase_add_test(tc, test_success);
+  return tc;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_OIDCAGENT_HTTP_CIRCUITBREAKER_CIRCUITBREAKER_H
+#define TEST_OIDCAGENT_HTTP_CIRCUITBREAKER_CIRCUITBREAKER_H
+
+#include <check.h>
+
+TCase* test_case_circuitBreaker();
+
+#endif  // TEST_OIDCAGENT_HTTP_CIRCUITBREAKER_CIRCUITBREAKER_H
@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_negativeCache.h"
+
+Suite* test_suite_negativeCache() {
+  Suite* ts_negativeCache = suite_create("negativeCache");
+  suite_add_tcase(ts_negativeCache, test_case_negativeCache());
+  return ts_negativeCache;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_OIDCAGENT_OIDC_FLOWS_NEGATIVECACHE_SUITE_H
+#define TEST_OIDCAGENT_OIDC_FLOWS_NEGATIVECACHE_SUITE_H
+
+#include <check.h>
+
+Suite* test_suite_negativeCache();
+
+#endif  // TEST_OIDCAGENT_OIDC_FLOWS_NEGATIVECACHE_SUITE_H
@@ -0,0 +1,48 @@
+#include "tc_negativeCache.h"
+
+#include "oidc-agent/oidc/flows/negative_cache.h"
+#include "utils/oidc_error.h"
+
+#define INVALID_GRANT "invalid_grant: refresh token expired"
+
+START_TEST(test_storeNew) {
+  oidc_seterror(INVALID_GRANT);
+  oidc_errno = OIDC_EOIDC;
+  // the key was never stored, so there is no entry to replace
+  negativeCache_store("new");
+  oidc_errno = OIDC_SUCCESS;
+  ck_assert(negativeCache_lookup("new"));
+  ck_assert_int_eq(oidc_errno, OIDC_EOIDC);
+  ck_assert_str_eq(oidc_serror(), INVALID_GRANT);
+  ck_assert(!negativeCache_lookup("other"));
+}
+END_TEST
+
+START_TEST(test_storeAgain) {
+  oidc_seterror(INVALID_GRANT);
+  oidc_errno = OIDC_EOIDC;
+  negativeCache_store("again");
+  oidc_seterror("invalid_grant: refresh token revoked");
+  negativeCache_store("again");
+  ck_assert(negativeCache_lookup("again"));
+  ck_assert_str_eq(oidc_serror(), "invalid_grant: refresh token revoked");
+}
+END_TEST
+
+START_TEST(test_prune) {
+  oidc_seterror(INVALID_GRANT);
+  oidc_errno = OIDC_EOIDC;
+  negativeCache_store("prune");
+  // nothing has expired yet
+  ck_assert_int_ne(negativeCache_prune(), 0);
+  ck_assert(negativeCache_lookup("prune"));
+}
+END_TEST
+
+TCase* test_case_negativeCache() {
+  TCase* tc = tcase_create("negativeCache");
+  tcase_add_test(tc, test_storeNew);
+  tcase_add_test(tc, test_storeAgain);
+  tcase_add_test(tc, test_prune);
+  return tc;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_OIDCAGENT_OIDC_FLOWS_NEGATIVECACHE_NEGATIVECACHE_H
+#define TEST_OIDCAGENT_OIDC_FLOWS_NEGATIVECACHE_NEGATIVECACHE_H
+
+#include <check.h>
+
+TCase* test_case_negativeCache();
+
+#endif  // TEST_OIDCAGENT_OIDC_FLOWS_NEGATIVECACHE_NEGATIVECACHE_H
@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_asyncPrompt.h"
+
+Suite* test_suite_asyncPrompt() {
+  Suite* ts_asyncPrompt = suite_create("asyncPrompt");
+  suite_add_tcase(ts_asyncPrompt, test_case_asyncPrompt());
+  return ts_asyncPrompt;
+}
@@ -0,0 +1,196 @@
+#include "tc_asyncPrompt.h"
+
+#include <poll.h>
+
+#include "oidc-agent/oidcp/async_prompt.h"
+#include "oidc-agent/oidcp/passwords/agent_prompt.h"
+#include "oidc-agent/oidcp/passwords/askpass.h"
+#include "utils/memory.h"
+#include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
+
+#define ISSUER "https://example.com/"
+#define CLIENTS (ASYNC_PROMPT_MAX_RUNNING + ASYNC_PROMPT_MAX_QUEUED + 1)
+
+// The prompt prints the short name of the account instead of asking the user
+static unsigned int started = 0;
+
+char* askpass_autoloadText(const char* issuer, const char* shortname,
+                           const char* application_hint) {
+  return oidc_strcopy(shortname);
+}
+
+char* askpass_confirmationText(const char* issuer, const char* shortname,
+                               const char* application_hint,
+                               const char* token_type) {
+  return oidc_strcopy(shortname);
+}
+
+char* agent_promptPasswordCmd(const char* text, const char* label) {
+  started++;
+  return oidc_sprintf("printf '%s'", text);
+}
+
+char* agent_promptConsentDefaultYesCmd(const char* text) {
+  started++;
+  return oidc_sprintf("printf '%s'", text);
+}
+
+struct test_client {
+  struct connection con;
+  unsigned char     type;
+  char              shortname[16];
+  const char*       application_hint;
+  char*             answer;
+  unsigned int      resumed;
+};
+
+static struct test_client clients[CLIENTS];
+
+static void _resume(struct connection* con, const char* request, void* arg) {
+  struct test_client* c = (struct test_client*)con;
+  c->resumed++;
+  c->answer = asyncPrompt_takeAnswer(c->type, c->shortname, ISSUER,
+                                     c->application_hint, NULL);
+  (*(unsigned int*)arg)++;
+}
+
+static oidc_error_t _park(size_t i, unsigned char type, const char* shortname,
+                          const char* application_hint) {
+  struct test_client* c = &clients[i];
+  c->type               = type;
+  strcpy(c->shortname, shortname);
+  c->application_hint = application_hint;
+  asyncPrompt_setClient(&c->con);
+  return asyncPrompt_park(type, shortname, ISSUER, application_hint, 0,
+                          "request");
+}
+
+static const struct ipc_watch* _init(unsigned int* resumed) {
+  started  = 0;
+  *resumed = 0;
+  for (size_t i = 0; i < CLIENTS; i++) {
+    secFree(clients[i].answer);
+  }
+  memset(clients, 0, sizeof(clients));
+  return asyncPromptWatch(NULL, _resume, resumed);
+}
+
+// handles the results of n prompts
+static int _finish(const struct ipc_watch* watch, unsigned int n) {
+  for (unsigned int i = 0; i < n; i++) {
+    struct pollfd pfd = {.fd = watch->fd, .events = POLLIN};
+    if (poll(&pfd, 1, 10000) != 1) {
+      return 0;
+    }
+    watch->handle();
+  }
+  return 1;
+}
+
+START_TEST(test_dedup) {
+  unsigned int            resumed;
+  const struct ipc_watch* watch = _init(&resumed);
+  ck_assert_int_eq(_park(0, ASYNC_PROMPT_CONFIRM, "a", "app"), OIDC_SUCCESS);
+  ck_assert_int_eq(_park(1, ASYNC_PROMPT_CONFIRM, "a", "app"), OIDC_SUCCESS);
+  // a confirmation is given for one application
+  ck_assert_int_eq(_park(2, ASYNC_PROMPT_CONFIRM, "a", "other"), OIDC_SUCCESS);
+  // the password of an account is the same for all applications
+  ck_assert_int_eq(_park(3, ASYNC_PROMPT_AUTOLOAD, "b", "app"), OIDC_SUCCESS);
+  ck_assert_int_eq(_park(4, ASYNC_PROMPT_AUTOLOAD, "b", "other"), OIDC_SUCCESS);
+  ck_assert_int_eq(started, 3);
+  for (size_t i = 0; i < 5; i++) {
+    ck_assert(asyncPrompt_isParked(&clients[i].con));
+  }
+  ck_assert(!asyncPrompt_canPark());
+  ck_assert(_finish(watch, 3));
+  ck_assert_int_eq(resumed, 5);
+  for (size_t i = 0; i < 5; i++) {
+    ck_assert_int_eq(clients[i].resumed, 1);
+    ck_assert_ptr_nonnull(clients[i].answer);
+    ck_assert_str_eq(clients[i].answer, clients[i].shortname);
+    ck_assert(!asyncPrompt_isParked(&clients[i].con));
+  }
+}
+END_TEST
+
+START_TEST(test_answerOnce) {
+  unsigned int            resumed;
+  const struct ipc_watch* watch = _init(&resumed);
+  ck_assert_int_eq(_park(0, ASYNC_PROMPT_AUTOLOAD, "a", NULL), OIDC_SUCCESS);
+  ck_assert(_finish(watch, 1));
+  ck_assert_int_eq(resumed, 1);
+  ck_assert_str_eq(clients[0].answer, "a");
+  // the answer was taken while the client was resumed
+  ck_assert_ptr_null(
+      asyncPrompt_takeAnswer(ASYNC_PROMPT_AUTOLOAD, "a", ISSUER, NULL, NULL));
+}
+END_TEST
+
+START_TEST(test_removeConnection) {
+  unsigned int            resumed;
+  const struct ipc_watch* watch = _init(&resumed);
+  ck_assert_int_eq(_park(0, ASYNC_PROMPT_CONFIRM, "a", "app"), OIDC_SUCCESS);
+  ck_assert_int_eq(_park(1, ASYNC_PROMPT_CONFIRM, "a", "app"), OIDC_SUCCESS);
+  asyncPrompt_removeConnection(&clients[0].con);
+  ck_assert(!asyncPrompt_isParked(&clients[0].con));
+  ck_assert(_finish(watch, 1));
+  ck_assert_int_eq(resumed, 1);
+  ck_assert_int_eq(clients[0].resumed, 0);
+  ck_assert_str_eq(clients[1].answer, "a");
+}
+END_TEST
+
+START_TEST(test_queue) {
+  unsigned int            resumed;
+  const struct ipc_watch* watch = _init(&resumed);
+  char                    shortname[16];
+  for (size_t i = 0; i < ASYNC_PROMPT_MAX_RUNNING + 1; i++) {
+    sprintf(shortname, "q%lu", (unsigned long)i);
+    ck_assert_int_eq(_park(i, ASYNC_PROMPT_AUTOLOAD, shortname, NULL),
+                     OIDC_SUCCESS);
+  }
+  ck_assert_int_eq(started, ASYNC_PROMPT_MAX_RUNNING);
+  // a queued prompt is shared as well
+  ck_assert_int_eq(_park(ASYNC_PROMPT_MAX_RUNNING + 1, ASYNC_PROMPT_AUTOLOAD,
+                         shortname, NULL),
+                   OIDC_SUCCESS);
+  ck_assert(_finish(watch, 1));
+  ck_assert_int_eq(started, ASYNC_PROMPT_MAX_RUNNING + 1);
+  ck_assert(_finish(watch, ASYNC_PROMPT_MAX_RUNNING));
+  ck_assert_int_eq(resumed, ASYNC_PROMPT_MAX_RUNNING + 2);
+  ck_assert_str_eq(clients[ASYNC_PROMPT_MAX_RUNNING + 1].answer, shortname);
+}
+END_TEST
+
+START_TEST(test_queueFull) {
+  unsigned int            resumed;
+  const struct ipc_watch* watch = _init(&resumed);
+  char                    shortname[16];
+  for (size_t i = 0; i < CLIENTS; i++) {
+    sprintf(shortname, "f%lu", (unsigned long)i);
+    oidc_error_t e = _park(i, ASYNC_PROMPT_CONFIRM, shortname, "app");
+    // the last client has to fall back to a blocking prompt
+    ck_assert_int_eq(e, i < CLIENTS - 1 ? OIDC_SUCCESS : OIDC_EERROR);
+  }
+  ck_assert_int_eq(started, ASYNC_PROMPT_MAX_RUNNING);
+  ck_assert(!asyncPrompt_isParked(&clients[CLIENTS - 1].con));
+  // queued prompts nobody waits for are not shown
+  for (size_t i = ASYNC_PROMPT_MAX_RUNNING; i < CLIENTS - 1; i++) {
+    asyncPrompt_removeConnection(&clients[i].con);
+  }
+  ck_assert(_finish(watch, ASYNC_PROMPT_MAX_RUNNING));
+  ck_assert_int_eq(started, ASYNC_PROMPT_MAX_RUNNING);
+  ck_assert_int_eq(resumed, ASYNC_PROMPT_MAX_RUNNING);
+}
+END_TEST
+
+TCase* test_case_asyncPrompt() {
+  TCase* tc = tcase_create("asyncPrompt");
+  tcase_add_test(tc, test_dedup);
+  tcase_add_test(tc, test_answerOnce);
+  tcase_add_test(tc, test_removeConnection);
+  tcase_add_test(tc, test_queue);
+  tcase_add_test(tc, test_queueFull);
+  return tc;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_OIDCAGENT_OIDCP_ASYNCPROMPT_ASYNCPROMPT_H
+#define TEST_OIDCAGENT_OIDCP_ASYNCPROMPT_ASYNCPROMPT_H
+
+#include <check.h>
+
+TCase* test_case_asyncPrompt();
+
+#endif  // TEST_OIDCAGENT_OIDCP_ASYNCPROMPT_ASYNCPROMPT_H
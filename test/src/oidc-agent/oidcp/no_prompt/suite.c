@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_noPrompt.h"
+
+Suite* test_suite_noPrompt() {
+  Suite* ts_noPrompt = suite_create("noPrompt");
+  suite_add_tcase(ts_noPrompt, test_case_noPrompt());
+  return ts_noPrompt;
+}
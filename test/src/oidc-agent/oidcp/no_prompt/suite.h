@@ -0,0 +1,8 @@
+#ifndef TEST_OIDCAGENT_OIDCP_NOPROMPT_SUITE_H
+#define TEST_OIDCAGENT_OIDCP_NOPROMPT_SUITE_H
+
+#include <check.h>
+
+Suite* test_suite_noPrompt();
+
+#endif  // TEST_OIDCAGENT_OIDCP_NOPROMPT_SUITE_H
@@ -0,0 +1,72 @@
+#include "tc_noPrompt.h"
+
+#include "defines/ipc_values.h"
+#include "defines/oidc_values.h"
+#include "oidc-agent/oidcp/no_prompt.h"
+#include "utils/json.h"
+#include "utils/memory.h"
+#include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
+
+static void _assertErrno(const char* request) {
+  unsigned char final  = 1;
+  char*         answer = noPrompt_answer(request, &final);
+  ck_assert_ptr_nonnull(answer);
+  ck_assert_int_eq(final, 0);
+  char* errno_str = getJSONValueFromString(answer, INT_IPC_KEY_OIDCERRNO);
+  ck_assert_ptr_nonnull(errno_str);
+  ck_assert_int_eq(strToInt(errno_str), OIDC_ENOINTERACT);
+  secFree(errno_str);
+  secFree(answer);
+}
+
+START_TEST(test_set) {
+  ck_assert(!noPrompt_isSet());
+  noPrompt_set(1);
+  ck_assert(noPrompt_isSet());
+  noPrompt_set(0);
+  ck_assert(!noPrompt_isSet());
+}
+END_TEST
+
+START_TEST(test_prompts) {
+  _assertErrno(INT_REQUEST_VALUE_AUTOLOAD);
+  _assertErrno(INT_REQUEST_VALUE_CONFIRM);
+  _assertErrno(INT_REQUEST_VALUE_CONFIRMIDTOKEN);
+  _assertErrno(INT_REQUEST_VALUE_CONFIRMMYTOKEN);
+}
+END_TEST
+
+START_TEST(test_autogen) {
+  unsigned char final  = 0;
+  char*         answer = noPrompt_answer(INT_REQUEST_VALUE_AUTOGEN, &final);
+  ck_assert_ptr_nonnull(answer);
+  // oidcd does not wait for an answer, the client gets it
+  ck_assert_int_eq(final, 1);
+  char* error = getJSONValueFromString(answer, OIDC_KEY_ERROR);
+  ck_assert_ptr_nonnull(error);
+  ck_assert_str_eq(error, oidc_serrorFor(OIDC_ENOINTERACT));
+  secFree(error);
+  secFree(answer);
+}
+END_TEST
+
+START_TEST(test_noUser) {
+  unsigned char final = 0;
+  ck_assert_ptr_null(noPrompt_answer(INT_REQUEST_VALUE_UPD_REFRESH, &final));
+  ck_assert_ptr_null(noPrompt_answer(INT_REQUEST_VALUE_UPD_ISSUER, &final));
+  ck_assert_ptr_null(noPrompt_answer(INT_REQUEST_VALUE_RELOAD, &final));
+  ck_assert_ptr_null(
+      noPrompt_answer(INT_REQUEST_VALUE_QUERY_ACCDEFAULT, &final));
+  ck_assert_int_eq(final, 0);
+}
+END_TEST
+
+TCase* test_case_noPrompt() {
+  TCase* tc = tcase_create("noPrompt");
+  tcase_add_test(tc, test_set);
+  tcase_add_test(tc, test_prompts);
+  tcase_add_test(tc, test_autogen);
+  tcase_add_test(tc, test_noUser);
+  return tc;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_OIDCAGENT_OIDCP_NOPROMPT_NOPROMPT_H
+#define TEST_OIDCAGENT_OIDCP_NOPROMPT_NOPROMPT_H
+
+#include <check.h>
+
+TCase* test_case_noPrompt();
+
+#endif  // TEST_OIDCAGENT_OIDCP_NOPROMPT_NOPROMPT_H
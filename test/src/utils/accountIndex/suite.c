@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_accountIndex.h"
+
+Suite* test_suite_accountIndex() {
+  Suite* ts_accountIndex = suite_create("accountIndex");
+  suite_add_tcase(ts_accountIndex, test_case_accountIndex());
+  return ts_accountIndex;
+}
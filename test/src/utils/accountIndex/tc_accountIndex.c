@@ -0,0 +1,121 @@
+#include "tc_accountIndex.h"
+
+#include <utime.h>
+
+#include "defines/settings.h"
+#include "test/src/helper/oidcDir.h"
+#include "utils/config/accountIndex.h"
+#include "utils/file_io/oidc_file_io.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+#define ISSUER "https://example.com/"
+
+static void countEntry(const struct accountIndexEntry* e, void* arg) {
+  (void)e;
+  (*(int*)arg)++;
+}
+
+START_TEST(test_update) {
+  char* dir = test_newOidcDir();  // every test uses a fresh oidc dir
+  ck_assert_ptr_ne(dir, NULL);
+  accountIndex_update("a", ISSUER, "openid");
+  ck_assert_ptr_eq(accountIndex_getAccountForIssuer(ISSUER), NULL);
+  writeOidcFile("a", "encrypted");
+  accountIndex_update("a", ISSUER, "openid");
+  ck_assert_str_eq(accountIndex_getAccountForIssuer(ISSUER), "a");
+  ck_assert_str_eq(accountIndex_getAccountForIssuer("https://example.com"),
+                   "a");
+  ck_assert_ptr_eq(accountIndex_getAccountForIssuer("https://other.com/"),
+                   NULL);
+  ck_assert(oidcFileDoesExist(ACCOUNT_INDEX_FILENAME));
+  char* content = readOidcFile(ACCOUNT_INDEX_FILENAME);
+  ck_assert_ptr_ne(strstr(content, ISSUER), NULL);
+  secFree(content);
+  ck_assert_int_eq(test_removeOidcDir(dir), 0);
+}
+END_TEST
+
+START_TEST(test_updateFromConfig) {
+  char* dir = test_newOidcDir();
+  ck_assert_ptr_ne(dir, NULL);
+  const char* config =
+      "{\"name\":\"a\",\"issuer_url\":\"" ISSUER "\",\"scope\":\"openid\"}";
+  writeOidcFile("a", "encrypted");
+  accountIndex_updateFromConfig("b", config);
+  accountIndex_updateFromConfig("a", "not an account config");
+  ck_assert_ptr_eq(accountIndex_getAccountForIssuer(ISSUER), NULL);
+  accountIndex_updateFromConfig("a", config);
+  ck_assert_str_eq(accountIndex_getAccountForIssuer(ISSUER), "a");
+  ck_assert_int_eq(test_removeOidcDir(dir), 0);
+}
+END_TEST
+
+START_TEST(test_staleEntry) {
+  char* dir = test_newOidcDir();
+  ck_assert_ptr_ne(dir, NULL);
+  writeOidcFile("a", "encrypted");
+  accountIndex_update("a", ISSUER, "openid");
+  int count = 0;
+  accountIndex_foreach(countEntry, &count);
+  ck_assert_int_eq(count, 1);
+  // the account config was changed without updating the index
+  char*          path  = concatToOidcDir("a");
+  struct utimbuf times = {.actime = 1000, .modtime = 1000};
+  ck_assert_int_eq(utime(path, &times), 0);
+  secFree(path);
+  ck_assert_ptr_eq(accountIndex_getAccountForIssuer(ISSUER), NULL);
+  count = 0;
+  accountIndex_foreach(countEntry, &count);
+  ck_assert_int_eq(count, 0);
+  // loading the account indexes it again
+  accountIndex_update("a", ISSUER, NULL);
+  ck_assert_str_eq(accountIndex_getAccountForIssuer(ISSUER), "a");
+  ck_assert_int_eq(test_removeOidcDir(dir), 0);
+}
+END_TEST
+
+START_TEST(test_remove) {
+  char* dir = test_newOidcDir();
+  ck_assert_ptr_ne(dir, NULL);
+  writeOidcFile("a", "encrypted");
+  writeOidcFile("b", "encrypted");
+  accountIndex_update("a", ISSUER, "openid");
+  accountIndex_update("b", ISSUER, "openid");
+  accountIndex_remove("a");
+  accountIndex_remove("c");
+  ck_assert_str_eq(accountIndex_getAccountForIssuer(ISSUER), "b");
+  accountIndex_remove("b");
+  ck_assert_ptr_eq(accountIndex_getAccountForIssuer(ISSUER), NULL);
+  ck_assert_int_eq(test_removeOidcDir(dir), 0);
+}
+END_TEST
+
+START_TEST(test_unparsable) {
+  char* dir = test_newOidcDir();
+  ck_assert_ptr_ne(dir, NULL);
+  writeOidcFile("a", "encrypted");
+  writeOidcFile("b", "encrypted");
+  accountIndex_update("a", ISSUER, "openid");
+  writeOidcFile(ACCOUNT_INDEX_FILENAME, "{\"a\":");
+  // the index is neither dropped nor replaced by what this process knows
+  accountIndex_update("b", "https://other.com/", "openid");
+  char* content = readOidcFile(ACCOUNT_INDEX_FILENAME);
+  ck_assert_str_eq(content, "{\"a\":");
+  secFree(content);
+  ck_assert_str_eq(accountIndex_getAccountForIssuer(ISSUER), "a");
+  ck_assert_ptr_eq(accountIndex_getAccountForIssuer("https://other.com/"),
+                   NULL);
+  ck_assert_int_eq(test_removeOidcDir(dir), 0);
+}
+END_TEST
+
+TCase* test_case_accountIndex() {
+  TCase* tc = tcase_create("accountIndex");
+  tcase_add_test(tc, test_update);
+  tcase_add_test(tc, test_updateFromConfig);
+  tcase_add_test(tc, test_staleEntry);
+  tcase_add_test(tc, test_remove);
+  tcase_add_test(tc, test_unparsable);
+  return tc;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_ACCOUNTINDEX_ACCOUNTINDEX_H
+#define TEST_UTILS_ACCOUNTINDEX_ACCOUNTINDEX_H
+
+#include <check.h>
+
+TCase* test_case_accountIndex();
+
+#endif  // TEST_UTILS_ACCOUNTINDEX_ACCOUNTINDEX_H
@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_db_limits.h"
+
+Suite* test_suite_db() {
+  Suite* ts_db = suite_create("db");
+  suite_add_tcase(ts_db, test_case_db_limits());
+  return ts_db;
+}
@@ -0,0 +1,201 @@
+#include "tc_db_limits.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "utils/db/db.h"
+#include "utils/matcher.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+struct entry {
+  char*  name;
+  time_t death;
+};
+
+static size_t evicted = 0;
+
+static int _match(const struct entry* a, const struct entry* b) {
+  return matchStrings(a->name, b->name);
+}
+
+static void _free(struct entry* e) {
+  secFree(e->name);
+  secFree(e);
+}
+
+static time_t _death(const struct entry* e) { return e->death; }
+
+static size_t _size(const struct entry* e) { return strlen(e->name); }
+
+static void _evict(struct entry* e) {
+  (void)e;
+  evicted++;
+}
+
+static void _newDB(db_name db, size_t max_entries, size_t max_bytes) {
+  db_newDB(db);
+  db_setFreeFunction(db, (freeFunction)_free);
+  db_setMatchFunction(db, (matchFunction)_match);
+  db_setLimits(db, (struct db_limits){
+                       .max_entries = max_entries,
+                       .max_bytes   = max_bytes,
+                       .deathGetter = (time_t(*)(void*))_death,
+                       .sizeGetter  = (size_t(*)(void*))_size,
+                       .evict       = (void (*)(void*))_evict,
+                   });
+  evicted = 0;
+}
+
+static void _add(db_name db, const char* name, time_t death) {
+  struct entry* e = secAlloc(sizeof(struct entry));
+  e->name         = oidc_strcopy(name);
+  e->death        = death;
+  db_addValue(db, e);
+}
+
+static int _contains(db_name db, const char* name) {
+  struct entry key = {.name = (char*)name};
+  return db_findValue(db, &key) != NULL;
+}
+
+START_TEST(test_evictLeastRecentlyUsed) {
+  const db_name db = 101;
+  _newDB(db, 3, 0);
+  _add(db, "a", 0);
+  _add(db, "b", 0);
+  _add(db, "c", 0);
+  ck_assert(_contains(db, "a"));  // "b" is now the least recently used
+  _add(db, "d", 0);
+  ck_assert_int_eq(db_getSize(db), 3);
+  ck_assert(!_contains(db, "b"));
+  ck_assert(_contains(db, "a"));
+  ck_assert(_contains(db, "c"));
+  ck_assert(_contains(db, "d"));
+  ck_assert_int_eq(evicted, 1);
+  ck_assert_int_eq(db_getStats(db).evicted, 1);
+  db_reset(db);
+}
+END_TEST
+
+START_TEST(test_maxBytes) {
+  const db_name db = 102;
+  _newDB(db, 0, 10);
+  _add(db, "1234", 0);
+  _add(db, "5678", 0);
+  ck_assert_int_eq(db_getStats(db).bytes, 8);
+  _add(db, "90", 0);
+  ck_assert_int_eq(db_getSize(db), 3);
+  _add(db, "x", 0);
+  ck_assert_int_eq(db_getSize(db), 3);
+  ck_assert(!_contains(db, "1234"));
+  ck_assert_int_eq(db_getStats(db).bytes, 7);
+  _add(db, "a very long entry", 0);  // the newest entry is kept
+  ck_assert_int_eq(db_getSize(db), 1);
+  ck_assert(_contains(db, "a very long entry"));
+  struct entry key = {.name = "a very long entry"};
+  db_removeIfFound(db, db_findValue(db, &key));
+  ck_assert_int_eq(db_getStats(db).bytes, 0);
+  ck_assert_int_eq(evicted, 4);
+  db_reset(db);
+}
+END_TEST
+
+START_TEST(test_removeExpired) {
+  const db_name db  = 103;
+  time_t        now = time(NULL);
+  _newDB(db, 0, 0);
+  _add(db, "old", now - 1);
+  _add(db, "new", now + 100);
+  _add(db, "forever", 0);
+  ck_assert_int_eq(db_getNextExpiry(db), now - 1);
+  db_removeExpired(db);
+  ck_assert_int_eq(db_getSize(db), 2);
+  ck_assert(!_contains(db, "old"));
+  ck_assert_int_eq(db_getNextExpiry(db), now + 100);
+  struct db_stats stats = db_getStats(db);
+  ck_assert_int_eq(stats.entries, 2);
+  ck_assert_int_eq(stats.expired, 1);
+  ck_assert_int_eq(stats.evicted, 0);
+  ck_assert_int_eq(evicted, 1);
+  db_reset(db);
+}
+END_TEST
+
+START_TEST(test_deferredEvict) {
+  const db_name db = 105;
+  _newDB(db, 2, 0);
+  db_setLimits(db, (struct db_limits){
+                       .max_entries    = 2,
+                       .evict          = (void (*)(void*))_evict,
+                       .deferred_evict = 1,
+                   });
+  _add(db, "a", 0);
+  _add(db, "b", 0);
+  _add(db, "c", 0);
+  ck_assert_int_eq(db_getSize(db), 3);
+  ck_assert_int_eq(evicted, 0);
+  ck_assert(_contains(db, "a"));
+  db_evictOverLimits(db);
+  ck_assert_int_eq(db_getSize(db), 2);
+  ck_assert(!_contains(db, "b"));
+  ck_assert(_contains(db, "a"));
+  ck_assert(_contains(db, "c"));
+  ck_assert_int_eq(evicted, 1);
+  db_reset(db);
+}
+END_TEST
+
+static int _canEvict(const struct entry* e) { return e->death != 0; }
+
+START_TEST(test_canEvict) {
+  const db_name db = 106;
+  _newDB(db, 2, 0);
+  db_setLimits(db, (struct db_limits){
+                       .max_entries = 2,
+                       .evict       = (void (*)(void*))_evict,
+                       .canEvict    = (int (*)(void*))_canEvict,
+                   });
+  _add(db, "pinned", 0);
+  _add(db, "a", 1);
+  _add(db, "b", 1);
+  ck_assert_int_eq(db_getSize(db), 2);
+  ck_assert(_contains(db, "pinned"));
+  ck_assert(!_contains(db, "a"));
+  _add(db, "pinned too", 0);
+  ck_assert_int_eq(db_getSize(db), 2);
+  ck_assert(!_contains(db, "b"));
+  _add(db, "pinned three", 0);  // nothing can be evicted
+  ck_assert_int_eq(db_getSize(db), 3);
+  ck_assert_int_eq(evicted, 2);
+  db_reset(db);
+}
+END_TEST
+
+START_TEST(test_unlimited) {
+  const db_name db = 104;
+  db_newDB(db);
+  db_setFreeFunction(db, (freeFunction)_free);
+  db_setMatchFunction(db, (matchFunction)_match);
+  for (int i = 0; i < 200; i++) {
+    char* name = oidc_sprintf("%d", i);
+    _add(db, name, 1);
+    secFree(name);
+  }
+  db_removeExpired(db);
+  ck_assert_int_eq(db_getSize(db), 200);
+  ck_assert_int_eq(db_getNextExpiry(db), 0);
+  db_reset(db);
+}
+END_TEST
+
+TCase* test_case_db_limits() {
+  TCase* tc = tcase_create("db_limits");
+  tcase_add_test(tc, test_evictLeastRecentlyUsed);
+  tcase_add_test(tc, test_maxBytes);
+  tcase_add_test(tc, test_removeExpired);
+  tcase_add_test(tc, test_deferredEvict);
+  tcase_add_test(tc, test_canEvict);
+  tcase_add_test(tc, test_unlimited);
+  return tc;
+}
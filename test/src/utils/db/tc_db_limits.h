@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_DB_DB_LIMITS_H
+#define TEST_UTILS_DB_DB_LIMITS_H
+
+#include <check.h>
+
+TCase* test_case_db_limits();
+
+#endif  // TEST_UTILS_DB_DB_LIMITS_H
@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_hashmap_put.h"
+
+Suite* test_suite_hashmap() {
+  Suite* ts_hashmap = suite_create("hashmap");
+  suite_add_tcase(ts_hashmap, test_case_hashmap_put());
+  return ts_hashmap;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_HASHMAP_SUITE_H
+#define TEST_UTILS_HASHMAP_SUITE_H
+
+#include <check.h>
+
+Suite* test_suite_hashmap();
+
+#endif  // TEST_UTILS_HASHMAP_SUITE_H
@@ -0,0 +1,84 @@
+#include "tc_hashmap_put.h"
+
+#include "utils/hashmap.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+START_TEST(test_putGet) {
+  hashmap_t* map = hashmap_new(0, _secFree);
+  hashmap_put(map, "a", oidc_strcopy("1"));
+  hashmap_put(map, "b", oidc_strcopy("2"));
+  ck_assert_int_eq(hashmap_size(map), 2);
+  ck_assert_str_eq(hashmap_get(map, "a"), "1");
+  ck_assert_str_eq(hashmap_get(map, "b"), "2");
+  ck_assert_ptr_eq(hashmap_get(map, "c"), NULL);
+  hashmap_put(map, "a", oidc_strcopy("3"));
+  ck_assert_int_eq(hashmap_size(map), 2);
+  ck_assert_str_eq(hashmap_get(map, "a"), "3");
+  secFreeHashmap(map);
+  ck_assert_ptr_eq(map, NULL);
+}
+END_TEST
+
+START_TEST(test_remove) {
+  hashmap_t* map = hashmap_new(0, NULL);
+  hashmap_put(map, "a", "1");
+  hashmap_put(map, "b", "2");
+  ck_assert_str_eq(hashmap_remove(map, "a"), "1");
+  ck_assert(!hashmap_contains(map, "a"));
+  ck_assert(hashmap_contains(map, "b"));
+  ck_assert_ptr_eq(hashmap_remove(map, "a"), NULL);
+  hashmap_put(map, "a", "4");
+  ck_assert_str_eq(hashmap_get(map, "a"), "4");
+  ck_assert_int_eq(hashmap_size(map), 2);
+  secFreeHashmap(map);
+}
+END_TEST
+
+START_TEST(test_getKey) {
+  hashmap_t* map = hashmap_new(0, NULL);
+  char*      key = oidc_strcopy("a");
+  hashmap_put(map, key, "1");
+  const char* stored = hashmap_getKey(map, "a");
+  ck_assert_str_eq(stored, "a");
+  ck_assert_ptr_ne(stored, key);
+  ck_assert_ptr_eq(hashmap_getKey(map, key), stored);
+  ck_assert_ptr_eq(hashmap_getKey(map, "b"), NULL);
+  char* owned = oidc_strcopy("b");
+  hashmap_putOwnedKey(map, owned, "2");
+  ck_assert_ptr_eq(hashmap_getKey(map, "b"), owned);
+  hashmap_putOwnedKey(map, oidc_strcopy("b"), "3");
+  ck_assert_ptr_eq(hashmap_getKey(map, "b"), owned);
+  ck_assert_str_eq(hashmap_get(map, "b"), "3");
+  secFree(key);
+  secFreeHashmap(map);
+}
+END_TEST
+
+START_TEST(test_grow) {
+  hashmap_t* map = hashmap_new(0, _secFree);
+  for (long i = 0; i < 10000; i++) {
+    char* key = oidc_sprintf("key%ld", i);
+    hashmap_put(map, key, oidc_sprintf("%ld", i));
+    secFree(key);
+  }
+  for (long i = 0; i < 10000; i += 2) {
+    char* key = oidc_sprintf("key%ld", i);
+    _secFree(hashmap_remove(map, key));
+    secFree(key);
+  }
+  ck_assert_int_eq(hashmap_size(map), 5000);
+  ck_assert_ptr_eq(hashmap_get(map, "key42"), NULL);
+  ck_assert_str_eq(hashmap_get(map, "key4243"), "4243");
+  secFreeHashmap(map);
+}
+END_TEST
+
+TCase* test_case_hashmap_put() {
+  TCase* tc = tcase_create("hashmap_put");
+  tcase_add_test(tc, test_putGet);
+  tcase_add_test(tc, test_remove);
+  tcase_add_test(tc, test_getKey);
+  tcase_add_test(tc, test_grow);
+  return tc;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_HASHMAP_HASHMAP_PUT_H
+#define TEST_UTILS_HASHMAP_HASHMAP_PUT_H
+
+#include <check.h>
+
+TCase* test_case_hashmap_put();
+
+#endif  // TEST_UTILS_HASHMAP_HASHMAP_PUT_H
@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_intern.h"
+
+Suite* test_suite_intern() {
+  Suite* ts_intern = suite_create("intern");
+  suite_add_tcase(ts_intern, test_case_intern());
+  return ts_intern;
+}
@@ -0,0 +1,76 @@
+#include "tc_intern.h"
+
+#include "account/account.h"
+#include "utils/memory.h"
+#include "utils/string/intern.h"
+#include "utils/string/stringUtils.h"
+
+#define TOKEN_ENDPOINT "https://example.com/oauth2/token"
+
+START_TEST(test_share) {
+  struct intern_stats before = intern_getStats();
+  char*               a      = intern_take(oidc_strcopy(TOKEN_ENDPOINT));
+  char*               b      = intern_take(oidc_strcopy(TOKEN_ENDPOINT));
+  ck_assert_ptr_eq(a, b);
+  ck_assert_str_eq(a, TOKEN_ENDPOINT);
+  struct intern_stats stats = intern_getStats();
+  ck_assert_int_eq(stats.strings, before.strings + 1);
+  ck_assert_int_eq(stats.references, before.references + 2);
+  ck_assert_int_eq(intern_footprint(a), (sizeof(TOKEN_ENDPOINT) + 1) / 2);
+  intern_release(a);
+  ck_assert_str_eq(b, TOKEN_ENDPOINT);
+  intern_release(b);
+  stats = intern_getStats();
+  ck_assert_int_eq(stats.strings, before.strings);
+  ck_assert_int_eq(stats.references, before.references);
+}
+END_TEST
+
+START_TEST(test_takeInterned) {
+  char* a = intern_take(oidc_strcopy(TOKEN_ENDPOINT));
+  char* b = intern_take(a);
+  ck_assert_ptr_eq(a, b);
+  intern_release(a);
+  ck_assert_str_eq(b, TOKEN_ENDPOINT);
+  intern_release(b);
+}
+END_TEST
+
+START_TEST(test_releaseNotInterned) {
+  char* a = intern_take(oidc_strcopy(TOKEN_ENDPOINT));
+  intern_release(oidc_strcopy(TOKEN_ENDPOINT));
+  ck_assert_str_eq(a, TOKEN_ENDPOINT);
+  intern_release(a);
+  intern_release(NULL);
+  ck_assert_ptr_eq(intern_take(NULL), NULL);
+}
+END_TEST
+
+START_TEST(test_accountsShareIssuer) {
+  struct oidc_account* a = secAlloc(sizeof(struct oidc_account));
+  struct oidc_account* b = secAlloc(sizeof(struct oidc_account));
+  account_setIssuerUrl(a, oidc_strcopy("https://example.com/"));
+  account_setIssuerUrl(b, oidc_strcopy("https://example.com/"));
+  issuer_setTokenEndpoint(account_getIssuer(a), oidc_strcopy(TOKEN_ENDPOINT));
+  issuer_setTokenEndpoint(account_getIssuer(b), oidc_strcopy(TOKEN_ENDPOINT));
+  ck_assert_ptr_eq(account_getIssuerUrl(a), account_getIssuerUrl(b));
+  ck_assert_ptr_eq(account_getTokenEndpoint(a), account_getTokenEndpoint(b));
+  size_t shared = account_getMemoryFootprint(a);
+  issuer_setTokenEndpoint(account_getIssuer(b),
+                          oidc_strcopy(TOKEN_ENDPOINT "2"));
+  ck_assert_str_eq(account_getTokenEndpoint(a), TOKEN_ENDPOINT);
+  ck_assert(account_getMemoryFootprint(a) > shared);
+  secFreeAccount(b);
+  ck_assert_str_eq(account_getIssuerUrl(a), "https://example.com/");
+  secFreeAccount(a);
+}
+END_TEST
+
+TCase* test_case_intern() {
+  TCase* tc = tcase_create("intern");
+  tcase_add_test(tc, test_share);
+  tcase_add_test(tc, test_takeInterned);
+  tcase_add_test(tc, test_releaseNotInterned);
+  tcase_add_test(tc, test_accountsShareIssuer);
+  return tc;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_INTERN_INTERN_H
+#define TEST_UTILS_INTERN_INTERN_H
+
+#include <check.h>
+
+TCase* test_case_intern();
+
+#endif  // TEST_UTILS_INTERN_INTERN_H
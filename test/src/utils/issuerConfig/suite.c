@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_getIssuerConfig.h"
+
+Suite* test_suite_issuerConfig() {
+  Suite* ts_issuerConfig = suite_create("issuerConfig");
+  suite_add_tcase(ts_issuerConfig, test_case_getIssuerConfig());
+  return ts_issuerConfig;
+}
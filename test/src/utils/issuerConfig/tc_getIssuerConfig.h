@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_ISSUERCONFIG_GETISSUERCONFIG_H
+#define TEST_UTILS_ISSUERCONFIG_GETISSUERCONFIG_H
+
+#include <check.h>
+
+TCase* test_case_getIssuerConfig();
+
+#endif  // TEST_UTILS_ISSUERCONFIG_GETISSUERCONFIG_H
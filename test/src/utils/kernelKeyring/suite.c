@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_tokens.h"
+
+Suite* test_suite_kernelKeyring() {
+  Suite* ts_kernelKeyring = suite_create("kernelKeyring");
+  suite_add_tcase(ts_kernelKeyring, test_case_tokens());
+  return ts_kernelKeyring;
+}
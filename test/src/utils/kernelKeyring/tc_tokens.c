@@ -0,0 +1,86 @@
+#include "tc_tokens.h"
+
+#include <unistd.h>
+
+#include "utils/kernelKeyring.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+// The tests use the real session keyring; if it is not available (e.g. not on
+// Linux or blocked in a container) they do nothing
+
+START_TEST(test_publishGet) {
+  char*  account = oidc_sprintf("test:%d", (int)getpid());
+  time_t exp     = time(NULL) + 100;
+  if (kernelKeyring_publishToken(account, "openid", "tok1", "https://iss",
+                                 exp) != OIDC_SUCCESS) {
+    secFree(account);
+    return;
+  }
+  char*  issuer     = NULL;
+  time_t expires_at = 0;
+  char*  token =
+      kernelKeyring_getToken(account, "openid", &issuer, &expires_at);
+  ck_assert_str_eq(token, "tok1");
+  ck_assert_str_eq(issuer, "https://iss");
+  ck_assert_int_eq(expires_at, exp);
+  secFree(token);
+  secFree(issuer);
+  ck_assert_ptr_eq(
+      kernelKeyring_getToken(account, "profile", NULL, &expires_at), NULL);
+  kernelKeyring_publishToken(account, "openid", "tok2", "https://iss", exp + 1);
+  token = kernelKeyring_getToken(account, "openid", NULL, &expires_at);
+  ck_assert_str_eq(token, "tok2");
+  ck_assert_int_eq(expires_at, exp + 1);
+  secFree(token);
+  kernelKeyring_removeTokens(account);
+  ck_assert_ptr_eq(
+      kernelKeyring_getToken(account, "openid", NULL, &expires_at), NULL);
+  secFree(account);
+}
+END_TEST
+
+START_TEST(test_separator) {
+  char*  a   = oidc_sprintf("test:%d", (int)getpid());
+  char*  b   = oidc_sprintf("test:%d:x", (int)getpid());
+  time_t exp = time(NULL) + 100;
+  if (kernelKeyring_publishToken(a, "x:openid", "tokA", NULL, exp) !=
+      OIDC_SUCCESS) {
+    secFree(a);
+    secFree(b);
+    return;
+  }
+  kernelKeyring_publishToken(b, "openid", "tokB", NULL, exp);
+  time_t expires_at;
+  char*  token = kernelKeyring_getToken(a, "x:openid", NULL, &expires_at);
+  ck_assert_str_eq(token, "tokA");
+  secFree(token);
+  kernelKeyring_removeTokens(a);
+  token = kernelKeyring_getToken(b, "openid", NULL, &expires_at);
+  ck_assert_str_eq(token, "tokB");
+  secFree(token);
+  kernelKeyring_removeTokens(b);
+  ck_assert_ptr_eq(kernelKeyring_getToken(b, "openid", NULL, &expires_at),
+                   NULL);
+  secFree(a);
+  secFree(b);
+}
+END_TEST
+
+START_TEST(test_expired) {
+  ck_assert_int_eq(kernelKeyring_publishToken("test", NULL, "tok", NULL,
+                                              time(NULL) - 1),
+                   OIDC_SUCCESS);
+  time_t expires_at;
+  ck_assert_ptr_eq(kernelKeyring_getToken("test", NULL, NULL, &expires_at),
+                   NULL);
+}
+END_TEST
+
+TCase* test_case_tokens() {
+  TCase* tc = tcase_create("tokens");
+  tcase_add_test(tc, test_publishGet);
+  tcase_add_test(tc, test_separator);
+  tcase_add_test(tc, test_expired);
+  return tc;
+}
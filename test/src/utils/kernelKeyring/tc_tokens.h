@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_KERNELKEYRING_TOKENS_H
+#define TEST_UTILS_KERNELKEYRING_TOKENS_H
+
+#include <check.h>
+
+TCase* test_case_tokens();
+
+#endif  // TEST_UTILS_KERNELKEYRING_TOKENS_H
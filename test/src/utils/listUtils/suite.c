@@ -0,0 +1,13 @@
+#include "suite.h"
+
+#include "tc_intersectLists.h"
+#include "tc_list_mergeSort.h"
+#include "tc_subtractLists.h"
+
+Suite* test_suite_listUtils() {
+  Suite* ts_listUtils = suite_create("listUtils");
+  suite_add_tcase(ts_listUtils, test_case_list_mergeSort());
+  suite_add_tcase(ts_listUtils, test_case_intersectLists());
+  suite_add_tcase(ts_listUtils, test_case_subtractLists());
+  return ts_listUtils;
+}
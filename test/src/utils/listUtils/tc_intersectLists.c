@@ -0,0 +1,71 @@
+#include "tc_intersectLists.h"
+
+#include "utils/listUtils.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+#define BENCH_ELEMENTS 10000
+
+static list_t* numberList(long from, long to, long step) {
+  list_t* l = list_new();
+  l->free   = _secFree;
+  l->match  = (matchFunction)strequal;
+  for (long i = from; i < to; i += step) {
+    list_rpush(l, list_node_new(oidc_sprintf("%ld", i)));
+  }
+  return l;
+}
+
+START_TEST(test_small) {
+  list_t* a = createList(LIST_CREATE_COPY_VALUES, "openid", "profile", "email",
+                         NULL);
+  list_t* b = createList(LIST_CREATE_COPY_VALUES, "email", "offline_access",
+                         "openid", NULL);
+  list_t* l = intersectLists(a, b);
+  char*   s = listToDelimitedString(l, " ");
+  ck_assert_str_eq(s, "openid email");
+  secFree(s);
+  secFreeList(l);
+  secFreeList(a);
+  secFreeList(b);
+}
+END_TEST
+
+// The values of the result are taken from the second list
+START_TEST(test_valuesFromB) {
+  list_t* a = createList(LIST_CREATE_COPY_VALUES, "OpenID", "Email", NULL);
+  list_t* b = createList(LIST_CREATE_COPY_VALUES, "email", "openid", NULL);
+  a->match  = (matchFunction)strcaseequal;
+  b->match  = (matchFunction)strcaseequal;
+  list_t* l = intersectLists(a, b);
+  char*   s = listToDelimitedString(l, " ");
+  ck_assert_str_eq(s, "openid email");
+  secFree(s);
+  secFreeList(l);
+  secFreeList(a);
+  secFreeList(b);
+}
+END_TEST
+
+// Large lists are intersected through a hash index; this also serves as a
+// benchmark over BENCH_ELEMENTS elements.
+START_TEST(test_bench) {
+  list_t* a = numberList(0, BENCH_ELEMENTS, 1);
+  list_t* b = numberList(0, 2 * BENCH_ELEMENTS, 2);
+  list_t* l = intersectLists(a, b);
+  ck_assert_int_eq(l->len, BENCH_ELEMENTS / 2);
+  ck_assert_str_eq(l->head->val, "0");
+  ck_assert_str_eq(l->tail->val, "9998");
+  secFreeList(l);
+  secFreeList(a);
+  secFreeList(b);
+}
+END_TEST
+
+TCase* test_case_intersectLists() {
+  TCase* tc = tcase_create("intersectLists");
+  tcase_add_test(tc, test_small);
+  tcase_add_test(tc, test_valuesFromB);
+  tcase_add_test(tc, test_bench);
+  return tc;
+}
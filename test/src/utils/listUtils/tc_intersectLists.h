@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_LISTUTILS_INTERSECTLISTS_H
+#define TEST_UTILS_LISTUTILS_INTERSECTLISTS_H
+
+#include <check.h>
+
+TCase* test_case_intersectLists();
+
+#endif  // TEST_UTILS_LISTUTILS_INTERSECTLISTS_H
@@ -0,0 +1,96 @@
+#include "tc_list_mergeSort.h"
+
+#include <string.h>
+
+#include "utils/listUtils.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+#define BENCH_ELEMENTS 10000
+
+static int compInts(const long a, const long b) {
+  return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static int compFirstChar(const char* a, const char* b) {
+  return (unsigned char)a[0] - (unsigned char)b[0];
+}
+
+static int isSorted(list_t* l) {
+  if (l->len == 0) {
+    return l->head == NULL && l->tail == NULL;
+  }
+  unsigned int n    = 1;
+  list_node_t* node = l->head;
+  if (node->prev != NULL) {
+    return 0;
+  }
+  for (; node->next; node = node->next, n++) {
+    if ((long)node->val > (long)node->next->val || node->next->prev != node) {
+      return 0;
+    }
+  }
+  return node == l->tail && n == l->len;
+}
+
+START_TEST(test_empty) {
+  list_t* l = list_new();
+  list_mergeSort(l, (matchFunction)compInts);
+  ck_assert(isSorted(l));
+  secFreeList(l);
+}
+END_TEST
+
+START_TEST(test_small) {
+  list_t* l          = list_new();
+  long    values[]   = {5, 3, 9, 1, 3, 7, 2};
+  long    expected[] = {1, 2, 3, 3, 5, 7, 9};
+  for (size_t i = 0; i < sizeof(values) / sizeof(*values); i++) {
+    list_rpush(l, list_node_new((void*)values[i]));
+  }
+  list_mergeSort(l, (matchFunction)compInts);
+  ck_assert(isSorted(l));
+  size_t i = 0;
+  for (list_node_t* node = l->head; node; node = node->next) {
+    ck_assert_int_eq((long)node->val, expected[i++]);
+  }
+  secFreeList(l);
+}
+END_TEST
+
+START_TEST(test_stable) {
+  list_t* l = createList(LIST_CREATE_DONT_COPY_VALUES, "b1", "a1", "b2", "a2",
+                         "a3", "b3", NULL);
+  list_mergeSort(l, (matchFunction)compFirstChar);
+  char* s = listToDelimitedString(l, " ");
+  ck_assert_str_eq(s, "a1 a2 a3 b1 b2 b3");
+  secFree(s);
+  secFreeList(l);
+}
+END_TEST
+
+// Sorting BENCH_ELEMENTS elements used to take quadratic time and a stack
+// buffer of the list size; this also serves as a benchmark.
+START_TEST(test_bench) {
+  list_t* l    = list_new();
+  long    seed = 42;
+  for (long i = 0; i < BENCH_ELEMENTS; i++) {
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+    list_rpush(l, list_node_new((void*)(seed % 1000)));
+  }
+  list_mergeSort(l, (matchFunction)compInts);
+  ck_assert(isSorted(l));
+  list_mergeSort(l, (matchFunction)compInts);
+  ck_assert(isSorted(l));
+  secFreeList(l);
+}
+END_TEST
+
+TCase* test_case_list_mergeSort() {
+  TCase* tc = tcase_create("list_mergeSort");
+  tcase_add_test(tc, test_empty);
+  tcase_add_test(tc, test_small);
+  tcase_add_test(tc, test_stable);
+  tcase_add_test(tc, test_bench);
+  return tc;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_LISTUTILS_LIST_MERGESORT_H
+#define TEST_UTILS_LISTUTILS_LIST_MERGESORT_H
+
+#include <check.h>
+
+TCase* test_case_list_mergeSort();
+
+#endif  // TEST_UTILS_LISTUTILS_LIST_MERGESORT_H
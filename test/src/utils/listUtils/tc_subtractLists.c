@@ -0,0 +1,45 @@
+#include "tc_subtractLists.h"
+
+#include "utils/listUtils.h"
+#include "utils/memory.h"
+#include "utils/string/stringUtils.h"
+
+#define BENCH_ELEMENTS 10000
+
+START_TEST(test_small) {
+  char* s = subtractListStrings("openid profile email offline_access",
+                                "profile offline_access", ' ');
+  ck_assert_str_eq(s, "openid email");
+  secFree(s);
+}
+END_TEST
+
+START_TEST(test_bench) {
+  list_t* a = list_new();
+  a->free   = _secFree;
+  a->match  = (matchFunction)strequal;
+  list_t* b = list_new();
+  b->free   = _secFree;
+  b->match  = (matchFunction)strequal;
+  for (long i = 0; i < BENCH_ELEMENTS; i++) {
+    list_rpush(a, list_node_new(oidc_sprintf("scope%ld", i)));
+    if (i % 3 != 0) {
+      list_rpush(b, list_node_new(oidc_sprintf("scope%ld", i)));
+    }
+  }
+  list_t* l = subtractLists(a, b);
+  ck_assert_int_eq(l->len, (BENCH_ELEMENTS + 2) / 3);
+  ck_assert_str_eq(l->head->val, "scope0");
+  ck_assert_str_eq(l->head->next->val, "scope3");
+  secFreeList(l);
+  secFreeList(a);
+  secFreeList(b);
+}
+END_TEST
+
+TCase* test_case_subtractLists() {
+  TCase* tc = tcase_create("subtractLists");
+  tcase_add_test(tc, test_small);
+  tcase_add_test(tc, test_bench);
+  return tc;
+}
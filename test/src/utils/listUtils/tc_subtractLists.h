@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_LISTUTILS_SUBTRACTLISTS_H
+#define TEST_UTILS_LISTUTILS_SUBTRACTLISTS_H
+
+#include <check.h>
+
+TCase* test_case_subtractLists();
+
+#endif  // TEST_UTILS_LISTUTILS_SUBTRACTLISTS_H
@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_pubAlloc.h"
+
+Suite* test_suite_memory() {
+  Suite* ts_memory = suite_create("memory");
+  suite_add_tcase(ts_memory, test_case_pubAlloc());
+  return ts_memory;
+}
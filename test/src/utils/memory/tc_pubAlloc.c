@@ -0,0 +1,58 @@
+#include "tc_pubAlloc.h"
+
+#include <string.h>
+
+#include "utils/memory.h"
+
+START_TEST(test_secAllocIsSecret) {
+  char* s = secAlloc(16);
+  ck_assert_ptr_ne(s, NULL);
+  ck_assert(!isPublicMem(s));
+  secFree(s);
+}
+END_TEST
+
+START_TEST(test_pubAllocIsPublic) {
+  char* s = pubAlloc(16);
+  ck_assert_ptr_ne(s, NULL);
+  ck_assert(isPublicMem(s));
+  for (int i = 0; i < 16; i++) { ck_assert_int_eq(s[i], 0); }
+  secFree(s);
+  ck_assert_ptr_eq(s, NULL);
+}
+END_TEST
+
+START_TEST(test_markPublic) {
+  char* s = secAlloc(16);
+  markPublicMem(s);
+  ck_assert(isPublicMem(s));
+  secFree(s);
+}
+END_TEST
+
+START_TEST(test_reallocKeepsClass) {
+  char* s = pubAlloc(4);
+  strcpy(s, "abc");
+  s = secRealloc(s, 4096);
+  ck_assert(isPublicMem(s));
+  ck_assert_str_eq(s, "abc");
+  ck_assert_int_eq(s[4095], 0);
+  secFree(s);
+
+  s = secAlloc(4);
+  strcpy(s, "abc");
+  s = secRealloc(s, 4096);
+  ck_assert(!isPublicMem(s));
+  ck_assert_str_eq(s, "abc");
+  secFree(s);
+}
+END_TEST
+
+TCase* test_case_pubAlloc() {
+  TCase* tc = tcase_create("pubAlloc");
+  tcase_add_test(tc, test_secAllocIsSecret);
+  tcase_add_test(tc, test_pubAllocIsPublic);
+  tcase_add_test(tc, test_markPublic);
+  tcase_add_test(tc, test_reallocKeepsClass);
+  return tc;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_MEMORY_PUBALLOC_H
+#define TEST_UTILS_MEMORY_PUBALLOC_H
+
+#include <check.h>
+
+TCase* test_case_pubAlloc();
+
+#endif  // TEST_UTILS_MEMORY_PUBALLOC_H
@@ -0,0 +1,11 @@
+#include "suite.h"
+
+#include "tc_legacy.h"
+#include "tc_threads.h"
+
+Suite* test_suite_oidc_error() {
+  Suite* ts_oidc_error = suite_create("oidc_error");
+  suite_add_tcase(ts_oidc_error, test_case_threads());
+  suite_add_tcase(ts_oidc_error, test_case_legacy());
+  return ts_oidc_error;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_OIDC_ERROR_SUITE_H
+#define TEST_UTILS_OIDC_ERROR_SUITE_H
+
+#include <check.h>
+
+Suite* test_suite_oidc_error();
+
+#endif  // TEST_UTILS_OIDC_ERROR_SUITE_H
@@ -0,0 +1,45 @@
+#include "tc_legacy.h"
+
+#include <pthread.h>
+
+#include "api/error.h"
+#include "utils/oidc_error.h"
+
+static void* setError(void* arg) {
+  oidc_errno = OIDC_EOIDC;
+  oidc_seterror("error of another thread");
+  return NULL;
+}
+
+// The objects applications built against liboidc-agent 5.0.x link to
+#undef oidc_errno
+#undef oidc_error
+extern int  oidc_errno;
+extern char oidc_error[1024];
+
+START_TEST(test_publish) {
+  oidc_thread_errno = OIDC_EERROR;
+  oidc_seterror("error of this thread");
+  oidc_publishErrorState();
+  ck_assert_int_eq(oidc_errno, OIDC_EERROR);
+  ck_assert_str_eq(oidc_error, "error of this thread");
+}
+END_TEST
+
+START_TEST(test_accessor) {
+  pthread_t thread;
+  oidc_thread_errno = OIDC_ENOACCOUNT;
+  ck_assert_int_eq(pthread_create(&thread, NULL, setError, NULL), 0);
+  pthread_join(thread, NULL);
+  // another thread does not change the error of this one
+  ck_assert_int_eq(oidcagent_errno(), OIDC_ENOACCOUNT);
+  ck_assert_int_eq(oidc_thread_errno, OIDC_ENOACCOUNT);
+}
+END_TEST
+
+TCase* test_case_legacy() {
+  TCase* tc = tcase_create("legacy");
+  tcase_add_test(tc, test_publish);
+  tcase_add_test(tc, test_accessor);
+  return tc;
+}
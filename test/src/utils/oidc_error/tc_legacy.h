@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_OIDC_ERROR_LEGACY_H
+#define TEST_UTILS_OIDC_ERROR_LEGACY_H
+
+#include <check.h>
+
+TCase* test_case_legacy();
+
+#endif  // TEST_UTILS_OIDC_ERROR_LEGACY_H
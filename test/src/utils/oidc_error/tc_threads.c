@@ -0,0 +1,84 @@
+#include "tc_threads.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "utils/json.h"
+#include "utils/memory.h"
+#include "utils/oidc_error.h"
+#include "utils/string/stringUtils.h"
+
+#define THREADS 32
+#define ROUNDS 2000
+
+static void* setAndCheckErrors(void* arg) {
+  long  id      = (long)arg;
+  char* msg     = oidc_sprintf("error of thread %ld", id);
+  long  corrupt = 0;
+  for (int i = 0; i < ROUNDS; i++) {
+    oidc_errno = OIDC_EERROR;
+    oidc_seterror(msg);
+    sched_yield();
+    if (oidc_errno != OIDC_EERROR || !strequal(oidc_serror(), msg)) {
+      corrupt++;
+    }
+    oidc_errno = 200 + (int)id;
+    sched_yield();
+    if (oidc_errno != 200 + id) {
+      corrupt++;
+    }
+  }
+  secFree(msg);
+  return (void*)corrupt;
+}
+
+START_TEST(test_errorState) {
+  pthread_t threads[THREADS];
+  oidc_errno = OIDC_SUCCESS;
+  for (long i = 0; i < THREADS; i++) {
+    ck_assert_int_eq(
+        pthread_create(&threads[i], NULL, setAndCheckErrors, (void*)i), 0);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    void* corrupt;
+    pthread_join(threads[i], &corrupt);
+    ck_assert_int_eq((long)corrupt, 0);
+  }
+  ck_assert_int_eq(oidc_errno, OIDC_SUCCESS);
+}
+END_TEST
+
+static void* parseJson(void* arg) {
+  long public = (long)arg % 2;
+  long wrong  = 0;
+  for (int i = 0; i < ROUNDS; i++) {
+    cJSON* json = public ? publicStringToJson("{\"key\":\"value\"}")
+                         : stringToJson("{\"key\":\"value\"}");
+    if (json == NULL || isPublicMem(json) != public) {
+      wrong++;
+    }
+    secFreeJson(json);
+  }
+  return (void*)wrong;
+}
+
+START_TEST(test_jsonMemory) {
+  pthread_t threads[THREADS];
+  for (long i = 0; i < THREADS; i++) {
+    ck_assert_int_eq(pthread_create(&threads[i], NULL, parseJson, (void*)i),
+                     0);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    void* wrong;
+    pthread_join(threads[i], &wrong);
+    ck_assert_int_eq((long)wrong, 0);
+  }
+}
+END_TEST
+
+TCase* test_case_threads() {
+  TCase* tc = tcase_create("threads");
+  tcase_add_test(tc, test_errorState);
+  tcase_add_test(tc, test_jsonMemory);
+  return tc;
+}
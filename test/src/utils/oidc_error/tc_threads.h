@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_OIDC_ERROR_THREADS_H
+#define TEST_UTILS_OIDC_ERROR_THREADS_H
+
+#include <check.h>
+
+TCase* test_case_threads();
+
+#endif  // TEST_UTILS_OIDC_ERROR_THREADS_H
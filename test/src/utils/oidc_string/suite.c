@@ -0,0 +1,9 @@
+#include "suite.h"
+
+#include "tc_string_append.h"
+
+Suite* test_suite_oidc_string() {
+  Suite* ts_oidc_string = suite_create("oidc_string");
+  suite_add_tcase(ts_oidc_string, test_case_string_append());
+  return ts_oidc_string;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_OIDC_STRING_SUITE_H
+#define TEST_UTILS_OIDC_STRING_SUITE_H
+
+#include <check.h>
+
+Suite* test_suite_oidc_string();
+
+#endif  // TEST_UTILS_OIDC_STRING_SUITE_H
@@ -0,0 +1,54 @@
+#include "tc_string_append.h"
+
+#include <string.h>
+
+#include "utils/memory.h"
+#include "utils/string/oidc_string.h"
+
+START_TEST(test_append) {
+  struct string s;
+  ck_assert_int_eq(init_string(&s), OIDC_SUCCESS);
+  ck_assert_int_eq(string_append(&s, "Hello", 5), OIDC_SUCCESS);
+  ck_assert_int_eq(string_append(&s, " World", 6), OIDC_SUCCESS);
+  ck_assert_int_eq(s.len, 11);
+  ck_assert_str_eq(s.ptr, "Hello World");
+  secFree(s.ptr);
+}
+END_TEST
+
+START_TEST(test_appendMany) {
+  struct string s;
+  ck_assert_int_eq(init_string(&s), OIDC_SUCCESS);
+  for (int i = 0; i < 100000; i++) {
+    ck_assert_int_eq(string_append(&s, "0123456789", 10), OIDC_SUCCESS);
+  }
+  ck_assert_int_eq(s.len, 1000000);
+  ck_assert_int_ge(s.cap, s.len);
+  ck_assert_int_eq(strlen(s.ptr), s.len);
+  ck_assert_int_eq(memcmp(s.ptr + 999990, "0123456789", 10), 0);
+  secFree(s.ptr);
+}
+END_TEST
+
+START_TEST(test_reserve) {
+  struct string s;
+  ck_assert_int_eq(init_string(&s), OIDC_SUCCESS);
+  markPublicMem(s.ptr);
+  ck_assert_int_eq(string_reserve(&s, 4096), OIDC_SUCCESS);
+  ck_assert_int_eq(s.cap, 4096);
+  ck_assert(isPublicMem(s.ptr));
+  char* before = s.ptr;
+  for (int i = 0; i < 400; i++) { string_append(&s, "0123456789", 10); }
+  ck_assert_ptr_eq(s.ptr, before);
+  ck_assert_int_eq(s.len, 4000);
+  secFree(s.ptr);
+}
+END_TEST
+
+TCase* test_case_string_append() {
+  TCase* tc = tcase_create("string_append");
+  tcase_add_test(tc, test_append);
+  tcase_add_test(tc, test_appendMany);
+  tcase_add_test(tc, test_reserve);
+  return tc;
+}
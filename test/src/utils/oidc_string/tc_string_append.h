@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_OIDC_STRING_STRING_APPEND_H
+#define TEST_UTILS_OIDC_STRING_STRING_APPEND_H
+
+#include <check.h>
+
+TCase* test_case_string_append();
+
+#endif  // TEST_UTILS_OIDC_STRING_STRING_APPEND_H
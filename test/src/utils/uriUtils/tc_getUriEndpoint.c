@@ -0,0 +1,53 @@
+#include "tc_getUriEndpoint.h"
+
+#include "utils/memory.h"
+#include "utils/oidc_error.h"
+#include "utils/uriUtils.h"
+
+START_TEST(test_NULL) {
+  char* endpoint = getUriEndpoint(NULL);
+  ck_assert_int_eq(oidc_errno, OIDC_EARGNULLFUNC);
+  ck_assert_ptr_eq(endpoint, NULL);
+}
+END_TEST
+
+START_TEST(test_noScheme) {
+  char* endpoint = getUriEndpoint("op.example.com/token");
+  ck_assert_int_eq(oidc_errno, OIDC_EURL);
+  ck_assert_ptr_eq(endpoint, NULL);
+}
+END_TEST
+
+START_TEST(test_path) {
+  char* endpoint = getUriEndpoint("https://op.example.com/auth/realms/x/token");
+  ck_assert_ptr_ne(endpoint, NULL);
+  ck_assert_str_eq(endpoint, "https://op.example.com/auth/realms/x/token");
+  secFree(endpoint);
+}
+END_TEST
+
+START_TEST(test_query) {
+  char* endpoint = getUriEndpoint("http://localhost:4242/cb?code=1234#x");
+  ck_assert_ptr_ne(endpoint, NULL);
+  ck_assert_str_eq(endpoint, "http://localhost:4242/cb");
+  secFree(endpoint);
+}
+END_TEST
+
+START_TEST(test_fragment) {
+  char* endpoint = getUriEndpoint("https://op.example.com/token#x");
+  ck_assert_ptr_ne(endpoint, NULL);
+  ck_assert_str_eq(endpoint, "https://op.example.com/token");
+  secFree(endpoint);
+}
+END_TEST
+
+TCase* test_case_getUriEndpoint() {
+  TCase* tc = tcase_create("getUriEndpoint");
+  tcase_add_test(tc, test_NULL);
+  tcase_add_test(tc, test_noScheme);
+  tcase_add_test(tc, test_path);
+  tcase_add_test(tc, test_query);
+  tcase_add_test(tc, test_fragment);
+  return tc;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_UTILS_URIUTILS_GETURIENDPOINT_H
+#define TEST_UTILS_URIUTILS_GETURIENDPOINT_H
+
+#include <check.h>
+
+TCase* test_case_getUriEndpoint();
+
+#endif  // TEST_UTILS_URIUTILS_GETURIENDPOINT_H